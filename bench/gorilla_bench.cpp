@@ -0,0 +1,127 @@
+// Compression ratio and decode throughput of the Gorilla blocks used by the series rings and change log.
+// Standalone (no OPC/N-API needed):
+//   g++ -O2 -std=c++17 -Isrc bench/gorilla_bench.cpp -o gorilla_bench && ./gorilla_bench
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "change_log.h"
+#include "gorilla.h"
+
+namespace {
+
+double SecondsSince(std::chrono::steady_clock::time_point t0) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Plant-like signal: 1 s scan with jitter, slow drift, occasional flat stretches and quality drops
+void MakeSeries(size_t n, std::vector<double>& ts, std::vector<double>& values, std::vector<uint16_t>& qualities) {
+  std::mt19937_64 rng(42);
+  ts.resize(n);
+  values.resize(n);
+  qualities.resize(n);
+  double t = 1.7e12, v = 50.0;
+  for (size_t i = 0; i < n; ++i) {
+    t += 1000.0 + static_cast<double>(rng() % 4 == 0 ? rng() % 20 : 0);
+    if (rng() % 3 == 0) v += (static_cast<double>(rng() % 200) - 100.0) / 1000.0;
+    ts[i] = t;
+    values[i] = v;
+    qualities[i] = (i % 5000) < 10 ? 0x00 : 0xC0;
+  }
+}
+
+void BenchSeries() {
+  const size_t kSamples = 1000000;
+  const size_t kBlock = 256;
+  std::vector<double> ts, values;
+  std::vector<uint16_t> qualities;
+  MakeSeries(kSamples, ts, values, qualities);
+
+  std::vector<gorilla::SeriesBlock> blocks(kSamples / kBlock);
+  size_t bytes = 0;
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t b = 0; b < blocks.size(); ++b) {
+    gorilla::EncodeSeriesBlock(&ts[b * kBlock], &values[b * kBlock], &qualities[b * kBlock], kBlock, blocks[b]);
+    bytes += blocks[b].ts.size() + blocks[b].values.size() + blocks[b].qualities.size();
+  }
+  double encodeSec = SecondsSince(t0);
+
+  std::vector<double> outTs(kBlock), outValues(kBlock);
+  std::vector<uint16_t> outQualities(kBlock);
+  double checksum = 0.0;
+  t0 = std::chrono::steady_clock::now();
+  for (const gorilla::SeriesBlock& block : blocks) {
+    gorilla::DecodeSeriesBlock(block, outTs.data(), outValues.data(), outQualities.data());
+    checksum += outValues[kBlock - 1];
+  }
+  double decodeSec = SecondsSince(t0);
+
+  size_t samples = blocks.size() * kBlock;
+  double raw = static_cast<double>(samples) * (8 + 8 + 2);
+  std::printf("series:  %zu samples, %.2f bytes/sample, ratio %.1fx, encode %.1f M/s, decode %.1f M/s (checksum %.3f)\n",
+              samples, bytes / static_cast<double>(samples), raw / bytes,
+              samples / encodeSec / 1e6, samples / decodeSec / 1e6, checksum);
+}
+
+void BenchChangeLog() {
+  const size_t kBatches = 2000;
+  const size_t kItems = 500;
+  std::vector<double> ts, values;
+  std::vector<uint16_t> qualities;
+  MakeSeries(kBatches * kItems, ts, values, qualities);
+
+  std::vector<uint8_t> raw, packed;
+  uint64_t seq = 0;
+  for (size_t b = 0; b < kBatches; ++b) {
+    std::vector<ChangeRecord> records(kItems);
+    std::vector<uint32_t> nameIds(kItems);
+    for (size_t i = 0; i < kItems; ++i) {
+      ChangeRecord& rec = records[i];
+      rec.seq = ++seq;
+      rec.handle = static_cast<uint32_t>(i);
+      rec.timestamp = JsMsToFileTimeTicks(ts[b * kItems + i]);
+      rec.quality = qualities[b * kItems + i];
+      rec.value.kind = ChangeValue::Kind::Number;
+      rec.value.number = values[i * kBatches / kItems + b % 4];
+      nameIds[i] = static_cast<uint32_t>(i);
+    }
+    size_t at = raw.size();
+    raw.resize(at + changelog::RawBlockSize(records));
+    changelog::EncodeRawBlock(raw.data() + at, records, nameIds, 0);
+    changelog::EncodeGorillaBlock(packed, records, nameIds, 0);
+  }
+
+  size_t rows = kBatches * kItems;
+  std::vector<double> outTs(rows), outValues(rows), outSeq(rows);
+  std::vector<uint16_t> outQualities(rows);
+  std::vector<uint32_t> outIds(rows);
+  changelog::ColumnSink sink;
+  sink.seq = outSeq.data();
+  sink.timestampMs = outTs.data();
+  sink.values = outValues.data();
+  sink.qualities = outQualities.data();
+  sink.nameIds = outIds.data();
+
+  for (const std::vector<uint8_t>* data : { &raw, &packed }) {
+    auto t0 = std::chrono::steady_clock::now();
+    size_t pos = 0, row = 0;
+    while (pos < data->size()) {
+      changelog::BlockHeader hdr;
+      if (!changelog::DecodeBlockColumns(data->data() + pos, data->size() - pos, sink, row, &hdr)) break;
+      pos += hdr.byteLength;
+      row += hdr.count;
+    }
+    double sec = SecondsSince(t0);
+    std::printf("changelog %-7s %zu rows, %.2f bytes/row, decode to columns %.1f M rows/s\n",
+                data == &raw ? "raw:" : "gorilla:", row, data->size() / static_cast<double>(rows), row / sec / 1e6);
+  }
+  std::printf("changelog ratio: %.1fx\n", raw.size() / static_cast<double>(packed.size()));
+}
+
+}  // namespace
+
+int main() {
+  BenchSeries();
+  BenchChangeLog();
+  return 0;
+}
@@ -41,6 +41,99 @@ client.write('Some.Item', 42).then(() => {
   console.log('Write OK');
 });
 
+// Catch up after a hiccup: changes still held natively after the last seen event.data.data.seq
+// const { changes, gap, losses } = client.changesSince('myGroup', lastSeq);
+// client.getSequenceStats('myGroup', fromSeq, toSeq); // drop/conflation/overflow counts per seq range
+
+// Native rolling windows: 1 min and 10 min aggregates for many tags in one call (typed arrays)
+// client.enableSeries('myGroup', 65536, { compress: true }); // Gorilla blocks, see bench/gorilla_bench.cpp
+// const { min, max, avg, last, count } = client.aggregate('myGroup', tags, [60000, 600000]);
+
+// Record every change to memory-mapped columnar segments (written on a background thread)
+// client.startRecording('./changelog', { maxSegmentBytes: 64 * 1024 * 1024, maxSegmentMs: 600000, compress: true });
+// client.decodeSegment(path).then(({ timestamps, values, qualities, nameIds, names }) => { /* typed arrays */ });
+// client.getRecorderStats(); client.stopRecording();
+
+// Replay a recorded log through the same pipeline subscribe() uses (speed: 1 = real time, 0 = max)
+// client.replay('./changelog', { speed: 10, groups: { myGroup: 'replayGroup' } }).then(stats => console.log(stats));
+
+// Store-and-forward: changes queue natively (spilling to disk past memoryRecords) until acked
+// client.subscribe('myGroup', handler, ['dataChange'], { storeAndForward: { dir: './spool', memoryRecords: 100000, window: 1000 } });
+// broker.publish(event).then(() => client.ack('myGroup', event.data.data.seq)); // client.getForwardStats('myGroup')
+
+// Where the time goes between the COM callback and the handler (HDR histograms per stage)
+// client.enableMetrics(true); const { counters, stages } = client.getMetrics(); // stages.handler.p99Us
+// http.createServer((req, res) => res.end(client.getMetrics('prometheus'))).listen(9464);
+
+// Slow handler attribution: events name the group, what was slow (handler/callback/dispatch) and for how long
+// client.setWatchdog({ handlerMs: 50, callbackMs: 20, dispatchMs: 500 }, (event) => console.warn(event.type, event.data));
+// client.getWatchdogStats(); client.setWatchdog(null);
+
+// Each worker_thread can load the addon and own its own connections (state is per env)
+// new Worker('./opc-worker.js', { workerData: { host: 'localhost', progId: 'Kepware.KEPServerEX.V6' } });
+
+// Live value table in a SharedArrayBuffer: post `sab` to workers once, then read slots directly
+// const sab = new SharedArrayBuffer(64 + 32 * tags.length);
+// client.attachValueTable('myGroup', new Uint8Array(sab), tags);
+// Slot i at 64 + 32 * i: retry while Atomics.load(i32, base / 4) is odd or changes across reading
+// f64[base / 8 + 1] (value), f64[base / 8 + 2] (timestamp), i32[base / 4 + 1] & 0xffff (quality)
+
+// Many consumers, one server group: each change is converted once and fanned out natively
+// const { id } = client.subscribeShared('myGroup', (event) => { /* ... */ }, { items: ['Tag1', 'Tag2'] });
+// client.getFanoutStats('myGroup'); client.unsubscribeShared('myGroup', id);
+
+// Let the addon partition a big tag list into groups by rate and size, and split groups whose callbacks grow
+// client.planGroups(tags.map(name => ({ name, rate: 1000 })), { maxItemsPerGroup: 1000, maxCallbackItems: 500 }, onChange);
+// setInterval(() => client.rebalancePlan(), 60000); client.getPlan();
+
+// Elastic groups: slowed (lowest priority first) while handlers fall behind, restored when load eases
+// client.setElastic('trendGroup', { minRate: 1000, maxRate: 10000, priority: 0 });
+// client.startRateControl({ intervalMs: 1000, highBusy: 0.8, highDepth: 5000 }); client.getRates(); // revised = granted
+
+// Reconfigure without tearing groups down: only the differences reach the server
+// client.applyConfig({ fastGroup: { rate: 250, items: ['Tag1', 'Tag2'] }, slowGroup: { rate: 5000, deadband: 0.5, items: tags } });
+
+// Plant-area views: only the visible area's items are scanned; switching costs one call per group and direction
+// client.defineView('boilerHouse', { area1: boilerTags }); client.defineView('tankFarm', { area1: tankTags });
+// client.showViews(['tankFarm']); client.setActive('area1', ['Tag1', 'Tag2'], false);
+
+// Numeric tags published as strings: have the server convert them so changes stay on the numeric path
+// client.setDatatypes('myGroup', null, 'double'); client.setDatatypes('myGroup', ['Status'], 'native'); client.getDatatypes('myGroup');
+
+// "Fresh within 2 s": served from the server cache when it can, from the device only when needed
+// const values = await client.readMaxAge('myGroup', ['Tag1', 'Tag2'], 2000); client.refreshMaxAge('myGroup', 2000);
+
+// Inject computed points with their own quality and source timestamp, one server call per batch
+// await client.writeVQT('calcGroup', names, { values: new Float64Array(v), qualities: new Uint16Array(q), timestamps: new Float64Array(t) });
+
+// Ad-hoc diagnostics without a group: one IOPCItemIO call by item ID, nothing left on the server
+// const values = await client.readItems(['Channel1.Device1.Tag1', 'Channel1.Device1.Tag2'], 1000);
+// await client.writeItems(['Sim.Setpoint'], { values: new Float64Array([42]) }); client.getItemIdCacheStats();
+
+// Engineering units and ranges for a whole tag list in a few server calls, then served locally
+// client.loadPropertyCache('props.bin'); await client.loadProperties(tagIds, { propertyIds: [100, 102, 103] });
+// client.getProperties(['Tag1'])['Tag1']['100'].value; client.savePropertyCache('props.bin');
+
+// Pre-flight a whole config file: every misspelled tag in one report, known-bad tags skipped on apply
+// const { invalid } = await client.validateItems(config); invalid.forEach(e => console.warn(e.item, e.groups, e.error));
+// client.applyConfig(config);
+
+// Scan all OPC hosts in parallel; dead hosts time out individually, found CLSIDs are kept for later connects
+// client.loadClsidCache('clsids.txt'); const hosts = await client.discoverServers(plantHosts, { concurrency: 8, timeoutMs: 3000 });
+// hosts.filter(h => h.timedOut).forEach(h => console.warn('no answer from', h.host)); client.saveClsidCache('clsids.txt');
+
+// Hot standby: groups and items are registered on the backup too (scanning at 10 s); failover flips activity only
+// await client.enableRedundancy({ host: 'opc-b', progId: 'Kepware.KEPServerEX.V6', standbyRate: 10000, checkMs: 500,
+//   failAfter: 2, livenessMs: 5000, keepAliveMs: 2000 }, ev => console.log(ev.type, ev.data)); client.getRedundancy();
+
+// Server health over time: state, bandwidth and clock skew, with events when something changes
+// client.startStatusPoller({ intervalMs: 5000, skewThresholdMs: 2000 }, ev => console.warn(ev.type, ev.data));
+// const { last, stats } = client.getServerStatus(); console.log(last.state, last.bandwidth, stats.skew.maxMs);
+
+// Legacy server without working callbacks: poll natively, only changes reach the subscribe handler
+// client.createGroup('legacy', 1000, 0); client.subscribe('legacy', onChange);
+// client.pollItems('legacy', fastTags, 250); client.pollItems('legacy', slowTags, 5000); client.getPollStats();
+
 // Unsubscribe example
 // client.unsubscribe('myGroup', ['dataChange']);
 // client.unsubscribeConnection(); // For init tsfn
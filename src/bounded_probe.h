@@ -0,0 +1,137 @@
+#pragma once
+// Runs one blocking probe per target on at most `threads` concurrent workers, each with its own deadline.
+// A blocking call (a DCOM activation against a dead host) cannot be interrupted, so a probe that misses its
+// deadline is reported as timed out and left to finish on its own detached thread; a replacement worker
+// takes over the queue so one dead host cannot starve the rest. Abandoned threads are counted process-wide
+// and capped: past the cap no replacement is started, and targets no worker is left for time out unstarted.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+template <typename R>
+struct ProbeResult {
+  R value{};
+  bool started = false;
+  bool done = false;
+  bool timedOut = false;  // Also set, with started false, for targets never probed (no worker left)
+  double ms = 0.0;  // Until done, or until the deadline for timed-out probes
+};
+
+// Probe threads still stuck in a call that missed its deadline, across all runs
+inline std::atomic<size_t>& AbandonedProbes() {
+  static std::atomic<size_t> count{0};
+  return count;
+}
+
+template <typename R>
+class BoundedProbe {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // probe(i) runs on a worker thread; threadInit/threadExit wrap every worker (COM). Blocks until each probe
+  // has finished or passed its deadline. Results are in target order. Once AbandonedProbes() reaches
+  // maxAbandoned a timed-out worker is not replaced, so threads stay within maxAbandoned + threads.
+  static std::vector<ProbeResult<R>> Run(size_t count, size_t threads, std::chrono::milliseconds deadline,
+                                         std::function<R(size_t)> probe, std::function<void()> threadInit = nullptr,
+                                         std::function<void()> threadExit = nullptr, size_t maxAbandoned = 64) {
+    auto state = std::make_shared<State>();
+    state->results.resize(count);
+    state->startedAt.resize(count);
+    state->probe = std::move(probe);
+    state->threadInit = std::move(threadInit);
+    state->threadExit = std::move(threadExit);
+    size_t workers = std::min(std::max<size_t>(threads, 1), count);
+    std::unique_lock<std::mutex> lock(state->mtx);
+    for (size_t i = 0; i < workers; ++i) Spawn(state);
+
+    for (;;) {
+      auto now = Clock::now();
+      size_t settled = 0;
+      Clock::time_point wake = Clock::time_point::max();
+      for (size_t i = 0; i < count; ++i) {
+        ProbeResult<R>& r = state->results[i];
+        if (r.done || r.timedOut) {
+          ++settled;
+          continue;
+        }
+        if (!r.started) {
+          // Every worker is stuck and the cap allows no replacement: nothing will start this target
+          if (state->live == 0) {
+            r.timedOut = true;
+            ++settled;
+          }
+          continue;
+        }
+        Clock::time_point due = state->startedAt[i] + deadline;
+        if (due <= now) {
+          r.timedOut = true;
+          r.ms = static_cast<double>(deadline.count());
+          ++settled;
+          --state->live;  // The stuck worker no longer counts against the bound
+          if (++AbandonedProbes() < maxAbandoned && state->next < count) Spawn(state);
+        } else {
+          wake = std::min(wake, due);
+        }
+      }
+      if (settled == count) break;
+      if (wake == Clock::time_point::max()) state->cv.wait(lock);
+      else state->cv.wait_until(lock, wake);
+    }
+    state->finished = true;  // Workers still stuck drop their results and exit
+    return state->results;
+  }
+
+private:
+  struct State {
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t next = 0;
+    size_t live = 0;  // Workers that have not been abandoned
+    bool finished = false;
+    std::vector<ProbeResult<R>> results;
+    std::vector<Clock::time_point> startedAt;
+    std::function<R(size_t)> probe;
+    std::function<void()> threadInit;
+    std::function<void()> threadExit;
+  };
+
+  // Caller holds state->mtx. A worker takes targets until the queue is empty or its current probe timed out.
+  static void Spawn(const std::shared_ptr<State>& state) {
+    ++state->live;
+    std::thread([state] {
+      if (state->threadInit) state->threadInit();
+      for (;;) {
+        size_t i;
+        {
+          std::lock_guard<std::mutex> lock(state->mtx);
+          if (state->finished || state->next >= state->results.size()) {
+            --state->live;
+            break;
+          }
+          i = state->next++;
+          state->results[i].started = true;
+          state->startedAt[i] = Clock::now();
+        }
+        state->cv.notify_all();  // Its deadline starts now
+        R value = state->probe(i);
+        std::lock_guard<std::mutex> lock(state->mtx);
+        ProbeResult<R>& r = state->results[i];
+        if (r.timedOut) {
+          --AbandonedProbes();
+          break;
+        }
+        r.value = std::move(value);
+        r.done = true;
+        r.ms = std::chrono::duration<double, std::milli>(Clock::now() - state->startedAt[i]).count();
+        state->cv.notify_all();
+      }
+      if (state->threadExit) state->threadExit();
+    }).detach();
+  }
+};
@@ -0,0 +1,193 @@
+#pragma once
+// Native change records and the bounded per-group history behind changesSince().
+// Kept free of COM/N-API types so the same structures can be reused off Windows.
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Value taken out of a VARIANT at record-build time (numbers stay unboxed)
+struct ChangeValue {
+  enum class Kind : uint8_t { Empty = 0, Number = 1, Boolean = 2, String = 3, Unsupported = 4 };
+  Kind kind = Kind::Empty;
+  double number = 0.0;  // Number and Boolean (0/1)
+  std::string text;     // String only
+
+  bool IsNumeric() const { return kind == Kind::Number || kind == Kind::Boolean; }
+};
+
+// One item change, stamped with the group sequence number when taken from OnDataChange
+struct ChangeRecord {
+  uint64_t seq = 0;
+  uint32_t handle = 0;     // Index into the group's item name table
+  uint64_t timestamp = 0;  // FILETIME ticks (100 ns since 1601-01-01 UTC)
+  uint16_t quality = 0;
+  int32_t error = 0;       // HRESULT from the server for this item
+  ChangeValue value;
+};
+
+// A change as handed over by OnDataChange (or replay), before it is sequenced
+struct IncomingChange {
+  const std::string* item = nullptr;  // Must outlive GroupPipeline::Ingest
+  uint64_t timestamp = 0;
+  uint16_t quality = 0;
+  int32_t error = 0;
+  ChangeValue value;
+};
+
+// FILETIME ticks -> JS Date milliseconds
+inline double FileTimeTicksToJsMs(uint64_t ticks) {
+  const uint64_t kEpochDiff = 116444736000000000ULL;  // 1601 -> 1970 in 100 ns
+  if (ticks < kEpochDiff) return 0.0;
+  return static_cast<double>(ticks - kEpochDiff) / 10000.0;
+}
+
+inline uint64_t JsMsToFileTimeTicks(double ms) {
+  const uint64_t kEpochDiff = 116444736000000000ULL;
+  if (ms <= 0.0) return kEpochDiff;
+  return kEpochDiff + static_cast<uint64_t>(ms * 10000.0);
+}
+
+// Where a change went missing between OnDataChange and the JS handler
+enum class LossKind : uint8_t { Drop = 0, Conflation = 1, Overflow = 2 };
+
+struct LossCounts {
+  uint64_t dropped = 0;
+  uint64_t conflated = 0;
+  uint64_t overflowed = 0;
+
+  void Add(LossKind kind, uint64_t n) {
+    switch (kind) {
+      case LossKind::Drop: dropped += n; break;
+      case LossKind::Conflation: conflated += n; break;
+      case LossKind::Overflow: overflowed += n; break;
+    }
+  }
+};
+
+// Bounded log of loss events keyed by sequence range, so a consumer can ask
+// "what happened between seq A and seq B". Oldest events fall off; totals never do.
+class SequenceLedger {
+public:
+  struct Event {
+    LossKind kind;
+    uint64_t firstSeq;
+    uint64_t lastSeq;
+    uint64_t count;
+  };
+
+  explicit SequenceLedger(size_t capacity = 4096) : events_(capacity ? capacity : 1) {}
+
+  void Note(LossKind kind, uint64_t firstSeq, uint64_t lastSeq, uint64_t count) {
+    if (count == 0) return;
+    std::lock_guard<std::mutex> lock(mtx_);
+    totals_.Add(kind, count);
+    // Extend the newest event when losses of one kind continue it (typical for bursts). Conflation notes older
+    // records out of order; one that starts before the event gets its own, so its seq stays attributed.
+    if (size_ > 0) {
+      Event& last = events_[(head_ + size_ - 1) % events_.size()];
+      if (last.kind == kind && firstSeq >= last.firstSeq && firstSeq <= last.lastSeq + 1) {
+        last.lastSeq = lastSeq > last.lastSeq ? lastSeq : last.lastSeq;
+        last.count += count;
+        return;
+      }
+    }
+    if (size_ == events_.size()) {
+      head_ = (head_ + 1) % events_.size();
+      --size_;
+    }
+    events_[(head_ + size_) % events_.size()] = Event{kind, firstSeq, lastSeq, count};
+    ++size_;
+  }
+
+  // Counts for events overlapping [fromSeq, toSeq]; events are attributed whole
+  LossCounts Summarize(uint64_t fromSeq, uint64_t toSeq, std::vector<Event>* detail = nullptr) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    LossCounts counts;
+    for (size_t i = 0; i < size_; ++i) {
+      const Event& ev = events_[(head_ + i) % events_.size()];
+      if (ev.lastSeq < fromSeq || ev.firstSeq > toSeq) continue;
+      counts.Add(ev.kind, ev.count);
+      if (detail) detail->push_back(ev);
+    }
+    return counts;
+  }
+
+  LossCounts Totals() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return totals_;
+  }
+
+private:
+  mutable std::mutex mtx_;
+  std::vector<Event> events_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+  LossCounts totals_;
+};
+
+// Fixed-capacity ring of the most recent change records of one group
+class ChangeHistory {
+public:
+  explicit ChangeHistory(size_t capacity = 4096) : ring_(capacity ? capacity : 1) {}
+
+  void Reset(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ring_.assign(capacity ? capacity : 1, ChangeRecord());
+    head_ = 0;
+    size_ = 0;
+  }
+
+  void Push(const ChangeRecord& rec) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (size_ == ring_.size()) {
+      ring_[head_] = rec;
+      head_ = (head_ + 1) % ring_.size();
+    } else {
+      ring_[(head_ + size_) % ring_.size()] = rec;
+      ++size_;
+    }
+  }
+
+  // Copies up to maxCount records with seq > afterSeq into out (oldest first).
+  // Returns true if records after afterSeq have already been evicted (gap).
+  bool Since(uint64_t afterSeq, size_t maxCount, std::vector<ChangeRecord>& out) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (size_ == 0) return false;
+    uint64_t oldest = ring_[head_].seq;
+    bool gap = oldest > afterSeq + 1;
+    // Sequence numbers are contiguous inside the ring, so the start index is direct
+    size_t start = 0;
+    if (afterSeq >= oldest) {
+      uint64_t skip = afterSeq - oldest + 1;
+      if (skip >= size_) return false;
+      start = static_cast<size_t>(skip);
+    }
+    for (size_t i = start; i < size_ && out.size() < maxCount; ++i) {
+      out.push_back(ring_[(head_ + i) % ring_.size()]);
+    }
+    return gap;
+  }
+
+  uint64_t OldestSeq() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return size_ ? ring_[head_].seq : 0;
+  }
+
+  uint64_t NewestSeq() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return size_ ? ring_[(head_ + size_ - 1) % ring_.size()].seq : 0;
+  }
+
+  size_t Capacity() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return ring_.size();
+  }
+
+private:
+  mutable std::mutex mtx_;
+  std::vector<ChangeRecord> ring_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
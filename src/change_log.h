@@ -0,0 +1,410 @@
+#pragma once
+// On-disk change log format: segment files made of columnar blocks, one block per recorded batch.
+//
+//   segment = SegmentHeader (64 bytes) + blocks up to header.dataEnd
+//   block   = BlockHeader (32 bytes) + columns, each 8-byte aligned:
+//             u64 seq[n] | u64 timestamp[n] | f64 value[n] | u32 nameId[n] | i32 error[n]
+//             | u16 quality[n] | u8 kind[n] | u32 heapBytes + string heap
+//   String values store their heap offset in value[i]; heap entries are u32 length + UTF-8 bytes.
+//   nameId refers to names.dict in the same directory ("id<TAB>group<TAB>item" per line).
+//
+//   Compressed blocks (flags = kBlockGorilla) replace the columns with length-prefixed sections:
+//   u32 bytes + delta-of-delta seq | ts, XOR values, varint nameIds, RLE errors | qualities | kinds,
+//   then the same string heap.
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "change_history.h"
+#include "gorilla.h"
+
+namespace changelog {
+
+const char kSegmentMagic[8] = {'O', 'P', 'C', 'S', 'E', 'G', 0, 1};
+const uint32_t kBlockMagic = 0x4B4C424F;  // "OBLK"
+const uint32_t kFormatVersion = 1;
+const char kDictionaryFile[] = "names.dict";
+const char kSegmentExt[] = ".opcseg";
+
+struct SegmentHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t headerBytes;
+  uint64_t createdTicks;  // FILETIME ticks
+  uint64_t dataEnd;       // Committed bytes, readers stop here
+  uint64_t blockCount;
+  uint64_t recordCount;
+  uint64_t reserved[2];
+};
+static_assert(sizeof(SegmentHeader) == 64, "segment header layout");
+
+enum BlockFlags : uint32_t { kBlockRaw = 0, kBlockGorilla = 1 };
+
+struct BlockHeader {
+  uint32_t magic;
+  uint32_t count;
+  uint32_t byteLength;    // Whole block including this header
+  uint32_t flags;
+  uint64_t firstSeq;
+  uint64_t receivedTicks; // Local FILETIME ticks when OnDataChange delivered the batch (replay pacing)
+};
+static_assert(sizeof(BlockHeader) == 32, "block header layout");
+
+inline size_t Align8(size_t n) { return (n + 7) & ~static_cast<size_t>(7); }
+
+// Bytes needed to encode records as one raw block
+inline size_t RawBlockSize(const std::vector<ChangeRecord>& records) {
+  size_t n = records.size();
+  size_t heap = 0;
+  for (const ChangeRecord& rec : records) {
+    if (rec.value.kind == ChangeValue::Kind::String) heap += 4 + rec.value.text.size();
+  }
+  return sizeof(BlockHeader) + n * 8 * 3 + Align8(n * 4) * 2 + Align8(n * 2) + Align8(n) + Align8(4 + heap);
+}
+
+// Encodes records into dst (RawBlockSize bytes). nameIds is parallel to records.
+inline size_t EncodeRawBlock(uint8_t* dst, const std::vector<ChangeRecord>& records,
+                             const std::vector<uint32_t>& nameIds, uint64_t receivedTicks) {
+  size_t n = records.size();
+  BlockHeader hdr = {};
+  hdr.magic = kBlockMagic;
+  hdr.count = static_cast<uint32_t>(n);
+  hdr.byteLength = static_cast<uint32_t>(RawBlockSize(records));
+  hdr.flags = kBlockRaw;
+  hdr.firstSeq = n ? records[0].seq : 0;
+  hdr.receivedTicks = receivedTicks;
+  std::memcpy(dst, &hdr, sizeof(hdr));
+
+  uint8_t* p = dst + sizeof(hdr);
+  uint8_t* seqCol = p;      p += n * 8;
+  uint8_t* tsCol = p;       p += n * 8;
+  uint8_t* valCol = p;      p += n * 8;
+  uint8_t* idCol = p;       p += Align8(n * 4);
+  uint8_t* errCol = p;      p += Align8(n * 4);
+  uint8_t* qualCol = p;     p += Align8(n * 2);
+  uint8_t* kindCol = p;     p += Align8(n);
+  uint8_t* heapStart = p + 4;
+  uint32_t heapBytes = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const ChangeRecord& rec = records[i];
+    double value = rec.value.number;
+    if (rec.value.kind == ChangeValue::Kind::String) {
+      value = static_cast<double>(heapBytes);
+      uint32_t len = static_cast<uint32_t>(rec.value.text.size());
+      std::memcpy(heapStart + heapBytes, &len, 4);
+      std::memcpy(heapStart + heapBytes + 4, rec.value.text.data(), len);
+      heapBytes += 4 + len;
+    }
+    uint8_t kind = static_cast<uint8_t>(rec.value.kind);
+    std::memcpy(seqCol + i * 8, &rec.seq, 8);
+    std::memcpy(tsCol + i * 8, &rec.timestamp, 8);
+    std::memcpy(valCol + i * 8, &value, 8);
+    std::memcpy(idCol + i * 4, &nameIds[i], 4);
+    std::memcpy(errCol + i * 4, &rec.error, 4);
+    std::memcpy(qualCol + i * 2, &rec.quality, 2);
+    kindCol[i] = kind;
+  }
+  std::memcpy(p, &heapBytes, 4);
+  return hdr.byteLength;
+}
+
+// Encodes records as one Gorilla-compressed block appended to out
+inline void EncodeGorillaBlock(std::vector<uint8_t>& out, const std::vector<ChangeRecord>& records,
+                               const std::vector<uint32_t>& nameIds, uint64_t receivedTicks) {
+  size_t n = records.size();
+  size_t start = out.size();
+  out.resize(start + sizeof(BlockHeader));
+
+  std::vector<uint8_t> heap;
+  std::vector<uint8_t> section;
+  auto flush = [&out, &section]() {
+    uint32_t len = static_cast<uint32_t>(section.size());
+    const uint8_t* lp = reinterpret_cast<const uint8_t*>(&len);
+    out.insert(out.end(), lp, lp + 4);
+    out.insert(out.end(), section.begin(), section.end());
+    section.clear();
+  };
+  {
+    gorilla::DeltaEncoder enc(section);
+    for (const ChangeRecord& rec : records) enc.Add(static_cast<int64_t>(rec.seq));
+  }
+  flush();
+  {
+    gorilla::DeltaEncoder enc(section);
+    for (const ChangeRecord& rec : records) enc.Add(static_cast<int64_t>(rec.timestamp));
+  }
+  flush();
+  {
+    gorilla::FloatEncoder enc(section);
+    for (const ChangeRecord& rec : records) {
+      double value = rec.value.number;
+      if (rec.value.kind == ChangeValue::Kind::String) {
+        value = static_cast<double>(heap.size());
+        uint32_t len = static_cast<uint32_t>(rec.value.text.size());
+        const uint8_t* lp = reinterpret_cast<const uint8_t*>(&len);
+        heap.insert(heap.end(), lp, lp + 4);
+        heap.insert(heap.end(), rec.value.text.begin(), rec.value.text.end());
+      }
+      enc.Add(value);
+    }
+  }
+  flush();
+  for (size_t i = 0; i < n; ++i) gorilla::PutVarint(section, nameIds[i]);
+  flush();
+  std::vector<uint32_t> errors(n);
+  std::vector<uint16_t> qualities(n);
+  std::vector<uint8_t> kinds(n);
+  for (size_t i = 0; i < n; ++i) {
+    errors[i] = static_cast<uint32_t>(records[i].error);
+    qualities[i] = records[i].quality;
+    kinds[i] = static_cast<uint8_t>(records[i].value.kind);
+  }
+  gorilla::PutRle(section, errors.data(), n);
+  flush();
+  gorilla::PutRle(section, qualities.data(), n);
+  flush();
+  gorilla::PutRle(section, kinds.data(), n);
+  flush();
+  section.swap(heap);
+  flush();
+  out.resize(start + Align8(out.size() - start));
+
+  BlockHeader hdr = {};
+  hdr.magic = kBlockMagic;
+  hdr.count = static_cast<uint32_t>(n);
+  hdr.byteLength = static_cast<uint32_t>(out.size() - start);
+  hdr.flags = kBlockGorilla;
+  hdr.firstSeq = n ? records[0].seq : 0;
+  hdr.receivedTicks = receivedTicks;
+  std::memcpy(out.data() + start, &hdr, sizeof(hdr));
+}
+
+// Column destinations for streaming decode (e.g. straight into typed array storage).
+// Any pointer may be null; string values decode as NaN in `values`, their text goes to `texts`.
+struct ColumnSink {
+  double* seq = nullptr;
+  double* timestampMs = nullptr;
+  uint64_t* timestampTicks = nullptr;  // Exact FILETIME ticks
+  double* values = nullptr;
+  uint16_t* qualities = nullptr;
+  uint32_t* nameIds = nullptr;
+  int32_t* errors = nullptr;
+  uint8_t* kinds = nullptr;
+  std::vector<std::pair<size_t, std::string>>* texts = nullptr;  // (row, text)
+};
+
+inline bool ReadHeapString(const uint8_t* heap, uint32_t heapBytes, double offsetValue, std::string& out) {
+  if (!(offsetValue >= 0.0 && offsetValue <= heapBytes)) return false;  // Also rejects NaN
+  size_t off = static_cast<size_t>(offsetValue);
+  uint32_t len = 0;
+  if (off + 4 > heapBytes) return false;
+  std::memcpy(&len, heap + off, 4);
+  if (off + 4 + len > heapBytes) return false;
+  out.assign(reinterpret_cast<const char*>(heap + off + 4), len);
+  return true;
+}
+
+// Reads the header of the block at src and checks its count against the block size before anything is
+// sized or offset by it: a raw block must hold every column, a compressed one at least a bit per record.
+inline bool ReadBlockHeader(const uint8_t* src, size_t avail, BlockHeader& hdr) {
+  if (avail < sizeof(BlockHeader)) return false;
+  std::memcpy(&hdr, src, sizeof(hdr));
+  if (hdr.magic != kBlockMagic || hdr.byteLength < sizeof(BlockHeader) || hdr.byteLength > avail) return false;
+  uint64_t n = hdr.count;
+  uint64_t body = hdr.byteLength - sizeof(BlockHeader);
+  if (hdr.flags == kBlockRaw) return n * 8 * 3 + Align8(n * 4) * 2 + Align8(n * 2) + Align8(n) + 4 <= body;
+  if (hdr.flags == kBlockGorilla) return n <= body * 8;
+  return false;
+}
+
+// Decodes one block (raw or compressed) into rows [row, row + count) of sink
+inline bool DecodeBlockColumns(const uint8_t* src, size_t avail, ColumnSink& sink, size_t row, BlockHeader* hdrOut = nullptr) {
+  BlockHeader hdr;
+  if (!ReadBlockHeader(src, avail, hdr)) return false;
+  if (hdrOut) *hdrOut = hdr;
+  size_t n = hdr.count;
+  const uint8_t* end = src + hdr.byteLength;
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+
+  if (hdr.flags == kBlockRaw) {
+    const uint8_t* p = src + sizeof(hdr);
+    const uint8_t* seqCol = p;   p += n * 8;
+    const uint8_t* tsCol = p;    p += n * 8;
+    const uint8_t* valCol = p;   p += n * 8;
+    const uint8_t* idCol = p;    p += Align8(n * 4);
+    const uint8_t* errCol = p;   p += Align8(n * 4);
+    const uint8_t* qualCol = p;  p += Align8(n * 2);
+    const uint8_t* kindCol = p;  p += Align8(n);  // ReadBlockHeader checked that the columns fit
+    uint32_t heapBytes = 0;
+    std::memcpy(&heapBytes, p, 4);
+    const uint8_t* heap = p + 4;
+    if (heapBytes > static_cast<size_t>(end - heap)) return false;
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t seq, ts;
+      double value;
+      std::memcpy(&seq, seqCol + i * 8, 8);
+      std::memcpy(&ts, tsCol + i * 8, 8);
+      std::memcpy(&value, valCol + i * 8, 8);
+      bool isText = kindCol[i] == static_cast<uint8_t>(ChangeValue::Kind::String);
+      if (isText && sink.texts) {
+        std::string text;
+        if (!ReadHeapString(heap, heapBytes, value, text)) return false;
+        sink.texts->emplace_back(row + i, std::move(text));
+      }
+      if (sink.seq) sink.seq[row + i] = static_cast<double>(seq);
+      if (sink.timestampMs) sink.timestampMs[row + i] = FileTimeTicksToJsMs(ts);
+      if (sink.timestampTicks) sink.timestampTicks[row + i] = ts;
+      if (sink.values) sink.values[row + i] = isText ? nan : value;
+      if (sink.nameIds) std::memcpy(&sink.nameIds[row + i], idCol + i * 4, 4);
+      if (sink.errors) std::memcpy(&sink.errors[row + i], errCol + i * 4, 4);
+      if (sink.qualities) std::memcpy(&sink.qualities[row + i], qualCol + i * 2, 2);
+      if (sink.kinds) sink.kinds[row + i] = kindCol[i];
+    }
+    return true;
+  }
+
+  if (hdr.flags != kBlockGorilla) return false;
+  const uint8_t* sections[8];
+  uint32_t lengths[8];
+  const uint8_t* p = src + sizeof(hdr);
+  for (int s = 0; s < 8; ++s) {
+    if (end - p < 4) return false;
+    std::memcpy(&lengths[s], p, 4);
+    if (lengths[s] > static_cast<size_t>(end - p - 4)) return false;
+    sections[s] = p + 4;
+    p += 4 + lengths[s];
+  }
+  std::vector<uint8_t> kinds(n);
+  if (!gorilla::GetRle(sections[6], sections[6] + lengths[6], kinds.data(), n)) return false;
+  gorilla::DeltaDecoder seqDec(sections[0], lengths[0]);
+  gorilla::DeltaDecoder tsDec(sections[1], lengths[1]);
+  gorilla::FloatDecoder valDec(sections[2], lengths[2]);
+  const uint8_t* idp = sections[3];
+  for (size_t i = 0; i < n; ++i) {
+    int64_t seq = seqDec.Next();
+    int64_t ts = tsDec.Next();
+    double value = valDec.Next();
+    uint64_t id = 0;
+    if (!gorilla::GetVarint(idp, sections[3] + lengths[3], id)) return false;
+    bool isText = kinds[i] == static_cast<uint8_t>(ChangeValue::Kind::String);
+    if (isText && sink.texts) {
+      std::string text;
+      if (!ReadHeapString(sections[7], lengths[7], value, text)) return false;
+      sink.texts->emplace_back(row + i, std::move(text));
+    }
+    if (sink.seq) sink.seq[row + i] = static_cast<double>(seq);
+    if (sink.timestampMs) sink.timestampMs[row + i] = FileTimeTicksToJsMs(static_cast<uint64_t>(ts));
+    if (sink.timestampTicks) sink.timestampTicks[row + i] = static_cast<uint64_t>(ts);
+    if (sink.values) sink.values[row + i] = isText ? nan : value;
+    if (sink.nameIds) sink.nameIds[row + i] = static_cast<uint32_t>(id);
+    if (sink.kinds) sink.kinds[row + i] = kinds[i];
+  }
+  if (seqDec.Overrun() || tsDec.Overrun() || valDec.Overrun()) return false;
+  if (sink.errors) {
+    std::vector<uint32_t> errors(n);
+    if (!gorilla::GetRle(sections[4], sections[4] + lengths[4], errors.data(), n)) return false;
+    for (size_t i = 0; i < n; ++i) sink.errors[row + i] = static_cast<int32_t>(errors[i]);
+  }
+  if (sink.qualities && !gorilla::GetRle(sections[5], sections[5] + lengths[5], sink.qualities + row, n)) return false;
+  return true;
+}
+
+// A decoded block: records carry nameId in handle
+struct DecodedBlock {
+  uint64_t receivedTicks = 0;
+  std::vector<ChangeRecord> records;
+};
+
+inline bool DecodeBlock(const uint8_t* src, size_t avail, DecodedBlock& out) {
+  BlockHeader hdr;
+  if (!ReadBlockHeader(src, avail, hdr)) return false;
+  size_t n = hdr.count;
+  std::vector<double> seq(n), values(n);
+  std::vector<uint64_t> ts(n);
+  std::vector<uint32_t> ids(n);
+  std::vector<int32_t> errors(n);
+  std::vector<uint16_t> qualities(n);
+  std::vector<uint8_t> kinds(n);
+  std::vector<std::pair<size_t, std::string>> texts;
+  ColumnSink sink;
+  sink.seq = seq.data();
+  sink.timestampTicks = ts.data();
+  sink.values = values.data();
+  sink.nameIds = ids.data();
+  sink.errors = errors.data();
+  sink.qualities = qualities.data();
+  sink.kinds = kinds.data();
+  sink.texts = &texts;
+  if (!DecodeBlockColumns(src, avail, sink, 0)) return false;
+
+  out.receivedTicks = hdr.receivedTicks;
+  out.records.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    ChangeRecord& rec = out.records[i];
+    rec.seq = static_cast<uint64_t>(seq[i]);
+    rec.timestamp = ts[i];
+    rec.handle = ids[i];
+    rec.error = errors[i];
+    rec.quality = qualities[i];
+    rec.value = ChangeValue();
+    rec.value.kind = static_cast<ChangeValue::Kind>(kinds[i]);
+    rec.value.number = values[i];
+  }
+  for (auto& text : texts) {
+    out.records[text.first].value.number = 0.0;
+    out.records[text.first].value.text = std::move(text.second);
+  }
+  return true;
+}
+
+inline bool LoadSegment(const std::string& path, std::vector<uint8_t>& data, SegmentHeader& hdr) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  data.assign((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (data.size() < sizeof(SegmentHeader)) return false;
+  std::memcpy(&hdr, data.data(), sizeof(hdr));
+  if (std::memcmp(hdr.magic, kSegmentMagic, sizeof(kSegmentMagic)) != 0) return false;
+  if (hdr.dataEnd < data.size()) data.resize(static_cast<size_t>(hdr.dataEnd));
+  if (hdr.headerBytes < sizeof(SegmentHeader) || hdr.headerBytes > data.size()) return false;
+  return true;
+}
+
+// Reads every committed block of a segment file (plain reads, no mapping needed)
+inline bool ReadSegment(const std::string& path, std::vector<DecodedBlock>& blocks, SegmentHeader* headerOut = nullptr) {
+  std::vector<uint8_t> data;
+  SegmentHeader hdr;
+  if (!LoadSegment(path, data, hdr)) return false;
+  if (headerOut) *headerOut = hdr;
+  size_t pos = hdr.headerBytes;
+  while (pos + sizeof(BlockHeader) <= data.size()) {
+    DecodedBlock block;
+    BlockHeader bh;
+    if (!ReadBlockHeader(data.data() + pos, data.size() - pos, bh)) return false;
+    if (!DecodeBlock(data.data() + pos, data.size() - pos, block)) return false;
+    blocks.push_back(std::move(block));
+    pos += bh.byteLength;
+  }
+  return true;
+}
+
+// names.dict: nameId -> (group, item)
+inline std::map<uint32_t, std::pair<std::string, std::string>> ReadDictionary(const std::string& dir) {
+  std::map<uint32_t, std::pair<std::string, std::string>> names;
+  std::ifstream in(dir + "/" + kDictionaryFile);
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t t1 = line.find('\t');
+    size_t t2 = t1 == std::string::npos ? std::string::npos : line.find('\t', t1 + 1);
+    if (t2 == std::string::npos) continue;
+    uint32_t id = static_cast<uint32_t>(std::stoul(line.substr(0, t1)));
+    names[id] = std::make_pair(line.substr(t1 + 1, t2 - t1 - 1), line.substr(t2 + 1));
+  }
+  return names;
+}
+
+}  // namespace changelog
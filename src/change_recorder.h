@@ -0,0 +1,241 @@
+#pragma once
+// Background recorder: the change path only queues batches, a dedicated thread encodes them
+// into memory-mapped segment files (see change_log.h) and rotates by size or age.
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "change_log.h"
+#include "mapped_file.h"
+
+struct RecorderOptions {
+  size_t maxSegmentBytes = 64 * 1024 * 1024;
+  uint64_t maxSegmentMs = 10 * 60 * 1000;
+  size_t maxQueueRecords = 1000000;  // Beyond this batches are dropped (and counted), never blocking the producer
+  bool compress = false;             // Gorilla-compressed blocks instead of raw columns
+};
+
+// One OnDataChange batch as handed to the recorder
+struct RecordedBatch {
+  std::string group;
+  uint64_t receivedTicks = 0;
+  std::vector<std::pair<uint32_t, std::string>> newNames;  // handle -> item name, first time seen
+  std::vector<ChangeRecord> records;                       // handle = pipeline handle
+};
+
+struct RecorderStats {
+  uint64_t segments = 0;
+  uint64_t records = 0;
+  uint64_t bytes = 0;
+  uint64_t rawBytes = 0;  // What the same blocks take uncompressed
+  uint64_t droppedRecords = 0;
+  uint64_t queuedRecords = 0;
+  std::string currentSegment;
+};
+
+class ChangeRecorder {
+public:
+  ChangeRecorder(const std::string& dir, const RecorderOptions& opts) : dir_(dir), opts_(opts) {}
+  ChangeRecorder(const ChangeRecorder&) = delete;
+  ChangeRecorder& operator=(const ChangeRecorder&) = delete;
+  ~ChangeRecorder() { Stop(); }
+
+  bool Start() {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    if (ec) return false;
+    LoadDictionary();
+    dict_.open(dir_ + "/" + changelog::kDictionaryFile, std::ios::app);
+    if (!dict_) return false;
+    running_ = true;
+    worker_ = std::thread(&ChangeRecorder::Run, this);
+    return true;
+  }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (!running_) return;
+      running_ = false;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) worker_.join();
+    CloseSegment();
+    dict_.close();
+  }
+
+  // Called from the COM callback thread: O(1) handoff, drops instead of blocking when full
+  void Submit(RecordedBatch&& batch) {
+    size_t n = batch.records.size();
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (!running_) return;
+      if (queuedRecords_ + n > opts_.maxQueueRecords && batch.newNames.empty()) {
+        droppedRecords_ += n;
+        return;
+      }
+      queuedRecords_ += n;
+      queue_.push_back(std::move(batch));
+    }
+    cv_.notify_one();
+  }
+
+  RecorderStats Stats() {
+    RecorderStats st;
+    std::lock_guard<std::mutex> lock(mtx_);
+    st.segments = segments_;
+    st.records = records_;
+    st.bytes = bytes_;
+    st.rawBytes = rawBytes_;
+    st.droppedRecords = droppedRecords_;
+    st.queuedRecords = queuedRecords_;
+    st.currentSegment = currentPath_;
+    return st;
+  }
+
+  const std::string& Dir() const { return dir_; }
+
+private:
+  void Run() {
+    for (;;) {
+      std::deque<RecordedBatch> work;
+      {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait_for(lock, std::chrono::seconds(1), [this] { return !running_ || !queue_.empty(); });
+        work.swap(queue_);
+        if (work.empty() && !running_) return;
+      }
+      for (RecordedBatch& batch : work) WriteBatch(batch);
+      if (segment_.IsOpen() && SegmentAgeMs() >= opts_.maxSegmentMs) CloseSegment();
+      std::lock_guard<std::mutex> lock(mtx_);
+      for (const RecordedBatch& batch : work) queuedRecords_ -= batch.records.size();
+    }
+  }
+
+  void WriteBatch(const RecordedBatch& batch) {
+    std::vector<uint32_t>& ids = groupIds_[batch.group];
+    for (const auto& nm : batch.newNames) {
+      if (nm.first >= ids.size()) ids.resize(nm.first + 1, UINT32_MAX);
+      if (ids[nm.first] != UINT32_MAX) continue;
+      ids[nm.first] = nextNameId_;
+      dict_ << nextNameId_ << '\t' << batch.group << '\t' << nm.second << '\n';
+      ++nextNameId_;
+    }
+    dict_.flush();
+    if (batch.records.empty()) return;
+
+    std::vector<uint32_t> nameIds(batch.records.size());
+    for (size_t i = 0; i < batch.records.size(); ++i) {
+      uint32_t h = batch.records[i].handle;
+      nameIds[i] = h < ids.size() ? ids[h] : UINT32_MAX;
+    }
+    size_t rawSize = changelog::RawBlockSize(batch.records);
+    size_t need = rawSize;
+    if (opts_.compress) {
+      scratch_.clear();
+      changelog::EncodeGorillaBlock(scratch_, batch.records, nameIds, batch.receivedTicks);
+      need = scratch_.size();
+    }
+    if (segment_.IsOpen() && (header_.dataEnd + need > segment_.Size() || SegmentAgeMs() >= opts_.maxSegmentMs)) {
+      CloseSegment();
+    }
+    if (!segment_.IsOpen() && !OpenSegment(need)) {
+      std::lock_guard<std::mutex> lock(mtx_);
+      droppedRecords_ += batch.records.size();
+      return;
+    }
+    size_t written = need;
+    if (opts_.compress) std::memcpy(segment_.Data() + header_.dataEnd, scratch_.data(), need);
+    else changelog::EncodeRawBlock(segment_.Data() + header_.dataEnd, batch.records, nameIds, batch.receivedTicks);
+    header_.dataEnd += written;
+    header_.blockCount += 1;
+    header_.recordCount += batch.records.size();
+    std::memcpy(segment_.Data(), &header_, sizeof(header_));
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    records_ += batch.records.size();
+    bytes_ += written;
+    rawBytes_ += rawSize;
+  }
+
+  bool OpenSegment(size_t minPayload) {
+    uint64_t ticks = NowTicks();
+    char name[80];
+    std::snprintf(name, sizeof(name), "seg-%020llu-%06llu%s", static_cast<unsigned long long>(ticks),
+                  static_cast<unsigned long long>(segments_ % 1000000), changelog::kSegmentExt);
+    std::string path = dir_ + "/" + name;
+    size_t size = sizeof(changelog::SegmentHeader) + minPayload;
+    if (size < opts_.maxSegmentBytes) size = opts_.maxSegmentBytes;
+    if (!segment_.Create(path, size)) return false;
+    std::memset(&header_, 0, sizeof(header_));
+    std::memcpy(header_.magic, changelog::kSegmentMagic, sizeof(header_.magic));
+    header_.version = changelog::kFormatVersion;
+    header_.headerBytes = sizeof(changelog::SegmentHeader);
+    header_.createdTicks = ticks;
+    header_.dataEnd = sizeof(changelog::SegmentHeader);
+    std::memcpy(segment_.Data(), &header_, sizeof(header_));
+    openedAt_ = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mtx_);
+    currentPath_ = path;
+    ++segments_;
+    return true;
+  }
+
+  void CloseSegment() {
+    if (!segment_.IsOpen()) return;
+    segment_.Close(static_cast<size_t>(header_.dataEnd));
+    std::lock_guard<std::mutex> lock(mtx_);
+    currentPath_.clear();
+  }
+
+  uint64_t SegmentAgeMs() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - openedAt_).count());
+  }
+
+  // Continue numbering after whatever an earlier run left in names.dict (handles are per run, ids never reused)
+  void LoadDictionary() {
+    auto names = changelog::ReadDictionary(dir_);
+    if (!names.empty()) nextNameId_ = names.rbegin()->first + 1;
+  }
+
+  static uint64_t NowTicks() {
+    using namespace std::chrono;
+    const uint64_t kEpochDiff = 116444736000000000ULL;
+    return kEpochDiff + static_cast<uint64_t>(duration_cast<microseconds>(system_clock::now().time_since_epoch()).count()) * 10;
+  }
+
+  std::string dir_;
+  RecorderOptions opts_;
+
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  std::deque<RecordedBatch> queue_;
+  bool running_ = false;
+  std::thread worker_;
+  uint64_t queuedRecords_ = 0;
+  uint64_t droppedRecords_ = 0;
+  uint64_t segments_ = 0;
+  uint64_t records_ = 0;
+  uint64_t bytes_ = 0;
+  uint64_t rawBytes_ = 0;
+  std::string currentPath_;
+
+  // Writer-thread state
+  MappedFile segment_;
+  changelog::SegmentHeader header_ = {};
+  std::chrono::steady_clock::time_point openedAt_;
+  std::ofstream dict_;
+  std::vector<uint8_t> scratch_;
+  std::map<std::string, std::vector<uint32_t>> groupIds_;  // group -> pipeline handle -> name id
+  uint32_t nextNameId_ = 0;
+};
@@ -0,0 +1,153 @@
+#pragma once
+// Replays a recorded change log (change_log.h) batch by batch into a sink that takes the
+// place of OnDataChange. Pacing follows the recorded arrival times at 1x, Nx or max speed.
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "change_log.h"
+
+struct ReplayStats {
+  uint64_t segments = 0;
+  uint64_t batches = 0;
+  uint64_t records = 0;
+  uint64_t unknownNames = 0;  // Records whose name id is missing from names.dict (skipped)
+  double durationMs = 0.0;
+  bool stopped = false;
+};
+
+// Stop request and completion of one Run. Stop() also cuts short a paced wait between batches;
+// WaitFinished() lets the owner block until Run has returned and no longer touches the sink.
+class ReplayControl {
+public:
+  void Stop() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stop_ = true;
+    cv_.notify_all();
+  }
+
+  bool Stopped() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return stop_;
+  }
+
+  // Sleeps until t; true if stopped first
+  bool WaitUntil(std::chrono::steady_clock::time_point t) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    return cv_.wait_until(lock, t, [this] { return stop_; });
+  }
+
+  void Finish() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    finished_ = true;
+    cv_.notify_all();
+  }
+
+  void WaitFinished() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_.wait(lock, [this] { return finished_; });
+  }
+
+private:
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+  bool finished_ = false;
+};
+
+class ChangeReplayer {
+public:
+  // group is the recorded group name; receivedTicks the recorded arrival time of the batch
+  using Sink = std::function<void(const std::string& group, std::vector<IncomingChange>& batch, uint64_t receivedTicks)>;
+
+  // speed: 1 = real time, N = N times faster, 0 = as fast as the sink accepts
+  ChangeReplayer(const std::string& dir, double speed) : dir_(dir), speed_(speed) {}
+
+  // Segment files in recording order (names start with the creation timestamp)
+  std::vector<std::string> Segments() const {
+    std::vector<std::string> paths;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir_, ec)) {
+      if (entry.path().extension() == changelog::kSegmentExt) paths.push_back(entry.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+  }
+
+  // Recorded group names, so callers can prepare targets before Run
+  std::vector<std::string> Groups() const {
+    std::vector<std::string> groups;
+    for (const auto& entry : changelog::ReadDictionary(dir_)) {
+      if (std::find(groups.begin(), groups.end(), entry.second.first) == groups.end()) groups.push_back(entry.second.first);
+    }
+    return groups;
+  }
+
+  // The caller marks control finished once Run returns
+  bool Run(const Sink& sink, ReplayControl& control, ReplayStats& stats) const {
+    auto names = changelog::ReadDictionary(dir_);
+    auto started = std::chrono::steady_clock::now();
+    bool haveFirst = false;
+    uint64_t firstTicks = 0;
+
+    for (const std::string& path : Segments()) {
+      std::vector<changelog::DecodedBlock> blocks;
+      if (!changelog::ReadSegment(path, blocks)) return false;
+      ++stats.segments;
+      for (changelog::DecodedBlock& block : blocks) {
+        if (!haveFirst) {
+          firstTicks = block.receivedTicks;
+          haveFirst = true;
+        }
+        bool stopped;
+        if (speed_ > 0.0 && block.receivedTicks > firstTicks) {
+          auto offset = std::chrono::microseconds(static_cast<int64_t>((block.receivedTicks - firstTicks) / 10 / speed_));
+          stopped = control.WaitUntil(started + offset);
+        } else {
+          stopped = control.Stopped();
+        }
+        if (stopped) {
+          stats.stopped = true;
+          Finish(started, stats);
+          return true;
+        }
+        // A recorded batch comes from one group; split defensively anyway
+        std::map<std::string, std::vector<IncomingChange>> byGroup;
+        for (ChangeRecord& rec : block.records) {
+          auto nm = names.find(rec.handle);
+          if (nm == names.end()) {
+            ++stats.unknownNames;
+            continue;
+          }
+          IncomingChange in;
+          in.item = &nm->second.second;
+          in.timestamp = rec.timestamp;
+          in.quality = rec.quality;
+          in.error = rec.error;
+          in.value = std::move(rec.value);
+          byGroup[nm->second.first].push_back(std::move(in));
+        }
+        for (auto& group : byGroup) {
+          stats.records += group.second.size();
+          sink(group.first, group.second, block.receivedTicks);
+        }
+        ++stats.batches;
+      }
+    }
+    Finish(started, stats);
+    return true;
+  }
+
+private:
+  static void Finish(std::chrono::steady_clock::time_point started, ReplayStats& stats) {
+    stats.durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+  }
+
+  std::string dir_;
+  double speed_;
+};
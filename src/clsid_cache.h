@@ -0,0 +1,102 @@
+#pragma once
+// progID -> CLSID per host, as learned from discovery or a successful lookup. Connects use it to skip the
+// remote registry / OpcEnum round trip. Persisted as text, one "host<TAB>progID<TAB>{CLSID}" line per entry.
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+class ClsidCache {
+public:
+  using Key = std::pair<std::string, std::string>;  // host (lower case, "" for local), progID
+
+  static std::string NormalizeHost(const std::string& host) {
+    std::string out;
+    for (char c : host) out += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    return out == "localhost" || out == "127.0.0.1" ? std::string() : out;
+  }
+
+  const std::string* Find(const std::string& host, const std::string& progId) const {
+    auto it = entries_.find(Key(NormalizeHost(host), progId));
+    return it == entries_.end() ? nullptr : &it->second;
+  }
+
+  void Put(const std::string& host, const std::string& progId, const std::string& clsid) {
+    entries_[Key(NormalizeHost(host), progId)] = clsid;
+  }
+
+  bool Erase(const std::string& host, const std::string& progId) {
+    return entries_.erase(Key(NormalizeHost(host), progId)) > 0;
+  }
+
+  // Drops every entry of the host (before storing a fresh discovery result)
+  void EraseHost(const std::string& host) {
+    std::string h = NormalizeHost(host);
+    auto it = entries_.lower_bound(Key(h, std::string()));
+    while (it != entries_.end() && it->first.first == h) it = entries_.erase(it);
+  }
+
+  void Clear() { entries_.clear(); }
+  size_t Size() const { return entries_.size(); }
+  const std::map<Key, std::string>& Entries() const { return entries_; }
+
+  // Written to path + ".tmp" and renamed over path, so a failed save leaves the previous file intact
+  bool Save(const std::string& path) const {
+    std::string tmp = path + ".tmp";
+    {
+      std::ofstream out(tmp, std::ios::trunc);
+      if (!out) return false;
+      for (const auto& pair : entries_) out << pair.first.first << '\t' << pair.first.second << '\t' << pair.second << '\n';
+      out.close();
+      if (!out) {
+        std::remove(tmp.c_str());
+        return false;
+      }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) std::remove(tmp.c_str());
+    return !ec;
+  }
+
+  // Merges the file into the cache (file entries win). False if unreadable or if any non-empty line is not
+  // host<TAB>progID<TAB>{CLSID}; nothing is merged then.
+  bool Load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) return false;
+    std::vector<std::pair<Key, std::string>> parsed;
+    std::string line;
+    while (std::getline(in, line)) {
+      if (!line.empty() && line.back() == '\r') line.pop_back();
+      if (line.empty()) continue;
+      size_t a = line.find('\t');
+      size_t b = a == std::string::npos ? a : line.find('\t', a + 1);
+      if (b == std::string::npos || b == a + 1 || line.find('\t', b + 1) != std::string::npos) return false;
+      std::string clsid = line.substr(b + 1);
+      if (!IsGuid(clsid)) return false;
+      parsed.emplace_back(Key(line.substr(0, a), line.substr(a + 1, b - a - 1)), std::move(clsid));
+    }
+    if (in.bad()) return false;
+    for (const auto& entry : parsed) Put(entry.first.first, entry.first.second, entry.second);
+    return true;
+  }
+
+private:
+  // {xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}
+  static bool IsGuid(const std::string& s) {
+    if (s.size() != 38 || s.front() != '{' || s.back() != '}') return false;
+    for (size_t i = 1; i < 37; ++i) {
+      char c = s[i];
+      bool dash = i == 9 || i == 14 || i == 19 || i == 24;
+      bool hex = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+      if (dash ? c != '-' : !hex) return false;
+    }
+    return true;
+  }
+
+  std::map<Key, std::string> entries_;
+};
@@ -0,0 +1,321 @@
+#pragma once
+// Gorilla-style compression (Pelkonen et al., VLDB 2015) for tag history:
+// delta-of-delta timestamps, XOR-encoded doubles, run-length qualities and varints.
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace gorilla {
+
+class BitWriter {
+public:
+  explicit BitWriter(std::vector<uint8_t>& out) : out_(out) {}
+
+  void Write(uint64_t value, int bits) {
+    while (bits > 0) {
+      if (used_ == 0) out_.push_back(0);
+      int room = 8 - used_;
+      int take = bits < room ? bits : room;
+      uint8_t chunk = static_cast<uint8_t>((value >> (bits - take)) & ((1u << take) - 1));
+      out_.back() |= static_cast<uint8_t>(chunk << (room - take));
+      used_ = (used_ + take) & 7;
+      bits -= take;
+    }
+  }
+
+  void WriteBit(bool bit) { Write(bit ? 1 : 0, 1); }
+
+private:
+  std::vector<uint8_t>& out_;
+  int used_ = 0;  // Bits used in out_.back()
+};
+
+class BitReader {
+public:
+  BitReader(const uint8_t* data, size_t bytes) : data_(data), bits_(bytes * 8) {}
+
+  uint64_t Read(int bits) {
+    uint64_t value = 0;
+    while (bits > 0) {
+      if (pos_ >= bits_) { overrun_ = true; return bits >= 64 ? 0 : value << bits; }
+      int offset = static_cast<int>(pos_ & 7);
+      int room = 8 - offset;
+      int take = bits < room ? bits : room;
+      uint8_t byte = data_[pos_ >> 3];
+      uint64_t chunk = (byte >> (room - take)) & ((1u << take) - 1);
+      value = (value << take) | chunk;
+      pos_ += take;
+      bits -= take;
+    }
+    return value;
+  }
+
+  bool ReadBit() { return Read(1) != 0; }
+  bool Overrun() const { return overrun_; }
+
+private:
+  const uint8_t* data_;
+  size_t bits_;
+  size_t pos_ = 0;
+  bool overrun_ = false;
+};
+
+inline uint64_t ZigZag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+inline int64_t UnZigZag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+// Delta-of-delta integers (timestamps, sequence numbers). Regular series cost one bit per sample.
+// Differences are taken modulo 2^64 so arbitrary (corrupt, extreme) inputs wrap instead of overflowing.
+class DeltaEncoder {
+public:
+  explicit DeltaEncoder(std::vector<uint8_t>& out) : w_(out) {}
+
+  void Add(int64_t v) {
+    if (count_ == 0) {
+      w_.Write(static_cast<uint64_t>(v), 64);
+    } else {
+      int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(v) - static_cast<uint64_t>(prev_));
+      uint64_t dod = ZigZag(static_cast<int64_t>(static_cast<uint64_t>(delta) - static_cast<uint64_t>(prevDelta_)));
+      if (dod == 0) {
+        w_.Write(0, 1);
+      } else if (dod < (1ull << 7)) {
+        w_.Write(0x2, 2); w_.Write(dod, 7);
+      } else if (dod < (1ull << 9)) {
+        w_.Write(0x6, 3); w_.Write(dod, 9);
+      } else if (dod < (1ull << 12)) {
+        w_.Write(0xE, 4); w_.Write(dod, 12);
+      } else if (dod < (1ull << 32)) {
+        w_.Write(0x1E, 5); w_.Write(dod, 32);
+      } else {
+        w_.Write(0x1F, 5); w_.Write(dod, 64);
+      }
+      prevDelta_ = delta;
+    }
+    prev_ = v;
+    ++count_;
+  }
+
+private:
+  BitWriter w_;
+  int64_t prev_ = 0;
+  int64_t prevDelta_ = 0;
+  size_t count_ = 0;
+};
+
+class DeltaDecoder {
+public:
+  DeltaDecoder(const uint8_t* data, size_t bytes) : r_(data, bytes) {}
+
+  int64_t Next() {
+    if (count_++ == 0) {
+      prev_ = static_cast<int64_t>(r_.Read(64));
+      return prev_;
+    }
+    uint64_t dod = 0;
+    if (!r_.ReadBit()) dod = 0;
+    else if (!r_.ReadBit()) dod = r_.Read(7);
+    else if (!r_.ReadBit()) dod = r_.Read(9);
+    else if (!r_.ReadBit()) dod = r_.Read(12);
+    else if (!r_.ReadBit()) dod = r_.Read(32);
+    else dod = r_.Read(64);
+    prevDelta_ = static_cast<int64_t>(static_cast<uint64_t>(prevDelta_) + static_cast<uint64_t>(UnZigZag(dod)));
+    prev_ = static_cast<int64_t>(static_cast<uint64_t>(prev_) + static_cast<uint64_t>(prevDelta_));
+    return prev_;
+  }
+
+  bool Overrun() const { return r_.Overrun(); }
+
+private:
+  BitReader r_;
+  int64_t prev_ = 0;
+  int64_t prevDelta_ = 0;
+  size_t count_ = 0;
+};
+
+// v != 0
+inline int Clz64(uint64_t v) {
+#if defined(_MSC_VER)
+  unsigned long idx;
+  _BitScanReverse64(&idx, v);
+  return 63 - static_cast<int>(idx);
+#else
+  return __builtin_clzll(v);
+#endif
+}
+
+inline int Ctz64(uint64_t v) {
+#if defined(_MSC_VER)
+  unsigned long idx;
+  _BitScanForward64(&idx, v);
+  return static_cast<int>(idx);
+#else
+  return __builtin_ctzll(v);
+#endif
+}
+
+// XOR floating point encoding: unchanged values cost one bit, slowly moving ones a few
+class FloatEncoder {
+public:
+  explicit FloatEncoder(std::vector<uint8_t>& out) : w_(out) {}
+
+  void Add(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, 8);
+    if (count_++ == 0) {
+      w_.Write(bits, 64);
+      prev_ = bits;
+      return;
+    }
+    uint64_t x = bits ^ prev_;
+    prev_ = bits;
+    if (x == 0) {
+      w_.Write(0, 1);
+      return;
+    }
+    int lead = Clz64(x);
+    int trail = Ctz64(x);
+    if (lead > 31) lead = 31;
+    if (window_ && lead >= lead_ && trail >= trail_) {
+      w_.Write(0x2, 2);
+      w_.Write(x >> trail_, 64 - lead_ - trail_);
+      return;
+    }
+    int meaningful = 64 - lead - trail;
+    w_.Write(0x3, 2);
+    w_.Write(static_cast<uint64_t>(lead), 5);
+    w_.Write(static_cast<uint64_t>(meaningful & 63), 6);  // 64 is stored as 0
+    w_.Write(x >> trail, meaningful);
+    lead_ = lead;
+    trail_ = trail;
+    window_ = true;
+  }
+
+private:
+  BitWriter w_;
+  uint64_t prev_ = 0;
+  int lead_ = 0;
+  int trail_ = 0;
+  bool window_ = false;
+  size_t count_ = 0;
+};
+
+class FloatDecoder {
+public:
+  FloatDecoder(const uint8_t* data, size_t bytes) : r_(data, bytes) {}
+
+  double Next() {
+    if (count_++ == 0) {
+      prev_ = r_.Read(64);
+    } else if (r_.ReadBit()) {
+      if (r_.ReadBit()) {
+        lead_ = static_cast<int>(r_.Read(5));
+        int meaningful = static_cast<int>(r_.Read(6));
+        if (meaningful == 0) meaningful = 64;
+        trail_ = 64 - lead_ - meaningful;
+      }
+      int meaningful = 64 - lead_ - trail_;
+      prev_ ^= r_.Read(meaningful) << trail_;
+    }
+    double value;
+    std::memcpy(&value, &prev_, 8);
+    return value;
+  }
+
+  bool Overrun() const { return r_.Overrun(); }
+
+private:
+  BitReader r_;
+  uint64_t prev_ = 0;
+  int lead_ = 0;
+  int trail_ = 0;
+  size_t count_ = 0;
+};
+
+inline void PutVarint(std::vector<uint8_t>& out, uint64_t v) {
+  while (v >= 0x80) {
+    out.push_back(static_cast<uint8_t>(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(v));
+}
+
+inline bool GetVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+  v = 0;
+  for (int shift = 0; p < end && shift < 64; shift += 7) {
+    uint8_t b = *p++;
+    v |= static_cast<uint64_t>(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+// Run-length encoding as (value, run) varint pairs; qualities and errors rarely change
+template <typename T>
+inline void PutRle(std::vector<uint8_t>& out, const T* values, size_t n) {
+  size_t i = 0;
+  while (i < n) {
+    size_t run = 1;
+    while (i + run < n && values[i + run] == values[i]) ++run;
+    PutVarint(out, static_cast<uint64_t>(values[i]));
+    PutVarint(out, run);
+    i += run;
+  }
+}
+
+template <typename T>
+inline bool GetRle(const uint8_t* p, const uint8_t* end, T* values, size_t n) {
+  size_t i = 0;
+  while (i < n) {
+    uint64_t v, run;
+    if (!GetVarint(p, end, v) || !GetVarint(p, end, run) || run == 0 || i + run > n) return false;
+    for (size_t k = 0; k < run; ++k) values[i + k] = static_cast<T>(v);
+    i += run;
+  }
+  return true;
+}
+
+// Sealed block of one item's history: (timestamp, value, quality) columns compressed separately
+struct SeriesBlock {
+  uint32_t count = 0;
+  double minTsMs = 0.0;    // Timestamp range of the block (samples need not be in timestamp order)
+  double maxTsMs = 0.0;
+  std::vector<uint8_t> ts;
+  std::vector<uint8_t> values;
+  std::vector<uint8_t> qualities;
+
+  size_t Bytes() const { return ts.size() + values.size() + qualities.size() + sizeof(*this); }
+};
+
+// Timestamps are kept as 100 ns units since 1970 inside the block
+inline void EncodeSeriesBlock(const double* tsMs, const double* values, const uint16_t* qualities, size_t n, SeriesBlock& out) {
+  out = SeriesBlock();
+  out.count = static_cast<uint32_t>(n);
+  if (n == 0) return;
+  out.minTsMs = out.maxTsMs = tsMs[0];
+  DeltaEncoder te(out.ts);
+  FloatEncoder ve(out.values);
+  for (size_t i = 0; i < n; ++i) {
+    out.minTsMs = std::min(out.minTsMs, tsMs[i]);
+    out.maxTsMs = std::max(out.maxTsMs, tsMs[i]);
+    te.Add(static_cast<int64_t>(tsMs[i] * 10000.0 + (tsMs[i] >= 0 ? 0.5 : -0.5)));
+    ve.Add(values[i]);
+  }
+  PutRle(out.qualities, qualities, n);
+}
+
+inline bool DecodeSeriesBlock(const SeriesBlock& block, double* tsMs, double* values, uint16_t* qualities) {
+  DeltaDecoder td(block.ts.data(), block.ts.size());
+  FloatDecoder vd(block.values.data(), block.values.size());
+  for (uint32_t i = 0; i < block.count; ++i) {
+    tsMs[i] = static_cast<double>(td.Next()) / 10000.0;
+    values[i] = vd.Next();
+  }
+  if (td.Overrun() || vd.Overrun()) return false;
+  return GetRle(block.qualities.data(), block.qualities.data() + block.qualities.size(), qualities, block.count);
+}
+
+}  // namespace gorilla
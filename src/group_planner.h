@@ -0,0 +1,98 @@
+#pragma once
+// Partitions a tag list into server groups: bucket by update rate, cap items per group, spread
+// each bucket evenly. Rebalancing splits groups whose measured callbacks grew too large.
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct PlannerOptions {
+  size_t maxItemsPerGroup = 1000;
+  size_t maxCallbackItems = 500;  // Average OnDataChange size that triggers a split
+  std::vector<uint32_t> rateBuckets = {100, 250, 500, 1000, 2000, 5000, 10000, 30000, 60000};
+  std::string prefix = "plan";
+};
+
+struct PlannedGroup {
+  std::string name;
+  uint32_t rateMs = 0;
+  std::vector<std::string> items;
+};
+
+// Observed OnDataChange sizes of one group
+struct CallbackSizeStats {
+  uint64_t callbacks = 0;
+  uint64_t items = 0;
+  uint64_t maxItems = 0;
+  double Average() const { return callbacks ? static_cast<double>(items) / callbacks : 0.0; }
+};
+
+// Fastest bucket that is not slower than desired; tags faster than every bucket get the fastest
+inline uint32_t BucketRate(uint32_t desiredMs, const std::vector<uint32_t>& sortedBuckets) {
+  if (sortedBuckets.empty()) return desiredMs;
+  uint32_t rate = sortedBuckets.front();
+  for (uint32_t b : sortedBuckets) {
+    if (b <= desiredMs) rate = b;
+  }
+  return rate;
+}
+
+inline std::string PlannedGroupName(const std::string& prefix, uint32_t rateMs, uint32_t index) {
+  return prefix + "_" + std::to_string(rateMs) + "ms_" + std::to_string(index);
+}
+
+// tags: (name, desired rate ms). nextIndex keeps generated names unique across plan and rebalance.
+inline std::vector<PlannedGroup> PlanGroups(const std::vector<std::pair<std::string, uint32_t>>& tags,
+                                            PlannerOptions opts, uint32_t& nextIndex) {
+  std::sort(opts.rateBuckets.begin(), opts.rateBuckets.end());
+  size_t cap = std::max<size_t>(1, opts.maxItemsPerGroup);
+  std::map<uint32_t, std::vector<std::string>> byRate;
+  for (const auto& tag : tags) byRate[BucketRate(tag.second, opts.rateBuckets)].push_back(tag.first);
+
+  std::vector<PlannedGroup> plan;
+  for (auto& bucket : byRate) {
+    std::vector<std::string>& names = bucket.second;
+    std::sort(names.begin(), names.end());  // Neighbouring addresses usually share a device scan
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    size_t groupCount = (names.size() + cap - 1) / cap;
+    size_t base = names.size() / groupCount, extra = names.size() % groupCount;
+    size_t pos = 0;
+    for (size_t g = 0; g < groupCount; ++g) {
+      size_t n = base + (g < extra ? 1 : 0);  // Sizes differ by at most one
+      PlannedGroup group;
+      group.name = PlannedGroupName(opts.prefix, bucket.first, nextIndex++);
+      group.rateMs = bucket.first;
+      group.items.assign(names.begin() + pos, names.begin() + pos + n);
+      pos += n;
+      plan.push_back(std::move(group));
+    }
+  }
+  return plan;
+}
+
+// Items to move out of `group` into new groups of the same rate, or nothing if it is within limits.
+// The group keeps its first share so most items never move.
+inline std::vector<PlannedGroup> SplitGroup(const PlannedGroup& group, const CallbackSizeStats& observed,
+                                            const PlannerOptions& opts, uint32_t& nextIndex) {
+  size_t cap = std::max<size_t>(1, opts.maxItemsPerGroup);
+  size_t maxCb = std::max<size_t>(1, opts.maxCallbackItems);
+  size_t bySize = (group.items.size() + cap - 1) / cap;
+  size_t byCallbacks = static_cast<size_t>(observed.Average() / maxCb) + 1;
+  size_t parts = std::min(group.items.size(), std::max(bySize, byCallbacks));
+  std::vector<PlannedGroup> moved;
+  if (parts < 2) return moved;
+  size_t base = group.items.size() / parts, extra = group.items.size() % parts;
+  size_t pos = base + (extra > 0 ? 1 : 0);
+  for (size_t p = 1; p < parts; ++p) {
+    size_t n = base + (p < extra ? 1 : 0);
+    PlannedGroup part;
+    part.name = PlannedGroupName(opts.prefix, group.rateMs, nextIndex++);
+    part.rateMs = group.rateMs;
+    part.items.assign(group.items.begin() + pos, group.items.begin() + pos + n);
+    pos += n;
+    moved.push_back(std::move(part));
+  }
+  return moved;
+}
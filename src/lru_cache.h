@@ -0,0 +1,98 @@
+#pragma once
+// Bounded least-recently-used map with optional per-entry expiry. Not synchronized: the owner locks.
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+template <typename K, typename V>
+class LruCache {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit LruCache(size_t capacity = 4096) : capacity_(capacity ? capacity : 1) {}
+
+  void SetCapacity(size_t capacity) {
+    capacity_ = capacity ? capacity : 1;
+    Trim();
+  }
+
+  // nullptr when absent or expired (an expired entry is dropped); a hit becomes most recent
+  V* Get(const K& key, Clock::time_point now = Clock::now()) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      ++misses_;
+      return nullptr;
+    }
+    if (it->second->expires <= now) {
+      order_.erase(it->second);
+      index_.erase(it);
+      ++misses_;
+      return nullptr;
+    }
+    order_.splice(order_.begin(), order_, it->second);
+    ++hits_;
+    return &it->second->value;
+  }
+
+  void Put(const K& key, V value, Clock::time_point expires = Clock::time_point::max()) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      it->second->value = std::move(value);
+      it->second->expires = expires;
+      order_.splice(order_.begin(), order_, it->second);
+      return;
+    }
+    order_.push_front(Entry{key, std::move(value), expires});
+    index_.emplace(key, order_.begin());
+    Trim();
+  }
+
+  bool Erase(const K& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) return false;
+    order_.erase(it->second);
+    index_.erase(it);
+    return true;
+  }
+
+  void Clear() {
+    order_.clear();
+    index_.clear();
+  }
+
+  // Most recent first; expired entries included
+  template <typename F>
+  void ForEach(F&& fn) const {
+    for (const Entry& e : order_) fn(e.key, e.value, e.expires);
+  }
+
+  size_t Size() const { return index_.size(); }
+  size_t Capacity() const { return capacity_; }
+  uint64_t Hits() const { return hits_; }
+  uint64_t Misses() const { return misses_; }
+  uint64_t Evictions() const { return evictions_; }
+
+private:
+  struct Entry {
+    K key;
+    V value;
+    Clock::time_point expires;
+  };
+
+  void Trim() {
+    while (index_.size() > capacity_) {
+      index_.erase(order_.back().key);
+      order_.pop_back();
+      ++evictions_;
+    }
+  }
+
+  size_t capacity_;
+  std::list<Entry> order_;
+  std::unordered_map<K, typename std::list<Entry>::iterator> index_;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+  uint64_t evictions_ = 0;
+};
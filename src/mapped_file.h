@@ -0,0 +1,85 @@
+#pragma once
+// Minimal read/write file mapping used by the change log segments
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+class MappedFile {
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile() { Close(0); }
+
+  // Creates (truncates) path with `size` bytes and maps it writable
+  bool Create(const std::string& path, size_t size) {
+    Close(0);
+#ifdef _WIN32
+    file_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER li;
+    li.QuadPart = static_cast<LONGLONG>(size);
+    map_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE, li.HighPart, li.LowPart, nullptr);
+    if (!map_) { CloseHandle(file_); file_ = INVALID_HANDLE_VALUE; return false; }
+    data_ = static_cast<uint8_t*>(MapViewOfFile(map_, FILE_MAP_WRITE, 0, 0, size));
+    if (!data_) { CloseHandle(map_); CloseHandle(file_); map_ = nullptr; file_ = INVALID_HANDLE_VALUE; return false; }
+#else
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) return false;
+    if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) { ::close(fd_); fd_ = -1; return false; }
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) { ::close(fd_); fd_ = -1; return false; }
+    data_ = static_cast<uint8_t*>(p);
+#endif
+    size_ = size;
+    return true;
+  }
+
+  // Unmaps and trims the file to `keepBytes` (0 keeps the mapped size)
+  void Close(size_t keepBytes) {
+    if (!data_) return;
+#ifdef _WIN32
+    FlushViewOfFile(data_, 0);
+    UnmapViewOfFile(data_);
+    CloseHandle(map_);
+    if (keepBytes) {
+      LARGE_INTEGER li;
+      li.QuadPart = static_cast<LONGLONG>(keepBytes);
+      SetFilePointerEx(file_, li, nullptr, FILE_BEGIN);
+      SetEndOfFile(file_);
+    }
+    CloseHandle(file_);
+    map_ = nullptr;
+    file_ = INVALID_HANDLE_VALUE;
+#else
+    ::msync(data_, size_, MS_ASYNC);
+    ::munmap(data_, size_);
+    if (keepBytes) (void)::ftruncate(fd_, static_cast<off_t>(keepBytes));
+    ::close(fd_);
+    fd_ = -1;
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  uint8_t* Data() const { return data_; }
+  size_t Size() const { return size_; }
+  bool IsOpen() const { return data_ != nullptr; }
+
+private:
+  uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+#ifdef _WIN32
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE map_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+};
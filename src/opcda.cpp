@@ -4,9 +4,39 @@
 #include <string>
 #include <vector>
 #include <algorithm>  // Для std::find
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <set>
+#include <iterator>
+#include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
 #include <windows.h>  // For rpc.h, ole2.h if not pulled by opcda.h
 #include <objbase.h>  // COM init
 #include "OPCClientToolKit.h"  // Assume: COPCClient, COPCGroup, OnDisconnectCb, etc.
+#include "change_history.h"
+#include "tag_series.h"
+#include "change_recorder.h"
+#include "change_replay.h"
+#include "spill_queue.h"
+#include "pipeline_metrics.h"
+#include "stall_watchdog.h"
+#include "value_table.h"
+#include "group_planner.h"
+#include "rate_controller.h"
+#include "view_set.h"
+#include "lru_cache.h"
+#include "property_cache.h"
+#include "bounded_probe.h"
+#include "clsid_cache.h"
+#include "redundancy.h"
+#include "status_monitor.h"
+#include "poll_scheduler.h"
+#include "task_thread.h"
 
 using Napi::CallbackInfo;
 using Napi::Env;
@@ -24,9 +54,611 @@ using Napi::ObjectWrap;
 Napi::Value VariantToNapi(const Napi::Env& env, VARIANT* var);
 void EmitEvent(napi_threadsafe_function tsfn, const std::string& type, const Napi::Object& dataObj, Env env);
 
+// Per-subscribe delivery options (4th arg of subscribe)
+struct DeliveryOptions {
+  size_t maxPending = 10000;  // Records waiting for the JS thread before the oldest are overflowed
+  bool conflate = false;      // Keep only the newest pending change per item
+  // storeAndForward: records go through a disk-backed queue and leave it only when acked
+  std::string spillDir;
+  size_t spillMemoryRecords = 100000;
+  size_t ackWindow = 1000;    // Delivered but unacked records
+  uint32_t maxRedeliveries = 5;  // A record whose handler throws this many more times is dropped
+};
+
+// Consumer-side fan-out target (subscribeShared): touched on the JS thread only
+struct FanoutSubscriber {
+  uint32_t id = 0;
+  Napi::FunctionReference fn;
+  bool all = true;                       // No item filter
+  std::unordered_set<std::string> items;
+  std::vector<uint8_t> match;            // handle -> 0 not looked up, 1 match, 2 no match
+
+  bool Matches(uint32_t handle, const std::string& itemName) {
+    if (all) return true;
+    if (handle >= match.size()) match.resize(handle + 1, 0);
+    if (!match[handle]) match[handle] = items.count(itemName) ? 1 : 2;
+    return match[handle] == 1;
+  }
+};
+
+const HRESULT kOpcUnknownItemId = static_cast<HRESULT>(0xC0040007L);  // OPC_E_UNKNOWNITEMID (opcerror.h is not vendored)
+const HRESULT kOpcInvalidItemId = static_cast<HRESULT>(0xC0040008L);  // OPC_E_INVALIDITEMID
+
+inline bool IsBadItemId(HRESULT hr) { return hr == kOpcUnknownItemId || hr == kOpcInvalidItemId; }
+
+std::string WideToUtf8(const wchar_t* wide, int len = -1);
+std::wstring Utf8ToWide(const std::string& s);
+ChangeValue VariantToChangeValue(const VARIANT& var);
+Napi::Value ChangeValueToNapi(const Napi::Env& env, const ChangeValue& v);
+Napi::Object ChangeToNapi(const Napi::Env& env, const ChangeRecord& rec, const std::string& itemName);
+
+// Per-group change path: OnDataChange -> sequenced records -> history ring + pending batch -> group tsfn.
+// Every record gets its seq here, so anything lost later shows up as a hole in the ledger.
+class GroupPipeline : public IAsynchDataCallback {
+  std::string name_;
+  std::mutex mtx_;
+  uint64_t nextSeq_ = 0;
+  std::map<std::string, uint32_t> handles_;  // item name -> handle
+  std::vector<std::string> names_;           // handle -> item name
+
+  std::deque<ChangeRecord> pending_;         // seq == 0 marks a conflated (skipped) slot
+  std::unordered_map<uint32_t, uint64_t> pendingIndex_;  // handle -> absolute pending position
+  uint64_t pendingBase_ = 0;                 // absolute position of pending_.front()
+  bool scheduled_ = false;
+  napi_threadsafe_function tsfn_ = nullptr;  // Not owned (lives in OPCDA::tsfns)
+  napi_threadsafe_function fanoutTsfn_ = nullptr;  // Not owned; carries deliveries while tsfn_ is not set
+  std::vector<std::shared_ptr<FanoutSubscriber>> subscribers_;  // JS thread only
+  uint64_t conversions_ = 0;                 // JS thread: events built
+  uint64_t fanoutCalls_ = 0;                 // JS thread: subscriber handler calls
+  std::atomic<uint64_t> handlerNs_{0};       // Time spent delivering batches on the JS thread (rate control)
+  std::atomic<uint64_t> handled_{0};         // Records delivered
+  std::atomic<COPCGroup*> source_{nullptr};  // Redundancy: only this group's callbacks are taken (nullptr: any)
+  std::atomic<uint64_t> lastCallbackNs_{0};  // Last callback taken from the source (liveness)
+  DeliveryOptions opts_;
+
+  ChangeHistory history_;
+  SequenceLedger ledger_;
+  std::shared_ptr<SeriesStore> series_;      // Optional per-item time-series rings
+  std::shared_ptr<ChangeRecorder> recorder_; // Optional on-disk change log
+  uint32_t recordedNames_ = 0;               // Handles already announced to recorder_
+
+  PipelineMetrics& metrics_;                 // Owned by OPCDA
+  StallWatchdog& watchdog_;                  // Owned by OPCDA
+  uint64_t dispatchStartNs_ = 0;             // When the queued tsfn call was made (metrics or watchdog on)
+
+  CallbackSizeStats callbackSizes_;          // Batch sizes seen by Ingest (drives plan rebalancing)
+  std::shared_ptr<ValueTable> table_;        // Optional shared live value table
+  std::vector<int64_t> tableSlots_;          // handle -> table slot (-1 none, -2 not looked up yet)
+
+  std::unique_ptr<SpillQueue> spill_;        // Store-and-forward mode when set
+  std::deque<ChangeRecord> inflight_;        // Taken from spill_, not acked yet (oldest first)
+  size_t inflightSent_ = 0;                  // Leading part of inflight_ already handed to the tsfn
+  uint64_t lastAcked_ = 0;
+  uint64_t failedSeq_ = 0;                   // Forwarded record whose handler threw last, and how often in a row
+  uint32_t failedCount_ = 0;
+
+  uint32_t HandleFor(const std::string& itemName) {
+    auto it = handles_.find(itemName);
+    if (it != handles_.end()) return it->second;
+    uint32_t handle = static_cast<uint32_t>(names_.size());
+    names_.push_back(itemName);
+    handles_[itemName] = handle;
+    return handle;
+  }
+
+  // Caller holds mtx_
+  void Enqueue(ChangeRecord&& rec) {
+    if (spill_) {
+      spill_->Push(std::move(rec));  // No conflation or overflow: the queue spills instead
+      return;
+    }
+    if (opts_.conflate) {
+      auto idx = pendingIndex_.find(rec.handle);
+      if (idx != pendingIndex_.end() && idx->second >= pendingBase_) {
+        ChangeRecord& older = pending_[static_cast<size_t>(idx->second - pendingBase_)];
+        if (older.seq != 0) {
+          ledger_.Note(LossKind::Conflation, older.seq, older.seq, 1);
+          older.seq = 0;
+        }
+      }
+      pendingIndex_[rec.handle] = pendingBase_ + pending_.size();
+    }
+    pending_.push_back(std::move(rec));
+    while (pending_.size() > opts_.maxPending) {
+      const ChangeRecord& oldest = pending_.front();
+      if (oldest.seq != 0) ledger_.Note(LossKind::Overflow, oldest.seq, oldest.seq, 1);
+      pending_.pop_front();
+      ++pendingBase_;
+    }
+  }
+
+  // Caller holds mtx_
+  void DropPending() {
+    if (spill_) {
+      // Everything pending is still in inflight_ and goes out again on the next Schedule
+      pending_.clear();
+      inflightSent_ = 0;
+      return;
+    }
+    for (const ChangeRecord& rec : pending_) {
+      if (rec.seq != 0) ledger_.Note(LossKind::Drop, rec.seq, rec.seq, 1);
+    }
+    pendingBase_ += pending_.size();
+    pending_.clear();
+    pendingIndex_.clear();
+  }
+
+  // Caller holds mtx_. At most one delivery is queued per group; it takes whatever is pending.
+  void Schedule() {
+    napi_threadsafe_function tsfn = ActiveTsfn();
+    if (spill_ && tsfn && !scheduled_) TopUpInflight();
+    if (!tsfn || scheduled_ || pending_.empty()) return;
+    scheduled_ = true;
+    if (metrics_.Enabled() || watchdog_.Enabled()) dispatchStartNs_ = MonotonicNs();
+    napi_status status = napi_call_threadsafe_function(tsfn, this, napi_tsfn_nonblocking);
+    if (status == napi_queue_full) {
+      scheduled_ = false;  // Stays pending: retried when a queued call drains (DeliverChanges), by the spill writer or on the next OnDataChange
+    } else if (status != napi_ok) {
+      scheduled_ = false;
+      DropPending();  // tsfn closing
+    }
+  }
+
+  // Caller holds mtx_. A plain subscribe callback takes precedence; fan-out subscribers ride along on it.
+  napi_threadsafe_function ActiveTsfn() const { return tsfn_ ? tsfn_ : fanoutTsfn_; }
+
+  // Caller holds mtx_. Refills the ack window from spill_ and queues whatever has not been sent yet.
+  void TopUpInflight() {
+    if (inflight_.size() < opts_.ackWindow) {
+      std::vector<ChangeRecord> more;
+      spill_->Pop(opts_.ackWindow - inflight_.size(), more);
+      for (ChangeRecord& rec : more) inflight_.push_back(std::move(rec));
+    }
+    for (; inflightSent_ < inflight_.size(); ++inflightSent_) pending_.push_back(inflight_[inflightSent_]);
+  }
+
+  // Writer thread of spill_ (a block reached disk or was read back, which may be what a stalled drain
+  // waits for) or a drained tsfn call
+  void Kick() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Schedule();
+  }
+
+  // Caller holds mtx_. Unacked records leaving store-and-forward mode are lost.
+  void DropForwarded() {
+    for (const ChangeRecord& rec : inflight_) ledger_.Note(LossKind::Drop, rec.seq, rec.seq, 1);
+    inflight_.clear();
+    inflightSent_ = 0;
+    std::vector<ChangeRecord> rest;
+    do {
+      rest.clear();
+      spill_->Pop(4096, rest);
+      for (const ChangeRecord& rec : rest) ledger_.Note(LossKind::Drop, rec.seq, rec.seq, 1);
+    } while (!rest.empty());
+    // Still on disk (not read back here): the newest records, in sequence order
+    uint64_t left = spill_->Discard();
+    if (left) ledger_.Note(LossKind::Drop, nextSeq_ - left + 1, nextSeq_, left);
+  }
+
+public:
+  GroupPipeline(const std::string& name, PipelineMetrics& metrics, StallWatchdog& watchdog)
+      : name_(name), metrics_(metrics), watchdog_(watchdog) {}
+
+  // The spill writer calls Kick(), which touches inflight_ and pending_: it is joined before any member goes
+  ~GroupPipeline() {
+    if (spill_) spill_->Close();
+  }
+
+  const std::string& Name() const { return name_; }
+
+  // False if the store-and-forward directory cannot be used
+  bool Attach(napi_threadsafe_function tsfn, const DeliveryOptions& opts) {
+    std::unique_ptr<SpillQueue> closing;  // Closed outside mtx_: its writer thread may be waiting in Kick()
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (!opts.spillDir.empty() && !spill_) {
+        SpillOptions so;
+        so.dir = opts.spillDir;
+        so.memoryRecords = opts.spillMemoryRecords;
+        auto spill = std::make_unique<SpillQueue>(so);
+        spill->SetOnReady([this] { Kick(); });
+        if (!spill->Open()) return false;
+        spill_ = std::move(spill);
+      } else if (opts.spillDir.empty() && spill_) {
+        DropForwarded();
+        closing = std::move(spill_);
+      }
+      tsfn_ = tsfn;
+      opts_ = opts;
+      opts_.ackWindow = std::max<size_t>(1, opts_.ackWindow);
+      Schedule();  // Resubscribe: redeliver what was unacked
+    }
+    return true;
+  }
+
+  // Must be called before the group tsfn is released.
+  // In store-and-forward mode nothing is dropped: unacked records wait for the next subscribe.
+  void Detach() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    tsfn_ = nullptr;
+    scheduled_ = false;
+    if (fanoutTsfn_) Schedule();  // Shared subscribers keep receiving
+    else DropPending();
+  }
+
+  // Fan-out tsfn (no JS function of its own); nullptr once the last shared subscriber is gone.
+  // Must be cleared before that tsfn is released.
+  void SetFanoutTsfn(napi_threadsafe_function tsfn) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    fanoutTsfn_ = tsfn;
+    scheduled_ = false;
+    if (ActiveTsfn()) Schedule();
+    else DropPending();
+  }
+
+  // JS thread only
+  void AddSubscriber(std::shared_ptr<FanoutSubscriber> sub) { subscribers_.push_back(std::move(sub)); }
+
+  bool RemoveSubscriber(uint32_t id, std::shared_ptr<FanoutSubscriber>* removed = nullptr) {
+    for (auto it = subscribers_.begin(); it != subscribers_.end(); ++it) {
+      if ((*it)->id != id) continue;
+      if (removed) *removed = *it;
+      subscribers_.erase(it);
+      return true;
+    }
+    return false;
+  }
+
+  void ClearSubscribers() { subscribers_.clear(); }
+  size_t SubscriberCount() const { return subscribers_.size(); }
+  uint64_t Conversions() const { return conversions_; }
+  uint64_t FanoutCalls() const { return fanoutCalls_; }
+
+  // Releases every forwarded record up to and including seq
+  void Ack(uint64_t seq) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!spill_) return;
+    while (!inflight_.empty() && inflight_.front().seq <= seq) {
+      inflight_.pop_front();
+      if (inflightSent_ > 0) --inflightSent_;
+    }
+    lastAcked_ = std::max(lastAcked_, seq);
+    Schedule();
+  }
+
+  // False when the group is not in store-and-forward mode
+  bool ForwardStats(SpillStats& st, size_t& inflight, uint64_t& lastAcked) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!spill_) return false;
+    st = spill_->Stats();
+    inflight = inflight_.size();
+    lastAcked = lastAcked_;
+    return true;
+  }
+
+  // Cumulative delivery cost and current backlog (pending plus unforwarded records)
+  GroupLoad Load() {
+    GroupLoad load;
+    load.handlerNs = handlerNs_.load(std::memory_order_relaxed);
+    load.handled = handled_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mtx_);
+    load.depth = pending_.size();
+    // Records already on disk are a store-and-forward backlog, not JS falling behind the server
+    if (spill_) load.depth += spill_->Stats().memoryRecords;
+    return load;
+  }
+
+  // Redundancy: callbacks of any other group (the standby server's twin) are ignored from now on
+  void SetSource(COPCGroup* group) { source_.store(group, std::memory_order_release); }
+  uint64_t LastCallbackNs() const { return lastCallbackNs_.load(std::memory_order_relaxed); }
+
+  void OnDataChange(COPCGroup& group, CAtlMap<COPCItem*, OPCItemData*>& changes) override {
+    COPCGroup* source = source_.load(std::memory_order_acquire);
+    if (source && &group != source) return;
+    lastCallbackNs_.store(MonotonicNs(), std::memory_order_relaxed);
+    bool timed = metrics_.Enabled();
+    uint64_t entryNs = timed ? MonotonicNs() : 0;
+    StallWatchdog::Op watchOp;
+    bool watched = watchdog_.Enabled();
+    if (watched) watchdog_.Begin(watchOp, StallKind::Callback, name_, 0);
+    std::vector<IncomingChange> batch;
+    batch.reserve(changes.GetCount());
+    POSITION pos = changes.GetStartPosition();
+    while (pos != NULL) {
+      CAtlMap<COPCItem*, OPCItemData*>::CPair* pair = changes.GetNext(pos);
+      IncomingChange in;
+      in.item = &pair->m_key->getName();
+      OPCItemData* data = pair->m_value;
+      if (data) {
+        in.timestamp = (static_cast<uint64_t>(data->ftTimeStamp.dwHighDateTime) << 32) | data->ftTimeStamp.dwLowDateTime;
+        in.quality = data->wQuality;
+        in.error = data->error;
+        in.value = VariantToChangeValue(data->vDataValue);
+      } else {
+        in.error = E_FAIL;
+      }
+      batch.push_back(std::move(in));
+    }
+    if (timed) {
+      metrics_.Observe(Stage::RecordBuild, MonotonicNs() - entryNs);
+      metrics_.Add(Counter::Callbacks);
+      metrics_.Add(Counter::Items, batch.size());
+    }
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    Ingest(batch, (static_cast<uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime);
+    if (timed) metrics_.Observe(Stage::Callback, MonotonicNs() - entryNs);
+    if (watched) watchdog_.End(watchOp);
+  }
+
+  // Everything after OnDataChange: sequencing, history, series, recorder, pending + tsfn.
+  // The replay engine enters here too, so replayed batches take exactly the live path.
+  void Ingest(std::vector<IncomingChange>& batch, uint64_t receivedTicks) {
+    bool timed = metrics_.Enabled();
+    uint64_t startNs = timed ? MonotonicNs() : 0;  // Includes waiting for mtx_
+    std::lock_guard<std::mutex> lock(mtx_);
+    ++callbackSizes_.callbacks;
+    callbackSizes_.items += batch.size();
+    callbackSizes_.maxItems = std::max<uint64_t>(callbackSizes_.maxItems, batch.size());
+    RecordedBatch recorded;
+    if (recorder_) {
+      recorded.receivedTicks = receivedTicks;
+      recorded.records.reserve(batch.size());
+    }
+    for (IncomingChange& in : batch) {
+      ChangeRecord rec;
+      rec.seq = ++nextSeq_;
+      rec.handle = HandleFor(*in.item);
+      rec.timestamp = in.timestamp;
+      rec.quality = in.quality;
+      rec.error = in.error;
+      rec.value = std::move(in.value);
+      history_.Push(rec);
+      if (table_) {
+        if (rec.handle >= tableSlots_.size()) tableSlots_.resize(rec.handle + 1, -2);
+        int64_t& slot = tableSlots_[rec.handle];
+        if (slot == -2) slot = table_->SlotOf(names_[rec.handle]);
+        if (slot >= 0) table_->Write(static_cast<uint32_t>(slot), rec);
+      }
+      if (series_ && rec.value.IsNumeric() && SUCCEEDED(rec.error)) {
+        series_->Feed(rec.handle, FileTimeTicksToJsMs(rec.timestamp), rec.value.number, rec.quality);
+      }
+      if (recorder_) recorded.records.push_back(rec);
+      if (ActiveTsfn() || spill_) Enqueue(std::move(rec));  // Forwarded records are kept while unsubscribed
+    }
+    if (table_) table_->BumpGeneration();
+    if (recorder_) {
+      recorded.group = name_;
+      for (; recordedNames_ < names_.size(); ++recordedNames_) {
+        recorded.newNames.emplace_back(recordedNames_, names_[recordedNames_]);
+      }
+      recorder_->Submit(std::move(recorded));  // Queue handoff only, encoding happens on the recorder thread
+    }
+    Schedule();
+    if (timed) {
+      metrics_.Add(Counter::Records, batch.size());
+      metrics_.Observe(Stage::Enqueue, MonotonicNs() - startNs);
+    }
+  }
+
+  // tsfn call_js: runs on the JS thread, materializes the pending batch
+  static void DeliverChanges(napi_env env, napi_value jsCb, void* context, void* data) {
+    auto* self = static_cast<GroupPipeline*>(data);
+    uint64_t deliverStartNs = MonotonicNs();
+    std::deque<ChangeRecord> batch;
+    std::vector<std::string> names;
+    bool forwarding;
+    PipelineMetrics& metrics = self->metrics_;
+    StallWatchdog& watchdog = self->watchdog_;
+    bool timed = metrics.Enabled();
+    bool watched = watchdog.Enabled();
+    {
+      std::lock_guard<std::mutex> lock(self->mtx_);
+      if (env == nullptr && self->ActiveTsfn()) {
+        // A released tsfn draining: the pending records belong to the one still attached
+        self->scheduled_ = false;
+        self->Schedule();
+        return;
+      }
+      if (self->dispatchStartNs_) {
+        uint64_t waited = MonotonicNs() - self->dispatchStartNs_;
+        if (timed) {
+          metrics.Observe(Stage::TsfnDispatch, waited);
+          metrics.Add(Counter::Batches);
+        }
+        if (watched && !self->pending_.empty()) watchdog.Observe(StallKind::Dispatch, self->name_, waited, self->pending_.back().seq);
+      }
+      self->dispatchStartNs_ = 0;
+      batch.swap(self->pending_);
+      self->pendingBase_ += batch.size();
+      self->pendingIndex_.clear();
+      self->scheduled_ = false;
+      forwarding = self->spill_ != nullptr;
+      names.reserve(batch.size());
+      for (const ChangeRecord& rec : batch) {
+        names.push_back(rec.handle < self->names_.size() ? self->names_[rec.handle] : std::string());
+      }
+      if (forwarding && env != nullptr) self->Schedule();  // Records spilled since the last top-up
+    }
+    if (env == nullptr) {
+      if (forwarding) {
+        std::lock_guard<std::mutex> lock(self->mtx_);
+        self->inflightSent_ = 0;  // Still unacked, redelivered after the next subscribe
+        return;
+      }
+      for (const ChangeRecord& rec : batch) {
+        if (rec.seq != 0) self->ledger_.Note(LossKind::Drop, rec.seq, rec.seq, 1);
+      }
+      return;
+    }
+
+    Napi::Env napiEnv(env);
+    bool hasPlain = jsCb != nullptr;  // Fan-out tsfns are created without a JS function
+    Napi::Function fn = hasPlain ? Napi::Function(env, jsCb) : Napi::Function();
+    auto subscribers = self->subscribers_;  // Handlers may add or remove subscribers
+    std::vector<FanoutSubscriber*> matched;
+    Napi::Error subscriberError;
+    bool plainThrew = false;  // The plain handler sits out the rest of the batch; shared subscribers do not
+    for (size_t i = 0; i < batch.size(); ++i) {
+      const ChangeRecord& rec = batch[i];
+      if (rec.seq == 0) continue;
+      matched.clear();
+      for (const auto& sub : subscribers) {
+        if (sub->Matches(rec.handle, names[i])) matched.push_back(sub.get());
+      }
+      if ((!hasPlain || plainThrew) && matched.empty()) continue;  // Filtered out everywhere: never materialized
+      uint64_t t0 = timed ? MonotonicNs() : 0;
+      std::string eventType = "dataChange";
+      Napi::Object eventData = Napi::Object::New(napiEnv);
+      eventData.Set("data", ChangeToNapi(napiEnv, rec, names[i]));
+      // Detect disconnect (e.g., bad quality or specific HRESULT)
+      if (FAILED(rec.error)) {
+        eventType = "disconnect";
+        eventData.Set("error", Napi::String::New(napiEnv, "Connection lost via data change"));
+      }
+      Napi::Object event = Napi::Object::New(napiEnv);
+      event.Set("type", Napi::String::New(napiEnv, eventType));
+      event.Set("data", eventData);
+      ++self->conversions_;
+      uint64_t t1 = timed ? MonotonicNs() : 0;
+      if (timed) metrics.Observe(Stage::Materialize, t1 - t0);
+      if (hasPlain && !plainThrew) {
+        StallWatchdog::Op watchOp;
+        if (watched) watchdog.Begin(watchOp, StallKind::Handler, self->name_, rec.seq);
+        try {
+          fn.Call({ event });
+          if (watched) watchdog.End(watchOp);
+          if (timed) {
+            metrics.Observe(Stage::Handler, MonotonicNs() - t1);
+            metrics.Add(Counter::Delivered);
+          }
+        } catch (const Napi::Error& e) {
+          if (watched) watchdog.End(watchOp);
+          if (timed) metrics.Add(Counter::HandlerErrors);
+          if (forwarding) {
+            // Unacked records are sent again, starting with the oldest. A record the handler keeps
+            // throwing on is dropped after maxRedeliveries retries so it cannot wedge the group.
+            std::lock_guard<std::mutex> lock(self->mtx_);
+            self->pending_.clear();
+            self->inflightSent_ = 0;
+            if (self->failedSeq_ == rec.seq) {
+              ++self->failedCount_;
+            } else {
+              self->failedSeq_ = rec.seq;
+              self->failedCount_ = 1;
+            }
+            if (self->failedCount_ > self->opts_.maxRedeliveries) {
+              for (auto it = self->inflight_.begin(); it != self->inflight_.end(); ++it) {
+                if (it->seq != rec.seq) continue;
+                self->inflight_.erase(it);
+                self->ledger_.Note(LossKind::Drop, rec.seq, rec.seq, 1);
+                break;
+              }
+              self->failedSeq_ = 0;
+              self->failedCount_ = 0;
+            }
+            e.ThrowAsJavaScriptException();
+            return;
+          }
+          // Handler threw: the rest of this batch never reaches it, while shared subscribers still get every record
+          for (size_t j = i + 1; j < batch.size(); ++j) {
+            if (batch[j].seq != 0) self->ledger_.Note(LossKind::Drop, batch[j].seq, batch[j].seq, 1);
+          }
+          plainThrew = true;
+          if (subscriberError.IsEmpty()) subscriberError = e;
+        }
+      }
+      // Same event object for every shared subscriber; one throwing does not starve the others
+      for (FanoutSubscriber* sub : matched) {
+        uint64_t t2 = timed ? MonotonicNs() : 0;
+        StallWatchdog::Op watchOp;
+        if (watched) watchdog.Begin(watchOp, StallKind::Handler, self->name_, rec.seq);
+        try {
+          sub->fn.Call({ event });
+          ++self->fanoutCalls_;
+          if (timed) {
+            metrics.Observe(Stage::Handler, MonotonicNs() - t2);
+            metrics.Add(Counter::Delivered);
+          }
+        } catch (const Napi::Error& e) {
+          if (timed) metrics.Add(Counter::HandlerErrors);
+          if (subscriberError.IsEmpty()) subscriberError = e;
+        }
+        if (watched) watchdog.End(watchOp);
+      }
+    }
+    self->handlerNs_.fetch_add(MonotonicNs() - deliverStartNs, std::memory_order_relaxed);
+    self->handled_.fetch_add(batch.size(), std::memory_order_relaxed);
+    self->Kick();  // A batch refused with napi_queue_full while this one was queued goes out now
+    if (!subscriberError.IsEmpty()) subscriberError.ThrowAsJavaScriptException();
+  }
+
+  std::string ItemName(uint32_t handle) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return handle < names_.size() ? names_[handle] : std::string();
+  }
+
+  // -1 if the item has not changed yet in this group
+  int64_t FindHandle(const std::string& itemName) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = handles_.find(itemName);
+    return it == handles_.end() ? -1 : static_cast<int64_t>(it->second);
+  }
+
+  // capacity 0 switches the series off and frees it
+  void EnableSeries(size_t capacity, bool compressed) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (capacity == 0) series_.reset();
+    else if (!series_ || series_->Capacity() != capacity || series_->Compressed() != compressed) {
+      series_ = std::make_shared<SeriesStore>(capacity, compressed);
+    }
+  }
+
+  // nullptr detaches; once this returns the old table is no longer written
+  void SetValueTable(const std::shared_ptr<ValueTable>& table) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    table_ = table;
+    tableSlots_.clear();
+  }
+
+  void SetRecorder(const std::shared_ptr<ChangeRecorder>& recorder) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    recorder_ = recorder;
+    recordedNames_ = 0;
+  }
+
+  std::shared_ptr<SeriesStore> Series() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return series_;
+  }
+
+  CallbackSizeStats CallbackSizes() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return callbackSizes_;
+  }
+
+  void ResetCallbackSizes() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    callbackSizes_ = CallbackSizeStats();
+  }
+
+  uint64_t LastSeq() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return nextSeq_;
+  }
+
+  ChangeHistory& History() { return history_; }
+  SequenceLedger& Ledger() { return ledger_; }
+};
+
+// Per-env addon state, set with napi_set_instance_data so each isolate loading the addon has its own.
+// Nothing mutable is shared between envs: every OPCDA owns its client, groups, pipelines and threads.
+struct AddonData {
+  Napi::FunctionReference constructor;
+};
+
 // Private data for OPCDA instance
 class OPCDA : public ObjectWrap<OPCDA> {
-  static Napi::FunctionReference constructor;
   Napi::Env env_;
 
   COPCClient* opcClient = nullptr;
@@ -34,40 +666,171 @@ class OPCDA : public ObjectWrap<OPCDA> {
   std::map<std::string, napi_threadsafe_function> tsfns;  // tsfn per key ('connection' or group)
   std::map<std::string, Napi::FunctionReference> jsCbs;   // JS refs for cleanup
   std::map<std::string, std::vector<std::string>> subscriptions;  // key -> eventTypes
+  PipelineMetrics metrics;  // Shared by all pipelines, declared first so it outlives them
+  StallWatchdog watchdog;
+  napi_threadsafe_function watchdogTsfn = nullptr;  // slowConsumer events, set while setWatchdog() is active
+  std::atomic<bool> watchdogScheduled{false};
+  std::map<std::string, std::unique_ptr<GroupPipeline>> pipelines;  // groupName -> change path
+  std::shared_ptr<ChangeRecorder> recorder;  // Set while startRecording() is active
+  std::map<std::string, Napi::ObjectReference> valueTableRefs;  // groupName -> buffer backing its value table
+  std::map<std::string, napi_threadsafe_function> fanoutTsfns;  // groupName -> tsfn of its shared subscribers
+  uint32_t nextSubscriberId = 0;
 
-  mutable std::mutex mtx_;  // Mutex for shared access (only!)
-  bool hasConnectionTsfn = false;  // Flag for auto-created connection tsfn
+  // Server items behind subscribeShared(): created once, deactivated (not removed) when the last user goes
+  struct SharedItem {
+    COPCItem* item = nullptr;
+    uint32_t refs = 0;
+    bool active = false;
+    VARTYPE datatype = VT_EMPTY;  // Granted by SetDatatypes; VT_EMPTY is the server's canonical type
+  };
+  std::map<std::string, std::map<std::string, SharedItem>> sharedItems;  // groupName -> item -> ref
+  // Wrappers of items removed from the server; an OnDataChange already in flight may still resolve them
+  std::map<COPCGroup*, std::vector<COPCItem*>> retiredItems;
 
-  // OPC Callbacks (static, assume closure via user_data or global map<OPCHANDLE, OPCDA*>)
-  static void OPCDataChangeCb(OPCHANDLE hGroup, LPWSTR itemName, VARIANT* value, HRESULT hResult) {
-    // OPCDA* thiz = GetInstanceFromHandle(hGroup);  // Implement retrieval (e.g., static std::map<OPCHANDLE, OPCDA*> instances;)
-    OPCDA* thiz = nullptr;  // Placeholder: implement based on OPC Toolkit
-    if (!thiz) return;
+  // Groups created and owned by planGroups()
+  struct GroupPlanState {
+    PlannerOptions opts;
+    Napi::FunctionReference callback;
+    std::map<std::string, PlannedGroup> groups;
+    std::map<std::string, uint32_t> subscribers;  // groupName -> id of the plan callback's shared subscriber
+    uint32_t nextIndex = 0;
+  };
+  std::unique_ptr<GroupPlanState> plan;
 
-    std::string itemStr = /* std::string(CW2A(itemName)) or similar */;
-    Napi::Object dataObj = Napi::Object::New(thiz->env_);
-    dataObj.Set("item", Napi::String::New(thiz->env_, itemStr));
-    dataObj.Set("value", VariantToNapi(thiz->env_, value));
-    dataObj.Set("quality", Napi::Number::New(thiz->env_, /* extract quality */ hResult & 0xC0000000));  // OPC quality mask
-    dataObj.Set("timestamp", Napi::Date::New(thiz->env_, /* FILETIME to JS ms */ 0.0));
+  // Update rate per group as requested and as granted by the server (setState reports the revision)
+  struct GroupRate {
+    DWORD requested = 0;
+    DWORD revised = 0;  // 0 until a setState round trip reported it
+    float deadband = 0.0f;
+    bool active = true;
+  };
+  std::map<std::string, GroupRate> groupRates;
+  std::map<std::string, ElasticGroup> elasticGroups;  // Groups the rate controller may slow down
+  RateController rateController;
 
-    std::string eventType = "dataChange";
-    Napi::Object eventData = Napi::Object::New(thiz->env_);
-    eventData.Set("data", dataObj);
+  // Desired state last applied by applyConfig(); its items hold refs in sharedItems like any other user
+  struct ConfigGroup {
+    DWORD rate = 0;
+    float deadband = 0.0f;
+    bool active = true;
+    std::set<std::string> items;
+  };
+  std::map<std::string, ConfigGroup> configGroups;
+  ViewSet views;  // Item sets switched on and off together (defineView/showViews)
+  DWORD nextTransactionId = 0;  // Client transaction ids of async calls the addon makes
+  class WriteVQTWorker;
+  std::set<WriteVQTWorker*> pendingWrites;  // Async writeVQT calls waiting for OnWriteComplete
 
-    // Detect disconnect (e.g., bad quality or specific HRESULT)
-    if (FAILED(hResult) || /* quality == OPC_QUALITY_BAD_NOT_CONNECTED */ false) {
-      eventType = "disconnect";
-      eventData.Set("error", Napi::String::New(thiz->env_, "Connection lost via data change"));
-    }
+  std::string serverHost, serverProgId;   // From connect(); directServer is opened from these
+  ATL::CComPtr<IOPCServer> directServer;  // Own server reference for interfaces COPCServer keeps private
+  // Opens directServer: its MTA apartment stays up while the reference is cached, unlike the worker threads'
+  TaskThread comThread{[] { CoInitializeEx(nullptr, COINIT_MULTITHREADED); }, [] { CoUninitialize(); }};
 
-    std::lock_guard<std::mutex> lock(thiz->mtx_);
-    // Emit to group tsfn (key = groupName from hGroup)
-    std::string groupKey = /* extract from hGroup */;
-    auto tsIt = thiz->tsfns.find(groupKey);
-    if (tsIt != thiz->tsfns.end()) {
-      EmitEvent(tsIt->second, eventType, eventData, thiz->env_);
-    }
+  // Item IDs the server already judged: good ones until evicted, bad ones (unknown/invalid) for negativeTtlMs
+  struct ItemIdInfo {
+    HRESULT error = S_OK;
+  };
+  LruCache<std::string, ItemIdInfo> itemIds{4096};
+  uint32_t negativeTtlMs = 60000;
+  PropertyCache properties;  // Filled by loadProperties(), read by getProperties() without server calls
+  ClsidCache clsids;         // Filled by discoverServers() and direct connects; persisted by saveClsidCache()
+  std::map<std::string, VARTYPE> groupDatatypes;  // Requested for every item the addon adds to the group
+
+  // Redundant pair (enableRedundancy): every group and registry item has a twin on the standby server that feeds
+  // the same pipeline, gated off until failover swaps the two sides
+  struct StandbyGroup {
+    COPCGroup* group = nullptr;
+    std::map<std::string, COPCItem*> items;
+  };
+  COPCClient* standbyClient = nullptr;
+  std::string standbyHost, standbyProgId;
+  ATL::CComPtr<IOPCServer> standbyServer;  // Status checks of the standby side
+  std::map<std::string, StandbyGroup> standbyGroups;
+  DWORD standbyRate = 0;                    // Twin groups scan at this rate (hot standby); 0 keeps them inactive
+  DWORD keepAliveMs = 0;                    // IOPCGroupStateMgt2 keep-alive on both sides (liveness)
+  uint64_t redundancySinceNs = 0;           // Liveness baseline: enable or last switch
+  uint64_t redundancyEpoch = 0;             // Bumped by StopRedundancy; a pairing started before it is stale
+  // Old active groups still to drop to standby rate; applied off mtx_ once that side answers again
+  struct Demotion {
+    COPCGroup* group = nullptr;
+    DWORD rate = 0;
+    float deadband = 0.0f;
+    BOOL active = FALSE;
+  };
+  std::vector<Demotion> demotions;
+  // Round trips that give a promoted twin the state of the group it replaces; applied off mtx_ (ApplyPromotions)
+  struct Promotion {
+    std::string name;
+    COPCGroup* group = nullptr;
+    std::vector<COPCItem*> off;
+    std::map<VARTYPE, std::vector<COPCItem*>> typed;
+    DWORD rate = 0;
+    float deadband = 0.0f;
+    BOOL active = FALSE;
+    DWORD refreshId = 0;  // Cache refresh of a warm twin; 0 for none
+  };
+  // Unbound registry items of one group to create off mtx_ (RebindItems), with the registry state they get
+  struct Rebind {
+    std::string name;
+    COPCGroup* group = nullptr;
+    COPCGroup* twin = nullptr;
+    std::vector<std::string> items;
+    std::vector<bool> active;
+    std::vector<VARTYPE> datatypes;
+    std::vector<COPCItem*> created;
+    std::vector<HRESULT> errors;
+    std::map<std::string, COPCItem*> twinItems;
+    bool failed = false;  // The AddItems call failed: the names stay queued
+  };
+  std::map<std::string, std::set<std::string>> unboundItems;  // Registry items the active side had no twin for
+  RedundancyOptions redundancyOpts;
+  RedundancyMonitor redundancy;
+  napi_threadsafe_function redundancyTsfn = nullptr;
+  std::atomic<bool> redundancyScheduled{false};
+  std::atomic<bool> failoverRequested{false};
+
+  StatusMonitor statusMonitor;  // startStatusPoller(): GetStatus telemetry of the active server
+  napi_threadsafe_function statusTsfn = nullptr;
+  std::atomic<bool> statusScheduled{false};
+
+  // pollItems(): registry items read per (group, period) with one IOPCSyncIO::Read per release
+  struct PollTask {
+    std::set<std::string> items;
+    OPCDATASOURCE source = OPC_DS_DEVICE;
+    PollFilter filter;  // Scheduler thread, under mtx_
+    HRESULT lastError = S_OK;
+    uint64_t changes = 0;
+  };
+  std::map<PollScheduler::Key, PollTask> pollTasks;
+  PollScheduler pollScheduler;
+  std::shared_ptr<ReplayControl> replayControl;   // Set while replay() is running
+
+  mutable std::mutex mtx_;  // Mutex for shared access (only!)
+  bool hasConnectionTsfn = false;  // Flag for auto-created connection tsfn
+  bool stopping = false;  // Shutdown() started: no worker Execute or replay may begin
+  bool shutDown = false;  // Shutdown() ran (env cleanup hook or destructor)
+  size_t executing = 0;   // Worker Execute calls in progress (ExecuteScope)
+  std::condition_variable executeIdle;
+
+  // COPCClient::init/stop set up and tear down COM for the whole process, not for one client: every
+  // client (each instance's, standby ones) holds a reference and only the last one out stops it
+  struct ClientRuntime {
+    std::mutex mtx;
+    size_t refs = 0;
+  };
+  static ClientRuntime& Runtime() {
+    static ClientRuntime runtime;
+    return runtime;
+  }
+  static void AcquireClientRuntime(COPCClient* client) {
+    ClientRuntime& rt = Runtime();
+    std::lock_guard<std::mutex> lock(rt.mtx);
+    if (rt.refs++ == 0) client->init(MULTITHREADED);
+  }
+  static void ReleaseClientRuntime(COPCClient* client) {
+    ClientRuntime& rt = Runtime();
+    std::lock_guard<std::mutex> lock(rt.mtx);
+    if (--rt.refs == 0) client->stop();
   }
 
   static void OPCDisconnectCb(HRESULT hResult) {
@@ -97,10 +860,74 @@ public:
       InstanceMethod<&OPCDA::Read>("read"),
       InstanceMethod<&OPCDA::Write>("write"),
       InstanceMethod<&OPCDA::Browse>("browse"),
+      InstanceMethod<&OPCDA::ChangesSince>("changesSince"),
+      InstanceMethod<&OPCDA::GetSequenceStats>("getSequenceStats"),
+      InstanceMethod<&OPCDA::EnableSeries>("enableSeries"),
+      InstanceMethod<&OPCDA::Aggregate>("aggregate"),
+      InstanceMethod<&OPCDA::GetSeriesStats>("getSeriesStats"),
+      InstanceMethod<&OPCDA::StartRecording>("startRecording"),
+      InstanceMethod<&OPCDA::StopRecording>("stopRecording"),
+      InstanceMethod<&OPCDA::GetRecorderStats>("getRecorderStats"),
+      InstanceMethod<&OPCDA::Replay>("replay"),
+      InstanceMethod<&OPCDA::StopReplay>("stopReplay"),
+      InstanceMethod<&OPCDA::DecodeSegment>("decodeSegment"),
+      InstanceMethod<&OPCDA::Ack>("ack"),
+      InstanceMethod<&OPCDA::GetForwardStats>("getForwardStats"),
+      InstanceMethod<&OPCDA::EnableMetrics>("enableMetrics"),
+      InstanceMethod<&OPCDA::GetMetrics>("getMetrics"),
+      InstanceMethod<&OPCDA::SetWatchdog>("setWatchdog"),
+      InstanceMethod<&OPCDA::GetWatchdogStats>("getWatchdogStats"),
+      InstanceMethod<&OPCDA::AttachValueTable>("attachValueTable"),
+      InstanceMethod<&OPCDA::DetachValueTable>("detachValueTable"),
+      InstanceMethod<&OPCDA::SubscribeShared>("subscribeShared"),
+      InstanceMethod<&OPCDA::UnsubscribeShared>("unsubscribeShared"),
+      InstanceMethod<&OPCDA::GetFanoutStats>("getFanoutStats"),
+      InstanceMethod<&OPCDA::PlanGroups>("planGroups"),
+      InstanceMethod<&OPCDA::RebalancePlan>("rebalancePlan"),
+      InstanceMethod<&OPCDA::GetPlan>("getPlan"),
+      InstanceMethod<&OPCDA::SetElastic>("setElastic"),
+      InstanceMethod<&OPCDA::StartRateControl>("startRateControl"),
+      InstanceMethod<&OPCDA::StopRateControl>("stopRateControl"),
+      InstanceMethod<&OPCDA::GetRates>("getRates"),
+      InstanceMethod<&OPCDA::ApplyConfig>("applyConfig"),
+      InstanceMethod<&OPCDA::SetActive>("setActive"),
+      InstanceMethod<&OPCDA::DefineView>("defineView"),
+      InstanceMethod<&OPCDA::ShowViews>("showViews"),
+      InstanceMethod<&OPCDA::RemoveView>("removeView"),
+      InstanceMethod<&OPCDA::GetViews>("getViews"),
+      InstanceMethod<&OPCDA::SetDatatypes>("setDatatypes"),
+      InstanceMethod<&OPCDA::GetDatatypes>("getDatatypes"),
+      InstanceMethod<&OPCDA::ReadMaxAge>("readMaxAge"),
+      InstanceMethod<&OPCDA::RefreshMaxAge>("refreshMaxAge"),
+      InstanceMethod<&OPCDA::WriteVQT>("writeVQT"),
+      InstanceMethod<&OPCDA::ReadItems>("readItems"),
+      InstanceMethod<&OPCDA::WriteItems>("writeItems"),
+      InstanceMethod<&OPCDA::ConfigureItemIdCache>("configureItemIdCache"),
+      InstanceMethod<&OPCDA::GetItemIdCacheStats>("getItemIdCacheStats"),
+      InstanceMethod<&OPCDA::LoadProperties>("loadProperties"),
+      InstanceMethod<&OPCDA::GetProperties>("getProperties"),
+      InstanceMethod<&OPCDA::SavePropertyCache>("savePropertyCache"),
+      InstanceMethod<&OPCDA::LoadPropertyCache>("loadPropertyCache"),
+      InstanceMethod<&OPCDA::ValidateItems>("validateItems"),
+      InstanceMethod<&OPCDA::DiscoverServers>("discoverServers"),
+      InstanceMethod<&OPCDA::SaveClsidCache>("saveClsidCache"),
+      InstanceMethod<&OPCDA::LoadClsidCache>("loadClsidCache"),
+      InstanceMethod<&OPCDA::EnableRedundancy>("enableRedundancy"),
+      InstanceMethod<&OPCDA::DisableRedundancy>("disableRedundancy"),
+      InstanceMethod<&OPCDA::Failover>("failover"),
+      InstanceMethod<&OPCDA::GetRedundancy>("getRedundancy"),
+      InstanceMethod<&OPCDA::StartStatusPoller>("startStatusPoller"),
+      InstanceMethod<&OPCDA::StopStatusPoller>("stopStatusPoller"),
+      InstanceMethod<&OPCDA::GetServerStatus>("getServerStatus"),
+      InstanceMethod<&OPCDA::PollItems>("pollItems"),
+      InstanceMethod<&OPCDA::UnpollItems>("unpollItems"),
+      InstanceMethod<&OPCDA::GetPollStats>("getPollStats"),
     });
 
-    constructor = Napi::Persistent(func);
-    constructor.SuppressDestruct();
+    // One AddonData per env (main thread and every worker_thread); the env deletes it on teardown
+    auto* data = new AddonData();
+    data->constructor = Napi::Persistent(func);
+    env.SetInstanceData<AddonData>(data);
 
     exports.Set("OPCDA", func);
     return exports;
@@ -108,8 +935,9 @@ public:
 
   OPCDA(const CallbackInfo& info) : ObjectWrap<OPCDA>(info), env_(info.Env()) {
     opcClient = new COPCClient();
-    opcClient->init(MULTITHREADED);
+    AcquireClientRuntime(opcClient);
     opcClient->SetDisconnectCallback(OPCDisconnectCb);  // Set once
+    napi_add_env_cleanup_hook(env_, &OPCDA::EnvCleanup, this);
 
     // Check for init callback (first arg)
     if (info.Length() > 0 && info[0].IsFunction()) {
@@ -119,17 +947,79 @@ public:
   }
 
   ~OPCDA() {
+    napi_remove_env_cleanup_hook(env_, &OPCDA::EnvCleanup, this);
+    Shutdown();
+  }
+
+  // Env teardown (worker_thread exit, process exit) may come before GC finalizes the object;
+  // everything tied to the env is released here and the destructor only repeats a no-op.
+  static void EnvCleanup(void* arg) { static_cast<OPCDA*>(arg)->Shutdown(); }
+
+  void Shutdown() {
+    // Replay feeds the pipelines from a worker thread; it has to be out of Ingest before they go
+    std::shared_ptr<ReplayControl> replaying;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      stopping = true;
+      replaying = replayControl;
+    }
+    if (replaying) {
+      replaying->Stop();
+      replaying->WaitFinished();
+    }
+    // Workers still in Execute use the client, the groups and COM; new ones see stopping and fail
+    {
+      std::unique_lock<std::mutex> lock(mtx_);
+      executeIdle.wait(lock, [this] { return executing == 0; });
+    }
+    StopWatchdog();
+    rateController.Stop();  // Its tick takes mtx_
+    StopRedundancy();
+    StopStatus();
+    pollScheduler.Stop();  // Its releases take mtx_
     std::lock_guard<std::mutex> lock(mtx_);
+    if (shutDown) return;
+    shutDown = true;
+    for (auto& pair : valueTableRefs) {
+      auto pit = pipelines.find(pair.first);
+      if (pit != pipelines.end()) pit->second->SetValueTable(nullptr);
+    }
+    valueTableRefs.clear();
+    for (auto& pair : fanoutTsfns) {
+      auto pit = pipelines.find(pair.first);
+      if (pit != pipelines.end()) {
+        pit->second->SetFanoutTsfn(nullptr);
+        pit->second->ClearSubscribers();
+      }
+      napi_release_threadsafe_function(pair.second, napi_threadsafe_function_release_mode::NAPI_TSFN_RELEASE_MODE_IMMEDIATE);
+    }
+    fanoutTsfns.clear();
+    plan.reset();
+    configGroups.clear();
+    for (auto& pair : pipelines) {
+      auto git = groups.find(pair.first);
+      if (git != groups.end() && git->second) git->second->disableAsynch();
+      pair.second->Detach();
+    }
+    AbandonWritesLocked(nullptr);
     for (auto& pair : tsfns) {
       napi_release_threadsafe_function(pair.second, napi_threadsafe_function_release_mode::NAPI_TSFN_RELEASE_MODE_MANUAL);
     }
     tsfns.clear();
     jsCbs.clear();
     subscriptions.clear();
+    if (recorder) {
+      recorder->Stop();
+      recorder.reset();
+    }
+    directServer.Release();
+    comThread.Stop();
     if (opcClient) {
-      opcClient->stop();
+      ReleaseClientRuntime(opcClient);
       delete opcClient;
+      opcClient = nullptr;
     }
+    FreeRetiredItemsLocked(nullptr);
   }
 
   // Internal: Setup tsfn for connection events from init callback
@@ -175,6 +1065,14 @@ public:
     }
     std::string host = info[0].As<String>().Utf8Value();
     std::string progId = info[1].As<String>().Utf8Value();
+    StopRedundancy();  // The pair was formed with the previous server
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      serverHost = host;
+      serverProgId = progId;
+      directServer.Release();
+      itemIds.Clear();  // Another server may judge the same IDs differently
+    }
 
     auto* worker = new ConnectWorker(info.This().As<Object>(), env_, host, progId, this);
     worker->Queue();
@@ -203,6 +1101,7 @@ public:
 
   Value Disconnect(const CallbackInfo& info) {
     std::lock_guard<std::mutex> lock(mtx_);
+    directServer.Release();
     if (opcClient) opcClient->Disconnect();
     // Emit to connection tsfn if exists
     Napi::Object dataObj = Napi::Object::New(env_);
@@ -220,9 +1119,7 @@ public:
     double deadband = info[2].As<Number>().DoubleValue();
 
     std::lock_guard<std::mutex> lock(mtx_);
-    bool success = opcClient->CreateGroup(groupName.c_str(), rate, deadband);
-    if (!success) throw Napi::Error::New(env_, "Failed to create group");
-    groups[groupName] = opcClient->GetGroup(groupName.c_str());
+    CreateGroupLocked(groupName, rate, deadband);
     return env_.Undefined();
   }
 
@@ -232,10 +1129,12 @@ public:
     std::string itemName = info[1].As<String>().Utf8Value();
 
     std::lock_guard<std::mutex> lock(mtx_);
-    auto it = groups.find(groupName);
-    if (it == groups.end()) throw Napi::Error::New(env_, "Group not found");
-    bool success = it->second->AddItem(itemName.c_str());
-    if (!success) throw Napi::Error::New(env_, "Failed to add item");
+    if (!groups.count(groupName)) throw Napi::Error::New(env_, "Group not found");
+    // Through the shared item registry, so later subscribeShared/views/polls reuse this server item
+    // (the reference is held for the group's lifetime)
+    std::vector<std::string> failed;
+    AcquireItems(groupName, {itemName}, failed);
+    if (!failed.empty()) throw Napi::Error::New(env_, "Failed to add item");
     return env_.Undefined();
   }
 
@@ -254,7 +1153,28 @@ public:
       }
     }
 
-    // Create tsfn
+    DeliveryOptions opts;
+    if (info.Length() > 3 && info[3].IsObject()) {
+      Object o = info[3].As<Object>();
+      if (o.Has("maxPending")) opts.maxPending = std::max<int64_t>(1, o.Get("maxPending").As<Number>().Int64Value());
+      if (o.Has("conflate")) opts.conflate = o.Get("conflate").ToBoolean().Value();
+      if (o.Has("storeAndForward") && o.Get("storeAndForward").IsObject()) {
+        Object sf = o.Get("storeAndForward").As<Object>();
+        if (!sf.Get("dir").IsString()) throw Napi::TypeError::New(env_, "storeAndForward.dir expected");
+        opts.spillDir = sf.Get("dir").As<String>().Utf8Value();
+        if (sf.Has("memoryRecords")) opts.spillMemoryRecords = std::max<int64_t>(1, sf.Get("memoryRecords").As<Number>().Int64Value());
+        if (sf.Has("window")) opts.ackWindow = std::max<int64_t>(1, sf.Get("window").As<Number>().Int64Value());
+        if (sf.Has("maxRedeliveries")) opts.maxRedeliveries = sf.Get("maxRedeliveries").As<Number>().Uint32Value();
+      }
+      if (o.Has("historySize")) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto pit = pipelines.find(target);
+        if (pit != pipelines.end()) pit->second->History().Reset(o.Get("historySize").As<Number>().Uint32Value());
+      }
+    }
+    bool isGroup = target != "connection";
+
+    // Create tsfn (group tsfns deliver native change batches through GroupPipeline::DeliverChanges)
     napi_threadsafe_function tsfn;
     Napi::FunctionReference* cbRefPtr = new Napi::FunctionReference(cbRef);
     auto finalize_cb = [](napi_env env, void* data) {
@@ -266,7 +1186,7 @@ public:
     };
     napi_status status = napi_create_threadsafe_function(
       env_, cb.As<Value>(), nullptr, Napi::String::New(env_, "OPCEvent"),
-      0, 10, finalize_cb, cbRefPtr, nullptr, nullptr, &tsfn  // Queue 10 for bursts
+      0, 10, finalize_cb, cbRefPtr, nullptr, isGroup ? &GroupPipeline::DeliverChanges : nullptr, &tsfn  // Queue 10 for bursts
     );
     if (status != napi_ok) {
       cbRef.Unref();
@@ -286,14 +1206,27 @@ public:
     subscriptions[key] = eventTypes;
 
     // Set OPC cbs if dataChange
-    if (std::find(eventTypes.begin(), eventTypes.end(), "dataChange") != eventTypes.end() && target != "connection") {
+    if (std::find(eventTypes.begin(), eventTypes.end(), "dataChange") != eventTypes.end() && isGroup) {
       auto it = groups.find(target);
-      if (it != groups.end()) {
-        it->second->SetDataChangeCallback(OPCDataChangeCb);  // With closure to this/tsfn
+      auto pit = pipelines.find(target);
+      if (pit != pipelines.end()) {
+        if (!pit->second->Attach(tsfn, opts)) {
+          tsfns.erase(key);
+          jsCbs.erase(key);
+          subscriptions.erase(key);
+          cbRef.Unref();
+          napi_release_threadsafe_function(tsfn, napi_threadsafe_function_release_mode::NAPI_TSFN_RELEASE_MODE_IMMEDIATE);
+          throw Napi::Error::New(env_, "Failed to open storeAndForward directory");
+        }
+        // Replay-only groups have a pipeline but no server-side group; shared subscribers may have enabled it already
+        if (it != groups.end() && !fanoutTsfns.count(target)) {
+          it->second->enableAsynch(*pit->second);
+          EnableTwinAsynchLocked(target, *pit->second);
+        }
       }
     }
-    // For connect: Emit initial if subscribed
-    if (std::find(eventTypes.begin(), eventTypes.end(), "connect") != eventTypes.end() && opcClient && opcClient->IsConnected()) {
+    // For connect: Emit initial if subscribed (group tsfns only carry change batches)
+    if (!isGroup && std::find(eventTypes.begin(), eventTypes.end(), "connect") != eventTypes.end() && opcClient && opcClient->IsConnected()) {
       Napi::Object dataObj = Napi::Object::New(env_);
       dataObj.Set("type", Napi::String::New(env_, "connect"));
       dataObj.Set("success", Napi::Boolean::New(env_, true));
@@ -326,6 +1259,7 @@ public:
         }), types.end());
         if (types.empty()) {
           // All removed, release tsfn
+          DetachPipeline(key);
           napi_release_threadsafe_function(tsIt->second, napi_threadsafe_function_release_mode::NAPI_TSFN_RELEASE_MODE_IMMEDIATE);
           tsfns.erase(tsIt);
           auto jsIt = jsCbs.find(key);
@@ -337,6 +1271,7 @@ public:
         }
       } else {
         // Full unsubscribe
+        DetachPipeline(key);
         napi_release_threadsafe_function(tsIt->second, napi_threadsafe_function_release_mode::NAPI_TSFN_RELEASE_MODE_IMMEDIATE);
         tsfns.erase(tsIt);
         auto jsIt = jsCbs.find(key);
@@ -374,62 +1309,4051 @@ public:
     return worker->Promise();
   }
 
-private:
-  // ConnectWorker (emits to connection tsfn)
-  class ConnectWorker : public AsyncWorker {
-    std::string host_, progId_;
-    OPCDA* op_;
-    bool success_;
-  public:
-    ConnectWorker(Object recv, Env env, std::string h, std::string p, OPCDA* op)
-        : AsyncWorker(recv, env, "ConnectWorker"), host_(h), progId_(p), op_(op), success_(false) {}
-    void Execute() override {
-      std::lock_guard<std::mutex> lock(op_->mtx_);
-      success_ = op_->opcClient->Connect(host_.c_str(), progId_.c_str());
+  // changesSince(groupName, seq [, max]) -> records after seq still held in the native history ring
+  Value ChangesSince(const CallbackInfo& info) {
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) throw Napi::TypeError::New(env_, "groupName, seq [, max] expected");
+    std::string groupName = info[0].As<String>().Utf8Value();
+    uint64_t afterSeq = static_cast<uint64_t>(std::max<int64_t>(0, info[1].As<Number>().Int64Value()));
+    size_t maxCount = info.Length() > 2 && info[2].IsNumber() ? info[2].As<Number>().Uint32Value() : 1000;
+
+    GroupPipeline* pipeline = FindPipeline(groupName);
+    std::vector<ChangeRecord> records;
+    bool gap = pipeline->History().Since(afterSeq, maxCount, records);
+    uint64_t lastSeq = pipeline->LastSeq();
+
+    Array changes = Array::New(env_, records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+      changes.Set(i, ChangeToNapi(env_, records[i], pipeline->ItemName(records[i].handle)));
     }
-    void OnOK() override {
-      Napi::Object eventData = Napi::Object::New(Env());
-      eventData.Set("success", Napi::Boolean::New(Env(), success_));
-      if (!success_) eventData.Set("error", Napi::String::New(Env(), "Connection failed"));
-      std::lock_guard<std::mutex> lock(op_->mtx_);
-      auto tsIt = op_->tsfns.find("connection");
-      if (tsIt != op_->tsfns.end()) {
-        EmitEvent(tsIt->second, "connect", eventData, Env());
-      }
+    Object result = Object::New(env_);
+    result.Set("changes", changes);
+    result.Set("gap", Napi::Boolean::New(env_, gap));
+    result.Set("oldestSeq", Number::New(env_, static_cast<double>(pipeline->History().OldestSeq())));
+    result.Set("lastSeq", Number::New(env_, static_cast<double>(lastSeq)));
+    result.Set("more", Napi::Boolean::New(env_, !records.empty() && records.back().seq < lastSeq));
+    result.Set("losses", LossCountsToNapi(pipeline->Ledger().Summarize(afterSeq + 1, lastSeq)));
+    return result;
+  }
+
+  // getSequenceStats(groupName [, fromSeq, toSeq]) -> drop/conflation/overflow counts per sequence range
+  Value GetSequenceStats(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "groupName [, fromSeq, toSeq] expected");
+    GroupPipeline* pipeline = FindPipeline(info[0].As<String>().Utf8Value());
+    uint64_t lastSeq = pipeline->LastSeq();
+    uint64_t fromSeq = info.Length() > 1 && info[1].IsNumber() ? static_cast<uint64_t>(std::max<int64_t>(0, info[1].As<Number>().Int64Value())) : 0;
+    uint64_t toSeq = info.Length() > 2 && info[2].IsNumber() ? static_cast<uint64_t>(std::max<int64_t>(0, info[2].As<Number>().Int64Value())) : lastSeq;
+
+    std::vector<SequenceLedger::Event> events;
+    LossCounts range = pipeline->Ledger().Summarize(fromSeq, toSeq, &events);
+    static const char* kKinds[] = {"drop", "conflation", "overflow"};
+    Array ranges = Array::New(env_, events.size());
+    for (size_t i = 0; i < events.size(); ++i) {
+      Object ev = Object::New(env_);
+      ev.Set("kind", String::New(env_, kKinds[static_cast<int>(events[i].kind)]));
+      ev.Set("firstSeq", Number::New(env_, static_cast<double>(events[i].firstSeq)));
+      ev.Set("lastSeq", Number::New(env_, static_cast<double>(events[i].lastSeq)));
+      ev.Set("count", Number::New(env_, static_cast<double>(events[i].count)));
+      ranges.Set(i, ev);
     }
-  };
+    Object result = Object::New(env_);
+    result.Set("lastSeq", Number::New(env_, static_cast<double>(lastSeq)));
+    result.Set("range", LossCountsToNapi(range));
+    result.Set("totals", LossCountsToNapi(pipeline->Ledger().Totals()));
+    result.Set("events", ranges);
+    return result;
+  }
 
-  // ReadWorker (placeholder implementation)
-  class ReadWorker : public AsyncWorker {
-    std::string itemName_;
-    VARIANT value_;
-    OPCDA* op_;
-  public:
-    ReadWorker(Object recv, Env env, std::string name, OPCDA* op) : AsyncWorker(recv, env, "ReadWorker"), itemName_(name), op_(op) {}
-    void Execute() override {
-      std::lock_guard<std::mutex> lock(op_->mtx_);
-      // op_->opcClient->Read(itemName_.c_str(), &value_);  // OPC call
+  // enableSeries(groupName, capacity [, { compress }]) -> keep the last `capacity` numeric samples per item natively (0 = off).
+  // compress seals older samples into Gorilla blocks (a few bytes per sample instead of 18).
+  Value EnableSeries(const CallbackInfo& info) {
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) throw Napi::TypeError::New(env_, "groupName, capacity [, options] expected");
+    bool compressed = false;
+    if (info.Length() > 2 && info[2].IsObject()) compressed = info[2].As<Object>().Get("compress").ToBoolean().Value();
+    FindPipeline(info[0].As<String>().Utf8Value())->EnableSeries(info[1].As<Number>().Uint32Value(), compressed);
+    return env_.Undefined();
+  }
+
+  Value GetSeriesStats(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "groupName expected");
+    std::shared_ptr<SeriesStore> series = FindPipeline(info[0].As<String>().Utf8Value())->Series();
+    if (!series) return env_.Null();
+    size_t items, samples, bytes;
+    series->Usage(items, samples, bytes);
+    Object result = Object::New(env_);
+    result.Set("items", Number::New(env_, static_cast<double>(items)));
+    result.Set("samples", Number::New(env_, static_cast<double>(samples)));
+    result.Set("bytes", Number::New(env_, static_cast<double>(bytes)));
+    result.Set("compressed", Napi::Boolean::New(env_, series->Compressed()));
+    return result;
+  }
+
+  // aggregate(groupName, items[], windowMs | windowMs[] [, { now, goodOnly }])
+  // -> { min, max, avg, last, lastTimestamp: Float64Array, count: Uint32Array }, index = window * items.length + item
+  Value Aggregate(const CallbackInfo& info) {
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsArray()) throw Napi::TypeError::New(env_, "groupName, items[], windowMs expected");
+    GroupPipeline* pipeline = FindPipeline(info[0].As<String>().Utf8Value());
+    std::shared_ptr<SeriesStore> series = pipeline->Series();
+    if (!series) throw Napi::Error::New(env_, "Series not enabled for group");
+
+    Array items = info[1].As<Array>();
+    std::vector<int64_t> handles(items.Length());
+    for (uint32_t i = 0; i < items.Length(); ++i) {
+      handles[i] = pipeline->FindHandle(items.Get(i).As<String>().Utf8Value());
     }
-    void OnOK() override {
-      Deferred().Resolve(Env(), VariantToNapi(Env(), &value_));
+    std::vector<double> windows;
+    if (info[2].IsArray()) {
+      Array arr = info[2].As<Array>();
+      for (uint32_t i = 0; i < arr.Length(); ++i) windows.push_back(arr.Get(i).As<Number>().DoubleValue());
+    } else {
+      windows.push_back(info[2].As<Number>().DoubleValue());
+    }
+    double nowMs = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count());
+    bool goodOnly = false;
+    if (info.Length() > 3 && info[3].IsObject()) {
+      Object o = info[3].As<Object>();
+      if (o.Has("now")) nowMs = o.Get("now").ToNumber().DoubleValue();
+      if (o.Has("goodOnly")) goodOnly = o.Get("goodOnly").ToBoolean().Value();
     }
-  };
 
-  // WriteWorker (placeholder)
-  class WriteWorker : public AsyncWorker {
-    std::string itemName_;
-    Value jsValue_;
-    OPCDA* op_;
-    bool success_;
-  public:
-    WriteWorker(Object recv, Env env, std::string name, Value val, OPCDA* op) : AsyncWorker(recv, env, "WriteWorker"), itemName_(name), jsValue_(val), op_(op), success_(false) {}
-    void Execute() override {
-      std::lock_guard<std::mutex> lock(op_->mtx_);
-      // VARIANT var = JsValueToVariant(jsValue_);  // Converter
-      // success_ = op_->opcClient->Write(itemName_.c_str(), &var);
+    std::vector<SeriesAggregate> aggs;
+    series->AggregateMany(handles, windows, nowMs, goodOnly, aggs);
+
+    size_t n = aggs.size();
+    Napi::Float64Array minArr = Napi::Float64Array::New(env_, n);
+    Napi::Float64Array maxArr = Napi::Float64Array::New(env_, n);
+    Napi::Float64Array avgArr = Napi::Float64Array::New(env_, n);
+    Napi::Float64Array lastArr = Napi::Float64Array::New(env_, n);
+    Napi::Float64Array lastTsArr = Napi::Float64Array::New(env_, n);
+    Napi::Uint32Array countArr = Napi::Uint32Array::New(env_, n);
+    for (size_t i = 0; i < n; ++i) {
+      minArr[i] = aggs[i].min;
+      maxArr[i] = aggs[i].max;
+      avgArr[i] = aggs[i].avg;
+      lastArr[i] = aggs[i].last;
+      lastTsArr[i] = aggs[i].lastTimestamp;
+      countArr[i] = aggs[i].count;
     }
-    void OnOK() override {
-      Deferred().Resolve(Env(), success_ ? Env().Undefined() : Napi::Error::New(Env(), "Write failed").Value());
+    Object result = Object::New(env_);
+    result.Set("min", minArr);
+    result.Set("max", maxArr);
+    result.Set("avg", avgArr);
+    result.Set("last", lastArr);
+    result.Set("lastTimestamp", lastTsArr);
+    result.Set("count", countArr);
+    return result;
+  }
+
+  // startRecording(dir [, { maxSegmentBytes, maxSegmentMs, maxQueueRecords, compress }]) -> columnar change log of every group
+  Value StartRecording(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "dir [, options] expected");
+    RecorderOptions opts;
+    if (info.Length() > 1 && info[1].IsObject()) {
+      Object o = info[1].As<Object>();
+      if (o.Has("maxSegmentBytes")) opts.maxSegmentBytes = static_cast<size_t>(o.Get("maxSegmentBytes").As<Number>().Int64Value());
+      if (o.Has("maxSegmentMs")) opts.maxSegmentMs = static_cast<uint64_t>(o.Get("maxSegmentMs").As<Number>().Int64Value());
+      if (o.Has("maxQueueRecords")) opts.maxQueueRecords = static_cast<size_t>(o.Get("maxQueueRecords").As<Number>().Int64Value());
+      if (o.Has("compress")) opts.compress = o.Get("compress").ToBoolean().Value();
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (recorder) throw Napi::Error::New(env_, "Recording already active");
+    auto rec = std::make_shared<ChangeRecorder>(info[0].As<String>().Utf8Value(), opts);
+    if (!rec->Start()) throw Napi::Error::New(env_, "Failed to open recording directory");
+    recorder = rec;
+    for (auto& pair : pipelines) pair.second->SetRecorder(recorder);
+    return env_.Undefined();
+  }
+
+  Value StopRecording(const CallbackInfo& info) {
+    std::shared_ptr<ChangeRecorder> rec;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      for (auto& pair : pipelines) pair.second->SetRecorder(nullptr);
+      rec.swap(recorder);
+    }
+    if (rec) rec->Stop();  // Drains the queue and trims the open segment
+    return env_.Undefined();
+  }
+
+  // replay(dir [, { speed, groups: { recordedName: targetGroup } }]) -> Promise<stats>
+  // Injects recorded batches into the group pipelines exactly where OnDataChange does.
+  // speed: 1 (default) real time, N faster, 0 max. Groups missing locally get a replay-only pipeline.
+  Value Replay(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "dir [, options] expected");
+    std::string dir = info[0].As<String>().Utf8Value();
+    double speed = 1.0;
+    std::map<std::string, std::string> groupMap;
+    if (info.Length() > 1 && info[1].IsObject()) {
+      Object o = info[1].As<Object>();
+      if (o.Has("speed")) speed = std::max(0.0, o.Get("speed").As<Number>().DoubleValue());
+      if (o.Has("groups") && o.Get("groups").IsObject()) {
+        Object g = o.Get("groups").As<Object>();
+        Array keys = g.GetPropertyNames();
+        for (uint32_t i = 0; i < keys.Length(); ++i) {
+          std::string from = keys.Get(i).As<String>().Utf8Value();
+          groupMap[from] = g.Get(from).As<String>().Utf8Value();
+        }
+      }
+    }
+
+    auto replayer = std::make_shared<ChangeReplayer>(dir, speed);
+    std::map<std::string, GroupPipeline*> targets;
+    auto control = std::make_shared<ReplayControl>();
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (stopping) throw Napi::Error::New(env_, "Client is shut down");
+      if (replayControl) throw Napi::Error::New(env_, "Replay already running");
+      for (const std::string& recorded : replayer->Groups()) {
+        auto mapped = groupMap.find(recorded);
+        std::string target = mapped != groupMap.end() ? mapped->second : recorded;
+        auto& pipeline = pipelines[target];
+        if (!pipeline) {
+          pipeline = std::make_unique<GroupPipeline>(target, metrics, watchdog);
+          if (recorder) pipeline->SetRecorder(recorder);
+        }
+        targets[recorded] = pipeline.get();
+      }
+      replayControl = control;
+    }
+    auto* worker = new ReplayWorker(info.This().As<Object>(), replayer, std::move(targets), control, this);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+  }
+
+  // decodeSegment(path) -> Promise<{ seq, timestamps, values: Float64Array, qualities: Uint16Array,
+  //   nameIds: Uint32Array, errors: Int32Array, kinds: Uint8Array, strings: { row: text }, names: [] }>
+  Value DecodeSegment(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "path expected");
+    auto* worker = new DecodeSegmentWorker(env_, info[0].As<String>().Utf8Value());
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+  }
+
+  Value StopReplay(const CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (replayControl) replayControl->Stop();
+    return env_.Undefined();
+  }
+
+  Value GetRecorderStats(const CallbackInfo& info) {
+    std::shared_ptr<ChangeRecorder> rec;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      rec = recorder;
+    }
+    if (!rec) return env_.Null();
+    RecorderStats st = rec->Stats();
+    Object result = Object::New(env_);
+    result.Set("dir", String::New(env_, rec->Dir()));
+    result.Set("segments", Number::New(env_, static_cast<double>(st.segments)));
+    result.Set("records", Number::New(env_, static_cast<double>(st.records)));
+    result.Set("bytes", Number::New(env_, static_cast<double>(st.bytes)));
+    result.Set("rawBytes", Number::New(env_, static_cast<double>(st.rawBytes)));
+    result.Set("compressionRatio", Number::New(env_, st.bytes ? static_cast<double>(st.rawBytes) / st.bytes : 1.0));
+    result.Set("droppedRecords", Number::New(env_, static_cast<double>(st.droppedRecords)));
+    result.Set("queuedRecords", Number::New(env_, static_cast<double>(st.queuedRecords)));
+    result.Set("currentSegment", String::New(env_, st.currentSegment));
+    return result;
+  }
+
+  // ack(groupName, seq) -> store-and-forward: everything up to seq was handled downstream and may go
+  Value Ack(const CallbackInfo& info) {
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) throw Napi::TypeError::New(env_, "groupName, seq expected");
+    uint64_t seq = static_cast<uint64_t>(std::max<int64_t>(0, info[1].As<Number>().Int64Value()));
+    FindPipeline(info[0].As<String>().Utf8Value())->Ack(seq);
+    return env_.Undefined();
+  }
+
+  Value GetForwardStats(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "groupName expected");
+    SpillStats st;
+    size_t inflight;
+    uint64_t lastAcked;
+    if (!FindPipeline(info[0].As<String>().Utf8Value())->ForwardStats(st, inflight, lastAcked)) return env_.Null();
+    Object result = Object::New(env_);
+    result.Set("memoryRecords", Number::New(env_, static_cast<double>(st.memoryRecords)));
+    result.Set("diskRecords", Number::New(env_, static_cast<double>(st.diskRecords)));
+    result.Set("spilledTotal", Number::New(env_, static_cast<double>(st.spilledTotal)));
+    result.Set("files", Number::New(env_, static_cast<double>(st.files)));
+    result.Set("writeErrors", Number::New(env_, static_cast<double>(st.writeErrors)));
+    result.Set("readErrors", Number::New(env_, static_cast<double>(st.readErrors)));
+    result.Set("dropped", Number::New(env_, static_cast<double>(st.dropped)));
+    result.Set("inflight", Number::New(env_, static_cast<double>(inflight)));
+    result.Set("lastAcked", Number::New(env_, static_cast<double>(lastAcked)));
+    return result;
+  }
+
+  // enableMetrics(on [, { reset }]) -> stage timings and counters; off costs one relaxed load per stage
+  Value EnableMetrics(const CallbackInfo& info) {
+    if (info.Length() < 1) throw Napi::TypeError::New(env_, "on [, options] expected");
+    if (info.Length() > 1 && info[1].IsObject() && info[1].As<Object>().Get("reset").ToBoolean().Value()) metrics.Reset();
+    metrics.SetEnabled(info[0].ToBoolean().Value());
+    return env_.Undefined();
+  }
+
+  // getMetrics([format]) -> { enabled, counters: {...}, stages: { name: { count, meanUs, p50Us, p90Us, p99Us, p999Us, maxUs } } }
+  // getMetrics('prometheus') -> text exposition format
+  Value GetMetrics(const CallbackInfo& info) {
+    if (info.Length() > 0 && info[0].IsString() && info[0].As<String>().Utf8Value() == "prometheus") {
+      return String::New(env_, metrics.Prometheus());
+    }
+    Object counters = Object::New(env_);
+    for (int c = 0; c < static_cast<int>(Counter::Count); ++c) {
+      counters.Set(CounterName(static_cast<Counter>(c)), Number::New(env_, static_cast<double>(metrics.Total(static_cast<Counter>(c)))));
+    }
+    Object stages = Object::New(env_);
+    for (int s = 0; s < static_cast<int>(Stage::Count); ++s) {
+      LatencyHistogram::Snapshot snap = metrics.Take(static_cast<Stage>(s));
+      Object st = Object::New(env_);
+      st.Set("count", Number::New(env_, static_cast<double>(snap.count)));
+      st.Set("meanUs", Number::New(env_, snap.Mean() / 1000.0));
+      st.Set("p50Us", Number::New(env_, snap.Quantile(0.5) / 1000.0));
+      st.Set("p90Us", Number::New(env_, snap.Quantile(0.9) / 1000.0));
+      st.Set("p99Us", Number::New(env_, snap.Quantile(0.99) / 1000.0));
+      st.Set("p999Us", Number::New(env_, snap.Quantile(0.999) / 1000.0));
+      st.Set("maxUs", Number::New(env_, snap.max / 1000.0));
+      stages.Set(StageName(static_cast<Stage>(s)), st);
+    }
+    Object result = Object::New(env_);
+    result.Set("enabled", Napi::Boolean::New(env_, metrics.Enabled()));
+    result.Set("counters", counters);
+    result.Set("stages", stages);
+    return result;
+  }
+
+  // setWatchdog({ handlerMs, callbackMs, dispatchMs, intervalMs }, cb) -> cb({ type: 'slowConsumer', data })
+  // for every handler call, server callback or queued batch over its threshold; setWatchdog(null) stops it
+  Value SetWatchdog(const CallbackInfo& info) {
+    StopWatchdog();
+    if (info.Length() < 1 || info[0].IsNull() || info[0].IsUndefined()) return env_.Undefined();
+    if (!info[0].IsObject() || info.Length() < 2 || !info[1].IsFunction()) throw Napi::TypeError::New(env_, "options, callback expected");
+    Object o = info[0].As<Object>();
+    WatchdogOptions opts;
+    static const char* kKeys[] = {"handlerMs", "callbackMs", "dispatchMs"};
+    for (int k = 0; k < static_cast<int>(StallKind::Count); ++k) {
+      if (o.Has(kKeys[k])) opts.thresholdNs[k] = static_cast<uint64_t>(std::max(0.0, o.Get(kKeys[k]).As<Number>().DoubleValue()) * 1e6);
+    }
+    if (o.Has("intervalMs")) opts.intervalNs = static_cast<uint64_t>(std::max(1.0, o.Get("intervalMs").As<Number>().DoubleValue()) * 1e6);
+
+    napi_threadsafe_function tsfn;
+    napi_status status = napi_create_threadsafe_function(
+      env_, info[1], nullptr, Napi::String::New(env_, "OPCWatchdog"),
+      0, 1, nullptr, nullptr, this, &OPCDA::DeliverStallEvents, &tsfn
+    );
+    if (status != napi_ok) throw Napi::Error::New(env_, "Failed to create tsfn");
+    watchdogTsfn = tsfn;
+    watchdogScheduled = false;
+    watchdog.Start(opts, [this] {
+      if (watchdogScheduled.exchange(true)) return;
+      if (napi_call_threadsafe_function(watchdogTsfn, nullptr, napi_tsfn_nonblocking) != napi_ok) watchdogScheduled = false;
+    });
+    return env_.Undefined();
+  }
+
+  // getWatchdogStats() -> { droppedEvents, groups: { name: { handler: { count, maxMs }, callback, dispatch } } }
+  Value GetWatchdogStats(const CallbackInfo& info) {
+    uint64_t dropped = 0;
+    std::map<std::string, StallCounts> counts = watchdog.Counts(dropped);
+    Object groupsObj = Object::New(env_);
+    for (const auto& pair : counts) {
+      Object g = Object::New(env_);
+      for (int k = 0; k < static_cast<int>(StallKind::Count); ++k) {
+        Object c = Object::New(env_);
+        c.Set("count", Number::New(env_, static_cast<double>(pair.second.count[k])));
+        c.Set("maxMs", Number::New(env_, pair.second.maxNs[k] / 1e6));
+        g.Set(StallKindName(static_cast<StallKind>(k)), c);
+      }
+      groupsObj.Set(pair.first, g);
+    }
+    Object result = Object::New(env_);
+    result.Set("enabled", Napi::Boolean::New(env_, watchdog.Enabled()));
+    result.Set("droppedEvents", Number::New(env_, static_cast<double>(dropped)));
+    result.Set("groups", groupsObj);
+    return result;
+  }
+
+  // attachValueTable(groupName, view, items[]) -> { slots, headerBytes, slotBytes }
+  // view: typed array over a SharedArrayBuffer of at least headerBytes + slotBytes * items.length. A plain
+  // ArrayBuffer can be detached (transferred) from JS while callback threads write into it, so it is refused.
+  // items[i] lives in slot i; the change path writes there in place under a per-slot seqlock (layout in value_table.h).
+  Value AttachValueTable(const CallbackInfo& info) {
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsTypedArray() || !info[2].IsArray()) {
+      throw Napi::TypeError::New(env_, "groupName, typed array over a SharedArrayBuffer, items[] expected");
+    }
+    std::string groupName = info[0].As<String>().Utf8Value();
+    Array arr = info[2].As<Array>();
+    std::vector<std::string> items(arr.Length());
+    for (uint32_t i = 0; i < arr.Length(); ++i) items[i] = arr.Get(i).As<String>().Utf8Value();
+
+    // Raw call: the ArrayBuffer wrapper rejects a SharedArrayBuffer
+    void* data = nullptr;
+    napi_typedarray_type type;
+    size_t length, offset;
+    napi_value buffer;
+    if (napi_get_typedarray_info(env_, info[1], &type, &length, &data, &buffer, &offset) != napi_ok) {
+      throw Napi::Error::New(env_, "Cannot access buffer");
+    }
+    Napi::Value sharedCtor = env_.Global().Get("SharedArrayBuffer");
+    if (!sharedCtor.IsFunction() || !Napi::Value(env_, buffer).As<Object>().InstanceOf(sharedCtor.As<Napi::Function>())) {
+      throw Napi::TypeError::New(env_, "Value table must live in a SharedArrayBuffer");
+    }
+    size_t bytes = length * info[1].As<Napi::TypedArray>().ElementSize();
+    if (!data || reinterpret_cast<uintptr_t>(data) % 8 != 0) throw Napi::Error::New(env_, "Buffer must be 8-byte aligned");
+    if (bytes < ValueTable::BytesFor(items.size())) throw Napi::RangeError::New(env_, "Buffer too small for items");
+
+    GroupPipeline* pipeline = FindPipeline(groupName);
+    auto table = std::make_shared<ValueTable>(static_cast<uint8_t*>(data), items);
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      pipeline->SetValueTable(table);  // Replaces (and stops writing) any previous table first
+      valueTableRefs[groupName] = Napi::Persistent(Napi::Value(env_, buffer).As<Object>());
+    }
+    Object result = Object::New(env_);
+    result.Set("slots", Number::New(env_, static_cast<double>(items.size())));
+    result.Set("headerBytes", Number::New(env_, static_cast<double>(ValueTable::kHeaderBytes)));
+    result.Set("slotBytes", Number::New(env_, static_cast<double>(ValueTable::kSlotBytes)));
+    return result;
+  }
+
+  Value DetachValueTable(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "groupName expected");
+    std::string groupName = info[0].As<String>().Utf8Value();
+    GroupPipeline* pipeline = FindPipeline(groupName);
+    std::lock_guard<std::mutex> lock(mtx_);
+    pipeline->SetValueTable(nullptr);
+    valueTableRefs.erase(groupName);
+    return env_.Undefined();
+  }
+
+  // subscribeShared(groupName, callback [, { items }]) -> { id, failed: [] }
+  // Any number of shared subscribers per group sit behind one server group and one tsfn; each change is
+  // converted to a JS event once and handed to every subscriber whose item filter matches.
+  // Items are reference counted across subscribers: created or re-activated on first use only.
+  Value SubscribeShared(const CallbackInfo& info) {
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsFunction()) throw Napi::TypeError::New(env_, "groupName, callback [, options] expected");
+    std::string groupName = info[0].As<String>().Utf8Value();
+    auto sub = std::make_shared<FanoutSubscriber>();
+    sub->fn = Napi::Persistent(info[1].As<Function>());
+    if (info.Length() > 2 && info[2].IsObject()) {
+      Object o = info[2].As<Object>();
+      if (o.Has("items") && o.Get("items").IsArray()) {
+        Array arr = o.Get("items").As<Array>();
+        sub->all = false;
+        for (uint32_t i = 0; i < arr.Length(); ++i) sub->items.insert(arr.Get(i).As<String>().Utf8Value());
+      }
+    }
+
+    std::vector<std::string> failed;
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!pipelines.count(groupName)) throw Napi::Error::New(env_, "Group not found");
+    if (!sub->all) AcquireItems(groupName, std::vector<std::string>(sub->items.begin(), sub->items.end()), failed);
+    for (const std::string& name : failed) sub->items.erase(name);  // Holds no reference to release later
+    AttachSubscriber(groupName, sub);
+
+    Array failedArr = Array::New(env_, failed.size());
+    for (size_t i = 0; i < failed.size(); ++i) failedArr.Set(i, String::New(env_, failed[i]));
+    Object result = Object::New(env_);
+    result.Set("id", Number::New(env_, sub->id));
+    result.Set("failed", failedArr);
+    return result;
+  }
+
+  Value UnsubscribeShared(const CallbackInfo& info) {
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) throw Napi::TypeError::New(env_, "groupName, id expected");
+    std::string groupName = info[0].As<String>().Utf8Value();
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto pit = pipelines.find(groupName);
+    if (pit == pipelines.end()) throw Napi::Error::New(env_, "Group not found");
+    return Napi::Boolean::New(env_, DetachSubscriber(groupName, info[1].As<Number>().Uint32Value()));
+  }
+
+  // getFanoutStats(groupName) -> { subscribers, conversions, calls, items: { name: refs }, serverItems }
+  Value GetFanoutStats(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "groupName expected");
+    std::string groupName = info[0].As<String>().Utf8Value();
+    GroupPipeline* pipeline = FindPipeline(groupName);
+    Object items = Object::New(env_);
+    size_t serverItems = 0;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      auto git = sharedItems.find(groupName);
+      if (git != sharedItems.end()) {
+        for (const auto& pair : git->second) {
+          items.Set(pair.first, Number::New(env_, pair.second.refs));
+          if (pair.second.item) ++serverItems;
+        }
+      }
+    }
+    Object result = Object::New(env_);
+    result.Set("subscribers", Number::New(env_, static_cast<double>(pipeline->SubscriberCount())));
+    result.Set("conversions", Number::New(env_, static_cast<double>(pipeline->Conversions())));
+    result.Set("calls", Number::New(env_, static_cast<double>(pipeline->FanoutCalls())));
+    result.Set("items", items);
+    result.Set("serverItems", Number::New(env_, static_cast<double>(serverItems)));
+    return result;
+  }
+
+  // planGroups(tags: [{ name, rate }], { maxItemsPerGroup, maxCallbackItems, rates, prefix }, callback) -> getPlan()
+  // Creates and owns the groups: bucketed by rate, capped and evenly filled. Every change of every planned
+  // group goes to callback. rebalancePlan() splits groups whose callbacks grew past maxCallbackItems.
+  Value PlanGroups(const CallbackInfo& info) {
+    if (info.Length() < 3 || !info[0].IsArray() || !info[2].IsFunction()) throw Napi::TypeError::New(env_, "tags[], options, callback expected");
+    PlannerOptions opts;
+    if (info[1].IsObject()) {
+      Object o = info[1].As<Object>();
+      if (o.Has("maxItemsPerGroup")) opts.maxItemsPerGroup = std::max<int64_t>(1, o.Get("maxItemsPerGroup").As<Number>().Int64Value());
+      if (o.Has("maxCallbackItems")) opts.maxCallbackItems = std::max<int64_t>(1, o.Get("maxCallbackItems").As<Number>().Int64Value());
+      if (o.Has("prefix")) opts.prefix = o.Get("prefix").As<String>().Utf8Value();
+      if (o.Has("rates") && o.Get("rates").IsArray()) {
+        Array rates = o.Get("rates").As<Array>();
+        opts.rateBuckets.clear();
+        for (uint32_t i = 0; i < rates.Length(); ++i) opts.rateBuckets.push_back(rates.Get(i).As<Number>().Uint32Value());
+      }
+    }
+    Array arr = info[0].As<Array>();
+    std::vector<std::pair<std::string, uint32_t>> tags;
+    tags.reserve(arr.Length());
+    for (uint32_t i = 0; i < arr.Length(); ++i) {
+      Object tag = arr.Get(i).As<Object>();
+      tags.emplace_back(tag.Get("name").As<String>().Utf8Value(), tag.Has("rate") ? tag.Get("rate").As<Number>().Uint32Value() : 1000);
+    }
+
+    std::vector<std::string> failed;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (plan) throw Napi::Error::New(env_, "Plan already active");
+      plan = std::make_unique<GroupPlanState>();
+      plan->opts = opts;
+      plan->callback = Napi::Persistent(info[2].As<Function>());
+      try {
+        for (PlannedGroup& group : PlanGroups(tags, opts, plan->nextIndex)) AddPlannedGroup(std::move(group), failed);
+      } catch (...) {
+        DropPlan();  // All or nothing, so planGroups can simply be called again
+        throw;
+      }
+    }
+    Object result = GetPlan(info).As<Object>();
+    Array failedArr = Array::New(env_, failed.size());
+    for (size_t i = 0; i < failed.size(); ++i) failedArr.Set(i, String::New(env_, failed[i]));
+    result.Set("failed", failedArr);
+    return result;
+  }
+
+  // rebalancePlan() -> [{ from, to: [names], moved }]; call periodically, groups only change when they outgrew the limits
+  Value RebalancePlan(const CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!plan) throw Napi::Error::New(env_, "No plan active");
+    Array result = Array::New(env_);
+    std::vector<std::string> names;
+    for (const auto& pair : plan->groups) names.push_back(pair.first);
+    for (const std::string& name : names) {
+      PlannedGroup& group = plan->groups[name];
+      GroupPipeline* pipeline = pipelines[name].get();
+      std::vector<PlannedGroup> parts = SplitGroup(group, pipeline->CallbackSizes(), plan->opts, plan->nextIndex);
+      if (parts.empty()) continue;
+      Array to = Array::New(env_, parts.size());
+      std::vector<std::string> movedItems;
+      for (size_t i = 0; i < parts.size(); ++i) {
+        std::string partName = parts[i].name;
+        to.Set(i, String::New(env_, partName));
+        std::vector<std::string> refused;
+        AddPlannedGroup(std::move(parts[i]), refused);  // New home is live before the old one lets go
+        const PlannedGroup& added = plan->groups[partName];
+        movedItems.insert(movedItems.end(), added.items.begin(), added.items.end());
+      }
+      // Items the new group could not take stay where they are
+      ReleaseItems(name, movedItems);
+      std::set<std::string> gone(movedItems.begin(), movedItems.end());
+      group.items.erase(std::remove_if(group.items.begin(), group.items.end(),
+                                       [&gone](const std::string& item) { return gone.count(item) > 0; }), group.items.end());
+      size_t moved = movedItems.size();
+      pipeline->ResetCallbackSizes();
+      Object change = Object::New(env_);
+      change.Set("from", String::New(env_, name));
+      change.Set("to", to);
+      change.Set("moved", Number::New(env_, static_cast<double>(moved)));
+      result.Set(result.Length(), change);
+    }
+    return result;
+  }
+
+  // getPlan() -> { groups: [{ name, rate, items, callbacks, avgCallbackItems, maxCallbackItems }] } or null
+  Value GetPlan(const CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!plan) return env_.Null();
+    Array groupsArr = Array::New(env_, plan->groups.size());
+    uint32_t i = 0;
+    for (const auto& pair : plan->groups) {
+      CallbackSizeStats cs = pipelines[pair.first]->CallbackSizes();
+      Object g = Object::New(env_);
+      g.Set("name", String::New(env_, pair.first));
+      g.Set("rate", Number::New(env_, pair.second.rateMs));
+      g.Set("items", Number::New(env_, static_cast<double>(pair.second.items.size())));
+      g.Set("callbacks", Number::New(env_, static_cast<double>(cs.callbacks)));
+      g.Set("avgCallbackItems", Number::New(env_, cs.Average()));
+      g.Set("maxCallbackItems", Number::New(env_, static_cast<double>(cs.maxItems)));
+      groupsArr.Set(i++, g);
+    }
+    Object result = Object::New(env_);
+    result.Set("groups", groupsArr);
+    return result;
+  }
+
+  // setElastic(groupName, { minRate, maxRate, priority }) lets the rate controller slow the group down to maxRate
+  // under load (lowest priority first); setElastic(groupName, null) restores minRate and pins it again
+  Value SetElastic(const CallbackInfo& info) {
+    if (info.Length() < 2 || !info[0].IsString()) throw Napi::TypeError::New(env_, "groupName, options or null expected");
+    std::string groupName = info[0].As<String>().Utf8Value();
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!groups.count(groupName)) throw Napi::Error::New(env_, "Group not found");
+    auto eit = elasticGroups.find(groupName);
+    if (info[1].IsNull() || info[1].IsUndefined()) {
+      if (eit != elasticGroups.end()) {
+        uint32_t base = eit->second.minRate;
+        elasticGroups.erase(eit);
+        if (groupRates[groupName].requested != base) ApplyRateLocked(groupName, base);
+      }
+      return env_.Undefined();
+    }
+    Object o = info[1].As<Object>();
+    ElasticGroup g;
+    g.minRate = o.Has("minRate") ? o.Get("minRate").As<Number>().Uint32Value() : static_cast<uint32_t>(groupRates[groupName].requested);
+    g.maxRate = o.Has("maxRate") ? o.Get("maxRate").As<Number>().Uint32Value() : g.minRate * 8;
+    g.priority = o.Has("priority") ? o.Get("priority").As<Number>().Int32Value() : 0;
+    if (g.minRate == 0 || g.maxRate < g.minRate) throw Napi::RangeError::New(env_, "0 < minRate <= maxRate required");
+    g.currentRate = std::min(g.maxRate, std::max(g.minRate, static_cast<uint32_t>(groupRates[groupName].requested)));
+    if (groupRates[groupName].requested != g.currentRate) ApplyRateLocked(groupName, g.currentRate);
+    g.currentRate = GrantedRateLocked(groupName);
+    elasticGroups[groupName] = g;
+    return env_.Undefined();
+  }
+
+  // startRateControl({ intervalMs, highBusy, lowBusy, highDepth, lowDepth, highLatencyMs, factor, restoreAfter })
+  Value StartRateControl(const CallbackInfo& info) {
+    RateControlOptions opts;
+    if (info.Length() > 0 && info[0].IsObject()) {
+      Object o = info[0].As<Object>();
+      if (o.Has("intervalMs")) opts.intervalMs = std::max(10u, o.Get("intervalMs").As<Number>().Uint32Value());
+      if (o.Has("highBusy")) opts.highBusy = o.Get("highBusy").As<Number>().DoubleValue();
+      if (o.Has("lowBusy")) opts.lowBusy = o.Get("lowBusy").As<Number>().DoubleValue();
+      if (o.Has("highDepth")) opts.highDepth = static_cast<uint64_t>(o.Get("highDepth").As<Number>().DoubleValue());
+      if (o.Has("lowDepth")) opts.lowDepth = static_cast<uint64_t>(o.Get("lowDepth").As<Number>().DoubleValue());
+      if (o.Has("highLatencyMs")) opts.highLatencyMs = o.Get("highLatencyMs").As<Number>().DoubleValue();
+      if (o.Has("factor")) opts.factor = std::max(1.1, o.Get("factor").As<Number>().DoubleValue());
+      if (o.Has("restoreAfter")) opts.restoreAfter = o.Get("restoreAfter").As<Number>().Uint32Value();
+    }
+    rateController.Start(opts, [this] { RateControlTick(); },
+                         [] { CoInitializeEx(nullptr, COINIT_MULTITHREADED); },  // setState from the controller thread
+                         [] { CoUninitialize(); });
+    return env_.Undefined();
+  }
+
+  // stopRateControl(): elastic groups go back to their minRate
+  Value StopRateControl(const CallbackInfo& info) {
+    rateController.Stop();
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto& pair : elasticGroups) {
+      if (pair.second.currentRate == pair.second.minRate) continue;
+      pair.second.currentRate = pair.second.minRate;
+      ApplyRateLocked(pair.first, pair.second.minRate);
+    }
+    return env_.Undefined();
+  }
+
+  // getRates() -> { running, level, busy, latencyMs, depth, groups: [{ name, requested, revised, elastic, minRate, maxRate, priority }] }
+  Value GetRates(const CallbackInfo& info) {
+    double busy = 0.0, latencyMs = 0.0;
+    uint64_t depth = 0;
+    LoadLevel level = rateController.Level(busy, latencyMs, depth);
+    static const char* kLevels[] = {"eased", "steady", "overloaded"};
+    std::lock_guard<std::mutex> lock(mtx_);
+    Array groupsArr = Array::New(env_, groupRates.size());
+    uint32_t i = 0;
+    for (const auto& pair : groupRates) {
+      Object g = Object::New(env_);
+      g.Set("name", String::New(env_, pair.first));
+      g.Set("requested", Number::New(env_, pair.second.requested));
+      if (pair.second.revised) g.Set("revised", Number::New(env_, pair.second.revised));
+      else g.Set("revised", env_.Null());
+      auto eit = elasticGroups.find(pair.first);
+      g.Set("elastic", Napi::Boolean::New(env_, eit != elasticGroups.end()));
+      if (eit != elasticGroups.end()) {
+        g.Set("minRate", Number::New(env_, eit->second.minRate));
+        g.Set("maxRate", Number::New(env_, eit->second.maxRate));
+        g.Set("priority", Number::New(env_, eit->second.priority));
+      }
+      groupsArr.Set(i++, g);
+    }
+    Object result = Object::New(env_);
+    result.Set("running", Napi::Boolean::New(env_, rateController.Running()));
+    result.Set("level", String::New(env_, kLevels[static_cast<int>(level)]));
+    result.Set("busy", Number::New(env_, busy));
+    result.Set("latencyMs", Number::New(env_, latencyMs));
+    result.Set("depth", Number::New(env_, static_cast<double>(depth)));
+    result.Set("groups", groupsArr);
+    return result;
+  }
+
+  // applyConfig({ groupName: { rate, deadband, active, items: [] } }) -> { createdGroups, removedGroups, added, removed,
+  // stateChanges, failed: [{ group, item }] }
+  // Diffs against the previously applied config: per group at most one AddItems, one SetActiveState, one RemoveItems
+  // and one setState. Unchanged groups and items are not touched, so their subscriptions keep flowing.
+  // Groups dropped from the config lose their items and are deactivated (groups themselves are never deleted).
+  Value ApplyConfig(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsObject()) throw Napi::TypeError::New(env_, "desired config object expected");
+    Object desiredObj = info[0].As<Object>();
+    std::map<std::string, ConfigGroup> desired;
+    Array names = desiredObj.GetPropertyNames();
+    for (uint32_t i = 0; i < names.Length(); ++i) {
+      std::string name = names.Get(i).As<String>().Utf8Value();
+      Object g = desiredObj.Get(name).As<Object>();
+      ConfigGroup cg;
+      cg.rate = g.Has("rate") ? g.Get("rate").As<Number>().Uint32Value() : 1000;
+      cg.deadband = g.Has("deadband") ? g.Get("deadband").As<Number>().FloatValue() : 0.0f;
+      cg.active = g.Has("active") ? g.Get("active").ToBoolean().Value() : true;
+      if (g.Has("items")) {
+        Array items = g.Get("items").As<Array>();
+        for (uint32_t j = 0; j < items.Length(); ++j) cg.items.insert(items.Get(j).As<String>().Utf8Value());
+      }
+      desired[name] = std::move(cg);
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!opcClient) throw Napi::Error::New(env_, "Not connected");
+    Array createdGroups = Array::New(env_);
+    Array removedGroups = Array::New(env_);
+    Array failedArr = Array::New(env_);
+    size_t added = 0, removed = 0, stateChanges = 0;
+
+    for (auto& pair : desired) {
+      const std::string& name = pair.first;
+      ConfigGroup& want = pair.second;
+      if (!groups.count(name)) {
+        CreateGroupLocked(name, static_cast<int>(want.rate), want.deadband);
+        createdGroups.Set(createdGroups.Length(), String::New(env_, name));
+      }
+      // Elastic groups keep their controller-chosen rate; the config moves their floor
+      DWORD rate = want.rate;
+      auto eit = elasticGroups.find(name);
+      if (eit != elasticGroups.end()) {
+        eit->second.minRate = want.rate;
+        eit->second.maxRate = std::max(eit->second.maxRate, want.rate);
+        eit->second.currentRate = std::max(eit->second.currentRate, want.rate);
+        rate = eit->second.currentRate;
+      }
+      GroupRate& gr = groupRates[name];
+      if (gr.requested != rate || gr.deadband != want.deadband || gr.active != want.active) {
+        if (SetGroupStateLocked(name, rate, want.deadband, want.active)) ++stateChanges;
+      }
+      if (eit != elasticGroups.end()) eit->second.currentRate = GrantedRateLocked(name);
+
+      // Committed as each step lands, so an exception part way leaves configGroups matching the refs held
+      ConfigGroup& applied = configGroups[name];
+      applied.rate = want.rate;
+      applied.deadband = want.deadband;
+      applied.active = want.active;
+      std::vector<std::string> toAdd, toRemove;
+      std::set_difference(want.items.begin(), want.items.end(), applied.items.begin(), applied.items.end(), std::back_inserter(toAdd));
+      std::set_difference(applied.items.begin(), applied.items.end(), want.items.begin(), want.items.end(), std::back_inserter(toRemove));
+      std::vector<std::string> failed;
+      AcquireItems(name, toAdd, failed);
+      std::set<std::string> bad(failed.begin(), failed.end());
+      for (const std::string& item : toAdd) {
+        if (!bad.count(item)) applied.items.insert(item);
+      }
+      added += toAdd.size() - failed.size();
+      removed += RemoveConfigItems(name, toRemove);
+      for (const std::string& item : toRemove) applied.items.erase(item);
+      for (const std::string& item : failed) {
+        Object f = Object::New(env_);
+        f.Set("group", String::New(env_, name));
+        f.Set("item", String::New(env_, item));
+        failedArr.Set(failedArr.Length(), f);
+      }
+    }
+
+    std::vector<std::string> dropped;
+    for (const auto& pair : configGroups) {
+      if (!desired.count(pair.first)) dropped.push_back(pair.first);
+    }
+    for (const std::string& name : dropped) {
+      ConfigGroup& old = configGroups[name];
+      removed += RemoveConfigItems(name, std::vector<std::string>(old.items.begin(), old.items.end()));
+      GroupRate& gr = groupRates[name];
+      if (gr.active && SetGroupStateLocked(name, gr.requested, gr.deadband, false)) ++stateChanges;
+      configGroups.erase(name);
+      removedGroups.Set(removedGroups.Length(), String::New(env_, name));
+    }
+
+    Object result = Object::New(env_);
+    result.Set("createdGroups", createdGroups);
+    result.Set("removedGroups", removedGroups);
+    result.Set("added", Number::New(env_, static_cast<double>(added)));
+    result.Set("removed", Number::New(env_, static_cast<double>(removed)));
+    result.Set("stateChanges", Number::New(env_, static_cast<double>(stateChanges)));
+    result.Set("failed", failedArr);
+    return result;
+  }
+
+  // setActive(groupName, items[], active) -> { changed, failed: [{ item, error }] } in one IOPCItemMgt::SetActiveState call.
+  // Covers items the addon created (applyConfig, subscribeShared, planGroups, defineView).
+  Value SetActive(const CallbackInfo& info) {
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsArray()) throw Napi::TypeError::New(env_, "groupName, items[], active expected");
+    std::string groupName = info[0].As<String>().Utf8Value();
+    Array arr = info[1].As<Array>();
+    bool active = info[2].ToBoolean().Value();
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto git = groups.find(groupName);
+    if (git == groups.end()) throw Napi::Error::New(env_, "Group not found");
+    auto& refs = sharedItems[groupName];
+    std::vector<COPCItem*> targets;
+    std::vector<SharedItem*> targetRefs;
+    std::vector<std::string> targetNames;
+    Array failed = Array::New(env_);
+    for (uint32_t i = 0; i < arr.Length(); ++i) {
+      std::string name = arr.Get(i).As<String>().Utf8Value();
+      auto it = refs.find(name);
+      if (it == refs.end() || !it->second.item) {
+        Object f = Object::New(env_);
+        f.Set("item", String::New(env_, name));
+        f.Set("error", String::New(env_, "Item not found"));
+        failed.Set(failed.Length(), f);
+        continue;
+      }
+      targets.push_back(it->second.item);
+      targetRefs.push_back(&it->second);
+      targetNames.push_back(name);
+    }
+    std::vector<HRESULT> errors;
+    SetItemsActive(git->second, targets, active, &errors);
+    size_t changed = 0;
+    for (size_t i = 0; i < targets.size(); ++i) {
+      if (SUCCEEDED(errors[i])) {
+        targetRefs[i]->active = active;
+        ++changed;
+        continue;
+      }
+      Object f = Object::New(env_);
+      f.Set("item", String::New(env_, targetNames[i]));
+      f.Set("error", Number::New(env_, static_cast<double>(errors[i])));
+      failed.Set(failed.Length(), f);
+    }
+    Object result = Object::New(env_);
+    result.Set("changed", Number::New(env_, static_cast<double>(changed)));
+    result.Set("failed", failed);
+    return result;
+  }
+
+  // defineView(name, { groupName: items[] }) -> { failed: [{ group, item }] }
+  // Items are created inactive and only scanned while a view containing them is shown.
+  Value DefineView(const CallbackInfo& info) {
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsObject()) throw Napi::TypeError::New(env_, "name, { groupName: items[] } expected");
+    std::string name = info[0].As<String>().Utf8Value();
+    Object o = info[1].As<Object>();
+    ViewSet::Items items;
+    Array groupNames = o.GetPropertyNames();
+    for (uint32_t i = 0; i < groupNames.Length(); ++i) {
+      std::string groupName = groupNames.Get(i).As<String>().Utf8Value();
+      Array arr = o.Get(groupName).As<Array>();
+      std::set<std::string>& set = items[groupName];
+      for (uint32_t j = 0; j < arr.Length(); ++j) set.insert(arr.Get(j).As<String>().Utf8Value());
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (const auto& pair : items) {
+      if (!groups.count(pair.first)) throw Napi::Error::New(env_, "Group not found: " + pair.first);
+    }
+    ViewSet::Items old;
+    if (const ViewSet::Items* existing = views.Find(name)) old = *existing;
+    Array failedArr = Array::New(env_);
+    for (auto& pair : items) {
+      const std::set<std::string>& had = old[pair.first];
+      std::vector<std::string> toAcquire, failed;
+      std::set_difference(pair.second.begin(), pair.second.end(), had.begin(), had.end(), std::back_inserter(toAcquire));
+      AcquireItems(pair.first, toAcquire, failed, false);
+      for (const std::string& item : failed) {
+        pair.second.erase(item);
+        Object f = Object::New(env_);
+        f.Set("group", String::New(env_, pair.first));
+        f.Set("item", String::New(env_, item));
+        failedArr.Set(failedArr.Length(), f);
+      }
+    }
+    std::map<std::string, std::vector<std::string>> toRelease;
+    static const std::set<std::string> kNone;
+    for (const auto& pair : old) {
+      auto kit = items.find(pair.first);
+      const std::set<std::string>& keep = kit == items.end() ? kNone : kit->second;
+      std::set_difference(pair.second.begin(), pair.second.end(), keep.begin(), keep.end(), std::back_inserter(toRelease[pair.first]));
+    }
+    ApplyViewDelta(views.Define(name, std::move(items)));
+    for (const auto& pair : toRelease) ReleaseItems(pair.first, pair.second);
+    Object result = Object::New(env_);
+    result.Set("failed", failedArr);
+    return result;
+  }
+
+  // showViews(names[]) -> { activated, deactivated, calls }: exactly these views become visible
+  Value ShowViews(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsArray()) throw Napi::TypeError::New(env_, "names[] expected");
+    Array arr = info[0].As<Array>();
+    std::vector<std::string> names(arr.Length());
+    for (uint32_t i = 0; i < arr.Length(); ++i) names[i] = arr.Get(i).As<String>().Utf8Value();
+    std::lock_guard<std::mutex> lock(mtx_);
+    return ApplyViewDelta(views.Show(names));
+  }
+
+  Value RemoveView(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "name expected");
+    std::string name = info[0].As<String>().Utf8Value();
+    std::lock_guard<std::mutex> lock(mtx_);
+    const ViewSet::Items* existing = views.Find(name);
+    if (!existing) return env_.Undefined();
+    ViewSet::Items old = *existing;
+    ApplyViewDelta(views.Remove(name));
+    for (const auto& pair : old) ReleaseItems(pair.first, std::vector<std::string>(pair.second.begin(), pair.second.end()));
+    return env_.Undefined();
+  }
+
+  // getViews() -> [{ name, shown, groups: { groupName: itemCount } }]
+  Value GetViews(const CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Array result = Array::New(env_, views.Views().size());
+    uint32_t i = 0;
+    for (const auto& view : views.Views()) {
+      Object groupsObj = Object::New(env_);
+      for (const auto& pair : view.second) groupsObj.Set(pair.first, Number::New(env_, static_cast<double>(pair.second.size())));
+      Object v = Object::New(env_);
+      v.Set("name", String::New(env_, view.first));
+      v.Set("shown", Napi::Boolean::New(env_, views.Shown(view.first)));
+      v.Set("groups", groupsObj);
+      result.Set(i++, v);
+    }
+    return result;
+  }
+
+  // setDatatypes(groupName, items[] | null, type) -> { changed, failed: [{ item, error }] }
+  // Asks the server to deliver the items as type (e.g. 'double' so numeric tags published as strings take the
+  // numeric path) in one SetDatatypes call. items null also makes type the group default for items added later.
+  Value SetDatatypes(const CallbackInfo& info) {
+    if (info.Length() < 3 || !info[0].IsString()) throw Napi::TypeError::New(env_, "groupName, items[] or null, type expected");
+    std::string groupName = info[0].As<String>().Utf8Value();
+    VARTYPE type = ParseDatatype(info[2]);
+    bool wholeGroup = info[1].IsNull() || info[1].IsUndefined();
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto git = groups.find(groupName);
+    if (git == groups.end()) throw Napi::Error::New(env_, "Group not found");
+    auto& refs = sharedItems[groupName];
+    std::vector<std::string> names;
+    if (wholeGroup) {
+      if (type == VT_EMPTY) groupDatatypes.erase(groupName);
+      else groupDatatypes[groupName] = type;
+      for (const auto& pair : refs) names.push_back(pair.first);
+    } else {
+      Array arr = info[1].As<Array>();
+      for (uint32_t i = 0; i < arr.Length(); ++i) names.push_back(arr.Get(i).As<String>().Utf8Value());
+    }
+    std::vector<COPCItem*> targets;
+    std::vector<SharedItem*> targetRefs;
+    std::vector<std::string> targetNames;
+    Array failed = Array::New(env_);
+    for (const std::string& name : names) {
+      auto it = refs.find(name);
+      if (it == refs.end() || !it->second.item) {
+        if (wholeGroup) continue;
+        Object f = Object::New(env_);
+        f.Set("item", String::New(env_, name));
+        f.Set("error", String::New(env_, "Item not found"));
+        failed.Set(failed.Length(), f);
+        continue;
+      }
+      if (it->second.datatype == type) continue;  // Already granted
+      targets.push_back(it->second.item);
+      targetRefs.push_back(&it->second);
+      targetNames.push_back(name);
+    }
+    std::vector<HRESULT> errors;
+    SetItemDatatypes(git->second, targets, type, &errors);
+    size_t changed = 0;
+    for (size_t i = 0; i < targets.size(); ++i) {
+      if (SUCCEEDED(errors[i])) {
+        targetRefs[i]->datatype = type;
+        ++changed;
+        continue;
+      }
+      Object f = Object::New(env_);
+      f.Set("item", String::New(env_, targetNames[i]));
+      f.Set("error", Number::New(env_, static_cast<double>(errors[i])));
+      failed.Set(failed.Length(), f);
+    }
+    Object result = Object::New(env_);
+    result.Set("changed", Number::New(env_, static_cast<double>(changed)));
+    result.Set("failed", failed);
+    return result;
+  }
+
+  // getDatatypes(groupName) -> { default, items: { itemName: type } } (types granted by the server)
+  Value GetDatatypes(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "groupName expected");
+    std::string groupName = info[0].As<String>().Utf8Value();
+    std::lock_guard<std::mutex> lock(mtx_);
+    Object items = Object::New(env_);
+    auto rit = sharedItems.find(groupName);
+    if (rit != sharedItems.end()) {
+      for (const auto& pair : rit->second) {
+        if (pair.second.item) items.Set(pair.first, String::New(env_, DatatypeName(pair.second.datatype)));
+      }
+    }
+    auto dit = groupDatatypes.find(groupName);
+    Object result = Object::New(env_);
+    result.Set("default", String::New(env_, DatatypeName(dit == groupDatatypes.end() ? VT_EMPTY : dit->second)));
+    result.Set("items", items);
+    return result;
+  }
+
+  // readMaxAge(groupName, items[], maxAgeMs | maxAgeMs[] | Uint32Array) -> Promise<[{ item, value, quality, timestamp, error }]>
+  // IOPCSyncIO2::ReadMaxAge on a worker: each item comes from the server cache when it is fresh enough, else from
+  // the device (0 forces a device read, 0xFFFFFFFF accepts any cached value).
+  Value ReadMaxAge(const CallbackInfo& info) {
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsArray()) throw Napi::TypeError::New(env_, "groupName, items[], maxAge expected");
+    std::string groupName = info[0].As<String>().Utf8Value();
+    std::vector<std::string> names = StringArray(info[1].As<Array>());
+    std::vector<DWORD> maxAges = ParseMaxAges(info[2], names.size());
+
+    auto* worker = new ReadMaxAgeWorker(info.This().As<Object>(), this, std::move(names), std::move(maxAges));
+    Napi::Promise promise = worker->GetPromise();
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      auto git = groups.find(groupName);
+      if (git == groups.end() || !git->second) {
+        delete worker;
+        throw Napi::Error::New(env_, "Group not found");
+      }
+      ATL::CComQIPtr<IOPCSyncIO2> io2(git->second->getSychIOInterface());
+      if (!io2) {
+        delete worker;
+        throw Napi::Error::New(env_, "Server does not support IOPCSyncIO2 (OPC DA 3.0)");
+      }
+      auto rit = sharedItems.find(groupName);
+      worker->Resolve(io2, rit != sharedItems.end() ? &rit->second : nullptr);
+    }
+    worker->Queue();
+    return promise;
+  }
+
+  // refreshMaxAge(groupName, maxAgeMs) -> cancelId. IOPCAsyncIO3::RefreshMaxAge: every active item of the group is
+  // sent through its subscription, from the cache when fresh enough, so the group must be subscribed.
+  Value RefreshMaxAge(const CallbackInfo& info) {
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber()) throw Napi::TypeError::New(env_, "groupName, maxAgeMs expected");
+    std::string groupName = info[0].As<String>().Utf8Value();
+    DWORD maxAge = info[1].As<Number>().Uint32Value();
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto git = groups.find(groupName);
+    if (git == groups.end() || !git->second) throw Napi::Error::New(env_, "Group not found");
+    if (!tsfns.count(groupName) && !fanoutTsfns.count(groupName)) throw Napi::Error::New(env_, "Group is not subscribed");
+    ATL::CComQIPtr<IOPCAsyncIO3> io3(git->second->getAsych2IOInterface());
+    if (!io3) throw Napi::Error::New(env_, "Server does not support IOPCAsyncIO3 (OPC DA 3.0)");
+    DWORD cancelId = 0;
+    HRESULT hr = io3->RefreshMaxAge(maxAge, ++nextTransactionId, &cancelId);
+    if (FAILED(hr)) throw Napi::Error::New(env_, "RefreshMaxAge failed: " + std::to_string(hr));
+    return Number::New(env_, cancelId);
+  }
+
+  // writeVQT(groupName, items[], { values, qualities, timestamps }, { async }) -> Promise<{ failed: [{ item, error }] }>
+  // values: any numeric typed array (its element type picks the VARIANT type); qualities: Uint16Array, optional;
+  // timestamps: Float64Array of JS ms, optional, NaN leaves that point's timestamp to the server.
+  // Sync goes through IOPCSyncIO2::WriteVQT on a worker; { async: true } issues IOPCAsyncIO3::WriteVQT and
+  // resolves with the server's per-item results (and the cancel id) once it reports the write complete.
+  Value WriteVQT(const CallbackInfo& info) {
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsArray() || !info[2].IsObject()) {
+      throw Napi::TypeError::New(env_, "groupName, items[], { values, qualities, timestamps } expected");
+    }
+    std::string groupName = info[0].As<String>().Utf8Value();
+    std::vector<std::string> names = StringArray(info[1].As<Array>());
+    size_t n = names.size();
+    Object data = info[2].As<Object>();
+    bool async = info.Length() > 3 && info[3].IsObject() && info[3].As<Object>().Get("async").ToBoolean().Value();
+
+    std::vector<OPCITEMVQT> vqts = ParseVQTs(data, n);
+
+    auto* worker = new WriteVQTWorker(info.This().As<Object>(), this, std::move(names), std::move(vqts));
+    Napi::Promise promise = worker->GetPromise();
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      auto git = groups.find(groupName);
+      ATL::CComQIPtr<IOPCSyncIO2> io2;
+      ATL::CComQIPtr<IOPCAsyncIO3> io3;
+      if (git != groups.end() && git->second) {
+        if (async) io3 = git->second->getAsych2IOInterface();
+        else io2 = git->second->getSychIOInterface();
+      }
+      if (git == groups.end() || !git->second || (async ? !io3 : !io2)) {
+        delete worker;
+        if (git == groups.end() || !git->second) throw Napi::Error::New(env_, "Group not found");
+        throw Napi::Error::New(env_, async ? "Server does not support IOPCAsyncIO3 (OPC DA 3.0)" : "Server does not support IOPCSyncIO2 (OPC DA 3.0)");
+      }
+      if (async && !tsfns.count(groupName) && !fanoutTsfns.count(groupName)) {
+        delete worker;
+        throw Napi::Error::New(env_, "Group is not subscribed");  // Async calls need the group's callback
+      }
+      auto rit = sharedItems.find(groupName);
+      worker->Resolve(rit != sharedItems.end() ? &rit->second : nullptr);
+      if (async) {
+        if (!worker->WriteAsync(git->second, io3)) delete worker;
+        return promise;
+      }
+      worker->SetSync(io2);
+    }
+    worker->Queue();
+    return promise;
+  }
+
+  // readItems(itemIds[], maxAge = 0) -> Promise<[{ item, value, quality, timestamp } | { item, error, cached }]>
+  // One IOPCItemIO::Read by item ID: no group, no items left behind on the server. maxAge as for readMaxAge.
+  // IDs the server rejected recently are answered from the item ID cache without a round trip.
+  Value ReadItems(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsArray()) throw Napi::TypeError::New(env_, "itemIds[] expected");
+    std::vector<std::string> names = StringArray(info[0].As<Array>());
+    std::vector<DWORD> maxAges = info.Length() > 1 ? ParseMaxAges(info[1], names.size()) : std::vector<DWORD>(names.size(), 0);
+    auto* worker = new ItemIOWorker(info.This().As<Object>(), this, std::move(names), false);
+    Napi::Promise promise = worker->GetPromise();
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      auto now = LruCache<std::string, ItemIdInfo>::Clock::now();
+      for (size_t i = 0; i < worker->Count(); ++i) {
+        ItemIdInfo* known = itemIds.Get(worker->Name(i), now);
+        if (known && FAILED(known->error)) worker->Answer(i, known->error);
+        else worker->Read(i, maxAges[i]);
+      }
+    }
+    worker->Queue();
+    return promise;
+  }
+
+  // writeItems(itemIds[], { values, qualities, timestamps }) -> Promise<{ failed: [{ item, error, cached }] }>
+  // One IOPCItemIO::WriteVQT by item ID; the arrays are the same as for writeVQT.
+  Value WriteItems(const CallbackInfo& info) {
+    if (info.Length() < 2 || !info[0].IsArray() || !info[1].IsObject()) throw Napi::TypeError::New(env_, "itemIds[], { values, qualities, timestamps } expected");
+    std::vector<std::string> names = StringArray(info[0].As<Array>());
+    std::vector<OPCITEMVQT> vqts = ParseVQTs(info[1].As<Object>(), names.size());
+    auto* worker = new ItemIOWorker(info.This().As<Object>(), this, std::move(names), true);
+    Napi::Promise promise = worker->GetPromise();
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      auto now = LruCache<std::string, ItemIdInfo>::Clock::now();
+      for (size_t i = 0; i < worker->Count(); ++i) {
+        ItemIdInfo* known = itemIds.Get(worker->Name(i), now);
+        if (known && FAILED(known->error)) worker->Answer(i, known->error);
+        else worker->Write(i, vqts[i]);
+      }
+    }
+    worker->Queue();
+    return promise;
+  }
+
+  // configureItemIdCache({ capacity, negativeTtlMs, clear })
+  Value ConfigureItemIdCache(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsObject()) throw Napi::TypeError::New(env_, "options expected");
+    Object o = info[0].As<Object>();
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (o.Has("capacity")) itemIds.SetCapacity(o.Get("capacity").As<Number>().Uint32Value());
+    if (o.Has("negativeTtlMs")) negativeTtlMs = o.Get("negativeTtlMs").As<Number>().Uint32Value();
+    if (o.Get("clear").ToBoolean().Value()) itemIds.Clear();
+    return env_.Undefined();
+  }
+
+  // getItemIdCacheStats() -> { size, capacity, hits, misses, evictions, bad }
+  Value GetItemIdCacheStats(const CallbackInfo& info) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    size_t bad = 0;
+    itemIds.ForEach([&bad](const std::string&, const ItemIdInfo& id, LruCache<std::string, ItemIdInfo>::Clock::time_point) {
+      if (FAILED(id.error)) ++bad;
+    });
+    Object result = Object::New(env_);
+    result.Set("size", Number::New(env_, static_cast<double>(itemIds.Size())));
+    result.Set("capacity", Number::New(env_, static_cast<double>(itemIds.Capacity())));
+    result.Set("hits", Number::New(env_, static_cast<double>(itemIds.Hits())));
+    result.Set("misses", Number::New(env_, static_cast<double>(itemIds.Misses())));
+    result.Set("evictions", Number::New(env_, static_cast<double>(itemIds.Evictions())));
+    result.Set("bad", Number::New(env_, static_cast<double>(bad)));
+    return result;
+  }
+
+  // loadProperties(itemIds[], { propertyIds, refresh, batch }) -> Promise<{ loaded, cached, failed: [{ item, error }] }>
+  // Fetches properties on a worker: IOPCBrowse::GetProperties for batch items per call (DA 3.0), else
+  // IOPCItemProperties item by item. Items already cached are skipped unless refresh. No propertyIds: all.
+  Value LoadProperties(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsArray()) throw Napi::TypeError::New(env_, "itemIds[] expected");
+    std::vector<std::string> names = StringArray(info[0].As<Array>());
+    std::vector<DWORD> propertyIds;
+    bool refresh = false;
+    size_t batch = 500;
+    if (info.Length() > 1 && info[1].IsObject()) {
+      Object o = info[1].As<Object>();
+      if (o.Has("propertyIds")) {
+        Array ids = o.Get("propertyIds").As<Array>();
+        for (uint32_t i = 0; i < ids.Length(); ++i) propertyIds.push_back(ids.Get(i).As<Number>().Uint32Value());
+      }
+      refresh = o.Get("refresh").ToBoolean().Value();
+      if (o.Has("batch")) batch = std::max(1u, o.Get("batch").As<Number>().Uint32Value());
+    }
+    std::vector<std::string> missing;
+    size_t cached = 0;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      for (const std::string& name : names) {
+        if (!refresh && properties.Find(name)) ++cached;
+        else missing.push_back(name);
+      }
+    }
+    auto* worker = new PropertiesWorker(info.This().As<Object>(), this, std::move(missing), std::move(propertyIds), batch, cached);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+  }
+
+  // getProperties(itemIds[], propertyIds?) -> { itemId: { propertyId: { value, description } | { error } } } from the cache;
+  // items never loaded are left out
+  Value GetProperties(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsArray()) throw Napi::TypeError::New(env_, "itemIds[] expected");
+    std::vector<std::string> names = StringArray(info[0].As<Array>());
+    std::set<uint32_t> wanted;
+    if (info.Length() > 1 && info[1].IsArray()) {
+      Array ids = info[1].As<Array>();
+      for (uint32_t i = 0; i < ids.Length(); ++i) wanted.insert(ids.Get(i).As<Number>().Uint32Value());
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    Object result = Object::New(env_);
+    for (const std::string& name : names) {
+      const std::vector<PropertyCache::Property>* props = properties.Find(name);
+      if (!props) continue;
+      Object item = Object::New(env_);
+      for (const PropertyCache::Property& p : *props) {
+        if (!wanted.empty() && !wanted.count(p.id)) continue;
+        Object prop = Object::New(env_);
+        if (p.error < 0) {
+          prop.Set("error", Number::New(env_, p.error));
+        } else {
+          prop.Set("value", ChangeValueToNapi(env_, properties.Value(p)));
+          if (const PropertyCache::Info* pi = properties.FindInfo(p.id)) prop.Set("description", String::New(env_, properties.Text(pi->description)));
+        }
+        item.Set(std::to_string(p.id), prop);
+      }
+      result.Set(name, item);
+    }
+    return result;
+  }
+
+  // savePropertyCache(path) / loadPropertyCache(path) -> { items, properties, strings }; loading merges into the cache
+  Value SavePropertyCache(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "path expected");
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!properties.Save(info[0].As<String>().Utf8Value())) throw Napi::Error::New(env_, "Failed to write property cache");
+    return PropertyCacheStats();
+  }
+
+  Value LoadPropertyCache(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "path expected");
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!properties.Load(info[0].As<String>().Utf8Value())) throw Napi::Error::New(env_, "Missing or malformed property cache");
+    return PropertyCacheStats();
+  }
+
+  // validateItems(itemIds[] | { groupName: { items: [] } }, { force, batch }) -> Promise<{ checked, cached, valid,
+  //   invalid: [{ item, error, cached, groups }] }>
+  // Pre-flight for a whole config: IOPCItemMgt::ValidateItems on a private inactive group, batch IDs per call.
+  // Verdicts go to the item ID cache, so IDs known bad (within negativeTtlMs) or good are not asked again unless
+  // force; addItems/applyConfig skip known-bad IDs the same way.
+  Value ValidateItems(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsObject()) throw Napi::TypeError::New(env_, "itemIds[] or config object expected");
+    std::map<std::string, std::vector<std::string>> holders;  // item -> groups that list it
+    if (info[0].IsArray()) {
+      for (const std::string& name : StringArray(info[0].As<Array>())) holders[name];
+    } else {
+      Object config = info[0].As<Object>();
+      Array groupNames = config.GetPropertyNames();
+      for (uint32_t i = 0; i < groupNames.Length(); ++i) {
+        std::string group = groupNames.Get(i).As<String>().Utf8Value();
+        Value g = config.Get(group);
+        if (!g.IsObject() || !g.As<Object>().Has("items")) continue;
+        for (const std::string& name : StringArray(g.As<Object>().Get("items").As<Array>())) holders[name].push_back(group);
+      }
+    }
+    bool force = false;
+    size_t batch = 1000;
+    if (info.Length() > 1 && info[1].IsObject()) {
+      Object o = info[1].As<Object>();
+      force = o.Get("force").ToBoolean().Value();
+      if (o.Has("batch")) batch = std::max(1u, o.Get("batch").As<Number>().Uint32Value());
+    }
+    auto* worker = new ValidateWorker(info.This().As<Object>(), this, std::move(holders), batch);
+    Napi::Promise promise = worker->GetPromise();
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      auto now = LruCache<std::string, ItemIdInfo>::Clock::now();
+      for (size_t i = 0; i < worker->Count(); ++i) {
+        ItemIdInfo* known = force ? nullptr : itemIds.Get(worker->Name(i), now);
+        if (known) worker->Answer(i, known->error);
+        else worker->Check(i);
+      }
+    }
+    worker->Queue();
+    return promise;
+  }
+
+  // discoverServers(hosts[], { concurrency, timeoutMs }) -> Promise<[{ host, servers: [{ progId, clsid, userType }],
+  //   error, timedOut, ms }]>
+  // Asks each host's OpcEnum for DA 1.0/2.0/3.0 servers, at most concurrency hosts at a time. A host that has not
+  // answered within timeoutMs is reported as timed out without holding up the rest. Found progID -> CLSID
+  // pairs go to the CLSID cache.
+  Value DiscoverServers(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsArray()) throw Napi::TypeError::New(env_, "hosts[] expected");
+    std::vector<std::string> hosts = StringArray(info[0].As<Array>());
+    size_t concurrency = 8;
+    uint32_t timeoutMs = 5000;
+    if (info.Length() > 1 && info[1].IsObject()) {
+      Object o = info[1].As<Object>();
+      if (o.Has("concurrency")) concurrency = std::max(1u, o.Get("concurrency").As<Number>().Uint32Value());
+      if (o.Has("timeoutMs")) timeoutMs = o.Get("timeoutMs").As<Number>().Uint32Value();
+    }
+    auto* worker = new DiscoverWorker(info.This().As<Object>(), this, std::move(hosts), concurrency, timeoutMs);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+  }
+
+  // saveClsidCache(path) / loadClsidCache(path) -> number of entries; loading merges into the cache
+  Value SaveClsidCache(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "path expected");
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!clsids.Save(info[0].As<String>().Utf8Value())) throw Napi::Error::New(env_, "Failed to write CLSID cache");
+    return Number::New(env_, static_cast<double>(clsids.Size()));
+  }
+
+  Value LoadClsidCache(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "path expected");
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!clsids.Load(info[0].As<String>().Utf8Value())) throw Napi::Error::New(env_, "Missing or malformed CLSID cache");
+    return Number::New(env_, static_cast<double>(clsids.Size()));
+  }
+
+  // enableRedundancy({ host, progId, standbyRate, checkMs, failAfter, recoverAfter, failback, livenessMs, keepAliveMs }, cb)
+  //   -> Promise<{ groups, items, failed }>; cb({ type: 'health' | 'failover', data })
+  // Connects the backup server and registers a twin of every group and registry item there: inactive, or scanning
+  // at standbyRate for a warm cache. Every checkMs both servers' GetStatus (dwServerState) is sampled, and with
+  // livenessMs the active side must also have delivered a callback (set keepAliveMs so quiet groups still do).
+  // Failover flips group activity and the pipelines' source; subscriptions, views and item handles carry over.
+  Value EnableRedundancy(const CallbackInfo& info) {
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsFunction()) throw Napi::TypeError::New(env_, "options, callback expected");
+    Object o = info[0].As<Object>();
+    if (!o.Get("host").IsString() || !o.Get("progId").IsString()) throw Napi::TypeError::New(env_, "host, progId expected");
+    StopRedundancy();
+    RedundancyOptions opts;
+    if (o.Has("checkMs")) opts.checkMs = std::max(50u, o.Get("checkMs").As<Number>().Uint32Value());
+    if (o.Has("failAfter")) opts.failAfter = std::max(1u, o.Get("failAfter").As<Number>().Uint32Value());
+    if (o.Has("recoverAfter")) opts.recoverAfter = std::max(1u, o.Get("recoverAfter").As<Number>().Uint32Value());
+    if (o.Has("failback")) opts.failback = o.Get("failback").ToBoolean().Value();
+    if (o.Has("livenessMs")) opts.livenessMs = o.Get("livenessMs").As<Number>().Uint32Value();
+
+    napi_threadsafe_function tsfn;
+    napi_status status = napi_create_threadsafe_function(
+      env_, info[1], nullptr, Napi::String::New(env_, "OPCRedundancy"),
+      0, 1, nullptr, nullptr, this, &OPCDA::DeliverRedundancyEvents, &tsfn
+    );
+    if (status != napi_ok) throw Napi::Error::New(env_, "Failed to create tsfn");
+    COPCClient* client = new COPCClient();
+    AcquireClientRuntime(client);
+    client->SetDisconnectCallback(OPCDisconnectCb);
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      redundancyTsfn = tsfn;
+      redundancyOpts = opts;
+      standbyHost = o.Get("host").As<String>().Utf8Value();
+      standbyProgId = o.Get("progId").As<String>().Utf8Value();
+      standbyRate = o.Has("standbyRate") ? o.Get("standbyRate").As<Number>().Uint32Value() : 0;
+      keepAliveMs = o.Has("keepAliveMs") ? o.Get("keepAliveMs").As<Number>().Uint32Value() : 0;
+    }
+    auto* worker = new RedundancyWorker(info.This().As<Object>(), this, client);
+    Napi::Promise promise = worker->GetPromise();
+    worker->Queue();
+    return promise;
+  }
+
+  // disableRedundancy(): the active server stays, the other one is disconnected
+  Value DisableRedundancy(const CallbackInfo& info) {
+    StopRedundancy();
+    return env_.Undefined();
+  }
+
+  // failover(): switches to the other server at the next check, whatever its health (maintenance)
+  Value Failover(const CallbackInfo& info) {
+    if (!redundancy.Running()) throw Napi::Error::New(env_, "Redundancy not enabled");
+    failoverRequested = true;
+    return env_.Undefined();
+  }
+
+  // getRedundancy() -> { enabled, active: 'primary' | 'backup', switches, droppedEvents, primary: health, backup: health }
+  Value GetRedundancy(const CallbackInfo& info) {
+    Object result = Object::New(env_);
+    bool enabled = redundancy.Running();
+    result.Set("enabled", Napi::Boolean::New(env_, enabled));
+    if (!enabled) return result;
+    result.Set("active", String::New(env_, redundancy.OnPreferred() ? "primary" : "backup"));
+    result.Set("switches", Number::New(env_, static_cast<double>(redundancy.Switches())));
+    result.Set("droppedEvents", Number::New(env_, static_cast<double>(redundancy.DroppedEvents())));
+    result.Set("primary", SideHealthToNapi(env_, redundancy.Health(true)));
+    result.Set("backup", SideHealthToNapi(env_, redundancy.Health(false)));
+    return result;
+  }
+
+  // startStatusPoller({ intervalMs, skewThresholdMs, history }, cb?) -> cb({ type: 'serverState' | 'clockSkew' |
+  //   'statusError' | 'statusRecovered', data })
+  // Polls IOPCServer::GetStatus of the active server on a background thread (right away, then every intervalMs).
+  // Clock skew is ftCurrentTime against the local clock at the midpoint of the call; crossing skewThresholdMs
+  // either way is an event, as is every dwServerState change.
+  Value StartStatusPoller(const CallbackInfo& info) {
+    StopStatus();
+    StatusOptions opts;
+    if (info.Length() > 0 && info[0].IsObject()) {
+      Object o = info[0].As<Object>();
+      if (o.Has("intervalMs")) opts.intervalMs = std::max(100u, o.Get("intervalMs").As<Number>().Uint32Value());
+      if (o.Has("skewThresholdMs")) opts.skewThresholdMs = o.Get("skewThresholdMs").As<Number>().DoubleValue();
+      if (o.Has("history")) opts.history = o.Get("history").As<Number>().Uint32Value();
+    }
+    if (info.Length() > 1 && info[1].IsFunction()) {
+      napi_threadsafe_function tsfn;
+      napi_status status = napi_create_threadsafe_function(
+        env_, info[1], nullptr, Napi::String::New(env_, "OPCStatus"),
+        0, 1, nullptr, nullptr, this, &OPCDA::DeliverStatusEvents, &tsfn
+      );
+      if (status != napi_ok) throw Napi::Error::New(env_, "Failed to create tsfn");
+      statusTsfn = tsfn;
+    }
+    statusScheduled = false;
+    statusMonitor.Start(opts, [this] { StatusPoll(); },
+      [this] {
+        if (!statusTsfn || statusScheduled.exchange(true)) return;
+        if (napi_call_threadsafe_function(statusTsfn, nullptr, napi_tsfn_nonblocking) != napi_ok) statusScheduled = false;
+      },
+      [] { CoInitializeEx(nullptr, COINIT_MULTITHREADED); },
+      [] { CoUninitialize(); });
+    return env_.Undefined();
+  }
+
+  Value StopStatusPoller(const CallbackInfo& info) {
+    StopStatus();
+    return env_.Undefined();
+  }
+
+  // getServerStatus({ history }) -> { running, last: { state, bandwidth, groupCount, serverTime, startTime,
+  //   lastUpdateTime, skewMs, rttMs, version } | null, stats: { samples, errors, stateChanges, window, skew: { minMs,
+  //   maxMs, meanMs }, rttMeanMs, rttMaxMs, bandwidthMean, bandwidthMax }, droppedEvents, history? }
+  // From the poller's samples; no server call
+  Value GetServerStatus(const CallbackInfo& info) {
+    bool withHistory = info.Length() > 0 && info[0].IsObject() && info[0].As<Object>().Get("history").ToBoolean().Value();
+    Object result = Object::New(env_);
+    result.Set("running", Napi::Boolean::New(env_, statusMonitor.Running()));
+    StatusSample last;
+    if (statusMonitor.Last(last)) result.Set("last", StatusSampleToNapi(env_, last));
+    else result.Set("last", env_.Null());
+    StatusStats st = statusMonitor.Stats();
+    Object stats = Object::New(env_);
+    stats.Set("samples", Number::New(env_, static_cast<double>(st.samples)));
+    stats.Set("errors", Number::New(env_, static_cast<double>(st.errors)));
+    stats.Set("stateChanges", Number::New(env_, static_cast<double>(st.stateChanges)));
+    stats.Set("window", Number::New(env_, static_cast<double>(st.window)));
+    Object skew = Object::New(env_);
+    skew.Set("minMs", Number::New(env_, st.skewMinMs));
+    skew.Set("maxMs", Number::New(env_, st.skewMaxMs));
+    skew.Set("meanMs", Number::New(env_, st.skewMeanMs));
+    stats.Set("skew", skew);
+    stats.Set("rttMeanMs", Number::New(env_, st.rttMeanMs));
+    stats.Set("rttMaxMs", Number::New(env_, st.rttMaxMs));
+    stats.Set("bandwidthMean", Number::New(env_, st.bandwidthMean));
+    stats.Set("bandwidthMax", Number::New(env_, st.bandwidthMax));
+    result.Set("stats", stats);
+    result.Set("droppedEvents", Number::New(env_, static_cast<double>(statusMonitor.DroppedEvents())));
+    if (withHistory) {
+      std::deque<StatusSample> history = statusMonitor.History();
+      Array arr = Array::New(env_, history.size());
+      for (uint32_t i = 0; i < history.size(); ++i) arr.Set(i, StatusSampleToNapi(env_, history[i]));
+      result.Set("history", arr);
+    }
+    return result;
+  }
+
+  // pollItems(groupName, items[], periodMs, { source: 'device' | 'cache' }) -> { added, failed: [] }
+  // For servers whose OnDataChange cannot be trusted: the items are read natively every periodMs, all items of the
+  // group with the same period in one IOPCSyncIO::Read, and only values that changed (value, quality or error)
+  // enter the group's change pipeline, so subscribe() handlers see them like callbacks. Device reads leave the
+  // items inactive; cache reads activate them, so a (group, period) keeps the source it was first polled from.
+  Value PollItems(const CallbackInfo& info) {
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsArray() || !info[2].IsNumber()) {
+      throw Napi::TypeError::New(env_, "groupName, items[], periodMs expected");
+    }
+    std::string groupName = info[0].As<String>().Utf8Value();
+    std::vector<std::string> names = StringArray(info[1].As<Array>());
+    uint32_t period = info[2].As<Number>().Uint32Value();
+    if (period == 0) throw Napi::RangeError::New(env_, "periodMs must be positive");
+    OPCDATASOURCE source = OPC_DS_DEVICE;
+    if (info.Length() > 3 && info[3].IsObject()) {
+      Napi::Value src = info[3].As<Object>().Get("source");
+      if (src.IsString()) {
+        std::string name = src.As<String>().Utf8Value();
+        if (name == "cache") source = OPC_DS_CACHE;
+        else if (name != "device") throw Napi::TypeError::New(env_, "source must be 'device' or 'cache'");
+      }
+    }
+    PollScheduler::Key key(groupName, period);
+    Array failedArr = Array::New(env_);
+    size_t added = 0;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (stopping) throw Napi::Error::New(env_, "Client is shut down");
+      if (!groups.count(groupName)) throw Napi::Error::New(env_, "Group not found");
+      auto existing = pollTasks.find(key);
+      if (existing != pollTasks.end() && existing->second.source != source) {
+        throw Napi::Error::New(env_, std::string("Items of this group are already polled at this period from the ") +
+                                     (existing->second.source == OPC_DS_CACHE ? "cache" : "device"));
+      }
+      PollTask& task = pollTasks[key];
+      task.source = source;
+      std::vector<std::string> toAdd;
+      for (const std::string& name : names) {
+        if (!task.items.count(name)) toAdd.push_back(name);
+      }
+      std::vector<std::string> failed;
+      AcquireItems(groupName, toAdd, failed, source == OPC_DS_CACHE);
+      std::set<std::string> bad(failed.begin(), failed.end());
+      for (const std::string& name : toAdd) {
+        if (bad.count(name)) continue;
+        task.items.insert(name);
+        ++added;
+      }
+      for (const std::string& name : failed) failedArr.Set(failedArr.Length(), String::New(env_, name));
+      if (task.items.empty()) pollTasks.erase(key);
+    }
+    if (added) {
+      if (!pollScheduler.Running()) {
+        pollScheduler.Start([this](const PollScheduler::Key& k) { PollRelease(k); },
+          [] { CoInitializeEx(nullptr, COINIT_MULTITHREADED); },
+          [] { CoUninitialize(); });
+      }
+      pollScheduler.Add(key);
+    }
+    Object result = Object::New(env_);
+    result.Set("added", Number::New(env_, static_cast<double>(added)));
+    result.Set("failed", failedArr);
+    return result;
+  }
+
+  // unpollItems(groupName, items[] | null, periodMs?) -> number of items no longer polled
+  // Without periodMs every period of the group is affected; null items means all of them
+  Value UnpollItems(const CallbackInfo& info) {
+    if (info.Length() < 1 || !info[0].IsString()) throw Napi::TypeError::New(env_, "groupName expected");
+    std::string groupName = info[0].As<String>().Utf8Value();
+    bool all = info.Length() < 2 || !info[1].IsArray();
+    std::vector<std::string> names = all ? std::vector<std::string>() : StringArray(info[1].As<Array>());
+    bool anyPeriod = info.Length() < 3 || !info[2].IsNumber();
+    uint32_t period = anyPeriod ? 0 : info[2].As<Number>().Uint32Value();
+    size_t removed = 0;
+    std::vector<PollScheduler::Key> emptied;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      for (auto& pair : pollTasks) {
+        if (pair.first.first != groupName || (!anyPeriod && pair.first.second != period)) continue;
+        PollTask& task = pair.second;
+        std::vector<std::string> dropped;
+        for (const std::string& name : all ? std::vector<std::string>(task.items.begin(), task.items.end()) : names) {
+          if (!task.items.erase(name)) continue;
+          task.filter.Forget(name);
+          dropped.push_back(name);
+        }
+        ReleaseItems(groupName, dropped);
+        removed += dropped.size();
+        if (task.items.empty()) emptied.push_back(pair.first);
+      }
+      for (const PollScheduler::Key& key : emptied) pollTasks.erase(key);
+    }
+    for (const PollScheduler::Key& key : emptied) pollScheduler.Remove(key);
+    return Number::New(env_, static_cast<double>(removed));
+  }
+
+  // getPollStats() -> [{ group, periodMs, items, source, runs, missed, lateMsMax, lateMsMean, durationMsMax,
+  //   lastDurationMs, changes, lastError }]
+  Value GetPollStats(const CallbackInfo& info) {
+    std::map<PollScheduler::Key, PollTaskStats> stats = pollScheduler.Stats();
+    std::lock_guard<std::mutex> lock(mtx_);
+    Array result = Array::New(env_);
+    for (const auto& pair : pollTasks) {
+      const PollTask& task = pair.second;
+      PollTaskStats st;
+      auto sit = stats.find(pair.first);
+      if (sit != stats.end()) st = sit->second;
+      Object o = Object::New(env_);
+      o.Set("group", String::New(env_, pair.first.first));
+      o.Set("periodMs", Number::New(env_, pair.first.second));
+      o.Set("items", Number::New(env_, static_cast<double>(task.items.size())));
+      o.Set("source", String::New(env_, task.source == OPC_DS_CACHE ? "cache" : "device"));
+      o.Set("runs", Number::New(env_, static_cast<double>(st.runs)));
+      o.Set("missed", Number::New(env_, static_cast<double>(st.missed)));
+      o.Set("lateMsMax", Number::New(env_, st.lateNsMax / 1e6));
+      o.Set("lateMsMean", Number::New(env_, st.runs ? st.lateNsSum / 1e6 / st.runs : 0.0));
+      o.Set("durationMsMax", Number::New(env_, st.durationNsMax / 1e6));
+      o.Set("lastDurationMs", Number::New(env_, st.lastDurationNs / 1e6));
+      o.Set("changes", Number::New(env_, static_cast<double>(task.changes)));
+      o.Set("lastError", Number::New(env_, static_cast<double>(task.lastError)));
+      result.Set(result.Length(), o);
+    }
+    return result;
+  }
+
+private:
+  // Caller holds mtx_
+  Object PropertyCacheStats() {
+    Object result = Object::New(env_);
+    result.Set("items", Number::New(env_, static_cast<double>(properties.Items())));
+    result.Set("properties", Number::New(env_, static_cast<double>(properties.Properties())));
+    result.Set("strings", Number::New(env_, static_cast<double>(properties.PoolStrings())));
+    return result;
+  }
+
+  static std::vector<std::string> StringArray(const Array& arr) {
+    std::vector<std::string> out(arr.Length());
+    for (uint32_t i = 0; i < arr.Length(); ++i) out[i] = arr.Get(i).As<String>().Utf8Value();
+    return out;
+  }
+
+  // Caller holds mtx_. Records the server's verdict on an item ID; only bad-ID errors make a negative entry.
+  void NoteItemId(const std::string& id, HRESULT error) {
+    if (SUCCEEDED(error)) {
+      itemIds.Put(id, ItemIdInfo{S_OK});
+    } else if (IsBadItemId(error)) {
+      itemIds.Put(id, ItemIdInfo{error}, LruCache<std::string, ItemIdInfo>::Clock::now() + std::chrono::milliseconds(negativeTtlMs));
+    }
+  }
+
+  // Worker threads, without mtx_. Server object for interfaces the toolkit does not expose (IOPCItemIO, IOPCBrowse,
+  // status): COPCServer keeps its COM pointers private, so the addon opens its own reference to the same server.
+  // It is opened on comThread with mtx_ released (activation can take seconds) and cached if the connection is
+  // still the one it was opened for.
+  HRESULT DirectServer(ATL::CComPtr<IOPCServer>& out) {
+    std::string host, progId, clsid;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (directServer) {
+        out = directServer;
+        return S_OK;
+      }
+      if (serverProgId.empty()) return E_UNEXPECTED;  // connect() was never called
+      host = serverHost;
+      progId = serverProgId;
+      if (const std::string* c = clsids.Find(host, progId)) clsid = *c;
+    }
+    ATL::CComPtr<IOPCServer> server;
+    HRESULT hr = comThread.Run([&] { return OpenServer(host, progId, clsid, server, clsid); });
+    if (FAILED(hr)) return hr;
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (serverHost == host && serverProgId == progId) {
+      clsids.Put(host, progId, clsid);
+      if (!directServer) directServer = server;
+      out = directServer;
+    } else {
+      out = server;
+    }
+    return S_OK;
+  }
+
+  // Activates progId on host. A known CLSID skips the lookup; if the server was re-registered under another
+  // one, it is looked up once more. clsid receives the CLSID that worked.
+  static HRESULT OpenServer(const std::string& hostName, const std::string& progIdName, const std::string& knownClsid,
+                            ATL::CComPtr<IOPCServer>& out, std::string& clsidOut) {
+    bool local = ClsidCache::NormalizeHost(hostName).empty();
+    std::wstring host = Utf8ToWide(hostName);
+    std::wstring progId = Utf8ToWide(progIdName);
+    COSERVERINFO serverInfo = {};
+    serverInfo.pwszName = const_cast<LPWSTR>(host.c_str());
+    CLSID clsid;
+    bool cached = !knownClsid.empty() && SUCCEEDED(CLSIDFromString(Utf8ToWide(knownClsid).c_str(), &clsid));
+    for (;;) {
+      HRESULT hr = S_OK;
+      if (cached) {
+        // Known from discovery or an earlier connect
+      } else if (local) {
+        hr = CLSIDFromProgID(progId.c_str(), &clsid);
+      } else {
+        // The progID is registered on the server machine only: ask its OpcEnum
+        ATL::CComPtr<IOPCServerList> serverList;
+        hr = OpenServerList(hostName, serverList);
+        if (SUCCEEDED(hr)) hr = serverList->CLSIDFromProgID(progId.c_str(), &clsid);
+      }
+      if (FAILED(hr)) return hr;
+      MULTI_QI qi = { &IID_IOPCServer, nullptr, S_OK };
+      hr = CoCreateInstanceEx(clsid, nullptr, local ? CLSCTX_LOCAL_SERVER : CLSCTX_REMOTE_SERVER, local ? nullptr : &serverInfo, 1, &qi);
+      if (SUCCEEDED(hr)) hr = qi.hr;
+      if (hr == REGDB_E_CLASSNOTREG && cached) {
+        cached = false;
+        continue;
+      }
+      if (FAILED(hr)) return hr;
+      out.Attach(static_cast<IOPCServer*>(qi.pItf));
+      clsidOut = GuidString(clsid);
+      return S_OK;
+    }
+  }
+
+  // OpcEnum of a host ("" / localhost: this machine)
+  static HRESULT OpenServerList(const std::string& hostName, ATL::CComPtr<IOPCServerList>& out) {
+    std::wstring host = Utf8ToWide(hostName);
+    bool local = ClsidCache::NormalizeHost(hostName).empty();
+    COSERVERINFO serverInfo = {};
+    serverInfo.pwszName = const_cast<LPWSTR>(host.c_str());
+    MULTI_QI qi = { &IID_IOPCServerList, nullptr, S_OK };
+    HRESULT hr = CoCreateInstanceEx(CLSID_OpcServerList, nullptr, local ? CLSCTX_LOCAL_SERVER : CLSCTX_REMOTE_SERVER,
+                                    local ? nullptr : &serverInfo, 1, &qi);
+    if (SUCCEEDED(hr)) hr = qi.hr;
+    if (SUCCEEDED(hr)) out.Attach(static_cast<IOPCServerList*>(qi.pItf));
+    return hr;
+  }
+
+  static std::string GuidString(const GUID& guid) {
+    wchar_t buf[64];
+    int n = StringFromGUID2(guid, buf, 64);
+    return n > 0 ? WideToUtf8(buf, n - 1) : std::string();
+  }
+
+  // { values, qualities, timestamps } typed arrays -> one OPCITEMVQT per item (see writeVQT)
+  std::vector<OPCITEMVQT> ParseVQTs(const Object& data, size_t n) {
+    if (!data.Get("values").IsTypedArray()) throw Napi::TypeError::New(env_, "values must be a typed array");
+    // Raw call: the array may live in a SharedArrayBuffer, which the ArrayBuffer wrapper rejects
+    napi_typedarray_type valueType;
+    size_t valueCount = 0;
+    void* valueData = nullptr;
+    napi_get_typedarray_info(env_, data.Get("values"), &valueType, &valueCount, &valueData, nullptr, nullptr);
+    if (valueCount != n) throw Napi::RangeError::New(env_, "values needs one entry per item");
+    const uint16_t* qualities = nullptr;
+    if (data.Has("qualities") && !data.Get("qualities").IsUndefined()) {
+      Napi::Value q = data.Get("qualities");
+      if (!q.IsTypedArray() || q.As<Napi::TypedArray>().TypedArrayType() != napi_uint16_array) throw Napi::TypeError::New(env_, "qualities must be a Uint16Array");
+      if (q.As<Napi::Uint16Array>().ElementLength() != n) throw Napi::RangeError::New(env_, "qualities needs one entry per item");
+      qualities = q.As<Napi::Uint16Array>().Data();
+    }
+    const double* timestamps = nullptr;
+    if (data.Has("timestamps") && !data.Get("timestamps").IsUndefined()) {
+      Napi::Value t = data.Get("timestamps");
+      if (!t.IsTypedArray() || t.As<Napi::TypedArray>().TypedArrayType() != napi_float64_array) throw Napi::TypeError::New(env_, "timestamps must be a Float64Array");
+      if (t.As<Napi::Float64Array>().ElementLength() != n) throw Napi::RangeError::New(env_, "timestamps needs one entry per item");
+      timestamps = t.As<Napi::Float64Array>().Data();
+    }
+
+    // Numeric VARIANTs only: nothing to VariantClear afterwards
+    std::vector<OPCITEMVQT> vqts(n);
+    for (size_t i = 0; i < n; ++i) {
+      OPCITEMVQT& vqt = vqts[i];
+      std::memset(&vqt, 0, sizeof(vqt));
+      if (!TypedElementToVariant(valueType, valueData, i, vqt.vDataValue)) throw Napi::TypeError::New(env_, "Unsupported values array type");
+      vqt.bQualitySpecified = qualities ? TRUE : FALSE;
+      vqt.wQuality = qualities ? qualities[i] : 0;
+      if (timestamps && timestamps[i] == timestamps[i]) {
+        uint64_t ticks = JsMsToFileTimeTicks(timestamps[i]);
+        vqt.bTimeStampSpecified = TRUE;
+        vqt.ftTimeStamp.dwLowDateTime = static_cast<DWORD>(ticks);
+        vqt.ftTimeStamp.dwHighDateTime = static_cast<DWORD>(ticks >> 32);
+      }
+    }
+    return vqts;
+  }
+
+  // Element i of a numeric typed array as a VARIANT of the matching type; false for unsupported arrays
+  static bool TypedElementToVariant(napi_typedarray_type type, const void* data, size_t i, VARIANT& v) {
+    const uint8_t* base = static_cast<const uint8_t*>(data);
+    switch (type) {
+      case napi_float64_array: v.vt = VT_R8; std::memcpy(&v.dblVal, base + i * 8, 8); return true;
+      case napi_float32_array: v.vt = VT_R4; std::memcpy(&v.fltVal, base + i * 4, 4); return true;
+      case napi_int32_array: v.vt = VT_I4; std::memcpy(&v.lVal, base + i * 4, 4); return true;
+      case napi_uint32_array: v.vt = VT_UI4; std::memcpy(&v.ulVal, base + i * 4, 4); return true;
+      case napi_int16_array: v.vt = VT_I2; std::memcpy(&v.iVal, base + i * 2, 2); return true;
+      case napi_uint16_array: v.vt = VT_UI2; std::memcpy(&v.uiVal, base + i * 2, 2); return true;
+      case napi_int8_array: v.vt = VT_I1; std::memcpy(&v.cVal, base + i, 1); return true;
+      case napi_uint8_array:
+      case napi_uint8_clamped_array: v.vt = VT_UI1; v.bVal = base[i]; return true;
+      case napi_bigint64_array: v.vt = VT_I8; std::memcpy(&v.llVal, base + i * 8, 8); return true;
+      case napi_biguint64_array: v.vt = VT_UI8; std::memcpy(&v.ullVal, base + i * 8, 8); return true;
+      default: return false;
+    }
+  }
+
+  // One age for every item, or one per item (Array or Uint32Array)
+  std::vector<DWORD> ParseMaxAges(const Napi::Value& v, size_t count) {
+    if (v.IsNumber()) return std::vector<DWORD>(count, v.As<Number>().Uint32Value());
+    std::vector<DWORD> ages;
+    if (v.IsTypedArray() && v.As<Napi::TypedArray>().TypedArrayType() == napi_uint32_array) {
+      Napi::Uint32Array typed = v.As<Napi::Uint32Array>();
+      ages.assign(typed.Data(), typed.Data() + typed.ElementLength());
+    } else if (v.IsArray()) {
+      Array arr = v.As<Array>();
+      for (uint32_t i = 0; i < arr.Length(); ++i) ages.push_back(arr.Get(i).As<Number>().Uint32Value());
+    } else {
+      throw Napi::TypeError::New(env_, "maxAge must be a number, an array or a Uint32Array");
+    }
+    if (ages.size() != count) throw Napi::RangeError::New(env_, "maxAge needs one entry per item");
+    return ages;
+  }
+
+  // Caller holds mtx_. At most one activate and one deactivate SetActiveState call per group. Items that
+  // leave the visible set stay active while something besides the views (a subscriber, the config) holds them.
+  Object ApplyViewDelta(const std::map<std::string, ViewSet::Delta>& delta) {
+    size_t activated = 0, deactivated = 0, calls = 0;
+    for (const auto& pair : delta) {
+      auto git = groups.find(pair.first);
+      if (git == groups.end()) continue;
+      auto& refs = sharedItems[pair.first];
+      std::vector<COPCItem*> on, off;
+      std::vector<SharedItem*> onRefs, offRefs;
+      for (const std::string& name : pair.second.on) {
+        auto it = refs.find(name);
+        if (it == refs.end() || !it->second.item || it->second.active) continue;
+        on.push_back(it->second.item);
+        onRefs.push_back(&it->second);
+      }
+      for (const std::string& name : pair.second.off) {
+        auto it = refs.find(name);
+        if (it == refs.end() || !it->second.item || !it->second.active) continue;
+        if (views.NeedsScan(pair.first, name, it->second.refs)) continue;
+        off.push_back(it->second.item);
+        offRefs.push_back(&it->second);
+      }
+      std::vector<HRESULT> errors;
+      if (!on.empty()) {
+        ++calls;
+        SetItemsActive(git->second, on, true, &errors);
+        for (size_t i = 0; i < on.size(); ++i) {
+          if (FAILED(errors[i])) continue;
+          onRefs[i]->active = true;
+          ++activated;
+        }
+      }
+      if (!off.empty()) {
+        ++calls;
+        SetItemsActive(git->second, off, false, &errors);
+        for (size_t i = 0; i < off.size(); ++i) {
+          if (FAILED(errors[i])) continue;
+          offRefs[i]->active = false;
+          ++deactivated;
+        }
+      }
+    }
+    Object result = Object::New(env_);
+    result.Set("activated", Number::New(env_, static_cast<double>(activated)));
+    result.Set("deactivated", Number::New(env_, static_cast<double>(deactivated)));
+    result.Set("calls", Number::New(env_, static_cast<double>(calls)));
+    return result;
+  }
+
+  // Caller holds mtx_. Drops the config's refs; items nobody else holds are removed from the server in one
+  // IOPCItemMgt::RemoveItems call. Returns the number of refs dropped.
+  size_t RemoveConfigItems(const std::string& groupName, const std::vector<std::string>& names) {
+    auto rit = sharedItems.find(groupName);
+    if (rit == sharedItems.end() || names.empty()) return 0;
+    std::vector<COPCItem*> toRemove, kept;
+    std::vector<std::string> removing, erased, keptNames;
+    size_t dropped = 0;
+    for (const std::string& name : names) {
+      auto it = rit->second.find(name);
+      if (it == rit->second.end() || it->second.refs == 0) continue;
+      ++dropped;
+      if (--it->second.refs > 0) {
+        // Still held, but only by hidden views: stop scanning it
+        if (it->second.item && it->second.active && !views.NeedsScan(groupName, name, it->second.refs)) {
+          kept.push_back(it->second.item);
+          keptNames.push_back(name);
+        }
+        continue;
+      }
+      if (it->second.item) {
+        toRemove.push_back(it->second.item);
+        removing.push_back(name);
+      } else {
+        erased.push_back(name);
+      }
+    }
+    auto git = groups.find(groupName);
+    std::vector<bool> removed;
+    RemoveServerItems(git != groups.end() ? git->second : nullptr, toRemove, &removed);
+    // Items the server kept fall back to deactivation so scanning still stops; their refs stay for a later re-add
+    for (size_t i = 0; i < removing.size(); ++i) {
+      if (removed[i]) {
+        erased.push_back(removing[i]);
+      } else {
+        kept.push_back(toRemove[i]);
+        keptNames.push_back(removing[i]);
+      }
+    }
+    if (git != groups.end() && SUCCEEDED(SetItemsActive(git->second, kept, false))) {
+      for (const std::string& name : keptNames) rit->second[name].active = false;
+    }
+    for (const std::string& name : erased) rit->second.erase(name);
+    RemoveMirrorItemsLocked(groupName, erased);
+    return dropped;
+  }
+
+  // One IOPCItemMgt::RemoveItems round trip; removed tells which items the server removed, the others are still
+  // live on the server
+  static HRESULT RemoveItemsCall(COPCGroup* group, const std::vector<COPCItem*>& items, std::vector<bool>& removed) {
+    removed.assign(items.size(), false);
+    if (items.empty() || !group) return S_OK;
+    std::vector<OPCHANDLE> handles(items.size());
+    for (size_t i = 0; i < items.size(); ++i) handles[i] = items[i]->getHandle();
+    HRESULT* itemErrors = nullptr;
+    HRESULT hr = group->getItemManagementInterface()->RemoveItems(static_cast<DWORD>(handles.size()), handles.data(), &itemErrors);
+    for (size_t i = 0; SUCCEEDED(hr) && i < items.size(); ++i) {
+      removed[i] = !itemErrors || SUCCEEDED(itemErrors[i]);
+    }
+    if (itemErrors) CoTaskMemFree(itemErrors);
+    return hr;
+  }
+
+  // Caller holds mtx_. COPCGroup does not own its COPCItem wrappers; the ones of items the server removed are
+  // retired until the group goes (FreeRetiredItemsLocked).
+  HRESULT RemoveServerItems(COPCGroup* group, const std::vector<COPCItem*>& items, std::vector<bool>* removed = nullptr) {
+    std::vector<bool> done;
+    HRESULT hr = RemoveItemsCall(group, items, done);
+    for (size_t i = 0; i < items.size(); ++i) {
+      if (done[i]) retiredItems[group].push_back(items[i]);
+    }
+    if (removed) removed->swap(done);
+    return hr;
+  }
+
+  // Caller holds mtx_, once the client of group (all groups when null) has disconnected: no callback can still
+  // look up the retired wrappers
+  void FreeRetiredItemsLocked(COPCGroup* group) {
+    for (auto it = retiredItems.begin(); it != retiredItems.end();) {
+      if (group && it->first != group) {
+        ++it;
+        continue;
+      }
+      for (COPCItem* item : it->second) delete item;
+      it = retiredItems.erase(it);
+    }
+  }
+
+  // Controller thread: samples every pipeline, retunes elastic groups
+  void RateControlTick() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (shutDown) return;
+    std::map<std::string, GroupLoad> loads;
+    for (auto& pair : pipelines) loads[pair.first] = pair.second->Load();
+    for (const auto& change : rateController.Decide(loads, elasticGroups)) {
+      // The next step starts from the rate the server runs: the revision it granted, or the old rate if it refused
+      ApplyRateLocked(change.first, change.second);
+      elasticGroups[change.first].currentRate = GrantedRateLocked(change.first);
+    }
+  }
+
+  // Caller holds mtx_. Update rate the server actually runs the group at (requested until it reported a revision).
+  uint32_t GrantedRateLocked(const std::string& groupName) {
+    const GroupRate& gr = groupRates[groupName];
+    return static_cast<uint32_t>(gr.revised ? gr.revised : gr.requested);
+  }
+
+  // Caller holds mtx_. One setState round trip; deadband and active state are kept, the granted rate is stored.
+  bool ApplyRateLocked(const std::string& groupName, uint32_t rate) {
+    GroupRate& gr = groupRates[groupName];
+    return SetGroupStateLocked(groupName, rate, gr.deadband, gr.active);
+  }
+
+  // Caller holds mtx_
+  bool SetGroupStateLocked(const std::string& groupName, DWORD rate, float deadband, bool active) {
+    auto git = groups.find(groupName);
+    if (git == groups.end() || !git->second) return false;
+    DWORD revised = 0;
+    try {
+      git->second->setState(rate, revised, deadband, active ? TRUE : FALSE);
+    } catch (...) {
+      return false;
+    }
+    GroupRate& gr = groupRates[groupName];
+    gr.requested = rate;
+    gr.revised = revised;
+    gr.deadband = deadband;
+    gr.active = active;
+    return true;
+  }
+
+  // Caller holds mtx_
+  void CreateGroupLocked(const std::string& groupName, int rate, double deadband) {
+    bool success = opcClient->CreateGroup(groupName.c_str(), rate, deadband);
+    if (!success) throw Napi::Error::New(env_, "Failed to create group");
+    groups[groupName] = opcClient->GetGroup(groupName.c_str());
+    GroupRate& gr = groupRates[groupName];
+    gr.requested = static_cast<DWORD>(rate);
+    gr.revised = 0;
+    gr.deadband = static_cast<float>(deadband);
+    gr.active = true;
+    if (!pipelines.count(groupName)) {
+      pipelines[groupName] = std::make_unique<GroupPipeline>(groupName, metrics, watchdog);
+      if (recorder) pipelines[groupName]->SetRecorder(recorder);
+    }
+    MirrorGroupLocked(groupName);
+  }
+
+  // Caller holds mtx_. Puts sub on the group's fan-out tsfn (created, and asynch enabled, on first use).
+  void AttachSubscriber(const std::string& groupName, const std::shared_ptr<FanoutSubscriber>& sub) {
+    GroupPipeline* pipeline = pipelines[groupName].get();
+    if (!fanoutTsfns.count(groupName)) {
+      napi_threadsafe_function tsfn;
+      napi_status status = napi_create_threadsafe_function(
+        env_, nullptr, nullptr, Napi::String::New(env_, "OPCFanout"),
+        0, 1, nullptr, nullptr, nullptr, &GroupPipeline::DeliverChanges, &tsfn
+      );
+      if (status != napi_ok) throw Napi::Error::New(env_, "Failed to create tsfn");
+      fanoutTsfns[groupName] = tsfn;
+      pipeline->SetFanoutTsfn(tsfn);
+      auto git = groups.find(groupName);
+      if (git != groups.end() && !tsfns.count(groupName)) {
+        git->second->enableAsynch(*pipeline);
+        EnableTwinAsynchLocked(groupName, *pipeline);
+      }
+    }
+    sub->id = ++nextSubscriberId;
+    pipeline->AddSubscriber(sub);
+  }
+
+  // Caller holds mtx_. Takes sub off the group (releasing its item refs); the fan-out tsfn goes with the last one.
+  bool DetachSubscriber(const std::string& groupName, uint32_t id) {
+    auto pit = pipelines.find(groupName);
+    if (pit == pipelines.end()) return false;
+    std::shared_ptr<FanoutSubscriber> sub;
+    if (!pit->second->RemoveSubscriber(id, &sub)) return false;
+    if (!sub->all) ReleaseItems(groupName, std::vector<std::string>(sub->items.begin(), sub->items.end()));
+    if (pit->second->SubscriberCount() == 0) {
+      auto tit = fanoutTsfns.find(groupName);
+      if (tit != fanoutTsfns.end()) {
+        pit->second->SetFanoutTsfn(nullptr);
+        napi_release_threadsafe_function(tit->second, napi_threadsafe_function_release_mode::NAPI_TSFN_RELEASE_MODE_IMMEDIATE);
+        fanoutTsfns.erase(tit);
+      }
+    }
+    return true;
+  }
+
+  // Caller holds mtx_. Creates the server group (or reactivates one left by a dropped plan), takes item refs and
+  // routes it to the plan callback. Items the server refused stay out of the plan and are appended to failed.
+  void AddPlannedGroup(PlannedGroup&& group, std::vector<std::string>& failed) {
+    std::string name = group.name;
+    if (groups.count(name)) {
+      if (!SetGroupStateLocked(name, group.rateMs, 0.0f, true)) throw Napi::Error::New(env_, "Failed to activate group " + name);
+    } else {
+      CreateGroupLocked(name, static_cast<int>(group.rateMs), 0.0);
+    }
+    std::vector<std::string> refused;
+    AcquireItems(name, group.items, refused);
+    std::set<std::string> bad(refused.begin(), refused.end());
+    group.items.erase(std::remove_if(group.items.begin(), group.items.end(),
+                                     [&bad](const std::string& item) { return bad.count(item) > 0; }), group.items.end());
+    failed.insert(failed.end(), refused.begin(), refused.end());
+    plan->groups[name] = std::move(group);  // From here DropPlan undoes it
+    auto sub = std::make_shared<FanoutSubscriber>();
+    sub->fn = Napi::Persistent(plan->callback.Value());
+    AttachSubscriber(name, sub);
+    plan->subscribers[name] = sub->id;
+  }
+
+  // Caller holds mtx_. Undoes AddPlannedGroup for every group of the plan and clears it: the callback is detached,
+  // items released and the groups deactivated (groups are never deleted; a later plan reuses them by name).
+  void DropPlan() {
+    for (const auto& pair : plan->groups) {
+      auto sit = plan->subscribers.find(pair.first);
+      if (sit != plan->subscribers.end()) DetachSubscriber(pair.first, sit->second);
+      ReleaseItems(pair.first, pair.second.items);
+      GroupRate& gr = groupRates[pair.first];
+      if (gr.active) SetGroupStateLocked(pair.first, gr.requested, gr.deadband, false);
+    }
+    plan.reset();
+  }
+
+  // Caller holds mtx_. A reference to an item without a server item (first use, or an earlier add that failed)
+  // creates it (one addItems call for all of them); with activate, inactive items are switched on (one
+  // SetActiveState call). Names that could not be added or activated go to failed and keep no reference. A name
+  // listed twice takes one reference, as the callers release each name once.
+  void AcquireItems(const std::string& groupName, const std::vector<std::string>& names, std::vector<std::string>& failed,
+                    bool activate = true) {
+    auto& refs = sharedItems[groupName];
+    auto git = groups.find(groupName);
+    COPCGroup* group = git != groups.end() ? git->second : nullptr;
+    size_t failedBefore = failed.size();
+    std::vector<std::string> toCreate;
+    std::vector<COPCItem*> toActivate;
+    std::vector<std::string> activated;
+    std::set<std::string> seen;
+    for (const std::string& name : names) {
+      if (!seen.insert(name).second) continue;
+      SharedItem& ref = refs[name];
+      ++ref.refs;
+      if (!group) {
+        failed.push_back(name);
+      } else if (!ref.item) {
+        // Known-bad IDs (within their TTL) fail without another AddItems round trip
+        ItemIdInfo* known = itemIds.Get(name);
+        if (known && FAILED(known->error)) {
+          failed.push_back(name);
+        } else {
+          toCreate.push_back(name);
+        }
+      } else if (activate && !ref.active) {
+        toActivate.push_back(ref.item);
+        activated.push_back(name);
+      }
+    }
+    if (!toCreate.empty()) {
+      std::vector<COPCItem*> created;
+      std::vector<HRESULT> errors;
+      std::vector<std::string> mirrored;
+      try {
+        group->addItems(toCreate, created, errors, activate);
+      } catch (...) {
+        // The toolkit throws when the AddItems call itself fails: every item counts as refused
+        created.clear();
+        errors.assign(toCreate.size(), E_FAIL);
+      }
+      std::vector<COPCItem*> typed;
+      std::vector<SharedItem*> typedRefs;
+      auto dit = groupDatatypes.find(groupName);
+      for (size_t i = 0; i < toCreate.size(); ++i) {
+        SharedItem& ref = refs[toCreate[i]];
+        ref.item = i < created.size() ? created[i] : nullptr;
+        ref.active = activate && ref.item != nullptr;
+        NoteItemId(toCreate[i], ref.item ? S_OK : (i < errors.size() ? errors[i] : E_FAIL));
+        if (ref.item) mirrored.push_back(toCreate[i]);
+        if (!ref.item) failed.push_back(toCreate[i]);
+        else if (dit != groupDatatypes.end()) {
+          typed.push_back(ref.item);
+          typedRefs.push_back(&ref);
+        }
+      }
+      // The toolkit's AddItems always asks for VT_EMPTY, so the group's type follows in one SetDatatypes call
+      if (!typed.empty()) {
+        std::vector<HRESULT> typeErrors;
+        SetItemDatatypes(group, typed, dit->second, &typeErrors);
+        for (size_t i = 0; i < typed.size(); ++i) {
+          if (SUCCEEDED(typeErrors[i])) typedRefs[i]->datatype = dit->second;
+        }
+      }
+      MirrorItemsLocked(groupName, mirrored);
+    }
+    if (!toActivate.empty()) {
+      std::vector<HRESULT> activeErrors;
+      SetItemsActive(group, toActivate, true, &activeErrors);
+      for (size_t i = 0; i < activated.size(); ++i) {
+        if (SUCCEEDED(activeErrors[i])) refs[activated[i]].active = true;
+        else failed.push_back(activated[i]);
+      }
+    }
+    // The caller does not hold what failed; an item nobody else uses and that never got created goes away
+    for (size_t i = failedBefore; i < failed.size(); ++i) {
+      auto rit = refs.find(failed[i]);
+      if (rit == refs.end() || rit->second.refs == 0) continue;
+      if (--rit->second.refs == 0 && !rit->second.item) refs.erase(rit);
+    }
+  }
+
+  // Caller holds mtx_. Last reference deactivates the item so the server stops scanning it; so does the last one
+  // besides hidden views, which hold their items inactive.
+  void ReleaseItems(const std::string& groupName, const std::vector<std::string>& names) {
+    auto rit = sharedItems.find(groupName);
+    if (rit == sharedItems.end()) return;
+    auto git = groups.find(groupName);
+    std::vector<COPCItem*> toDeactivate;
+    std::vector<SharedItem*> released;
+    for (const std::string& name : names) {
+      auto it = rit->second.find(name);
+      if (it == rit->second.end() || it->second.refs == 0) continue;
+      --it->second.refs;
+      if (views.NeedsScan(groupName, name, it->second.refs) || !it->second.item || !it->second.active) continue;
+      toDeactivate.push_back(it->second.item);
+      released.push_back(&it->second);
+    }
+    if (git != groups.end() && SUCCEEDED(SetItemsActive(git->second, toDeactivate, false))) {
+      for (SharedItem* ref : released) ref->active = false;
+    }
+  }
+
+  // One IOPCItemMgt::SetDatatypes round trip, same type for all items; per-item results in errors when given
+  static HRESULT SetItemDatatypes(COPCGroup* group, const std::vector<COPCItem*>& items, VARTYPE type, std::vector<HRESULT>* errors = nullptr) {
+    if (items.empty() || !group) return S_OK;
+    std::vector<OPCHANDLE> handles(items.size());
+    for (size_t i = 0; i < items.size(); ++i) handles[i] = items[i]->getHandle();
+    std::vector<VARTYPE> types(items.size(), type);
+    HRESULT* itemErrors = nullptr;
+    HRESULT hr = group->getItemManagementInterface()->SetDatatypes(static_cast<DWORD>(handles.size()), handles.data(),
+                                                                  types.data(), &itemErrors);
+    if (errors) {
+      if (itemErrors) errors->assign(itemErrors, itemErrors + handles.size());
+      else errors->assign(handles.size(), hr);
+    }
+    if (itemErrors) CoTaskMemFree(itemErrors);
+    return hr;
+  }
+
+  // 'double', 'float', 'int32', ... or a VARTYPE number; 'native' (VT_EMPTY) asks for the canonical type again
+  VARTYPE ParseDatatype(const Napi::Value& v) {
+    if (v.IsNumber()) return static_cast<VARTYPE>(v.As<Number>().Uint32Value());
+    static const std::pair<const char*, VARTYPE> kTypes[] = {
+      {"native", VT_EMPTY}, {"double", VT_R8}, {"float", VT_R4}, {"int8", VT_I1}, {"int16", VT_I2}, {"int32", VT_I4},
+      {"int64", VT_I8}, {"uint8", VT_UI1}, {"uint16", VT_UI2}, {"uint32", VT_UI4}, {"uint64", VT_UI8},
+      {"bool", VT_BOOL}, {"string", VT_BSTR}};
+    std::string name = v.As<String>().Utf8Value();
+    for (const auto& t : kTypes) {
+      if (name == t.first) return t.second;
+    }
+    throw Napi::TypeError::New(env_, "Unknown datatype: " + name);
+  }
+
+  static std::string DatatypeName(VARTYPE vt) {
+    switch (vt) {
+      case VT_EMPTY: return "native";
+      case VT_R8: return "double";
+      case VT_R4: return "float";
+      case VT_I1: return "int8";
+      case VT_I2: return "int16";
+      case VT_I4: return "int32";
+      case VT_I8: return "int64";
+      case VT_UI1: return "uint8";
+      case VT_UI2: return "uint16";
+      case VT_UI4: return "uint32";
+      case VT_UI8: return "uint64";
+      case VT_BOOL: return "bool";
+      case VT_BSTR: return "string";
+      default: return std::to_string(vt);
+    }
+  }
+
+  // One IOPCItemMgt::SetActiveState round trip for all items; per-item results in errors when given
+  static HRESULT SetItemsActive(COPCGroup* group, const std::vector<COPCItem*>& items, bool active, std::vector<HRESULT>* errors = nullptr) {
+    if (items.empty() || !group) return S_OK;
+    std::vector<OPCHANDLE> handles(items.size());
+    for (size_t i = 0; i < items.size(); ++i) handles[i] = items[i]->getHandle();
+    HRESULT* itemErrors = nullptr;
+    HRESULT hr = group->getItemManagementInterface()->SetActiveState(static_cast<DWORD>(handles.size()), handles.data(),
+                                                                    active ? TRUE : FALSE, &itemErrors);
+    if (errors) {
+      if (itemErrors) errors->assign(itemErrors, itemErrors + handles.size());
+      else errors->assign(handles.size(), hr);
+    }
+    if (itemErrors) CoTaskMemFree(itemErrors);
+    return hr;
+  }
+
+  // Wall clock, JS epoch
+  static double JsNowMs() {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count());
+  }
+
+  static Object SideHealthToNapi(Napi::Env env, const SideHealth& h) {
+    Object o = Object::New(env);
+    o.Set("ok", Napi::Boolean::New(env, h.ok));
+    o.Set("state", Number::New(env, h.state));
+    o.Set("error", Number::New(env, h.error));
+    o.Set("stale", Napi::Boolean::New(env, h.stale));
+    return o;
+  }
+
+  // GetStatus round trip; healthy means dwServerState is OPC_STATUS_RUNNING
+  static SideHealth ProbeServer(IOPCServer* server) {
+    SideHealth h;
+    if (!server) {
+      h.error = E_POINTER;
+      return h;
+    }
+    OPCSERVERSTATUS* status = nullptr;
+    h.error = server->GetStatus(&status);
+    if (SUCCEEDED(h.error) && status) {
+      h.state = static_cast<uint32_t>(status->dwServerState);
+      h.ok = status->dwServerState == OPC_STATUS_RUNNING;
+      CoTaskMemFree(status->szVendorInfo);
+      CoTaskMemFree(status);
+    }
+    return h;
+  }
+
+  // Caller holds mtx_. Twin of the group on the standby server, with the group's registry items.
+  void MirrorGroupLocked(const std::string& name) {
+    if (!standbyClient || standbyGroups.count(name)) return;
+    auto git = groups.find(name);
+    auto pit = pipelines.find(name);
+    if (git == groups.end() || pit == pipelines.end()) return;
+    const GroupRate& gr = groupRates[name];
+    if (!standbyClient->CreateGroup(name.c_str(), static_cast<int>(standbyRate ? standbyRate : gr.requested), gr.deadband)) return;
+    StandbyGroup& twin = standbyGroups[name];
+    twin.group = standbyClient->GetGroup(name.c_str());
+    DWORD revised = 0;
+    try {
+      twin.group->setState(standbyRate ? standbyRate : gr.requested, revised, gr.deadband, standbyRate ? TRUE : FALSE);
+    } catch (...) {
+    }
+    pit->second->SetSource(git->second);
+    if (tsfns.count(name) || fanoutTsfns.count(name)) twin.group->enableAsynch(*pit->second);
+    if (keepAliveMs) {
+      SetKeepAlive(git->second, keepAliveMs);
+      SetKeepAlive(twin.group, keepAliveMs);
+    }
+    std::vector<std::string> names;
+    for (const auto& ref : sharedItems[name]) {
+      if (ref.second.item) names.push_back(ref.first);
+    }
+    MirrorItemsLocked(name, names);
+  }
+
+  // Caller holds mtx_. Asynch follows the active group's, so the twin can deliver the moment it takes over.
+  void EnableTwinAsynchLocked(const std::string& groupName, GroupPipeline& pipeline) {
+    auto tit = standbyGroups.find(groupName);
+    if (tit != standbyGroups.end() && tit->second.group) tit->second.group->enableAsynch(pipeline);
+  }
+
+  // Caller holds mtx_. Twin items are created active; the twin group's own activity decides scanning.
+  // Returns the number of names the standby server refused.
+  size_t MirrorItemsLocked(const std::string& groupName, std::vector<std::string> names) {
+    auto tit = standbyGroups.find(groupName);
+    if (tit == standbyGroups.end() || names.empty()) return 0;
+    StandbyGroup& twin = tit->second;
+    names.erase(std::remove_if(names.begin(), names.end(), [&twin](const std::string& n) { return twin.items.count(n) > 0; }), names.end());
+    if (names.empty()) return 0;
+    std::vector<COPCItem*> created;
+    std::vector<HRESULT> errors;
+    twin.group->addItems(names, created, errors, true);
+    size_t failed = 0;
+    for (size_t i = 0; i < names.size(); ++i) {
+      if (i < created.size() && created[i]) twin.items[names[i]] = created[i];
+      else ++failed;
+    }
+    return failed;
+  }
+
+  // Caller holds mtx_
+  void RemoveMirrorItemsLocked(const std::string& groupName, const std::vector<std::string>& names) {
+    auto tit = standbyGroups.find(groupName);
+    if (tit == standbyGroups.end()) return;
+    std::vector<COPCItem*> toRemove;
+    for (const std::string& name : names) {
+      auto it = tit->second.items.find(name);
+      if (it == tit->second.items.end()) continue;
+      toRemove.push_back(it->second);
+      tit->second.items.erase(it);
+    }
+    std::vector<bool> removed;
+    RemoveServerItems(tit->second.group, toRemove, &removed);
+    std::vector<COPCItem*> kept;
+    for (size_t i = 0; i < toRemove.size(); ++i) {
+      if (!removed[i]) kept.push_back(toRemove[i]);
+    }
+    SetItemsActive(tit->second.group, kept, false);
+  }
+
+  static void SetKeepAlive(COPCGroup* group, DWORD ms) {
+    ATL::CComQIPtr<IOPCGroupStateMgt2> mgt(group->getItemManagementInterface());
+    DWORD revised = 0;
+    if (mgt) mgt->SetKeepAlive(ms, &revised);
+  }
+
+  // Caller holds mtx_. Swaps the two servers. Per group: the pipeline takes the twin's callbacks from here on, and
+  // the registry's item pointers move to the twin items. The round trips that give the twin the items' activity
+  // and datatypes and the group's rate and activity are returned for ApplyPromotions; the old group is queued to
+  // drop to standby (demotions). Activating a cold twin makes the server send every active item; a warm twin is
+  // refreshed from its cache, so subscribers see current values either way. Items without a twin are queued for
+  // RebindItems.
+  std::vector<Promotion> FailoverLocked() {
+    std::vector<Promotion> promotions;
+    demotions.clear();  // Groups demoted but not yet applied are the ones being promoted now
+    for (auto& pair : standbyGroups) {
+      const std::string& name = pair.first;
+      StandbyGroup& twin = pair.second;
+      auto git = groups.find(name);
+      if (git == groups.end() || !twin.group) continue;
+      COPCGroup* old = git->second;
+      auto pit = pipelines.find(name);
+      if (pit != pipelines.end()) pit->second->SetSource(twin.group);
+
+      Promotion p;
+      p.name = name;
+      p.group = twin.group;
+      std::map<std::string, COPCItem*> oldItems;
+      std::set<std::string>& unbound = unboundItems[name];
+      unbound.clear();
+      bool anyOn = false;
+      for (auto& ref : sharedItems[name]) {
+        auto it = twin.items.find(ref.first);
+        COPCItem* replacement = it != twin.items.end() ? it->second : nullptr;
+        if (ref.second.item) oldItems[ref.first] = ref.second.item;
+        ref.second.item = replacement;
+        if (!replacement) {
+          if (ref.second.refs) unbound.insert(ref.first);
+          continue;
+        }
+        if (ref.second.active) anyOn = true;
+        else p.off.push_back(replacement);
+        if (ref.second.datatype != VT_EMPTY) p.typed[ref.second.datatype].push_back(replacement);
+      }
+      const GroupRate& gr = groupRates[name];
+      p.rate = gr.requested;
+      p.deadband = gr.deadband;
+      p.active = gr.active ? TRUE : FALSE;
+      if (standbyRate && gr.active && anyOn) p.refreshId = ++nextTransactionId;
+      promotions.push_back(std::move(p));
+      Demotion d;
+      d.group = old;
+      d.rate = standbyRate ? standbyRate : gr.requested;
+      d.deadband = gr.deadband;
+      d.active = standbyRate ? TRUE : FALSE;
+      demotions.push_back(d);
+      git->second = twin.group;
+      twin.group = old;
+      twin.items = std::move(oldItems);
+    }
+    std::swap(opcClient, standbyClient);
+    std::swap(serverHost, standbyHost);
+    std::swap(serverProgId, standbyProgId);
+    std::swap(directServer, standbyServer);
+    itemIds.Clear();  // The other server may judge IDs differently
+    redundancySinceNs = MonotonicNs();
+    return promotions;
+  }
+
+  // Monitor thread, without mtx_. Only this thread switches sides, and StopRedundancy joins it before the groups
+  // go, so the group pointers of a switch outlive the unlocked calls; the granted rates are stored under mtx_.
+  void ApplyPromotions(const std::vector<Promotion>& promotions) {
+    std::vector<DWORD> revised(promotions.size(), 0);
+    for (size_t i = 0; i < promotions.size(); ++i) {
+      const Promotion& p = promotions[i];
+      for (const auto& t : p.typed) SetItemDatatypes(p.group, t.second, t.first);
+      SetItemsActive(p.group, p.off, false);
+      try {
+        p.group->setState(p.rate, revised[i], p.deadband, p.active);
+      } catch (...) {
+        revised[i] = 0;
+      }
+      if (p.refreshId) {
+        DWORD cancelId = 0;
+        p.group->getAsych2IOInterface()->Refresh2(OPC_DS_CACHE, p.refreshId, &cancelId);
+      }
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (size_t i = 0; i < promotions.size(); ++i) {
+      auto git = groups.find(promotions[i].name);
+      if (!revised[i] || git == groups.end() || git->second != promotions[i].group) continue;
+      GroupRate& gr = groupRates[promotions[i].name];
+      if (gr.requested == promotions[i].rate) gr.revised = revised[i];  // Not retuned meanwhile
+    }
+  }
+
+  // Monitor thread, without mtx_: drops the old groups to standby (same lifetime argument as ApplyPromotions)
+  static void ApplyDemotions(const std::vector<Demotion>& pending) {
+    for (const Demotion& d : pending) {
+      DWORD revised = 0;
+      try {
+        d.group->setState(d.rate, revised, d.deadband, d.active);
+      } catch (...) {
+        // The group stays as it was; its callbacks are gated off by the pipeline's source
+      }
+    }
+  }
+
+  // Caller holds mtx_. What RebindItems creates: per group, the queued names still held and unbound, with the
+  // activity and datatype the registry records for them.
+  std::vector<Rebind> PlanRebindLocked() {
+    std::vector<Rebind> plan;
+    for (auto uit = unboundItems.begin(); uit != unboundItems.end();) {
+      auto git = groups.find(uit->first);
+      auto& refs = sharedItems[uit->first];
+      Rebind r;
+      for (const std::string& name : uit->second) {
+        auto rit = refs.find(name);
+        if (rit == refs.end() || !rit->second.refs || rit->second.item) continue;
+        r.items.push_back(name);
+        r.active.push_back(rit->second.active);
+        r.datatypes.push_back(rit->second.datatype);
+      }
+      if (git == groups.end() || r.items.empty()) {
+        uit = unboundItems.erase(uit);
+        continue;
+      }
+      r.name = uit->first;
+      r.group = git->second;
+      auto tit = standbyGroups.find(uit->first);
+      r.twin = tit != standbyGroups.end() ? tit->second.group : nullptr;
+      plan.push_back(std::move(r));
+      ++uit;
+    }
+    return plan;
+  }
+
+  // Monitor thread, without mtx_ except to bind (group lifetimes as in ApplyPromotions). Creates the planned items on
+  // the active group and their twins, then binds them in the registry. Items the server refuses leave the queue and
+  // stay unbound, like any refused item (the next acquire retries them); a failed AddItems call keeps them queued for
+  // the next tick. An item bound meanwhile wins, and the copy made here is removed again.
+  void RebindItems(std::vector<Rebind>& plan) {
+    for (Rebind& r : plan) {
+      try {
+        r.group->addItems(r.items, r.created, r.errors, false);
+      } catch (...) {
+        r.failed = true;
+        continue;
+      }
+      r.created.resize(r.items.size(), nullptr);
+      std::vector<COPCItem*> on;
+      std::map<VARTYPE, std::vector<COPCItem*>> typed;
+      std::vector<std::string> mirrored;
+      for (size_t i = 0; i < r.items.size(); ++i) {
+        if (!r.created[i]) continue;
+        mirrored.push_back(r.items[i]);
+        if (r.active[i]) on.push_back(r.created[i]);
+        if (r.datatypes[i] != VT_EMPTY) typed[r.datatypes[i]].push_back(r.created[i]);
+      }
+      for (const auto& t : typed) SetItemDatatypes(r.group, t.second, t.first);
+      SetItemsActive(r.group, on, true);
+      if (!r.twin || mirrored.empty()) continue;
+      std::vector<COPCItem*> twinCreated;
+      std::vector<HRESULT> twinErrors;
+      try {
+        r.twin->addItems(mirrored, twinCreated, twinErrors, true);  // Created active, like MirrorItemsLocked's
+      } catch (...) {
+        twinCreated.clear();
+      }
+      for (size_t i = 0; i < mirrored.size() && i < twinCreated.size(); ++i) {
+        if (twinCreated[i]) r.twinItems[mirrored[i]] = twinCreated[i];
+      }
+    }
+
+    std::map<COPCGroup*, std::vector<COPCItem*>> surplus;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      for (Rebind& r : plan) {
+        if (r.failed) continue;
+        auto uit = unboundItems.find(r.name);
+        auto git = groups.find(r.name);
+        auto tit = standbyGroups.find(r.name);
+        auto& refs = sharedItems[r.name];
+        for (size_t i = 0; i < r.items.size(); ++i) {
+          const std::string& name = r.items[i];
+          if (uit != unboundItems.end()) uit->second.erase(name);
+          auto twinIt = r.twinItems.find(name);
+          COPCItem* twinItem = twinIt != r.twinItems.end() ? twinIt->second : nullptr;
+          auto rit = refs.find(name);
+          bool bind = rit != refs.end() && rit->second.refs && !rit->second.item;
+          bind = bind && git != groups.end() && git->second == r.group;
+          if (!r.created[i]) {
+            if (bind) NoteItemId(name, i < r.errors.size() ? r.errors[i] : E_FAIL);
+            continue;
+          }
+          if (!bind) {
+            surplus[r.group].push_back(r.created[i]);
+            if (twinItem) surplus[r.twin].push_back(twinItem);
+            continue;
+          }
+          rit->second.item = r.created[i];
+          NoteItemId(name, S_OK);
+          if (!twinItem) continue;
+          if (tit != standbyGroups.end() && tit->second.group == r.twin && !tit->second.items.count(name)) {
+            tit->second.items[name] = twinItem;
+          } else {
+            surplus[r.twin].push_back(twinItem);
+          }
+        }
+        if (uit != unboundItems.end() && uit->second.empty()) unboundItems.erase(uit);
+      }
+    }
+    // Surplus items go the way RemoveMirrorItemsLocked's do: retired once removed, deactivated if the server keeps them
+    for (const auto& pair : surplus) {
+      std::vector<bool> removed;
+      RemoveItemsCall(pair.first, pair.second, removed);
+      std::vector<COPCItem*> kept;
+      for (size_t i = 0; i < pair.second.size(); ++i) {
+        if (!removed[i]) kept.push_back(pair.second[i]);
+      }
+      SetItemsActive(pair.first, kept, false);
+      std::lock_guard<std::mutex> lock(mtx_);
+      for (size_t i = 0; i < pair.second.size(); ++i) {
+        if (removed[i]) retiredItems[pair.first].push_back(pair.second[i]);
+      }
+    }
+  }
+
+  // Monitor thread: samples both servers (blocking calls run without mtx_, server references open on comThread)
+  // and fails over when told to. Every round trip of a switch, a rebind or a demotion runs after mtx_ is released.
+  // The old side is demoted once it answers again, which spares a switch away from a hung server the call that hangs.
+  void RedundancyTick() {
+    ATL::CComPtr<IOPCServer> active, standby;
+    std::string activeHost, activeProgId, activeClsid, backupHost, backupProgId, backupClsid;
+    {
+      std::unique_lock<std::mutex> lock(mtx_);
+      if (failoverRequested.exchange(false)) {
+        std::vector<Promotion> promotions = FailoverLocked();
+        redundancy.Switched(JsNowMs());
+        lock.unlock();
+        ApplyPromotions(promotions);
+        return;
+      }
+      active = directServer;
+      standby = standbyServer;
+      activeHost = serverHost;
+      activeProgId = serverProgId;
+      backupHost = standbyHost;
+      backupProgId = standbyProgId;
+      if (const std::string* c = clsids.Find(activeHost, activeProgId)) activeClsid = *c;
+      if (const std::string* c = clsids.Find(backupHost, backupProgId)) backupClsid = *c;
+    }
+    if (!active) comThread.Run([&] { return OpenServer(activeHost, activeProgId, activeClsid, active, activeClsid); });
+    if (!standby) comThread.Run([&] { return OpenServer(backupHost, backupProgId, backupClsid, standby, backupClsid); });
+    SideHealth a = ProbeServer(active);
+    SideHealth b = ProbeServer(standby);
+
+    std::vector<Rebind> rebind;
+    std::vector<Demotion> demote;
+    {
+      std::unique_lock<std::mutex> lock(mtx_);
+      if (serverHost != activeHost || serverProgId != activeProgId) return;  // Switched meanwhile
+      // A failed status call usually means a dead reference: the next tick opens a fresh one
+      if (SUCCEEDED(a.error)) directServer = active;
+      else if (directServer == active) directServer.Release();
+      if (SUCCEEDED(b.error)) standbyServer = standby;
+      else if (standbyServer == standby) standbyServer.Release();
+      if (redundancyOpts.livenessMs && a.ok) {
+        // Only groups with a callback subscriber get data callbacks; with none there is nothing to judge by
+        uint64_t last = redundancySinceNs;
+        bool watched = false;
+        for (const auto& pair : standbyGroups) {
+          auto pit = pipelines.find(pair.first);
+          if (pit == pipelines.end() || !groupRates[pair.first].active) continue;
+          if (!tsfns.count(pair.first) && !fanoutTsfns.count(pair.first)) continue;
+          watched = true;
+          last = std::max(last, pit->second->LastCallbackNs());
+        }
+        if (watched && MonotonicNs() - last > static_cast<uint64_t>(redundancyOpts.livenessMs) * 1000000ull) {
+          a.stale = true;
+          a.ok = false;
+        }
+      }
+      if (redundancy.Decide(a, b, JsNowMs())) {
+        std::vector<Promotion> promotions = FailoverLocked();
+        lock.unlock();
+        ApplyPromotions(promotions);
+        return;
+      }
+      if (a.ok && !unboundItems.empty()) rebind = PlanRebindLocked();
+      if (b.ok) demote.swap(demotions);
+    }
+    if (!rebind.empty()) RebindItems(rebind);
+    ApplyDemotions(demote);
+  }
+
+  // Status thread: one GetStatus round trip on the active server (opened on comThread without mtx_ when needed)
+  void StatusPoll() {
+    ATL::CComPtr<IOPCServer> server;
+    std::string host, progId, clsid;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      server = directServer;
+      host = serverHost;
+      progId = serverProgId;
+      if (const std::string* c = clsids.Find(host, progId)) clsid = *c;
+    }
+    if (progId.empty()) return;  // Not connected yet
+    StatusSample sample;
+    HRESULT hr = server ? S_OK : comThread.Run([&] { return OpenServer(host, progId, clsid, server, clsid); });
+    double before = JsNowMs();
+    OPCSERVERSTATUS* status = nullptr;
+    if (SUCCEEDED(hr)) hr = server->GetStatus(&status);
+    double after = JsNowMs();
+    sample.localMs = (before + after) / 2;
+    sample.rttMs = after - before;
+    sample.error = hr;
+    if (SUCCEEDED(hr) && status) {
+      sample.serverMs = FileTimeTicksToJsMs(FileTimeTicks(status->ftCurrentTime));
+      sample.startMs = FileTimeTicksToJsMs(FileTimeTicks(status->ftStartTime));
+      sample.lastUpdateMs = FileTimeTicksToJsMs(FileTimeTicks(status->ftLastUpdateTime));
+      sample.state = static_cast<uint32_t>(status->dwServerState);
+      sample.groupCount = status->dwGroupCount;
+      sample.bandwidth = status->dwBandWidth;
+      sample.major = status->wMajorVersion;
+      sample.minor = status->wMinorVersion;
+      sample.build = status->wBuildNumber;
+      CoTaskMemFree(status->szVendorInfo);
+      CoTaskMemFree(status);
+    }
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (serverHost == host && serverProgId == progId) {
+        // A failed status call usually means a dead reference: the next poll opens a fresh one
+        if (SUCCEEDED(hr) && !directServer) directServer = server;
+        else if (FAILED(hr) && directServer == server) directServer.Release();
+      }
+    }
+    statusMonitor.Record(sample);
+  }
+
+  // Scheduler thread: one release of a poll task. The read runs without mtx_; only changed items go to the pipeline.
+  void PollRelease(const PollScheduler::Key& key) {
+    ATL::CComPtr<IOPCSyncIO> io;
+    std::vector<std::string> names;
+    std::vector<OPCHANDLE> handles;
+    OPCDATASOURCE source = OPC_DS_DEVICE;
+    GroupPipeline* pipeline = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      auto tit = pollTasks.find(key);
+      auto git = groups.find(key.first);
+      auto pit = pipelines.find(key.first);
+      if (tit == pollTasks.end() || git == groups.end() || !git->second || pit == pipelines.end()) return;
+      auto& refs = sharedItems[key.first];
+      for (const std::string& name : tit->second.items) {
+        auto rit = refs.find(name);
+        if (rit == refs.end() || !rit->second.item) continue;
+        names.push_back(name);
+        handles.push_back(rit->second.item->getHandle());
+      }
+      io = git->second->getSychIOInterface();
+      source = tit->second.source;
+      pipeline = pit->second.get();
+    }
+    if (handles.empty() || !io) return;
+    OPCITEMSTATE* states = nullptr;
+    HRESULT* errors = nullptr;
+    HRESULT hr = io->Read(source, static_cast<DWORD>(handles.size()), handles.data(), &states, &errors);
+    std::vector<IncomingChange> batch;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      auto tit = pollTasks.find(key);
+      if (tit != pollTasks.end()) {
+        tit->second.lastError = hr;
+        for (size_t i = 0; SUCCEEDED(hr) && states && i < names.size(); ++i) {
+          IncomingChange in;
+          in.item = &names[i];
+          in.timestamp = FileTimeTicks(states[i].ftTimeStamp);
+          in.quality = states[i].wQuality;
+          in.error = errors ? errors[i] : S_OK;
+          in.value = VariantToChangeValue(states[i].vDataValue);
+          if (tit->second.items.count(names[i]) && tit->second.filter.Changed(names[i], in)) batch.push_back(std::move(in));
+        }
+        tit->second.changes += batch.size();
+      }
+    }
+    if (SUCCEEDED(hr) && states) {
+      for (size_t i = 0; i < handles.size(); ++i) VariantClear(&states[i].vDataValue);
+    }
+    CoTaskMemFree(states);
+    CoTaskMemFree(errors);
+    if (batch.empty()) return;
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    pipeline->Ingest(batch, FileTimeTicks(now));
+  }
+
+  static uint64_t FileTimeTicks(const FILETIME& ft) {
+    return (static_cast<uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+  }
+
+  static Object StatusSampleToNapi(Napi::Env env, const StatusSample& s) {
+    Object o = Object::New(env);
+    o.Set("timestamp", Number::New(env, s.localMs));
+    o.Set("state", Number::New(env, s.state));
+    o.Set("bandwidth", Number::New(env, s.bandwidth));
+    o.Set("groupCount", Number::New(env, s.groupCount));
+    o.Set("serverTime", Number::New(env, s.serverMs));
+    o.Set("startTime", Number::New(env, s.startMs));
+    o.Set("lastUpdateTime", Number::New(env, s.lastUpdateMs));
+    o.Set("skewMs", Number::New(env, s.SkewMs()));
+    o.Set("rttMs", Number::New(env, s.rttMs));
+    o.Set("version", String::New(env, std::to_string(s.major) + "." + std::to_string(s.minor) + "." + std::to_string(s.build)));
+    return o;
+  }
+
+  void StopStatus() {
+    statusMonitor.Stop();  // No notify after this returns
+    if (statusTsfn) {
+      napi_release_threadsafe_function(statusTsfn, napi_threadsafe_function_release_mode::NAPI_TSFN_RELEASE_MODE_IMMEDIATE);
+      statusTsfn = nullptr;
+    }
+  }
+
+  // Status tsfn call_js: drains queued status events on the JS thread
+  static void DeliverStatusEvents(napi_env env, napi_value jsCb, void* context, void* data) {
+    auto* self = static_cast<OPCDA*>(context);
+    self->statusScheduled = false;
+    std::deque<StatusEvent> events;
+    self->statusMonitor.Drain(events);
+    double threshold = self->statusMonitor.SkewThresholdMs();
+    CallEventHandler(env, jsCb, events, [threshold](Napi::Env napiEnv, const StatusEvent& ev) {
+      Object d = Object::New(napiEnv);
+      const char* type = "statusError";
+      switch (ev.type) {
+        case StatusEvent::Type::State:
+          type = "serverState";
+          d = StatusSampleToNapi(napiEnv, ev.sample);
+          d.Set("previousState", Number::New(napiEnv, ev.previousState));
+          break;
+        case StatusEvent::Type::Skew:
+          type = "clockSkew";
+          d = StatusSampleToNapi(napiEnv, ev.sample);
+          d.Set("exceeded", Napi::Boolean::New(napiEnv, ev.exceeded));
+          d.Set("thresholdMs", Number::New(napiEnv, threshold));
+          break;
+        case StatusEvent::Type::Error:
+          d.Set("error", Number::New(napiEnv, ev.sample.error));
+          d.Set("timestamp", Number::New(napiEnv, ev.sample.localMs));
+          break;
+        case StatusEvent::Type::Recovered:
+          type = "statusRecovered";
+          d = StatusSampleToNapi(napiEnv, ev.sample);
+          break;
+      }
+      return TypedEvent(napiEnv, type, d);
+    });
+  }
+
+  // Caller holds mtx_, on the JS thread. Rejects the async writes of group (all when null) once its callback is gone.
+  void AbandonWritesLocked(COPCGroup* group) {
+    for (auto it = pendingWrites.begin(); it != pendingWrites.end();) {
+      WriteVQTWorker* write = *it;
+      if (group && write->Group() != group) {
+        ++it;
+        continue;
+      }
+      it = pendingWrites.erase(it);
+      write->Abandon("Write abandoned: the group callback was removed");
+    }
+  }
+
+  // Stops the monitor and drops the standby side (whichever server that is at the moment)
+  void StopRedundancy() {
+    redundancy.Stop();  // Its tick takes mtx_
+    if (redundancyTsfn) {
+      napi_release_threadsafe_function(redundancyTsfn, napi_threadsafe_function_release_mode::NAPI_TSFN_RELEASE_MODE_IMMEDIATE);
+      redundancyTsfn = nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<COPCGroup*> twins;
+    for (auto& pair : standbyGroups) {
+      twins.push_back(pair.second.group);
+      try {
+        if (pair.second.group) pair.second.group->disableAsynch();
+      } catch (...) {
+        // Asynch was never enabled on this twin
+      }
+      if (pair.second.group) AbandonWritesLocked(pair.second.group);
+      auto pit = pipelines.find(pair.first);
+      if (pit != pipelines.end()) pit->second->SetSource(nullptr);
+    }
+    standbyGroups.clear();
+    standbyServer.Release();
+    demotions.clear();
+    unboundItems.clear();  // Still unbound; the next acquire of each retries it
+    ++redundancyEpoch;
+    failoverRequested = false;
+    if (standbyClient) {
+      standbyClient->Disconnect();
+      ReleaseClientRuntime(standbyClient);
+      delete standbyClient;
+      standbyClient = nullptr;
+      for (COPCGroup* group : twins) FreeRetiredItemsLocked(group);
+    }
+  }
+
+  // Redundancy tsfn call_js: drains queued health and failover events on the JS thread
+  static void DeliverRedundancyEvents(napi_env env, napi_value jsCb, void* context, void* data) {
+    auto* self = static_cast<OPCDA*>(context);
+    self->redundancyScheduled = false;
+    std::deque<RedundancyEvent> events;
+    self->redundancy.Drain(events);
+    CallEventHandler(env, jsCb, events, [](Napi::Env napiEnv, const RedundancyEvent& ev) {
+      bool failover = ev.type == RedundancyEvent::Type::Failover;
+      Object d = Object::New(napiEnv);
+      d.Set(failover ? "active" : "server", String::New(napiEnv, ev.preferred ? "primary" : "backup"));
+      d.Set(failover ? "previous" : "health", SideHealthToNapi(napiEnv, ev.health));
+      d.Set("timestamp", Number::New(napiEnv, ev.timestampMs));
+      return TypedEvent(napiEnv, failover ? "failover" : "health", d);
+    });
+  }
+
+  void StopWatchdog() {
+    watchdog.Stop();  // No notify after this returns
+    if (watchdogTsfn) {
+      napi_release_threadsafe_function(watchdogTsfn, napi_threadsafe_function_release_mode::NAPI_TSFN_RELEASE_MODE_IMMEDIATE);
+      watchdogTsfn = nullptr;
+    }
+  }
+
+  // { type, data } as the event callbacks get it
+  static Object TypedEvent(Napi::Env env, const char* type, Object data) {
+    Object event = Object::New(env);
+    event.Set("type", String::New(env, type));
+    event.Set("data", data);
+    return event;
+  }
+
+  // Body of the event tsfns' call_js: calls the handler once per drained event, as toNapi builds it. A throwing
+  // handler must not lose the remaining events; the first error is rethrown at the end.
+  template <typename Event, typename ToNapi>
+  static void CallEventHandler(napi_env env, napi_value jsCb, const std::deque<Event>& events, ToNapi toNapi) {
+    if (env == nullptr || jsCb == nullptr) return;
+    Napi::Env napiEnv(env);
+    Napi::Function fn(env, jsCb);
+    Napi::Error handlerError;
+    for (const Event& ev : events) {
+      Object event = toNapi(napiEnv, ev);
+      try {
+        fn.Call({ event });
+      } catch (const Napi::Error& e) {
+        if (handlerError.IsEmpty()) handlerError = e;
+      }
+    }
+    if (!handlerError.IsEmpty()) handlerError.ThrowAsJavaScriptException();
+  }
+
+  // Watchdog tsfn call_js: drains queued slowConsumer events on the JS thread
+  static void DeliverStallEvents(napi_env env, napi_value jsCb, void* context, void* data) {
+    auto* self = static_cast<OPCDA*>(context);
+    self->watchdogScheduled = false;
+    std::deque<StallEvent> events;
+    self->watchdog.Drain(events);
+    CallEventHandler(env, jsCb, events, [](Napi::Env napiEnv, const StallEvent& ev) {
+      Object d = Object::New(napiEnv);
+      d.Set("group", String::New(napiEnv, ev.group));
+      d.Set("kind", String::New(napiEnv, StallKindName(ev.kind)));
+      d.Set("durationMs", Number::New(napiEnv, ev.durationNs / 1e6));
+      d.Set("thresholdMs", Number::New(napiEnv, ev.thresholdNs / 1e6));
+      d.Set("seq", Number::New(napiEnv, static_cast<double>(ev.seq)));
+      d.Set("inProgress", Napi::Boolean::New(napiEnv, ev.inProgress));
+      d.Set("timestamp", Number::New(napiEnv, ev.timestampMs));
+      return TypedEvent(napiEnv, "slowConsumer", d);
+    });
+  }
+
+  GroupPipeline* FindPipeline(const std::string& groupName) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = pipelines.find(groupName);
+    if (it == pipelines.end()) throw Napi::Error::New(env_, "Group not found");
+    return it->second.get();
+  }
+
+  // Caller holds mtx_
+  void DetachPipeline(const std::string& key) {
+    auto pit = pipelines.find(key);
+    if (pit == pipelines.end()) return;
+    pit->second->Detach();
+  }
+
+  Object LossCountsToNapi(const LossCounts& counts) {
+    Object o = Object::New(env_);
+    o.Set("dropped", Number::New(env_, static_cast<double>(counts.dropped)));
+    o.Set("conflated", Number::New(env_, static_cast<double>(counts.conflated)));
+    o.Set("overflowed", Number::New(env_, static_cast<double>(counts.overflowed)));
+    return o;
+  }
+
+  // Held by a worker for the whole of Execute. Shutdown waits until none is left and turns new ones
+  // away, since the client, the groups and COM go with it.
+  class ExecuteScope {
+    OPCDA* op_;
+    bool entered_;
+  public:
+    explicit ExecuteScope(OPCDA* op) : op_(op) {
+      std::lock_guard<std::mutex> lock(op_->mtx_);
+      entered_ = !op_->stopping;
+      if (entered_) ++op_->executing;
+    }
+    ~ExecuteScope() {
+      if (!entered_) return;
+      std::lock_guard<std::mutex> lock(op_->mtx_);
+      if (--op_->executing == 0) op_->executeIdle.notify_all();
+    }
+    explicit operator bool() const { return entered_; }
+  };
+
+  // ConnectWorker (emits to connection tsfn)
+  class ConnectWorker : public AsyncWorker {
+    std::string host_, progId_;
+    OPCDA* op_;
+    bool success_;
+  public:
+    ConnectWorker(Object recv, Env env, std::string h, std::string p, OPCDA* op)
+        : AsyncWorker(recv, env, "ConnectWorker"), host_(h), progId_(p), op_(op), success_(false) {}
+    void Execute() override {
+      ExecuteScope scope(op_);
+      if (!scope) return;  // success_ stays false
+      std::lock_guard<std::mutex> lock(op_->mtx_);
+      success_ = op_->opcClient->Connect(host_.c_str(), progId_.c_str());
+    }
+    void OnOK() override {
+      Napi::Object eventData = Napi::Object::New(Env());
+      eventData.Set("success", Napi::Boolean::New(Env(), success_));
+      if (!success_) eventData.Set("error", Napi::String::New(Env(), "Connection failed"));
+      std::lock_guard<std::mutex> lock(op_->mtx_);
+      auto tsIt = op_->tsfns.find("connection");
+      if (tsIt != op_->tsfns.end()) {
+        EmitEvent(tsIt->second, "connect", eventData, Env());
+      }
+    }
+  };
+
+  // Promise workers holding op_: the OPCDA object (info.This()) stays referenced until OnOK/OnError have run,
+  // so it cannot be collected while Execute or the completion still uses it
+  class ReceiverWorker : public AsyncWorker {
+    Napi::ObjectReference receiver_;
+  protected:
+    ReceiverWorker(Object recv, const char* name) : AsyncWorker(recv.Env(), name), receiver_(Napi::Persistent(recv)) {}
+  };
+
+  // ReplayWorker: feeds a recorded change log into GroupPipeline::Ingest off the JS thread
+  class ReplayWorker : public ReceiverWorker {
+    std::shared_ptr<ChangeReplayer> replayer_;
+    std::map<std::string, GroupPipeline*> targets_;  // recorded group -> pipeline
+    std::shared_ptr<ReplayControl> control_;
+    OPCDA* op_;
+    Napi::Promise::Deferred deferred_;
+    ReplayStats stats_;
+  public:
+    ReplayWorker(Object recv, std::shared_ptr<ChangeReplayer> r, std::map<std::string, GroupPipeline*> targets,
+                 std::shared_ptr<ReplayControl> control, OPCDA* op)
+        : ReceiverWorker(recv, "ReplayWorker"), replayer_(r), targets_(std::move(targets)), control_(control), op_(op),
+          deferred_(Napi::Promise::Deferred::New(recv.Env())) {}
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+    void Execute() override {
+      auto sink = [this](const std::string& group, std::vector<IncomingChange>& batch, uint64_t receivedTicks) {
+        auto it = targets_.find(group);
+        if (it != targets_.end()) it->second->Ingest(batch, receivedTicks);
+      };
+      try {
+        if (!replayer_->Run(sink, *control_, stats_)) SetError("Failed to read change log segment");
+      } catch (const std::exception& e) {
+        SetError(e.what());
+      }
+      control_->Finish();  // Shutdown waits for this before the pipelines go
+    }
+    void OnOK() override {
+      ClearReplay();
+      Object result = Object::New(Env());
+      result.Set("segments", Number::New(Env(), static_cast<double>(stats_.segments)));
+      result.Set("batches", Number::New(Env(), static_cast<double>(stats_.batches)));
+      result.Set("records", Number::New(Env(), static_cast<double>(stats_.records)));
+      result.Set("unknownNames", Number::New(Env(), static_cast<double>(stats_.unknownNames)));
+      result.Set("durationMs", Number::New(Env(), stats_.durationMs));
+      result.Set("stopped", Napi::Boolean::New(Env(), stats_.stopped));
+      deferred_.Resolve(result);
+    }
+    void OnError(const Napi::Error& e) override {
+      ClearReplay();
+      deferred_.Reject(e.Value());
+    }
+  private:
+    void ClearReplay() {
+      std::lock_guard<std::mutex> lock(op_->mtx_);
+      if (op_->replayControl == control_) op_->replayControl.reset();
+    }
+  };
+
+  // DecodeSegmentWorker: decodes blocks straight into buffers that become the typed arrays (no copy on the JS thread)
+  class DecodeSegmentWorker : public AsyncWorker {
+    std::string path_;
+    Napi::Promise::Deferred deferred_;
+    size_t rows_ = 0;
+    double* seq_ = nullptr;
+    double* timestamps_ = nullptr;
+    double* values_ = nullptr;
+    uint16_t* qualities_ = nullptr;
+    uint32_t* nameIds_ = nullptr;
+    int32_t* errors_ = nullptr;
+    uint8_t* kinds_ = nullptr;
+    std::vector<std::pair<size_t, std::string>> texts_;
+    std::map<uint32_t, std::pair<std::string, std::string>> names_;
+
+    template <typename T>
+    static T* Alloc(size_t n) { return static_cast<T*>(std::malloc((n ? n : 1) * sizeof(T))); }
+
+    template <typename TA, typename T>
+    TA Adopt(T*& data) {
+      Napi::ArrayBuffer buf = Napi::ArrayBuffer::New(Env(), data, rows_ * sizeof(T), [](Napi::Env, void* p) { std::free(p); });
+      data = nullptr;  // Owned by the ArrayBuffer now
+      return TA::New(Env(), rows_, buf, 0);
+    }
+  public:
+    DecodeSegmentWorker(Env env, std::string path)
+        : AsyncWorker(env, "DecodeSegmentWorker"), path_(path), deferred_(Napi::Promise::Deferred::New(env)) {}
+    ~DecodeSegmentWorker() {
+      std::free(seq_); std::free(timestamps_); std::free(values_); std::free(qualities_);
+      std::free(nameIds_); std::free(errors_); std::free(kinds_);
+    }
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+    void Execute() override {
+      std::vector<uint8_t> data;
+      changelog::SegmentHeader hdr;
+      if (!changelog::LoadSegment(path_, data, hdr)) return SetError("Not a change log segment");
+      if (hdr.recordCount > static_cast<uint64_t>(data.size()) * 8) return SetError("Corrupt change log header");
+      rows_ = static_cast<size_t>(hdr.recordCount);
+      seq_ = Alloc<double>(rows_); timestamps_ = Alloc<double>(rows_); values_ = Alloc<double>(rows_);
+      qualities_ = Alloc<uint16_t>(rows_); nameIds_ = Alloc<uint32_t>(rows_); errors_ = Alloc<int32_t>(rows_);
+      kinds_ = Alloc<uint8_t>(rows_);
+      changelog::ColumnSink sink;
+      sink.seq = seq_; sink.timestampMs = timestamps_; sink.values = values_; sink.qualities = qualities_;
+      sink.nameIds = nameIds_; sink.errors = errors_; sink.kinds = kinds_; sink.texts = &texts_;
+      size_t pos = hdr.headerBytes, row = 0;
+      while (pos + sizeof(changelog::BlockHeader) <= data.size()) {
+        changelog::BlockHeader bh;
+        if (!changelog::ReadBlockHeader(data.data() + pos, data.size() - pos, bh) || bh.count > rows_ - row ||
+            !changelog::DecodeBlockColumns(data.data() + pos, data.size() - pos, sink, row)) {
+          return SetError("Corrupt change log block");
+        }
+        row += bh.count;
+        pos += bh.byteLength;
+      }
+      rows_ = row;
+      names_ = changelog::ReadDictionary(std::filesystem::path(path_).parent_path().string());
+    }
+    void OnOK() override {
+      Object result = Object::New(Env());
+      result.Set("seq", Adopt<Napi::Float64Array>(seq_));
+      result.Set("timestamps", Adopt<Napi::Float64Array>(timestamps_));
+      result.Set("values", Adopt<Napi::Float64Array>(values_));
+      result.Set("qualities", Adopt<Napi::Uint16Array>(qualities_));
+      result.Set("nameIds", Adopt<Napi::Uint32Array>(nameIds_));
+      result.Set("errors", Adopt<Napi::Int32Array>(errors_));
+      result.Set("kinds", Adopt<Napi::Uint8Array>(kinds_));
+      Object strings = Object::New(Env());
+      for (const auto& t : texts_) strings.Set(Number::New(Env(), static_cast<double>(t.first)), String::New(Env(), t.second));
+      result.Set("strings", strings);
+      Array names = Array::New(Env());
+      for (const auto& n : names_) names.Set(n.first, String::New(Env(), n.second.first + "/" + n.second.second));
+      result.Set("names", names);
+      deferred_.Resolve(result);
+    }
+    void OnError(const Napi::Error& e) override {
+      deferred_.Reject(e.Value());
+    }
+  };
+
+  // IOPCSyncIO2::ReadMaxAge off the JS thread; handles are resolved on the JS thread under mtx_
+  class ReadMaxAgeWorker : public ReceiverWorker {
+    OPCDA* op_;
+    std::vector<std::string> names_;
+    std::vector<DWORD> maxAges_;
+    std::vector<OPCHANDLE> handles_;
+    std::vector<size_t> slots_;          // handles_[k] belongs to names_[slots_[k]]
+    std::vector<ChangeRecord> results_;  // One per name; error set for unknown items
+    ATL::CComPtr<IOPCSyncIO2> io_;
+    Napi::Promise::Deferred deferred_;
+  public:
+    ReadMaxAgeWorker(Object recv, OPCDA* op, std::vector<std::string> names, std::vector<DWORD> maxAges)
+        : ReceiverWorker(recv, "ReadMaxAgeWorker"), op_(op), names_(std::move(names)), maxAges_(std::move(maxAges)),
+          results_(names_.size()), deferred_(Napi::Promise::Deferred::New(recv.Env())) {}
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+
+    // Only items the addon created have a known server handle
+    void Resolve(IOPCSyncIO2* io, const std::map<std::string, SharedItem>* refs) {
+      io_ = io;
+      std::vector<DWORD> ages;
+      for (size_t i = 0; i < names_.size(); ++i) {
+        auto it = refs ? refs->find(names_[i]) : std::map<std::string, SharedItem>::const_iterator();
+        if (!refs || it == refs->end() || !it->second.item) {
+          results_[i].error = kOpcUnknownItemId;
+          continue;
+        }
+        handles_.push_back(it->second.item->getHandle());
+        ages.push_back(maxAges_[i]);
+        slots_.push_back(i);
+      }
+      maxAges_.swap(ages);
+    }
+
+    void Execute() override {
+      if (handles_.empty()) return;
+      ExecuteScope scope(op_);
+      if (!scope) return SetError("Client is shut down");
+      CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+      VARIANT* values = nullptr;
+      WORD* qualities = nullptr;
+      FILETIME* stamps = nullptr;
+      HRESULT* errors = nullptr;
+      HRESULT hr = io_->ReadMaxAge(static_cast<DWORD>(handles_.size()), handles_.data(), maxAges_.data(),
+                                   &values, &qualities, &stamps, &errors);
+      if (SUCCEEDED(hr)) {
+        for (size_t k = 0; k < handles_.size(); ++k) {
+          ChangeRecord& rec = results_[slots_[k]];
+          rec.error = errors ? errors[k] : S_OK;
+          if (FAILED(rec.error)) continue;
+          rec.quality = qualities[k];
+          rec.timestamp = (static_cast<uint64_t>(stamps[k].dwHighDateTime) << 32) | stamps[k].dwLowDateTime;
+          rec.value = VariantToChangeValue(values[k]);
+          VariantClear(&values[k]);
+        }
+      }
+      CoTaskMemFree(values);
+      CoTaskMemFree(qualities);
+      CoTaskMemFree(stamps);
+      CoTaskMemFree(errors);
+      io_.Release();
+      CoUninitialize();
+      if (FAILED(hr)) SetError("ReadMaxAge failed: " + std::to_string(hr));
+    }
+
+    void OnOK() override {
+      Napi::Env env = Env();
+      Array arr = Array::New(env, results_.size());
+      for (size_t i = 0; i < results_.size(); ++i) {
+        const ChangeRecord& rec = results_[i];
+        Object o = Object::New(env);
+        o.Set("item", String::New(env, names_[i]));
+        if (FAILED(rec.error)) {
+          o.Set("error", Number::New(env, static_cast<double>(rec.error)));
+        } else {
+          o.Set("value", ChangeValueToNapi(env, rec.value));
+          o.Set("quality", Number::New(env, rec.quality));
+          o.Set("timestamp", Napi::Date::New(env, FileTimeTicksToJsMs(rec.timestamp)));
+        }
+        arr.Set(i, o);
+      }
+      deferred_.Resolve(arr);
+    }
+    void OnError(const Napi::Error& e) override {
+      deferred_.Reject(e.Value());
+    }
+  };
+
+  // IOPCSyncIO2::WriteVQT off the JS thread (or IOPCAsyncIO3::WriteVQT issued directly); one call for the batch
+  class WriteVQTWorker : public ReceiverWorker, public ITransactionComplete {
+    OPCDA* op_;
+    std::vector<std::string> names_;
+    std::vector<OPCITEMVQT> vqts_;
+    std::vector<OPCHANDLE> handles_;
+    std::vector<COPCItem*> items_;       // items_[k] has handles_[k]
+    std::vector<OPCITEMVQT> sent_;       // vqts_ of the items with a handle
+    std::vector<size_t> slots_;          // handles_[k] belongs to names_[slots_[k]]
+    std::vector<HRESULT> errors_;        // One per name
+    ATL::CComPtr<IOPCSyncIO2> io_;
+    Napi::Promise::Deferred deferred_;
+    // Async only: the toolkit's group callback hands OnWriteComplete to the CTransaction whose address is the
+    // transaction id, and complete() wakes the JS thread through tsfn_
+    COPCGroup* group_ = nullptr;
+    std::unique_ptr<CTransaction> transaction_;
+    napi_threadsafe_function tsfn_ = nullptr;
+    DWORD cancelId_ = 0;
+
+    Object Result(Napi::Env env) {
+      Array failed = Array::New(env);
+      for (size_t i = 0; i < errors_.size(); ++i) {
+        if (SUCCEEDED(errors_[i])) continue;
+        Object f = Object::New(env);
+        f.Set("item", String::New(env, names_[i]));
+        f.Set("error", Number::New(env, static_cast<double>(errors_[i])));
+        failed.Set(failed.Length(), f);
+      }
+      Object result = Object::New(env);
+      result.Set("failed", failed);
+      return result;
+    }
+
+    void Collect(HRESULT* errors, HRESULT hr) {
+      for (size_t k = 0; k < handles_.size(); ++k) errors_[slots_[k]] = errors ? errors[k] : hr;
+    }
+  public:
+    // The reference to the JS object also covers an async write waiting in pendingWrites: DeliverComplete reaches
+    // the client through the tsfn context until it deletes the worker
+    WriteVQTWorker(Object recv, OPCDA* op, std::vector<std::string> names, std::vector<OPCITEMVQT> vqts)
+        : ReceiverWorker(recv, "WriteVQTWorker"), op_(op), names_(std::move(names)), vqts_(std::move(vqts)),
+          errors_(names_.size(), S_OK), deferred_(Napi::Promise::Deferred::New(recv.Env())) {}
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+
+    void Resolve(const std::map<std::string, SharedItem>* refs) {
+      for (size_t i = 0; i < names_.size(); ++i) {
+        auto it = refs ? refs->find(names_[i]) : std::map<std::string, SharedItem>::const_iterator();
+        if (!refs || it == refs->end() || !it->second.item) {
+          errors_[i] = kOpcUnknownItemId;
+          continue;
+        }
+        handles_.push_back(it->second.item->getHandle());
+        items_.push_back(it->second.item);
+        sent_.push_back(vqts_[i]);
+        slots_.push_back(i);
+      }
+    }
+
+    void SetSync(IOPCSyncIO2* io) { io_ = io; }
+
+    // JS thread, caller holds op_->mtx_. The server queues the write and reports the per-item results through the
+    // group callback; the promise settles from there. Returns false when nothing is in flight (the promise is
+    // settled and the caller deletes the worker), true when the worker deletes itself on completion.
+    bool WriteAsync(COPCGroup* group, IOPCAsyncIO3* io) {
+      if (handles_.empty()) {
+        OnOK();
+        return false;
+      }
+      napi_status status = napi_create_threadsafe_function(
+        Env(), nullptr, nullptr, Napi::String::New(Env(), "OPCWriteVQT"),
+        0, 1, nullptr, nullptr, op_, &WriteVQTWorker::DeliverComplete, &tsfn_
+      );
+      if (status != napi_ok) {
+        deferred_.Reject(Napi::Error::New(Env(), "Failed to create tsfn").Value());
+        return false;
+      }
+      napi_unref_threadsafe_function(Env(), tsfn_);  // A write the server never completes does not hold the process
+      group_ = group;
+      transaction_.reset(new CTransaction(items_, this));
+      HRESULT* errors = nullptr;
+      HRESULT hr = io->WriteVQT(static_cast<DWORD>(handles_.size()), handles_.data(), sent_.data(),
+                                static_cast<DWORD>(reinterpret_cast<DWORD_PTR>(transaction_.get())), &cancelId_, &errors);
+      Collect(errors, hr);
+      CoTaskMemFree(errors);
+      bool pending = false;
+      for (size_t k = 0; SUCCEEDED(hr) && k < handles_.size(); ++k) pending = pending || SUCCEEDED(errors_[slots_[k]]);
+      if (pending) {
+        op_->pendingWrites.insert(this);
+        return true;
+      }
+      // Refused up front: the server sends no completion for this transaction
+      napi_release_threadsafe_function(tsfn_, napi_threadsafe_function_release_mode::NAPI_TSFN_RELEASE_MODE_IMMEDIATE);
+      tsfn_ = nullptr;
+      if (FAILED(hr)) deferred_.Reject(Napi::Error::New(Env(), "WriteVQT failed: " + std::to_string(hr)).Value());
+      else OnOK();
+      return false;
+    }
+
+    // COM callback thread (ITransactionComplete)
+    void complete(CTransaction& transaction) override {
+      napi_call_threadsafe_function(tsfn_, this, napi_tsfn_nonblocking);
+    }
+
+    // JS thread, caller holds op_->mtx_. The group's callback went away before the server answered.
+    void Abandon(const char* why) {
+      napi_release_threadsafe_function(tsfn_, napi_threadsafe_function_release_mode::NAPI_TSFN_RELEASE_MODE_IMMEDIATE);
+      deferred_.Reject(Napi::Error::New(Env(), why).Value());
+      delete this;
+    }
+
+    COPCGroup* Group() const { return group_; }
+
+    void Execute() override {
+      if (handles_.empty()) return;
+      ExecuteScope scope(op_);
+      if (!scope) return SetError("Client is shut down");
+      CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+      HRESULT* errors = nullptr;
+      HRESULT hr = io_->WriteVQT(static_cast<DWORD>(handles_.size()), handles_.data(), sent_.data(), &errors);
+      Collect(errors, hr);
+      CoTaskMemFree(errors);
+      io_.Release();
+      CoUninitialize();
+      if (FAILED(hr)) SetError("WriteVQT failed: " + std::to_string(hr));
+    }
+
+    void OnOK() override {
+      Object result = Result(Env());
+      if (transaction_) result.Set("cancelId", Number::New(Env(), cancelId_));
+      deferred_.Resolve(result);
+    }
+    void OnError(const Napi::Error& e) override {
+      deferred_.Reject(e.Value());
+    }
+
+  private:
+    // Write tsfn call_js: the per-item HRESULTs of OnWriteComplete (items refused up front keep their error)
+    static void DeliverComplete(napi_env env, napi_value jsCb, void* context, void* data) {
+      auto* op = static_cast<OPCDA*>(context);
+      auto* self = static_cast<WriteVQTWorker*>(data);
+      {
+        std::lock_guard<std::mutex> lock(op->mtx_);
+        if (!op->pendingWrites.erase(self)) return;  // Abandoned, self is gone
+      }
+      napi_release_threadsafe_function(self->tsfn_, napi_threadsafe_function_release_mode::NAPI_TSFN_RELEASE_MODE_IMMEDIATE);
+      for (size_t k = 0; k < self->items_.size(); ++k) {
+        if (FAILED(self->errors_[self->slots_[k]])) continue;
+        const OPCItemData* d = self->transaction_->getItemValue(self->items_[k]);
+        if (d) self->errors_[self->slots_[k]] = d->error;
+      }
+      if (env != nullptr) self->OnOK();
+      delete self;
+    }
+  };
+
+  // IOPCItemIO::Read / WriteVQT by item ID on a worker; the server reference is opened on first use
+  class ItemIOWorker : public ReceiverWorker {
+    OPCDA* op_;
+    bool write_;
+    std::vector<std::string> names_;
+    std::vector<size_t> slots_;          // Positions in names_ that go to the server
+    std::vector<DWORD> maxAges_;         // Per slot (reads)
+    std::vector<OPCITEMVQT> vqts_;       // Per slot (writes)
+    std::vector<ChangeRecord> results_;  // Per name
+    std::vector<bool> cached_;           // Answered from the item ID cache
+    Napi::Promise::Deferred deferred_;
+  public:
+    ItemIOWorker(Object recv, OPCDA* op, std::vector<std::string> names, bool write)
+        : ReceiverWorker(recv, "ItemIOWorker"), op_(op), write_(write), names_(std::move(names)), results_(names_.size()),
+          cached_(names_.size(), false), deferred_(Napi::Promise::Deferred::New(recv.Env())) {}
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+    size_t Count() const { return names_.size(); }
+    const std::string& Name(size_t i) const { return names_[i]; }
+
+    void Answer(size_t i, HRESULT error) {
+      results_[i].error = error;
+      cached_[i] = true;
+    }
+    void Read(size_t i, DWORD maxAge) {
+      slots_.push_back(i);
+      maxAges_.push_back(maxAge);
+    }
+    void Write(size_t i, const OPCITEMVQT& vqt) {
+      slots_.push_back(i);
+      vqts_.push_back(vqt);
+    }
+
+    void Execute() override {
+      if (slots_.empty()) return;
+      ExecuteScope scope(op_);
+      if (!scope) return SetError("Client is shut down");
+      CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+      ATL::CComPtr<IOPCServer> server;
+      HRESULT hr = op_->DirectServer(server);
+      ATL::CComQIPtr<IOPCItemIO> io;
+      if (SUCCEEDED(hr)) {
+        io = server;
+        if (!io) hr = E_NOINTERFACE;
+      }
+      if (SUCCEEDED(hr)) {
+        std::vector<std::wstring> wide(slots_.size());
+        std::vector<LPCWSTR> ids(slots_.size());
+        for (size_t k = 0; k < slots_.size(); ++k) {
+          wide[k] = Utf8ToWide(names_[slots_[k]]);
+          ids[k] = wide[k].c_str();
+        }
+        DWORD count = static_cast<DWORD>(slots_.size());
+        HRESULT* errors = nullptr;
+        if (write_) {
+          hr = io->WriteVQT(count, ids.data(), vqts_.data(), &errors);
+          for (size_t k = 0; SUCCEEDED(hr) && k < slots_.size(); ++k) results_[slots_[k]].error = errors ? errors[k] : S_OK;
+        } else {
+          VARIANT* values = nullptr;
+          WORD* qualities = nullptr;
+          FILETIME* stamps = nullptr;
+          hr = io->Read(count, ids.data(), maxAges_.data(), &values, &qualities, &stamps, &errors);
+          for (size_t k = 0; SUCCEEDED(hr) && k < slots_.size(); ++k) {
+            ChangeRecord& rec = results_[slots_[k]];
+            rec.error = errors ? errors[k] : S_OK;
+            if (FAILED(rec.error)) continue;
+            rec.quality = qualities[k];
+            rec.timestamp = (static_cast<uint64_t>(stamps[k].dwHighDateTime) << 32) | stamps[k].dwLowDateTime;
+            rec.value = VariantToChangeValue(values[k]);
+            VariantClear(&values[k]);
+          }
+          CoTaskMemFree(values);
+          CoTaskMemFree(qualities);
+          CoTaskMemFree(stamps);
+        }
+        CoTaskMemFree(errors);
+      }
+      server.Release();
+      io.Release();
+      CoUninitialize();
+      if (FAILED(hr)) SetError(std::string(write_ ? "IOPCItemIO::WriteVQT" : "IOPCItemIO::Read") + " failed: " + std::to_string(hr));
+    }
+
+    void OnOK() override {
+      {
+        std::lock_guard<std::mutex> lock(op_->mtx_);
+        // Only the bad IDs: reads and writes are sent whatever is known about an ID, so a positive entry would
+        // just push negative ones out of the cache
+        for (size_t i : slots_) {
+          if (FAILED(results_[i].error)) op_->NoteItemId(names_[i], results_[i].error);
+        }
+      }
+      Napi::Env env = Env();
+      if (write_) {
+        Array failed = Array::New(env);
+        for (size_t i = 0; i < names_.size(); ++i) {
+          if (SUCCEEDED(results_[i].error)) continue;
+          Object f = Object::New(env);
+          f.Set("item", String::New(env, names_[i]));
+          f.Set("error", Number::New(env, static_cast<double>(results_[i].error)));
+          f.Set("cached", Napi::Boolean::New(env, cached_[i]));
+          failed.Set(failed.Length(), f);
+        }
+        Object result = Object::New(env);
+        result.Set("failed", failed);
+        deferred_.Resolve(result);
+        return;
+      }
+      Array arr = Array::New(env, names_.size());
+      for (size_t i = 0; i < names_.size(); ++i) {
+        const ChangeRecord& rec = results_[i];
+        Object o = Object::New(env);
+        o.Set("item", String::New(env, names_[i]));
+        if (FAILED(rec.error)) {
+          o.Set("error", Number::New(env, static_cast<double>(rec.error)));
+          o.Set("cached", Napi::Boolean::New(env, cached_[i]));
+        } else {
+          o.Set("value", ChangeValueToNapi(env, rec.value));
+          o.Set("quality", Number::New(env, rec.quality));
+          o.Set("timestamp", Napi::Date::New(env, FileTimeTicksToJsMs(rec.timestamp)));
+        }
+        arr.Set(i, o);
+      }
+      deferred_.Resolve(arr);
+    }
+    void OnError(const Napi::Error& e) override {
+      deferred_.Reject(e.Value());
+    }
+  };
+
+  // Connects the backup server and mirrors every group onto it, then starts the redundancy monitor. The backup client
+  // and its twins stay private to Execute until they are complete, so the round trips run without mtx_.
+  class RedundancyWorker : public ReceiverWorker {
+    struct GroupSnapshot {
+      std::string name;
+      GroupRate rate;
+      std::vector<std::string> items;
+    };
+    OPCDA* op_;
+    COPCClient* client_;
+    uint64_t epoch_ = 0;
+    bool stale_ = false;  // disableRedundancy() or shutdown came first; the state is no longer this worker's
+    size_t groups_ = 0, items_ = 0, failed_ = 0;
+    Napi::Promise::Deferred deferred_;
+  public:
+    RedundancyWorker(Object recv, OPCDA* op, COPCClient* client)
+        : ReceiverWorker(recv, "RedundancyWorker"), op_(op), client_(client),
+          deferred_(Napi::Promise::Deferred::New(recv.Env())) {}
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+
+    void Execute() override {
+      ExecuteScope scope(op_);
+      if (!scope) return SetError("Client is shut down");
+      std::string host, progId;
+      DWORD standbyRate = 0, keepAliveMs = 0;
+      std::vector<GroupSnapshot> snapshot;
+      {
+        std::lock_guard<std::mutex> lock(op_->mtx_);
+        host = op_->standbyHost;
+        progId = op_->standbyProgId;
+        standbyRate = op_->standbyRate;
+        keepAliveMs = op_->keepAliveMs;
+        epoch_ = op_->redundancyEpoch;
+        for (const auto& pair : op_->groups) {
+          GroupSnapshot g;
+          g.name = pair.first;
+          g.rate = op_->groupRates[pair.first];
+          for (const auto& ref : op_->sharedItems[pair.first]) {
+            if (ref.second.item) g.items.push_back(ref.first);
+          }
+          snapshot.push_back(std::move(g));
+        }
+      }
+
+      if (!client_->Connect(host.c_str(), progId.c_str())) {
+        SetError("Backup connection failed");
+        return;
+      }
+      std::map<std::string, StandbyGroup> twins;
+      try {
+        for (const GroupSnapshot& g : snapshot) {
+          DWORD rate = standbyRate ? standbyRate : g.rate.requested;
+          if (!client_->CreateGroup(g.name.c_str(), static_cast<int>(rate), g.rate.deadband)) continue;
+          StandbyGroup& twin = twins[g.name];
+          twin.group = client_->GetGroup(g.name.c_str());
+          DWORD revised = 0;
+          try {
+            twin.group->setState(rate, revised, g.rate.deadband, standbyRate ? TRUE : FALSE);
+          } catch (...) {
+          }
+          if (keepAliveMs) SetKeepAlive(twin.group, keepAliveMs);
+          if (g.items.empty()) continue;
+          std::vector<COPCItem*> created;
+          std::vector<HRESULT> errors;
+          twin.group->addItems(g.items, created, errors, true);
+          for (size_t i = 0; i < g.items.size() && i < created.size(); ++i) {
+            if (created[i]) twin.items[g.items[i]] = created[i];
+          }
+        }
+      } catch (...) {
+        client_->Disconnect();
+        SetError("Failed to mirror groups on the backup server");
+        return;
+      }
+
+      std::lock_guard<std::mutex> lock(op_->mtx_);
+      if (op_->stopping || op_->redundancyEpoch != epoch_) {
+        stale_ = true;
+        client_->Disconnect();
+        SetError("Redundancy was disabled before the backup was ready");
+        return;
+      }
+      op_->standbyClient = client_;
+      client_ = nullptr;
+      try {
+        std::set<std::string> snapshotted;
+        for (const GroupSnapshot& g : snapshot) {
+          snapshotted.insert(g.name);
+          auto tit = twins.find(g.name);
+          auto git = op_->groups.find(g.name);
+          auto pit = op_->pipelines.find(g.name);
+          if (tit == twins.end() || git == op_->groups.end() || pit == op_->pipelines.end()) continue;
+          StandbyGroup& twin = op_->standbyGroups[g.name] = std::move(tit->second);
+          pit->second->SetSource(git->second);
+          if (op_->tsfns.count(g.name) || op_->fanoutTsfns.count(g.name)) twin.group->enableAsynch(*pit->second);
+          if (keepAliveMs) SetKeepAlive(git->second, keepAliveMs);
+          // The registry moved on while the twin was built: released items go, items acquired since follow
+          std::set<std::string> seen(g.items.begin(), g.items.end());
+          const auto& refs = op_->sharedItems[g.name];
+          std::vector<std::string> gone, added;
+          for (const auto& item : twin.items) {
+            auto rit = refs.find(item.first);
+            if (rit == refs.end() || !rit->second.item) gone.push_back(item.first);
+          }
+          for (const auto& ref : refs) {
+            if (ref.second.item && !seen.count(ref.first)) added.push_back(ref.first);
+          }
+          op_->RemoveMirrorItemsLocked(g.name, gone);
+          op_->MirrorItemsLocked(g.name, added);
+        }
+        for (const auto& pair : op_->groups) {
+          if (!snapshotted.count(pair.first)) op_->MirrorGroupLocked(pair.first);  // Created meanwhile
+        }
+      } catch (...) {
+        SetError("Failed to mirror groups on the backup server");
+        return;
+      }
+      for (const auto& pair : op_->standbyGroups) {
+        ++groups_;
+        items_ += pair.second.items.size();
+        for (const auto& ref : op_->sharedItems[pair.first]) {
+          if (ref.second.item && !pair.second.items.count(ref.first)) ++failed_;
+        }
+      }
+      op_->redundancySinceNs = MonotonicNs();
+    }
+
+    void OnOK() override {
+      OPCDA* op = op_;
+      {
+        std::lock_guard<std::mutex> lock(op->mtx_);
+        if (op->stopping || op->redundancyEpoch != epoch_) {
+          // StopRedundancy already took down what Execute committed
+          deferred_.Reject(Napi::Error::New(Env(), "Redundancy was disabled before the backup was ready").Value());
+          return;
+        }
+      }
+      op->redundancyScheduled = false;
+      op->redundancy.Start(op->redundancyOpts, [op] { op->RedundancyTick(); },
+        [op] {
+          if (op->redundancyScheduled.exchange(true)) return;
+          if (napi_call_threadsafe_function(op->redundancyTsfn, nullptr, napi_tsfn_nonblocking) != napi_ok) op->redundancyScheduled = false;
+        },
+        [] { CoInitializeEx(nullptr, COINIT_MULTITHREADED); },
+        [] { CoUninitialize(); });
+      Object result = Object::New(Env());
+      result.Set("groups", Number::New(Env(), static_cast<double>(groups_)));
+      result.Set("items", Number::New(Env(), static_cast<double>(items_)));
+      result.Set("failed", Number::New(Env(), static_cast<double>(failed_)));
+      deferred_.Resolve(result);
+    }
+    void OnError(const Napi::Error& e) override {
+      if (client_) {
+        ReleaseClientRuntime(client_);
+        delete client_;  // Not connected; a mirroring failure leaves the client to StopRedundancy
+      }
+      if (!stale_) op_->StopRedundancy();
+      deferred_.Reject(e.Value());
+    }
+  };
+
+  // Parallel OpcEnum enumeration; the CLSID cache is updated on the JS thread
+  class DiscoverWorker : public ReceiverWorker {
+    struct Server {
+      std::string progId, clsid, userType;
+    };
+    struct HostResult {
+      HRESULT error = S_OK;
+      std::vector<Server> servers;
+    };
+    OPCDA* op_;
+    std::vector<std::string> hosts_;
+    size_t concurrency_;
+    uint32_t timeoutMs_;
+    std::vector<ProbeResult<HostResult>> results_;
+    Napi::Promise::Deferred deferred_;
+
+    // Runs on a probe thread (COM initialized); copies of everything it needs, since it may outlive the worker
+    static HostResult Enumerate(const std::string& host) {
+      HostResult r;
+      ATL::CComPtr<IOPCServerList> serverList;
+      r.error = OpenServerList(host, serverList);
+      if (FAILED(r.error)) return r;
+      CATID categories[] = { CATID_OPCDAServer10, CATID_OPCDAServer20, CATID_OPCDAServer30 };
+      ATL::CComPtr<IEnumGUID> clsids;
+      r.error = serverList->EnumClassesOfCategories(3, categories, 0, nullptr, &clsids);
+      if (FAILED(r.error)) return r;
+      CLSID batch[32];
+      ULONG fetched = 0;
+      while (SUCCEEDED(clsids->Next(32, batch, &fetched)) && fetched > 0) {
+        for (ULONG i = 0; i < fetched; ++i) {
+          LPOLESTR progId = nullptr;
+          LPOLESTR userType = nullptr;
+          if (FAILED(serverList->GetClassDetails(batch[i], &progId, &userType))) continue;
+          r.servers.push_back(Server{progId ? WideToUtf8(progId) : std::string(), GuidString(batch[i]),
+                                     userType ? WideToUtf8(userType) : std::string()});
+          CoTaskMemFree(progId);
+          CoTaskMemFree(userType);
+        }
+      }
+      return r;
+    }
+  public:
+    DiscoverWorker(Object recv, OPCDA* op, std::vector<std::string> hosts, size_t concurrency, uint32_t timeoutMs)
+        : ReceiverWorker(recv, "DiscoverWorker"), op_(op), hosts_(std::move(hosts)), concurrency_(concurrency),
+          timeoutMs_(timeoutMs), deferred_(Napi::Promise::Deferred::New(recv.Env())) {}
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+
+    void Execute() override {
+      ExecuteScope scope(op_);
+      if (!scope) return SetError("Client is shut down");
+      std::vector<std::string> hosts = hosts_;
+      results_ = BoundedProbe<HostResult>::Run(
+        hosts.size(), concurrency_, std::chrono::milliseconds(timeoutMs_),
+        [hosts](size_t i) { return Enumerate(hosts[i]); },
+        [] { CoInitializeEx(nullptr, COINIT_MULTITHREADED); },
+        [] { CoUninitialize(); });
+    }
+
+    void OnOK() override {
+      Napi::Env env = Env();
+      Array out = Array::New(env, hosts_.size());
+      std::lock_guard<std::mutex> lock(op_->mtx_);
+      for (size_t i = 0; i < hosts_.size(); ++i) {
+        const ProbeResult<HostResult>& r = results_[i];
+        Object entry = Object::New(env);
+        entry.Set("host", String::New(env, hosts_[i]));
+        entry.Set("timedOut", Napi::Boolean::New(env, r.timedOut));
+        entry.Set("ms", Number::New(env, r.ms));
+        Array servers = Array::New(env, r.value.servers.size());
+        if (r.done && SUCCEEDED(r.value.error)) {
+          op_->clsids.EraseHost(hosts_[i]);
+          for (uint32_t k = 0; k < r.value.servers.size(); ++k) {
+            const Server& s = r.value.servers[k];
+            if (!s.progId.empty()) op_->clsids.Put(hosts_[i], s.progId, s.clsid);
+            Object server = Object::New(env);
+            server.Set("progId", String::New(env, s.progId));
+            server.Set("clsid", String::New(env, s.clsid));
+            server.Set("userType", String::New(env, s.userType));
+            servers.Set(k, server);
+          }
+        } else if (r.done) {
+          entry.Set("error", Number::New(env, static_cast<double>(r.value.error)));
+        }
+        entry.Set("servers", servers);
+        out.Set(static_cast<uint32_t>(i), entry);
+      }
+      deferred_.Resolve(out);
+    }
+    void OnError(const Napi::Error& e) override {
+      deferred_.Reject(e.Value());
+    }
+  };
+
+  // Bulk item ID validation; verdicts are noted in OPCDA::itemIds on the JS thread
+  class ValidateWorker : public ReceiverWorker {
+    OPCDA* op_;
+    std::vector<std::string> names_;
+    std::vector<std::vector<std::string>> groups_;  // Per name: config groups listing it
+    size_t batch_;
+    std::vector<size_t> slots_;       // Positions in names_ that go to the server
+    std::vector<HRESULT> errors_;     // Per name
+    std::vector<bool> cached_;        // Answered from the item ID cache
+    Napi::Promise::Deferred deferred_;
+  public:
+    ValidateWorker(Object recv, OPCDA* op, std::map<std::string, std::vector<std::string>> holders, size_t batch)
+        : ReceiverWorker(recv, "ValidateWorker"), op_(op), batch_(batch), deferred_(Napi::Promise::Deferred::New(recv.Env())) {
+      for (auto& pair : holders) {
+        names_.push_back(pair.first);
+        groups_.push_back(std::move(pair.second));
+      }
+      errors_.assign(names_.size(), S_OK);
+      cached_.assign(names_.size(), false);
+    }
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+    size_t Count() const { return names_.size(); }
+    const std::string& Name(size_t i) const { return names_[i]; }
+
+    void Answer(size_t i, HRESULT error) {
+      errors_[i] = error;
+      cached_[i] = true;
+    }
+    void Check(size_t i) { slots_.push_back(i); }
+
+    void Execute() override {
+      if (slots_.empty()) return;
+      ExecuteScope scope(op_);
+      if (!scope) return SetError("Client is shut down");
+      CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+      ATL::CComPtr<IOPCServer> server;
+      HRESULT hr = op_->DirectServer(server);
+      // A scratch group that is never activated, so validation costs the server no scanning
+      OPCHANDLE hGroup = 0;
+      DWORD revised = 0;
+      ATL::CComPtr<IOPCItemMgt> mgt;
+      if (SUCCEEDED(hr)) {
+        hr = server->AddGroup(L"", FALSE, 1000, 0, nullptr, nullptr, 0, &hGroup, &revised, IID_IOPCItemMgt,
+                              reinterpret_cast<LPUNKNOWN*>(&mgt));
+      }
+      for (size_t start = 0; SUCCEEDED(hr) && start < slots_.size(); start += batch_) {
+        size_t n = std::min(batch_, slots_.size() - start);
+        std::vector<std::wstring> wide(n);
+        std::vector<OPCITEMDEF> defs(n);
+        for (size_t k = 0; k < n; ++k) {
+          wide[k] = Utf8ToWide(names_[slots_[start + k]]);
+          defs[k].szAccessPath = const_cast<LPWSTR>(L"");
+          defs[k].szItemID = &wide[k][0];
+          defs[k].bActive = FALSE;
+          defs[k].hClient = static_cast<OPCHANDLE>(k);
+          defs[k].vtRequestedDataType = VT_EMPTY;
+        }
+        OPCITEMRESULT* results = nullptr;
+        HRESULT* errors = nullptr;
+        HRESULT call = mgt->ValidateItems(static_cast<DWORD>(n), defs.data(), FALSE, &results, &errors);
+        for (size_t k = 0; k < n; ++k) {
+          errors_[slots_[start + k]] = FAILED(call) ? call : (errors ? errors[k] : S_OK);
+          if (SUCCEEDED(call) && results) CoTaskMemFree(results[k].pBlob);
+        }
+        CoTaskMemFree(results);
+        CoTaskMemFree(errors);
+      }
+      mgt.Release();
+      if (hGroup) server->RemoveGroup(hGroup, FALSE);
+      server.Release();
+      CoUninitialize();
+      if (FAILED(hr)) SetError("ValidateItems failed: " + std::to_string(hr));
+    }
+
+    void OnOK() override {
+      Napi::Env env = Env();
+      Array invalid = Array::New(env);
+      size_t valid = 0, cached = 0;
+      {
+        std::lock_guard<std::mutex> lock(op_->mtx_);
+        for (size_t i : slots_) op_->NoteItemId(names_[i], errors_[i]);
+      }
+      for (size_t i = 0; i < names_.size(); ++i) {
+        if (cached_[i]) ++cached;
+        if (SUCCEEDED(errors_[i])) {
+          ++valid;
+          continue;
+        }
+        Object entry = Object::New(env);
+        entry.Set("item", String::New(env, names_[i]));
+        entry.Set("error", Number::New(env, static_cast<double>(errors_[i])));
+        entry.Set("cached", Napi::Boolean::New(env, cached_[i]));
+        Array groups = Array::New(env, groups_[i].size());
+        for (uint32_t g = 0; g < groups_[i].size(); ++g) groups.Set(g, String::New(env, groups_[i][g]));
+        entry.Set("groups", groups);
+        invalid.Set(invalid.Length(), entry);
+      }
+      Object result = Object::New(env);
+      result.Set("checked", Number::New(env, static_cast<double>(slots_.size())));
+      result.Set("cached", Number::New(env, static_cast<double>(cached)));
+      result.Set("valid", Number::New(env, static_cast<double>(valid)));
+      result.Set("invalid", invalid);
+      deferred_.Resolve(result);
+    }
+    void OnError(const Napi::Error& e) override {
+      deferred_.Reject(e.Value());
+    }
+  };
+
+  // Bulk property retrieval; results are merged into OPCDA::properties on the JS thread
+  class PropertiesWorker : public ReceiverWorker {
+    struct ItemResult {
+      HRESULT error = S_OK;
+      std::vector<std::pair<uint32_t, ChangeValue>> values;
+      std::vector<int32_t> errors;
+    };
+    struct PropertyInfo {
+      uint32_t id;
+      uint16_t vt;
+      std::string description;
+    };
+    OPCDA* op_;
+    std::vector<std::string> names_;
+    std::vector<DWORD> propertyIds_;
+    size_t batch_;
+    size_t cached_;
+    std::vector<ItemResult> results_;
+    std::vector<PropertyInfo> infos_;
+    std::set<uint32_t> seen_;
+    Napi::Promise::Deferred deferred_;
+
+    void NoteInfo(DWORD id, VARTYPE vt, const wchar_t* description) {
+      if (seen_.insert(id).second) infos_.push_back(PropertyInfo{id, vt, description ? WideToUtf8(description) : std::string()});
+    }
+
+    void ViaBrowse(IOPCBrowse* browse) {
+      for (size_t start = 0; start < names_.size(); start += batch_) {
+        size_t n = std::min(batch_, names_.size() - start);
+        std::vector<std::wstring> wide(n);
+        std::vector<LPWSTR> ids(n);
+        for (size_t i = 0; i < n; ++i) {
+          wide[i] = Utf8ToWide(names_[start + i]);
+          ids[i] = &wide[i][0];
+        }
+        OPCITEMPROPERTIES* props = nullptr;
+        HRESULT hr = browse->GetProperties(static_cast<DWORD>(n), ids.data(), TRUE, static_cast<DWORD>(propertyIds_.size()),
+                                           propertyIds_.empty() ? nullptr : propertyIds_.data(), &props);
+        for (size_t i = 0; i < n; ++i) {
+          ItemResult& r = results_[start + i];
+          if (FAILED(hr) || !props) {
+            r.error = FAILED(hr) ? hr : E_FAIL;
+            continue;
+          }
+          r.error = props[i].hrErrorID;
+          for (DWORD k = 0; k < props[i].dwNumProperties; ++k) {
+            OPCITEMPROPERTY& p = props[i].pItemProperties[k];
+            r.values.emplace_back(p.dwPropertyID, VariantToChangeValue(p.vValue));
+            r.errors.push_back(p.hrErrorID);
+            NoteInfo(p.dwPropertyID, p.vtDataType, p.szDescription);
+            CoTaskMemFree(p.szItemID);
+            CoTaskMemFree(p.szDescription);
+            VariantClear(&p.vValue);
+          }
+          CoTaskMemFree(props[i].pItemProperties);
+        }
+        CoTaskMemFree(props);
+      }
+    }
+
+    void ViaItemProperties(IOPCItemProperties* itemProps) {
+      for (size_t i = 0; i < names_.size(); ++i) {
+        ItemResult& r = results_[i];
+        std::wstring id = Utf8ToWide(names_[i]);
+        std::vector<DWORD> ids = propertyIds_;
+        if (ids.empty()) {
+          DWORD count = 0;
+          DWORD* available = nullptr;
+          LPWSTR* descriptions = nullptr;
+          VARTYPE* types = nullptr;
+          r.error = itemProps->QueryAvailableProperties(&id[0], &count, &available, &descriptions, &types);
+          if (SUCCEEDED(r.error)) {
+            ids.assign(available, available + count);
+            for (DWORD k = 0; k < count; ++k) {
+              NoteInfo(available[k], types[k], descriptions[k]);
+              CoTaskMemFree(descriptions[k]);
+            }
+          }
+          CoTaskMemFree(available);
+          CoTaskMemFree(descriptions);
+          CoTaskMemFree(types);
+          if (FAILED(r.error)) continue;
+        }
+        VARIANT* data = nullptr;
+        HRESULT* errors = nullptr;
+        HRESULT hr = itemProps->GetItemProperties(&id[0], static_cast<DWORD>(ids.size()), ids.data(), &data, &errors);
+        if (FAILED(hr)) {
+          r.error = hr;
+          continue;
+        }
+        for (size_t k = 0; k < ids.size(); ++k) {
+          r.values.emplace_back(ids[k], VariantToChangeValue(data[k]));
+          r.errors.push_back(errors ? errors[k] : S_OK);
+          VariantClear(&data[k]);
+        }
+        CoTaskMemFree(data);
+        CoTaskMemFree(errors);
+      }
+    }
+  public:
+    PropertiesWorker(Object recv, OPCDA* op, std::vector<std::string> names, std::vector<DWORD> propertyIds, size_t batch, size_t cached)
+        : ReceiverWorker(recv, "PropertiesWorker"), op_(op), names_(std::move(names)), propertyIds_(std::move(propertyIds)),
+          batch_(batch), cached_(cached), results_(names_.size()), deferred_(Napi::Promise::Deferred::New(recv.Env())) {}
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+
+    void Execute() override {
+      if (names_.empty()) return;
+      ExecuteScope scope(op_);
+      if (!scope) return SetError("Client is shut down");
+      CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+      ATL::CComPtr<IOPCServer> server;
+      HRESULT hr = op_->DirectServer(server);
+      if (SUCCEEDED(hr)) {
+        ATL::CComQIPtr<IOPCBrowse> browse(server);
+        ATL::CComQIPtr<IOPCItemProperties> itemProps(server);
+        if (browse) ViaBrowse(browse);
+        else if (itemProps) ViaItemProperties(itemProps);
+        else hr = E_NOINTERFACE;
+      }
+      server.Release();
+      CoUninitialize();
+      if (FAILED(hr)) SetError("Property retrieval failed: " + std::to_string(hr));
+    }
+
+    void OnOK() override {
+      Napi::Env env = Env();
+      Array failed = Array::New(env);
+      size_t loaded = 0;
+      {
+        std::lock_guard<std::mutex> lock(op_->mtx_);
+        for (const PropertyInfo& pi : infos_) op_->properties.SetInfo(pi.id, pi.vt, pi.description);
+        for (size_t i = 0; i < names_.size(); ++i) {
+          if (SUCCEEDED(results_[i].error)) {
+            op_->properties.Set(names_[i], results_[i].values, results_[i].errors);
+            ++loaded;
+            continue;
+          }
+          Object f = Object::New(env);
+          f.Set("item", String::New(env, names_[i]));
+          f.Set("error", Number::New(env, static_cast<double>(results_[i].error)));
+          failed.Set(failed.Length(), f);
+        }
+      }
+      Object result = Object::New(env);
+      result.Set("loaded", Number::New(env, static_cast<double>(loaded)));
+      result.Set("cached", Number::New(env, static_cast<double>(cached_)));
+      result.Set("failed", failed);
+      deferred_.Resolve(result);
+    }
+    void OnError(const Napi::Error& e) override {
+      deferred_.Reject(e.Value());
+    }
+  };
+
+  // ReadWorker (placeholder implementation)
+  class ReadWorker : public AsyncWorker {
+    std::string itemName_;
+    VARIANT value_;
+    OPCDA* op_;
+  public:
+    ReadWorker(Object recv, Env env, std::string name, OPCDA* op) : AsyncWorker(recv, env, "ReadWorker"), itemName_(name), op_(op) {}
+    void Execute() override {
+      std::lock_guard<std::mutex> lock(op_->mtx_);
+      // op_->opcClient->Read(itemName_.c_str(), &value_);  // OPC call
+    }
+    void OnOK() override {
+      Deferred().Resolve(Env(), VariantToNapi(Env(), &value_));
+    }
+  };
+
+  // WriteWorker (placeholder)
+  class WriteWorker : public AsyncWorker {
+    std::string itemName_;
+    Value jsValue_;
+    OPCDA* op_;
+    bool success_;
+  public:
+    WriteWorker(Object recv, Env env, std::string name, Value val, OPCDA* op) : AsyncWorker(recv, env, "WriteWorker"), itemName_(name), jsValue_(val), op_(op), success_(false) {}
+    void Execute() override {
+      std::lock_guard<std::mutex> lock(op_->mtx_);
+      // VARIANT var = JsValueToVariant(jsValue_);  // Converter
+      // success_ = op_->opcClient->Write(itemName_.c_str(), &var);
+    }
+    void OnOK() override {
+      Deferred().Resolve(Env(), success_ ? Env().Undefined() : Napi::Error::New(Env(), "Write failed").Value());
     }
   };
 
@@ -477,7 +5401,81 @@ Napi::Value VariantToNapi(const Napi::Env& env, VARIANT* var) {
   }
 }
 
-Napi::FunctionReference OPCDA::constructor;
+std::string WideToUtf8(const wchar_t* wide, int len) {
+  if (!wide) return std::string();
+  int size = WideCharToMultiByte(CP_UTF8, 0, wide, len, nullptr, 0, nullptr, nullptr);
+  if (size <= 0) return std::string();
+  std::string out(size, '\0');
+  WideCharToMultiByte(CP_UTF8, 0, wide, len, &out[0], size, nullptr, nullptr);
+  if (len < 0 && !out.empty()) out.pop_back();  // Drop terminator
+  return out;
+}
+
+std::wstring Utf8ToWide(const std::string& s) {
+  if (s.empty()) return std::wstring();
+  int size = MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), nullptr, 0);
+  if (size <= 0) return std::wstring();
+  std::wstring out(size, L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), &out[0], size);
+  return out;
+}
+
+// Record-build conversion: runs on the COM callback thread, no N-API involved
+ChangeValue VariantToChangeValue(const VARIANT& var) {
+  ChangeValue v;
+  v.kind = ChangeValue::Kind::Number;
+  switch (var.vt) {
+    case VT_I1: v.number = var.cVal; break;
+    case VT_I2: v.number = var.iVal; break;
+    case VT_I4: v.number = var.lVal; break;
+    case VT_I8: v.number = static_cast<double>(var.llVal); break;
+    case VT_INT: v.number = var.intVal; break;
+    case VT_UI1: v.number = var.bVal; break;
+    case VT_UI2: v.number = var.uiVal; break;
+    case VT_UI4: v.number = var.ulVal; break;
+    case VT_UI8: v.number = static_cast<double>(var.ullVal); break;
+    case VT_UINT: v.number = var.uintVal; break;
+    case VT_R4: v.number = var.fltVal; break;
+    case VT_R8: v.number = var.dblVal; break;
+    case VT_BOOL:
+      v.kind = ChangeValue::Kind::Boolean;
+      v.number = var.boolVal != VARIANT_FALSE ? 1.0 : 0.0;
+      break;
+    case VT_BSTR:
+      v.kind = ChangeValue::Kind::String;
+      v.text = WideToUtf8(var.bstrVal, var.bstrVal ? static_cast<int>(SysStringLen(var.bstrVal)) : 0);
+      break;
+    case VT_EMPTY:
+    case VT_NULL:
+      v.kind = ChangeValue::Kind::Empty;
+      break;
+    default:
+      v.kind = ChangeValue::Kind::Unsupported;
+      break;
+  }
+  return v;
+}
+
+Napi::Value ChangeValueToNapi(const Napi::Env& env, const ChangeValue& v) {
+  switch (v.kind) {
+    case ChangeValue::Kind::Number: return Napi::Number::New(env, v.number);
+    case ChangeValue::Kind::Boolean: return Napi::Boolean::New(env, v.number != 0.0);
+    case ChangeValue::Kind::String: return Napi::String::New(env, v.text);
+    case ChangeValue::Kind::Empty: return Napi::Null::New(env);
+    default: return Napi::String::New(env, "Unsupported type");
+  }
+}
+
+// JS-side conversion of one change record (same shape the dataChange event has always had, plus seq)
+Napi::Object ChangeToNapi(const Napi::Env& env, const ChangeRecord& rec, const std::string& itemName) {
+  Napi::Object dataObj = Napi::Object::New(env);
+  dataObj.Set("item", Napi::String::New(env, itemName));
+  dataObj.Set("value", ChangeValueToNapi(env, rec.value));
+  dataObj.Set("quality", Napi::Number::New(env, rec.quality));
+  dataObj.Set("timestamp", Napi::Date::New(env, FileTimeTicksToJsMs(rec.timestamp)));
+  dataObj.Set("seq", Napi::Number::New(env, static_cast<double>(rec.seq)));
+  return dataObj;
+}
 
 Napi::Object InitAll(Napi::Env env, Napi::Object exports) {
   return OPCDA::Init(env, exports);
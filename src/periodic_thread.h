@@ -0,0 +1,89 @@
+#pragma once
+// Background thread of the controllers and monitors: runs a step, sleeps until the time the step asks for (or until
+// Wake), and repeats until Stop. The step runs without the thread's lock, so it may take its owner's locks and call
+// Wake.
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class PeriodicThread {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  PeriodicThread() = default;
+  PeriodicThread(const PeriodicThread&) = delete;
+  PeriodicThread& operator=(const PeriodicThread&) = delete;
+  ~PeriodicThread() { Stop(); }
+
+  // step runs at first, then at the time it returns (Clock::time_point::max(): at the next Wake);
+  // threadInit/threadExit wrap the thread (COM)
+  void Start(Clock::time_point first, std::function<Clock::time_point()> step,
+             std::function<void()> threadInit = nullptr, std::function<void()> threadExit = nullptr) {
+    Stop();
+    std::lock_guard<std::mutex> lock(mtx_);
+    running_ = true;
+    woken_ = false;
+    thread_ = std::thread([this, first, step, threadInit, threadExit] {
+      if (threadInit) threadInit();
+      std::unique_lock<std::mutex> lock(mtx_);
+      Clock::time_point next = first;
+      while (running_) {
+        auto ready = [this] { return !running_ || woken_; };
+        if (next == Clock::time_point::max()) cv_.wait(lock, ready);
+        else cv_.wait_until(lock, next, ready);
+        if (!running_) break;
+        woken_ = false;
+        lock.unlock();
+        next = step();
+        lock.lock();
+      }
+      lock.unlock();
+      if (threadExit) threadExit();
+    });
+  }
+
+  // tick every interval, the first one right away or after one interval
+  void StartEvery(std::chrono::milliseconds interval, bool immediate, std::function<void()> tick,
+                  std::function<void()> threadInit = nullptr, std::function<void()> threadExit = nullptr) {
+    Clock::time_point first = immediate ? Clock::now() : Clock::now() + interval;
+    Start(first, [tick, interval] {
+      tick();
+      return Clock::now() + interval;
+    }, std::move(threadInit), std::move(threadExit));
+  }
+
+  // Runs the step now instead of at the time it asked for; a Wake during the step runs it once more
+  void Wake() {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (!running_) return;
+      woken_ = true;
+    }
+    cv_.notify_all();
+  }
+
+  // Joins the thread; a step in progress finishes first
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (!running_) return;
+      running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+  }
+
+  bool Running() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return running_;
+  }
+
+private:
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  bool running_ = false;
+  bool woken_ = false;
+  std::thread thread_;
+};
@@ -0,0 +1,239 @@
+#pragma once
+// Hot-path instrumentation of the change pipeline: per-core sharded counters and HDR-style
+// log-linear latency histograms, all lock-free (relaxed atomics). Disabled costs one relaxed load.
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+#include "gorilla.h"
+
+enum class Stage : int {
+  Callback = 0,   // OnDataChange entry -> return (server callback thread)
+  RecordBuild,    // CAtlMap -> IncomingChange batch
+  Enqueue,        // Ingest: sequencing, history, series, recorder handoff, pending + tsfn call
+  TsfnDispatch,   // tsfn call -> DeliverChanges start on the JS thread
+  Materialize,    // ChangeRecord -> JS event object
+  Handler,        // JS handler call -> return
+  Count
+};
+
+enum class Counter : int {
+  Callbacks = 0,
+  Items,
+  Records,
+  Batches,
+  Delivered,
+  HandlerErrors,
+  Count
+};
+
+inline const char* StageName(Stage s) {
+  static const char* kNames[] = {"callback", "recordBuild", "enqueue", "tsfnDispatch", "materialize", "handler"};
+  return kNames[static_cast<int>(s)];
+}
+
+inline const char* CounterName(Counter c) {
+  static const char* kNames[] = {"callbacks", "items", "records", "batches", "delivered", "handlerErrors"};
+  return kNames[static_cast<int>(c)];
+}
+
+// CPU the caller runs on, folded into [0, shards); threads on different cores rarely share a cache line
+inline int CurrentShard(int shards) {
+#if defined(_WIN32)
+  return static_cast<int>(GetCurrentProcessorNumber() % shards);
+#elif defined(__linux__)
+  int cpu = sched_getcpu();
+  return cpu < 0 ? 0 : cpu % shards;
+#else
+  return 0;
+#endif
+}
+
+inline uint64_t MonotonicNs() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Values in ns. 32 sub-buckets per power of two: about 3% relative error up to ~18 minutes.
+// Sharded per core like the counters, so callback threads recording the same stage do not contend.
+class LatencyHistogram {
+public:
+  static constexpr int kSubBits = 5;
+  static constexpr int kSub = 1 << kSubBits;
+  static constexpr int kMaxBits = 40;
+  static constexpr int kBuckets = (kMaxBits - kSubBits + 1) * kSub;
+  static constexpr int kShards = 8;
+
+  struct Snapshot {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    std::vector<uint64_t> buckets;
+
+    // Highest value equivalent to the bucket holding quantile q (0..1)
+    uint64_t Quantile(double q) const {
+      if (count == 0) return 0;
+      uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count) + 0.5);
+      if (rank < 1) rank = 1;
+      uint64_t seen = 0;
+      for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+          uint64_t upper = UpperBound(static_cast<int>(i));
+          return upper < max ? upper : max;
+        }
+      }
+      return max;
+    }
+    double Mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+  };
+
+  LatencyHistogram() { Reset(); }
+
+  void Record(uint64_t ns) {
+    Shard& shard = shards_[CurrentShard(kShards)];
+    shard.buckets[Index(ns)].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t prev = shard.max.load(std::memory_order_relaxed);
+    while (ns > prev && !shard.max.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+  }
+
+  Snapshot Take() const {
+    Snapshot s;
+    s.buckets.assign(kBuckets, 0);
+    for (const Shard& shard : shards_) {
+      for (int i = 0; i < kBuckets; ++i) s.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+      s.sum += shard.sum.load(std::memory_order_relaxed);
+      uint64_t max = shard.max.load(std::memory_order_relaxed);
+      if (max > s.max) s.max = max;
+    }
+    for (uint64_t b : s.buckets) s.count += b;  // Consistent with the buckets even while recording
+    return s;
+  }
+
+  void Reset() {
+    for (Shard& shard : shards_) {
+      for (auto& b : shard.buckets) b.store(0, std::memory_order_relaxed);
+      shard.sum.store(0, std::memory_order_relaxed);
+      shard.max.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  static int Index(uint64_t v) {
+    if (v < static_cast<uint64_t>(kSub)) return static_cast<int>(v);
+    int e = 63 - gorilla::Clz64(v);
+    if (e >= kMaxBits) return kBuckets - 1;
+    int sub = static_cast<int>((v >> (e - kSubBits)) & (kSub - 1));
+    return (e - kSubBits + 1) * kSub + sub;
+  }
+
+  static uint64_t UpperBound(int idx) {
+    if (idx < kSub) return static_cast<uint64_t>(idx);
+    int e = idx / kSub + kSubBits - 1;
+    uint64_t sub = static_cast<uint64_t>(idx % kSub);
+    uint64_t width = 1ull << (e - kSubBits);
+    return ((static_cast<uint64_t>(kSub) + sub) << (e - kSubBits)) + width - 1;
+  }
+
+private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> buckets[kBuckets];
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+  };
+
+  Shard shards_[kShards];
+};
+
+class PipelineMetrics {
+public:
+  static constexpr int kShards = 16;
+
+  PipelineMetrics() {
+    for (auto& shard : shards_) {
+      for (auto& c : shard.values) c.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+  void SetEnabled(bool on) { enabled_.store(on, std::memory_order_relaxed); }
+
+  // Callers check Enabled() first so the clock is not read when off
+  void Observe(Stage stage, uint64_t ns) { stages_[static_cast<int>(stage)].Record(ns); }
+
+  void Add(Counter c, uint64_t n = 1) {
+    shards_[CurrentShard(kShards)].values[static_cast<int>(c)].fetch_add(n, std::memory_order_relaxed);
+  }
+
+  uint64_t Total(Counter c) const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) total += shard.values[static_cast<int>(c)].load(std::memory_order_relaxed);
+    return total;
+  }
+
+  LatencyHistogram::Snapshot Take(Stage stage) const { return stages_[static_cast<int>(stage)].Take(); }
+
+  void Reset() {
+    for (auto& h : stages_) h.Reset();
+    for (auto& shard : shards_) {
+      for (auto& c : shard.values) c.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // Prometheus text exposition: counters plus one summary per stage (seconds)
+  std::string Prometheus(const std::string& prefix = "opcda") const {
+    std::string out;
+    char line[256];
+    for (int c = 0; c < static_cast<int>(Counter::Count); ++c) {
+      std::string name = prefix + "_" + SnakeCase(CounterName(static_cast<Counter>(c))) + "_total";
+      std::snprintf(line, sizeof(line), "# TYPE %s counter\n%s %llu\n", name.c_str(), name.c_str(),
+                    static_cast<unsigned long long>(Total(static_cast<Counter>(c))));
+      out += line;
+    }
+    std::string name = prefix + "_stage_latency_seconds";
+    out += "# TYPE " + name + " summary\n";
+    static const double kQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+    for (int s = 0; s < static_cast<int>(Stage::Count); ++s) {
+      const char* stage = StageName(static_cast<Stage>(s));
+      LatencyHistogram::Snapshot snap = Take(static_cast<Stage>(s));
+      for (double q : kQuantiles) {
+        std::snprintf(line, sizeof(line), "%s{stage=\"%s\",quantile=\"%g\"} %.9g\n", name.c_str(), stage, q,
+                      snap.Quantile(q) / 1e9);
+        out += line;
+      }
+      std::snprintf(line, sizeof(line), "%s_sum{stage=\"%s\"} %.9g\n%s_count{stage=\"%s\"} %llu\n",
+                    name.c_str(), stage, snap.sum / 1e9, name.c_str(), stage, static_cast<unsigned long long>(snap.count));
+      out += line;
+    }
+    return out;
+  }
+
+private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> values[static_cast<int>(Counter::Count)];
+  };
+
+  static std::string SnakeCase(const char* camel) {
+    std::string out;
+    for (const char* p = camel; *p; ++p) {
+      if (*p >= 'A' && *p <= 'Z') {
+        out += '_';
+        out += static_cast<char>(*p - 'A' + 'a');
+      } else {
+        out += *p;
+      }
+    }
+    return out;
+  }
+
+  std::atomic<bool> enabled_{false};
+  Shard shards_[kShards];
+  LatencyHistogram stages_[static_cast<int>(Stage::Count)];
+};
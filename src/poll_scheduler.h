@@ -0,0 +1,160 @@
+#pragma once
+// Native polling for servers whose subscriptions cannot be trusted. One task per (group, period) covers every
+// item polled at that period, so each release costs one read. A single thread runs the releases one after
+// another (polls never overlap), rate-monotonic: of the tasks due, the shortest period goes first. A release
+// that cannot start before its deadline (the next release) is skipped and counted as missed rather than
+// run late in a burst. PollFilter keeps what was last seen per item so only actual changes go on.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include "change_history.h"
+#include "periodic_thread.h"
+
+struct PollTaskStats {
+  uint64_t runs = 0;
+  uint64_t missed = 0;        // Releases skipped because their deadline had passed
+  uint64_t lateNsMax = 0;     // Start time after release
+  uint64_t lateNsSum = 0;
+  uint64_t durationNsMax = 0;
+  uint64_t lastDurationNs = 0;
+};
+
+class PollScheduler {
+public:
+  using Clock = std::chrono::steady_clock;
+  using Key = std::pair<std::string, uint32_t>;  // group, period in ms
+
+  PollScheduler() = default;
+  PollScheduler(const PollScheduler&) = delete;
+  PollScheduler& operator=(const PollScheduler&) = delete;
+  ~PollScheduler() { Stop(); }
+
+  // run executes one release on the scheduler thread; threadInit/threadExit wrap the thread (COM)
+  void Start(std::function<void(const Key&)> run, std::function<void()> threadInit = nullptr,
+             std::function<void()> threadExit = nullptr) {
+    Stop();
+    thread_.Start(Clock::now(), [this, run] { return Step(run); }, std::move(threadInit), std::move(threadExit));
+  }
+
+  void Stop() { thread_.Stop(); }
+  bool Running() { return thread_.Running(); }
+
+  // First release is immediate; false if the task existed
+  bool Add(const Key& key) {
+    if (key.second == 0) return false;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (tasks_.count(key)) return false;
+      tasks_[key].due = Clock::now();
+    }
+    thread_.Wake();
+    return true;
+  }
+
+  // A release already running finishes
+  bool Remove(const Key& key) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return tasks_.erase(key) > 0;
+  }
+
+  bool Has(const Key& key) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return tasks_.count(key) > 0;
+  }
+
+  std::map<Key, PollTaskStats> Stats() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::map<Key, PollTaskStats> out;
+    for (const auto& pair : tasks_) out[pair.first] = pair.second.stats;
+    return out;
+  }
+
+private:
+  struct Task {
+    Clock::time_point due;
+    PollTaskStats stats;
+  };
+
+  // One pass on the scheduler thread: runs the due task with the shortest period and asks to be called again
+  // right away, or returns the earliest release when nothing is due
+  Clock::time_point Step(const std::function<void(const Key&)>& run) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    auto now = Clock::now();
+    auto pick = tasks_.end();
+    Clock::time_point wake = Clock::time_point::max();
+    for (auto it = tasks_.begin(); it != tasks_.end(); ++it) {
+      if (it->second.due > now) {
+        wake = std::min(wake, it->second.due);
+        continue;
+      }
+      if (pick == tasks_.end() || it->first.second < pick->first.second ||
+          (it->first.second == pick->first.second && it->second.due < pick->second.due)) {
+        pick = it;
+      }
+    }
+    if (pick == tasks_.end()) return wake;
+    Key key = pick->first;
+    Task& task = pick->second;
+    auto period = std::chrono::milliseconds(key.second);
+    uint64_t behind = static_cast<uint64_t>((now - task.due) / period);
+    if (behind > 0) {
+      task.stats.missed += behind;
+      task.due += period * behind;
+    }
+    uint64_t lateNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - task.due).count());
+    lock.unlock();
+    run(key);
+    lock.lock();
+    auto it = tasks_.find(key);
+    if (it == tasks_.end()) return Clock::now();  // Removed while running
+    PollTaskStats& st = it->second.stats;
+    uint64_t durationNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - now).count());
+    ++st.runs;
+    st.lateNsMax = std::max(st.lateNsMax, lateNs);
+    st.lateNsSum += lateNs;
+    st.durationNsMax = std::max(st.durationNsMax, durationNs);
+    st.lastDurationNs = durationNs;
+    it->second.due += period;
+    return Clock::now();
+  }
+
+  std::mutex mtx_;
+  std::map<Key, Task> tasks_;
+  PeriodicThread thread_;  // Last: its step uses tasks_
+};
+
+// Last value, quality and error per item; the source timestamp alone does not make a change
+class PollFilter {
+public:
+  // True (and remembered) when the item is new or differs from what was seen last
+  bool Changed(const std::string& item, const IncomingChange& in) {
+    auto it = last_.find(item);
+    if (it != last_.end()) {
+      const IncomingChange& old = it->second;
+      if (old.quality == in.quality && old.error == in.error && old.value.kind == in.value.kind &&
+          SameNumber(old.value.number, in.value.number) && old.value.text == in.value.text) {
+        return false;
+      }
+    }
+    IncomingChange& kept = last_[item];
+    kept.quality = in.quality;
+    kept.error = in.error;
+    kept.value = in.value;
+    return true;
+  }
+
+  void Forget(const std::string& item) { last_.erase(item); }
+  size_t Size() const { return last_.size(); }
+
+private:
+  // A NaN read twice is no change
+  static bool SameNumber(double a, double b) { return a == b || (std::isnan(a) && std::isnan(b)); }
+
+  std::map<std::string, IncomingChange> last_;
+};
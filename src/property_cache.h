@@ -0,0 +1,253 @@
+#pragma once
+// Item property cache (engineering units, descriptions, ranges, ...): one small record per property,
+// text values interned in a shared string pool since most tags repeat the same units and descriptions.
+//
+// File format (little endian): "OPCPROP" + u8 version, u32 pool count, pool strings (u32 length + UTF-8),
+// u32 property-info count, infos (u32 id, u16 vt, u32 description index), u32 item count,
+// items (u32 name length + UTF-8, u32 property count, properties (u32 id, i32 error, u8 kind, f64 number | u32 text)).
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <utility>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "change_history.h"
+
+class PropertyCache {
+public:
+  struct Property {
+    uint32_t id = 0;
+    int32_t error = 0;  // HRESULT for this property; the value is Empty when it failed
+    ChangeValue::Kind kind = ChangeValue::Kind::Empty;
+    double number = 0.0;
+    uint32_t text = 0;  // Pool index when kind is String
+  };
+
+  struct Info {
+    uint16_t vt = 0;
+    uint32_t description = 0;  // Pool index
+  };
+
+  // Replaces what is cached for the item
+  void Set(const std::string& item, const std::vector<std::pair<uint32_t, ChangeValue>>& values, const std::vector<int32_t>& errors) {
+    std::vector<Property>& props = items_[item];
+    props.clear();
+    props.reserve(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+      Property p;
+      p.id = values[i].first;
+      p.error = i < errors.size() ? errors[i] : 0;
+      p.kind = values[i].second.kind;
+      if (p.kind == ChangeValue::Kind::String) p.text = Intern(values[i].second.text);
+      else p.number = values[i].second.number;
+      props.push_back(p);
+    }
+  }
+
+  void SetInfo(uint32_t id, uint16_t vt, const std::string& description) {
+    infos_[id] = Info{vt, Intern(description)};
+  }
+
+  const std::vector<Property>* Find(const std::string& item) const {
+    auto it = items_.find(item);
+    return it == items_.end() ? nullptr : &it->second;
+  }
+
+  const Info* FindInfo(uint32_t id) const {
+    auto it = infos_.find(id);
+    return it == infos_.end() ? nullptr : &it->second;
+  }
+
+  const std::string& Text(uint32_t index) const { return pool_[index]; }
+
+  ChangeValue Value(const Property& p) const {
+    ChangeValue v;
+    v.kind = p.kind;
+    if (p.kind == ChangeValue::Kind::String) v.text = pool_[p.text];
+    else v.number = p.number;
+    return v;
+  }
+
+  bool Erase(const std::string& item) { return items_.erase(item) > 0; }
+
+  void Clear() {
+    items_.clear();
+    infos_.clear();
+    pool_.clear();
+    poolIndex_.clear();
+  }
+
+  size_t Items() const { return items_.size(); }
+  size_t PoolStrings() const { return pool_.size(); }
+
+  size_t Properties() const {
+    size_t n = 0;
+    for (const auto& pair : items_) n += pair.second.size();
+    return n;
+  }
+
+  // Written to path + ".tmp" and renamed over path, so a failed save leaves the previous file intact
+  bool Save(const std::string& path) const {
+    std::string tmp = path + ".tmp";
+    {
+      std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+      if (!out) return false;
+      out.write(kMagic, sizeof(kMagic));
+      PutU32(out, static_cast<uint32_t>(pool_.size()));
+      for (const std::string& s : pool_) PutString(out, s);
+      PutU32(out, static_cast<uint32_t>(infos_.size()));
+      for (const auto& pair : infos_) {
+        PutU32(out, pair.first);
+        PutU16(out, pair.second.vt);
+        PutU32(out, pair.second.description);
+      }
+      PutU32(out, static_cast<uint32_t>(items_.size()));
+      for (const auto& pair : items_) {
+        PutString(out, pair.first);
+        PutU32(out, static_cast<uint32_t>(pair.second.size()));
+        for (const Property& p : pair.second) {
+          PutU32(out, p.id);
+          PutU32(out, static_cast<uint32_t>(p.error));
+          uint8_t kind = static_cast<uint8_t>(p.kind);
+          out.write(reinterpret_cast<const char*>(&kind), 1);
+          if (p.kind == ChangeValue::Kind::String) PutU32(out, p.text);
+          else out.write(reinterpret_cast<const char*>(&p.number), 8);
+        }
+      }
+      out.close();
+      if (!out) {
+        std::remove(tmp.c_str());
+        return false;
+      }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);  // Replaces path, on Windows too
+    if (ec) std::remove(tmp.c_str());
+    return !ec;
+  }
+
+  // Merges a saved cache into this one (entries in the file win); false if the file is missing or malformed.
+  // The whole file is parsed before anything is merged, so a malformed one leaves the cache as it was.
+  bool Load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    std::streamoff size = in.tellg();
+    if (size < 0) return false;
+    std::string data(static_cast<size_t>(size), '\0');
+    in.seekg(0);
+    if (size > 0 && !in.read(&data[0], size)) return false;
+    Reader r{data.data(), data.size()};
+
+    if (r.left < sizeof(kMagic) || std::memcmp(r.p, kMagic, sizeof(kMagic)) != 0) return false;
+    r.Skip(sizeof(kMagic));
+    // Counts are checked against the bytes left (at the smallest record size) before anything is allocated
+    uint32_t count;
+    if (!r.U32(count) || count > r.left / 4) return false;
+    std::vector<std::string> pool(count);
+    for (std::string& s : pool) {
+      if (!r.String(s)) return false;
+    }
+    if (!r.U32(count) || count > r.left / 10) return false;
+    std::vector<std::pair<uint32_t, Info>> infos(count);  // Descriptions as file pool indexes
+    for (auto& info : infos) {
+      if (!r.U32(info.first) || !r.U16(info.second.vt) || !r.U32(info.second.description)) return false;
+      if (info.second.description >= pool.size()) return false;
+    }
+    if (!r.U32(count) || count > r.left / 8) return false;
+    std::vector<std::pair<std::string, std::vector<Property>>> items(count);  // Texts as file pool indexes
+    for (auto& item : items) {
+      uint32_t n;
+      if (!r.String(item.first) || !r.U32(n) || n > r.left / 13) return false;
+      item.second.resize(n);
+      for (Property& p : item.second) {
+        uint32_t error;
+        uint8_t kind;
+        if (!r.U32(p.id) || !r.U32(error) || !r.U8(kind)) return false;
+        p.error = static_cast<int32_t>(error);
+        switch (static_cast<ChangeValue::Kind>(kind)) {
+          case ChangeValue::Kind::String:
+            if (!r.U32(p.text) || p.text >= pool.size()) return false;
+            break;
+          case ChangeValue::Kind::Empty:
+          case ChangeValue::Kind::Number:
+          case ChangeValue::Kind::Boolean:
+          case ChangeValue::Kind::Unsupported:
+            if (!r.F64(p.number)) return false;
+            break;
+          default:
+            return false;
+        }
+        p.kind = static_cast<ChangeValue::Kind>(kind);
+      }
+    }
+    if (r.left != 0) return false;
+
+    std::vector<uint32_t> remap(pool.size());  // File pool index -> our pool index
+    for (size_t i = 0; i < pool.size(); ++i) remap[i] = Intern(pool[i]);
+    for (const auto& info : infos) infos_[info.first] = Info{info.second.vt, remap[info.second.description]};
+    for (auto& item : items) {
+      for (Property& p : item.second) {
+        if (p.kind == ChangeValue::Kind::String) p.text = remap[p.text];
+      }
+      items_[item.first] = std::move(item.second);
+    }
+    return true;
+  }
+
+private:
+  static constexpr char kMagic[8] = {'O', 'P', 'C', 'P', 'R', 'O', 'P', 1};
+
+  // Bounds-checked little-endian reads over the loaded file
+  struct Reader {
+    const char* p;
+    size_t left;
+
+    void Skip(size_t n) {
+      p += n;
+      left -= n;
+    }
+    bool Bytes(void* out, size_t n) {
+      if (left < n) return false;
+      std::memcpy(out, p, n);
+      Skip(n);
+      return true;
+    }
+    bool U8(uint8_t& v) { return Bytes(&v, 1); }
+    bool U16(uint16_t& v) { return Bytes(&v, 2); }
+    bool U32(uint32_t& v) { return Bytes(&v, 4); }
+    bool F64(double& v) { return Bytes(&v, 8); }
+    bool String(std::string& s) {
+      uint32_t n;
+      if (!U32(n) || n > left) return false;
+      s.assign(p, n);
+      Skip(n);
+      return true;
+    }
+  };
+
+  uint32_t Intern(const std::string& s) {
+    auto it = poolIndex_.find(s);
+    if (it != poolIndex_.end()) return it->second;
+    uint32_t index = static_cast<uint32_t>(pool_.size());
+    pool_.push_back(s);
+    poolIndex_.emplace(s, index);
+    return index;
+  }
+
+  static void PutU16(std::ofstream& out, uint16_t v) { out.write(reinterpret_cast<const char*>(&v), 2); }
+  static void PutU32(std::ofstream& out, uint32_t v) { out.write(reinterpret_cast<const char*>(&v), 4); }
+  static void PutString(std::ofstream& out, const std::string& s) {
+    PutU32(out, static_cast<uint32_t>(s.size()));
+    out.write(s.data(), s.size());
+  }
+
+  std::map<std::string, std::vector<Property>> items_;
+  std::map<uint32_t, Info> infos_;
+  std::vector<std::string> pool_;
+  std::unordered_map<std::string, uint32_t> poolIndex_;
+};
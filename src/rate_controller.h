@@ -0,0 +1,153 @@
+#pragma once
+// Adaptive update rates for elastic groups: when the JS side saturates (handler time, queue depth),
+// the least important elastic groups are slowed step by step within their bounds; once load has
+// eased for a while, rates are restored, most important groups first.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include "periodic_thread.h"
+
+struct RateControlOptions {
+  uint32_t intervalMs = 1000;
+  double highBusy = 0.8;       // Fraction of wall time spent in handlers that counts as saturated
+  double lowBusy = 0.4;
+  uint64_t highDepth = 5000;   // Queued records per group
+  uint64_t lowDepth = 500;
+  double highLatencyMs = 20.0; // Average handler time per record
+  double factor = 2.0;         // Rate multiplier per step
+  uint32_t restoreAfter = 3;   // Consecutive eased samples before a restore step
+};
+
+struct ElasticGroup {
+  uint32_t minRate = 0;      // Normal (fastest) requested rate
+  uint32_t maxRate = 0;      // Slowest rate the group may be pushed to
+  uint32_t currentRate = 0;  // Rate the server granted for the last request; steps start from here
+  int priority = 0;          // Higher is more important: slowed last, restored first
+};
+
+// Cumulative counters of one group at sample time
+struct GroupLoad {
+  uint64_t depth = 0;        // Records waiting in memory for the JS thread
+  uint64_t handlerNs = 0;    // Total time in handlers
+  uint64_t handled = 0;      // Records handled
+};
+
+enum class LoadLevel { Eased, Steady, Overloaded };
+
+class RateController {
+public:
+  RateController() = default;
+  RateController(const RateController&) = delete;
+  RateController& operator=(const RateController&) = delete;
+  ~RateController() { Stop(); }
+
+  // tick runs on the controller thread every intervalMs; threadInit/threadExit wrap the thread (COM)
+  void Start(const RateControlOptions& opts, std::function<void()> tick,
+             std::function<void()> threadInit = nullptr, std::function<void()> threadExit = nullptr) {
+    Stop();
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      opts_ = opts;
+      eased_ = 0;
+      prev_.clear();
+      lastSample_ = std::chrono::steady_clock::now();
+    }
+    thread_.StartEvery(std::chrono::milliseconds(opts.intervalMs), false, std::move(tick), std::move(threadInit),
+                       std::move(threadExit));
+  }
+
+  void Stop() { thread_.Stop(); }
+  bool Running() { return thread_.Running(); }
+
+  // Classifies the interval since the previous call and picks new rates.
+  // Returns group -> new requested rate (only groups that change); updates currentRate in groups.
+  std::map<std::string, uint32_t> Decide(const std::map<std::string, GroupLoad>& loads,
+                                         std::map<std::string, ElasticGroup>& groups) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto now = std::chrono::steady_clock::now();
+    double wallNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastSample_).count());
+    lastSample_ = now;
+
+    uint64_t busyNs = 0, handled = 0, maxDepth = 0;
+    for (const auto& pair : loads) {
+      GroupLoad& prev = prev_[pair.first];
+      busyNs += pair.second.handlerNs >= prev.handlerNs ? pair.second.handlerNs - prev.handlerNs : 0;
+      handled += pair.second.handled >= prev.handled ? pair.second.handled - prev.handled : 0;
+      maxDepth = std::max(maxDepth, pair.second.depth);
+      prev = pair.second;
+    }
+    busy_ = wallNs > 0 ? busyNs / wallNs : 0.0;
+    latencyMs_ = handled ? busyNs / 1e6 / handled : 0.0;
+    depth_ = maxDepth;
+
+    if (busy_ > opts_.highBusy || maxDepth > opts_.highDepth || latencyMs_ > opts_.highLatencyMs) level_ = LoadLevel::Overloaded;
+    else if (busy_ < opts_.lowBusy && maxDepth < opts_.lowDepth) level_ = LoadLevel::Eased;
+    else level_ = LoadLevel::Steady;
+
+    std::map<std::string, uint32_t> changes;
+    if (level_ == LoadLevel::Overloaded) {
+      eased_ = 0;
+      // Least important tier that can still be slowed
+      int tier = 0;
+      bool found = false;
+      for (const auto& pair : groups) {
+        if (pair.second.currentRate >= pair.second.maxRate) continue;
+        if (!found || pair.second.priority < tier) tier = pair.second.priority;
+        found = true;
+      }
+      if (!found) return changes;
+      for (auto& pair : groups) {
+        ElasticGroup& g = pair.second;
+        if (g.priority != tier || g.currentRate >= g.maxRate) continue;
+        g.currentRate = std::min(g.maxRate, static_cast<uint32_t>(std::max<double>(g.currentRate + 1, g.currentRate * opts_.factor)));
+        changes[pair.first] = g.currentRate;
+      }
+    } else if (level_ == LoadLevel::Eased) {
+      if (++eased_ < opts_.restoreAfter) return changes;
+      eased_ = 0;
+      // Most important tier that is still slowed
+      int tier = 0;
+      bool found = false;
+      for (const auto& pair : groups) {
+        if (pair.second.currentRate <= pair.second.minRate) continue;
+        if (!found || pair.second.priority > tier) tier = pair.second.priority;
+        found = true;
+      }
+      if (!found) return changes;
+      for (auto& pair : groups) {
+        ElasticGroup& g = pair.second;
+        if (g.priority != tier || g.currentRate <= g.minRate) continue;
+        g.currentRate = std::max(g.minRate, static_cast<uint32_t>(g.currentRate / opts_.factor));
+        changes[pair.first] = g.currentRate;
+      }
+    } else {
+      eased_ = 0;
+    }
+    return changes;
+  }
+
+  // Last classification: level, busy fraction, ms per record, deepest queue
+  LoadLevel Level(double& busy, double& latencyMs, uint64_t& depth) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    busy = busy_;
+    latencyMs = latencyMs_;
+    depth = depth_;
+    return level_;
+  }
+
+private:
+  std::mutex mtx_;
+  PeriodicThread thread_;
+  RateControlOptions opts_;
+  std::map<std::string, GroupLoad> prev_;
+  std::chrono::steady_clock::time_point lastSample_;
+  uint32_t eased_ = 0;
+  LoadLevel level_ = LoadLevel::Steady;
+  double busy_ = 0.0;
+  double latencyMs_ = 0.0;
+  uint64_t depth_ = 0;
+};
@@ -0,0 +1,163 @@
+#pragma once
+// Primary/standby server pair: a background thread samples the health of both sides every checkMs and
+// decides when the delivery source flips. The active side fails over after failAfter bad samples in a row,
+// provided the standby is healthy; with failback, the preferred server takes over again once it has been
+// healthy for recoverAfter samples. Health changes and switches are queued as events for the JS thread.
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include "periodic_thread.h"
+
+struct RedundancyOptions {
+  uint32_t checkMs = 1000;
+  uint32_t failAfter = 2;      // Consecutive bad samples of the active side before switching
+  uint32_t recoverAfter = 5;   // Consecutive good samples of the preferred side before failing back
+  bool failback = false;
+  uint32_t livenessMs = 0;     // No callback from the active side for this long counts as bad (0: off)
+  size_t maxEvents = 100;
+};
+
+struct SideHealth {
+  bool ok = false;
+  int32_t error = 0;       // HRESULT of the status call
+  uint32_t state = 0;      // dwServerState, 0 when unknown
+  bool stale = false;      // Callbacks stopped (livenessMs)
+};
+
+struct RedundancyEvent {
+  enum class Type { Health, Failover } type = Type::Health;
+  bool preferred = true;   // Health: which side; Failover: the side now active
+  SideHealth health;       // Health: the new state; Failover: the state of the side given up
+  double timestampMs = 0.0;
+};
+
+class RedundancyMonitor {
+public:
+  RedundancyMonitor() = default;
+  RedundancyMonitor(const RedundancyMonitor&) = delete;
+  RedundancyMonitor& operator=(const RedundancyMonitor&) = delete;
+  ~RedundancyMonitor() { Stop(); }
+
+  // tick runs on the monitor thread every checkMs; notify is called when events are queued
+  void Start(const RedundancyOptions& opts, std::function<void()> tick, std::function<void()> notify,
+             std::function<void()> threadInit = nullptr, std::function<void()> threadExit = nullptr) {
+    Stop();
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      opts_ = opts;
+      notify_ = std::move(notify);
+      onPreferred_ = true;
+      activeBad_ = standbyGood_ = 0;
+      switches_ = 0;
+      health_[0] = health_[1] = SideHealth{true};
+    }
+    thread_.StartEvery(std::chrono::milliseconds(opts.checkMs), false, std::move(tick), std::move(threadInit),
+                       std::move(threadExit));
+  }
+
+  void Stop() { thread_.Stop(); }
+  bool Running() { return thread_.Running(); }
+
+  // One sample of both sides; true when the caller should switch the delivery source now
+  bool Decide(const SideHealth& active, const SideHealth& standby, double nowMs) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Note(onPreferred_, active, nowMs);
+    Note(!onPreferred_, standby, nowMs);
+    activeBad_ = active.ok ? 0 : activeBad_ + 1;
+    standbyGood_ = standby.ok ? standbyGood_ + 1 : 0;
+    bool fail = activeBad_ >= opts_.failAfter && standby.ok;
+    bool back = opts_.failback && !onPreferred_ && standbyGood_ >= opts_.recoverAfter;
+    if (!fail && !back) return false;
+    onPreferred_ = !onPreferred_;
+    activeBad_ = standbyGood_ = 0;
+    ++switches_;
+    RedundancyEvent ev;
+    ev.type = RedundancyEvent::Type::Failover;
+    ev.preferred = onPreferred_;
+    ev.health = active;
+    ev.timestampMs = nowMs;
+    Push(std::move(ev));
+    return true;
+  }
+
+  // Forced switch (failover() from JS)
+  void Switched(double nowMs) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    onPreferred_ = !onPreferred_;
+    activeBad_ = standbyGood_ = 0;
+    ++switches_;
+    RedundancyEvent ev;
+    ev.type = RedundancyEvent::Type::Failover;
+    ev.preferred = onPreferred_;
+    ev.health = health_[onPreferred_ ? 1 : 0];
+    ev.timestampMs = nowMs;
+    Push(std::move(ev));
+  }
+
+  void Drain(std::deque<RedundancyEvent>& out) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    out.swap(events_);
+    events_.clear();
+  }
+
+  // preferred: health of the preferred (configured primary) side, else of the backup
+  SideHealth Health(bool preferred) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return health_[preferred ? 0 : 1];
+  }
+
+  bool OnPreferred() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return onPreferred_;
+  }
+
+  uint64_t Switches() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return switches_;
+  }
+
+  uint64_t DroppedEvents() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return dropped_;
+  }
+
+private:
+  // Caller holds mtx_
+  void Note(bool preferred, const SideHealth& h, double nowMs) {
+    SideHealth& last = health_[preferred ? 0 : 1];
+    bool changed = last.ok != h.ok || last.state != h.state || last.stale != h.stale;
+    last = h;
+    if (!changed) return;
+    RedundancyEvent ev;
+    ev.type = RedundancyEvent::Type::Health;
+    ev.preferred = preferred;
+    ev.health = h;
+    ev.timestampMs = nowMs;
+    Push(std::move(ev));
+  }
+
+  // Caller holds mtx_
+  void Push(RedundancyEvent&& ev) {
+    events_.push_back(std::move(ev));
+    while (events_.size() > opts_.maxEvents) {
+      events_.pop_front();
+      ++dropped_;
+    }
+    if (notify_) notify_();
+  }
+
+  std::mutex mtx_;
+  PeriodicThread thread_;
+  RedundancyOptions opts_;
+  std::function<void()> notify_;
+  bool onPreferred_ = true;
+  uint32_t activeBad_ = 0;
+  uint32_t standbyGood_ = 0;
+  uint64_t switches_ = 0;
+  uint64_t dropped_ = 0;
+  SideHealth health_[2];
+  std::deque<RedundancyEvent> events_;
+};
@@ -0,0 +1,349 @@
+#pragma once
+// Disk-backed FIFO of change records for store-and-forward delivery.
+// Records stay in memory up to a limit; past it everything new spills to files (in order)
+// written by a background thread. The same thread reads the oldest spilled block back ahead of the
+// consumer, so Push and Pop never touch the disk and the OnDataChange thread never waits on I/O.
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "change_log.h"
+
+struct SpillOptions {
+  std::string dir;
+  size_t memoryRecords = 100000;        // In-memory backlog before spilling
+  size_t blockRecords = 4096;           // Records per spilled block
+  size_t maxFileBytes = 64 * 1024 * 1024;
+  size_t maxQueuedBlocks = 64;          // Blocks kept for the writer while writes fail; older ones are dropped
+};
+
+struct SpillStats {
+  uint64_t memoryRecords = 0;
+  uint64_t diskRecords = 0;   // Spilled and not yet read back (including blocks waiting for the writer)
+  uint64_t spilledTotal = 0;
+  uint64_t files = 0;
+  uint64_t writeErrors = 0;
+  uint64_t readErrors = 0;    // Spilled blocks that could not be read back (their records are lost)
+  uint64_t dropped = 0;       // Records dropped because writes kept failing
+};
+
+class SpillQueue {
+public:
+  explicit SpillQueue(const SpillOptions& opts) : opts_(opts) {}
+  SpillQueue(const SpillQueue&) = delete;
+  SpillQueue& operator=(const SpillQueue&) = delete;
+  ~SpillQueue() { Close(); }
+
+  // Called on the writer thread (no locks held) after a block reached disk or was read back,
+  // so a drain waiting for either can resume
+  void SetOnReady(std::function<void()> cb) { onReady_ = std::move(cb); }
+
+  // Leftover files from an earlier run are not readable without their handle tables, so start clean
+  bool Open() {
+    std::error_code ec;
+    std::filesystem::create_directories(opts_.dir, ec);
+    if (ec) return false;
+    for (const auto& entry : std::filesystem::directory_iterator(opts_.dir, ec)) {
+      if (entry.path().extension() == kSpillExt) std::filesystem::remove(entry.path(), ec);
+    }
+    running_ = true;
+    writer_ = std::thread(&SpillQueue::RunWriter, this);
+    return true;
+  }
+
+  void Close() {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (!running_) return;
+      running_ = false;
+    }
+    cv_.notify_all();
+    if (writer_.joinable()) writer_.join();
+    out_.close();
+    std::error_code ec;
+    for (const DiskFile& f : files_) std::filesystem::remove(f.path, ec);
+    files_.clear();
+  }
+
+  void Push(ChangeRecord&& rec) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!spilling_ && memory_.size() < opts_.memoryRecords) {
+      memory_.push_back(std::move(rec));
+      return;
+    }
+    // Once spilling, everything goes through disk until it has drained, so order is kept
+    spilling_ = true;
+    writeBuf_.push_back(std::move(rec));
+    ++spilledTotal_;
+    if (writeBuf_.size() >= opts_.blockRecords) {
+      toWrite_.push_back(std::move(writeBuf_));
+      writeBuf_.clear();
+      if (writeFailing_) TrimUnwritten();
+      cv_.notify_one();
+    }
+  }
+
+  // Appends oldest-first until out holds maxCount records. Stops early while the next records are still on disk;
+  // onReady fires once they have been read back.
+  void Pop(size_t maxCount, std::vector<ChangeRecord>& out) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    while (out.size() < maxCount) {
+      if (memory_.empty() && !Refill()) break;
+      out.push_back(std::move(memory_.front()));
+      memory_.pop_front();
+    }
+  }
+
+  // Forgets everything still queued without reading it back; returns how many records that was
+  uint64_t Discard() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    uint64_t n = memory_.size() + writeBuf_.size();
+    for (const auto& b : ready_) n += b.size();
+    for (const auto& b : toWrite_) n += b.size();
+    for (const DiskBlock& b : diskBlocks_) {
+      n += b.count;
+      --files_[b.file - fileBase_].blocksLeft;
+    }
+    memory_.clear();
+    ready_.clear();
+    writeBuf_.clear();
+    toWrite_.clear();
+    diskBlocks_.clear();
+    spilling_ = false;
+    ++epoch_;  // A block the writer is reading or writing right now is dropped when it comes back
+    ReleaseDrainedFiles();
+    return n;
+  }
+
+  bool Empty() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return memory_.empty() && ready_.empty() && writeBuf_.empty() && toWrite_.empty() && diskBlocks_.empty() &&
+           !writing_ && !reading_;
+  }
+
+  SpillStats Stats() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    SpillStats st;
+    st.memoryRecords = memory_.size();
+    for (const auto& b : ready_) st.memoryRecords += b.size();
+    uint64_t disk = writeBuf_.size();
+    for (const auto& b : toWrite_) disk += b.size();
+    for (const DiskBlock& b : diskBlocks_) disk += b.count;
+    st.diskRecords = disk;
+    st.spilledTotal = spilledTotal_;
+    st.files = files_.size();
+    st.writeErrors = writeErrors_;
+    st.readErrors = readErrors_;
+    st.dropped = dropped_;
+    return st;
+  }
+
+private:
+  static constexpr const char* kSpillExt = ".opcspill";
+
+  struct DiskBlock {
+    size_t file;       // Index into files_ (absolute, see fileBase_)
+    uint64_t offset;
+    uint32_t bytes;
+    uint32_t count;
+  };
+
+  struct DiskFile {
+    std::string path;
+    size_t blocksLeft = 0;
+    bool sealed = false;
+  };
+
+  // Caller holds mtx_. Moves the oldest spilled records into memory_ without any I/O: a block read back
+  // by the writer thread, else (nothing left on disk) blocks the writer has not taken yet.
+  bool Refill() {
+    if (!ready_.empty()) {
+      for (ChangeRecord& rec : ready_.front()) memory_.push_back(std::move(rec));
+      ready_.pop_front();
+      if (!diskBlocks_.empty()) cv_.notify_one();  // Read the next one ahead
+      return true;
+    }
+    if (!diskBlocks_.empty() || reading_) {
+      cv_.notify_one();
+      return false;  // Older records are still on disk
+    }
+    if (!toWrite_.empty() && !writing_) {
+      // Not on disk yet: take it straight from the writer queue
+      for (ChangeRecord& rec : toWrite_.front()) memory_.push_back(std::move(rec));
+      toWrite_.pop_front();
+      return true;
+    }
+    if (toWrite_.empty() && !writing_ && !writeBuf_.empty()) {
+      for (ChangeRecord& rec : writeBuf_) memory_.push_back(std::move(rec));
+      writeBuf_.clear();
+      spilling_ = false;
+      return true;
+    }
+    if (toWrite_.empty() && !writing_ && writeBuf_.empty()) spilling_ = false;
+    return false;
+  }
+
+  // Caller holds mtx_. One block is read ahead of the consumer.
+  bool PrefetchDue() const { return ready_.empty() && !reading_ && !diskBlocks_.empty(); }
+
+  // Caller holds mtx_. While writes fail nothing leaves toWrite_ but the consumer, so it is bounded:
+  // the oldest queued blocks are dropped (and counted) first.
+  void TrimUnwritten() {
+    while (toWrite_.size() > std::max<size_t>(1, opts_.maxQueuedBlocks)) {
+      dropped_ += toWrite_.front().size();
+      toWrite_.pop_front();
+    }
+  }
+
+  // Caller holds mtx_
+  void ReleaseDrainedFiles() {
+    std::error_code ec;
+    while (!files_.empty() && files_.front().sealed && files_.front().blocksLeft == 0) {
+      std::filesystem::remove(files_.front().path, ec);
+      files_.pop_front();
+      ++fileBase_;
+    }
+  }
+
+  void RunWriter() {
+    std::vector<uint8_t> encoded;
+    std::unique_lock<std::mutex> lock(mtx_);
+    for (;;) {
+      cv_.wait(lock, [this] { return !running_ || !toWrite_.empty() || PrefetchDue(); });
+      if (!running_) return;
+      bool progressed = false;
+      if (PrefetchDue()) progressed = ReadBack(lock);
+      if (running_ && !toWrite_.empty()) {
+        if (WriteNext(lock, encoded)) {
+          progressed = true;
+        } else {
+          // Disk trouble: the block stays queued (Refill can still take it from memory); try again later
+          cv_.wait_for(lock, std::chrono::milliseconds(500), [this] { return !running_; });
+        }
+      }
+      if (progressed && onReady_) {
+        lock.unlock();
+        onReady_();
+        lock.lock();
+      }
+    }
+  }
+
+  // Writer thread, lock held on entry and exit. Reads and decodes the oldest spilled block with mtx_ released.
+  bool ReadBack(std::unique_lock<std::mutex>& lock) {
+    DiskBlock block = diskBlocks_.front();
+    std::string path = files_[block.file - fileBase_].path;
+    uint64_t epoch = epoch_;
+    reading_ = true;
+    lock.unlock();
+    std::vector<uint8_t> data(block.bytes);
+    std::ifstream in(path, std::ios::binary);
+    in.seekg(static_cast<std::streamoff>(block.offset));
+    in.read(reinterpret_cast<char*>(data.data()), block.bytes);
+    changelog::DecodedBlock decoded;
+    bool ok = in && changelog::DecodeBlock(data.data(), data.size(), decoded);
+    lock.lock();
+    reading_ = false;
+    if (epoch != epoch_) return true;  // Discarded meanwhile
+    diskBlocks_.pop_front();
+    if (ok) {
+      ready_.push_back(std::move(decoded.records));
+    } else {
+      ++readErrors_;
+    }
+    --files_[block.file - fileBase_].blocksLeft;
+    ReleaseDrainedFiles();
+    return true;
+  }
+
+  // Writer thread, lock held on entry and exit. Encodes and writes the oldest queued block with mtx_ released;
+  // out_, outBytes_ and nextFile_ belong to the writer thread. False if the write failed.
+  bool WriteNext(std::unique_lock<std::mutex>& lock, std::vector<uint8_t>& encoded) {
+    std::vector<ChangeRecord> batch = std::move(toWrite_.front());
+    toWrite_.pop_front();
+    uint64_t epoch = epoch_;
+    writing_ = true;
+    lock.unlock();
+    encoded.clear();
+    std::vector<uint32_t> handles(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) handles[i] = batch[i].handle;
+    changelog::EncodeGorillaBlock(encoded, batch, handles, 0);
+    std::string opened;
+    if (outBytes_ + encoded.size() > opts_.maxFileBytes || !out_.is_open()) opened = OpenNextFile();
+    uint64_t offset = outBytes_;
+    out_.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+    out_.flush();
+    bool ok = static_cast<bool>(out_);
+    if (ok) outBytes_ += encoded.size();
+    else out_.close();
+    lock.lock();
+    writing_ = false;
+    if (!opened.empty()) {
+      if (!files_.empty()) files_.back().sealed = true;
+      DiskFile file;
+      file.path = opened;
+      files_.push_back(file);
+      ReleaseDrainedFiles();
+    }
+    if (epoch != epoch_) return ok;  // Discarded meanwhile
+    if (ok && !files_.empty()) {
+      diskBlocks_.push_back(DiskBlock{fileBase_ + files_.size() - 1, offset, static_cast<uint32_t>(encoded.size()),
+                                      static_cast<uint32_t>(batch.size())});
+      ++files_.back().blocksLeft;
+      writeFailing_ = false;
+      return true;
+    }
+    ++writeErrors_;
+    writeFailing_ = true;
+    toWrite_.push_front(std::move(batch));
+    TrimUnwritten();
+    return false;
+  }
+
+  // Writer thread, no lock. Returns the path of the new file; the caller registers it in files_.
+  std::string OpenNextFile() {
+    out_.close();
+    char name[48];
+    std::snprintf(name, sizeof(name), "spill-%010llu%s", static_cast<unsigned long long>(nextFile_++), kSpillExt);
+    std::string path = opts_.dir + "/" + name;
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    outBytes_ = 0;
+    return path;
+  }
+
+  SpillOptions opts_;
+  std::function<void()> onReady_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  bool running_ = false;
+  std::thread writer_;
+
+  std::deque<ChangeRecord> memory_;
+  bool spilling_ = false;
+  std::vector<ChangeRecord> writeBuf_;               // Newest spilled records, not yet a block
+  std::deque<std::vector<ChangeRecord>> toWrite_;    // Blocks waiting for the writer thread
+  bool writing_ = false;                             // Writer holds a block between toWrite_ and diskBlocks_
+  std::deque<DiskBlock> diskBlocks_;                 // Oldest spilled blocks, on disk
+  bool reading_ = false;                             // Writer is reading diskBlocks_.front() back
+  uint64_t epoch_ = 0;                               // Bumped by Discard
+  bool writeFailing_ = false;                        // The last write failed
+  std::deque<std::vector<ChangeRecord>> ready_;      // Read back from disk, older than anything in diskBlocks_
+  std::deque<DiskFile> files_;
+  size_t fileBase_ = 0;
+  uint64_t nextFile_ = 0;
+  std::ofstream out_;
+  uint64_t outBytes_ = 0;
+  uint64_t spilledTotal_ = 0;
+  uint64_t writeErrors_ = 0;
+  uint64_t readErrors_ = 0;
+  uint64_t dropped_ = 0;
+};
@@ -0,0 +1,185 @@
+#pragma once
+// Watches how long the change path is held up: JS handler calls, OPC callback threads (including
+// the pipeline lock wait) and batches waiting for the JS thread. Operations over their threshold
+// become slowConsumer events naming the group; a background thread reports ones still running.
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "pipeline_metrics.h"
+
+enum class StallKind : int {
+  Handler = 0,  // JS subscribe handler run time
+  Callback,     // OnDataChange on the server callback thread
+  Dispatch,     // Pending batch waiting for the JS thread (the consumer is behind)
+  Count
+};
+
+inline const char* StallKindName(StallKind k) {
+  static const char* kNames[] = {"handler", "callback", "dispatch"};
+  return kNames[static_cast<int>(k)];
+}
+
+struct WatchdogOptions {
+  uint64_t thresholdNs[static_cast<int>(StallKind::Count)] = {100000000ull, 50000000ull, 500000000ull};
+  uint64_t intervalNs = 100000000ull;  // Scan period for operations still running
+  size_t maxEvents = 1000;             // Undelivered events kept; older ones are counted as dropped
+};
+
+struct StallEvent {
+  std::string group;
+  StallKind kind = StallKind::Handler;
+  uint64_t durationNs = 0;
+  uint64_t thresholdNs = 0;
+  uint64_t seq = 0;          // Record being handled (handler), newest seq of the batch (dispatch), 0 for callbacks
+  bool inProgress = false;   // Reported by the scan while still running; a final event follows
+  double timestampMs = 0.0;  // Wall clock, JS epoch
+};
+
+struct StallCounts {
+  uint64_t count[static_cast<int>(StallKind::Count)] = {};
+  uint64_t maxNs[static_cast<int>(StallKind::Count)] = {};
+};
+
+class StallWatchdog {
+public:
+  // Stack object covering one operation; linked into the active list while it runs
+  struct Op {
+    StallKind kind;
+    const std::string* group;
+    uint64_t seq;
+    uint64_t startNs;
+    bool reported = false;
+    Op* prev = nullptr;
+    Op* next = nullptr;
+  };
+
+  StallWatchdog() = default;
+  StallWatchdog(const StallWatchdog&) = delete;
+  StallWatchdog& operator=(const StallWatchdog&) = delete;
+  ~StallWatchdog() { Stop(); }
+
+  bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  // notify is called (under the watchdog lock) when events become available; it should only signal
+  void Start(const WatchdogOptions& opts, std::function<void()> notify) {
+    Stop();
+    std::lock_guard<std::mutex> lock(mtx_);
+    opts_ = opts;
+    notify_ = std::move(notify);
+    running_ = true;
+    enabled_.store(true, std::memory_order_relaxed);
+    scanner_ = std::thread(&StallWatchdog::RunScanner, this);
+  }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (!running_) return;
+      running_ = false;
+      enabled_.store(false, std::memory_order_relaxed);
+      notify_ = nullptr;
+    }
+    cv_.notify_all();
+    if (scanner_.joinable()) scanner_.join();
+  }
+
+  void Begin(Op& op, StallKind kind, const std::string& group, uint64_t seq) {
+    op.kind = kind;
+    op.group = &group;
+    op.seq = seq;
+    op.startNs = MonotonicNs();
+    std::lock_guard<std::mutex> lock(mtx_);
+    op.next = active_;
+    if (active_) active_->prev = &op;
+    active_ = &op;
+  }
+
+  void End(Op& op) {
+    uint64_t duration = MonotonicNs() - op.startNs;
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (op.prev) op.prev->next = op.next;
+    else active_ = op.next;
+    if (op.next) op.next->prev = op.prev;
+    Check(op.kind, *op.group, duration, op.seq, false);
+  }
+
+  // Operations measured elsewhere (dispatch wait)
+  void Observe(StallKind kind, const std::string& group, uint64_t durationNs, uint64_t seq) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    Check(kind, group, durationNs, seq, false);
+  }
+
+  void Drain(std::deque<StallEvent>& out) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    out.swap(events_);
+    events_.clear();
+  }
+
+  std::map<std::string, StallCounts> Counts(uint64_t& droppedEvents) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    droppedEvents = dropped_;
+    return counts_;
+  }
+
+private:
+  // Caller holds mtx_
+  void Check(StallKind kind, const std::string& group, uint64_t durationNs, uint64_t seq, bool inProgress) {
+    uint64_t threshold = opts_.thresholdNs[static_cast<int>(kind)];
+    if (durationNs <= threshold) return;
+    if (!inProgress) {
+      StallCounts& counts = counts_[group];
+      ++counts.count[static_cast<int>(kind)];
+      if (durationNs > counts.maxNs[static_cast<int>(kind)]) counts.maxNs[static_cast<int>(kind)] = durationNs;
+    }
+    StallEvent ev;
+    ev.group = group;
+    ev.kind = kind;
+    ev.durationNs = durationNs;
+    ev.thresholdNs = threshold;
+    ev.seq = seq;
+    ev.inProgress = inProgress;
+    ev.timestampMs = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count());
+    events_.push_back(std::move(ev));
+    while (events_.size() > opts_.maxEvents) {
+      events_.pop_front();
+      ++dropped_;
+    }
+    if (notify_) notify_();
+  }
+
+  void RunScanner() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (running_) {
+      cv_.wait_for(lock, std::chrono::nanoseconds(opts_.intervalNs), [this] { return !running_; });
+      if (!running_) break;
+      uint64_t now = MonotonicNs();
+      for (Op* op = active_; op; op = op->next) {
+        uint64_t running = now - op->startNs;
+        if (!op->reported && running > opts_.thresholdNs[static_cast<int>(op->kind)]) {
+          op->reported = true;
+          Check(op->kind, *op->group, running, op->seq, true);
+        }
+      }
+    }
+  }
+
+  std::atomic<bool> enabled_{false};
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  bool running_ = false;
+  std::thread scanner_;
+  WatchdogOptions opts_;
+  std::function<void()> notify_;
+  Op* active_ = nullptr;
+  std::deque<StallEvent> events_;
+  uint64_t dropped_ = 0;
+  std::map<std::string, StallCounts> counts_;
+};
@@ -0,0 +1,192 @@
+#pragma once
+// Server status telemetry: a background thread calls IOPCServer::GetStatus every intervalMs and records
+// state, bandwidth, group count and the server clock. Skew is the server's ftCurrentTime minus the local
+// clock at the midpoint of the call, so the round trip does not count as skew. State changes, skew
+// crossing its threshold and failing status calls become events for the JS thread.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include "periodic_thread.h"
+
+struct StatusOptions {
+  uint32_t intervalMs = 5000;
+  double skewThresholdMs = 1000.0;
+  size_t history = 120;    // Samples kept for getServerStatus({ history: true }) and the window statistics
+  size_t maxEvents = 100;
+};
+
+struct StatusSample {
+  double localMs = 0.0;    // Local wall clock at the midpoint of the call, JS epoch
+  double rttMs = 0.0;
+  int32_t error = 0;       // HRESULT of GetStatus; the fields below are only valid when it succeeded
+  double serverMs = 0.0;   // ftCurrentTime
+  double startMs = 0.0;    // ftStartTime
+  double lastUpdateMs = 0.0;  // ftLastUpdateTime (last data sent to this client)
+  uint32_t state = 0;      // OPCSERVERSTATE
+  uint32_t groupCount = 0;
+  uint32_t bandwidth = 0;  // Percent of the server's bandwidth in use; 0xFFFFFFFF when unknown
+  uint16_t major = 0, minor = 0, build = 0;
+  double SkewMs() const { return serverMs - localMs; }
+};
+
+struct StatusEvent {
+  enum class Type { State, Skew, Error, Recovered } type = Type::State;
+  StatusSample sample;
+  uint32_t previousState = 0;  // State
+  bool exceeded = false;       // Skew: crossed above the threshold (false: back within it)
+};
+
+// Statistics over the kept history (successful samples only)
+struct StatusStats {
+  uint64_t samples = 0;    // Since Start, including failures
+  uint64_t errors = 0;
+  uint64_t stateChanges = 0;
+  size_t window = 0;
+  double skewMinMs = 0.0, skewMaxMs = 0.0, skewMeanMs = 0.0;
+  double rttMeanMs = 0.0, rttMaxMs = 0.0;
+  double bandwidthMean = 0.0;  // Over samples that report it
+  uint32_t bandwidthMax = 0;
+};
+
+class StatusMonitor {
+public:
+  StatusMonitor() = default;
+  StatusMonitor(const StatusMonitor&) = delete;
+  StatusMonitor& operator=(const StatusMonitor&) = delete;
+  ~StatusMonitor() { Stop(); }
+
+  // poll runs on the monitor thread right away and then every intervalMs; notify is called when events are queued
+  void Start(const StatusOptions& opts, std::function<void()> poll, std::function<void()> notify,
+             std::function<void()> threadInit = nullptr, std::function<void()> threadExit = nullptr) {
+    Stop();
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      opts_ = opts;
+      opts_.history = std::max<size_t>(1, opts_.history);
+      notify_ = std::move(notify);
+      history_.clear();
+      events_.clear();
+      stats_ = StatusStats();
+      hasLast_ = false;
+      skewHigh_ = false;
+      failing_ = false;
+    }
+    thread_.StartEvery(std::chrono::milliseconds(opts.intervalMs), true, std::move(poll), std::move(threadInit),
+                       std::move(threadExit));
+  }
+
+  void Stop() { thread_.Stop(); }
+  bool Running() { return thread_.Running(); }
+
+  void Record(const StatusSample& s) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    ++stats_.samples;
+    if (s.error < 0) {
+      ++stats_.errors;
+      if (!failing_) Push(StatusEvent::Type::Error, s);
+      failing_ = true;
+      return;
+    }
+    if (failing_) Push(StatusEvent::Type::Recovered, s);
+    failing_ = false;
+    if (hasLast_ && last_.state != s.state) {
+      ++stats_.stateChanges;
+      Push(StatusEvent::Type::State, s, last_.state);
+    }
+    bool high = std::fabs(s.SkewMs()) > opts_.skewThresholdMs;
+    if (high != skewHigh_) Push(StatusEvent::Type::Skew, s, 0, high);
+    skewHigh_ = high;
+    last_ = s;
+    hasLast_ = true;
+    history_.push_back(s);
+    while (history_.size() > opts_.history) history_.pop_front();
+  }
+
+  // False until a status call has succeeded
+  bool Last(StatusSample& out) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    out = last_;
+    return hasLast_;
+  }
+
+  StatusStats Stats() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    StatusStats st = stats_;
+    st.window = history_.size();
+    if (history_.empty()) return st;
+    st.skewMinMs = st.skewMaxMs = history_.front().SkewMs();
+    double skewSum = 0.0, rttSum = 0.0, bwSum = 0.0;
+    size_t bwCount = 0;
+    for (const StatusSample& s : history_) {
+      double skew = s.SkewMs();
+      st.skewMinMs = std::min(st.skewMinMs, skew);
+      st.skewMaxMs = std::max(st.skewMaxMs, skew);
+      skewSum += skew;
+      rttSum += s.rttMs;
+      st.rttMaxMs = std::max(st.rttMaxMs, s.rttMs);
+      if (s.bandwidth != 0xFFFFFFFFu) {
+        bwSum += s.bandwidth;
+        ++bwCount;
+        st.bandwidthMax = std::max(st.bandwidthMax, s.bandwidth);
+      }
+    }
+    st.skewMeanMs = skewSum / history_.size();
+    st.rttMeanMs = rttSum / history_.size();
+    st.bandwidthMean = bwCount ? bwSum / bwCount : 0.0;
+    return st;
+  }
+
+  std::deque<StatusSample> History() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return history_;
+  }
+
+  void Drain(std::deque<StatusEvent>& out) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    out.swap(events_);
+    events_.clear();
+  }
+
+  uint64_t DroppedEvents() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return dropped_;
+  }
+
+  double SkewThresholdMs() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return opts_.skewThresholdMs;
+  }
+
+private:
+  // Caller holds mtx_
+  void Push(StatusEvent::Type type, const StatusSample& s, uint32_t previousState = 0, bool exceeded = false) {
+    StatusEvent ev;
+    ev.type = type;
+    ev.sample = s;
+    ev.previousState = previousState;
+    ev.exceeded = exceeded;
+    events_.push_back(ev);
+    while (events_.size() > opts_.maxEvents) {
+      events_.pop_front();
+      ++dropped_;
+    }
+    if (notify_) notify_();
+  }
+
+  std::mutex mtx_;
+  PeriodicThread thread_;
+  StatusOptions opts_;
+  std::function<void()> notify_;
+  std::deque<StatusSample> history_;
+  std::deque<StatusEvent> events_;
+  StatusStats stats_;
+  StatusSample last_;
+  bool hasLast_ = false;
+  bool skewHigh_ = false;
+  bool failing_ = false;
+  uint64_t dropped_ = 0;
+};
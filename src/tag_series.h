@@ -0,0 +1,181 @@
+#pragma once
+// Optional fixed-capacity (timestamp, value, quality) ring per item, fed from the change path,
+// with windowed min/max/avg/last queries over many items at once.
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "gorilla.h"
+
+struct SeriesAggregate {
+  double min = std::numeric_limits<double>::quiet_NaN();
+  double max = std::numeric_limits<double>::quiet_NaN();
+  double avg = std::numeric_limits<double>::quiet_NaN();
+  double last = std::numeric_limits<double>::quiet_NaN();
+  double lastTimestamp = std::numeric_limits<double>::quiet_NaN();
+  uint32_t count = 0;
+};
+
+// Column layout so the window scan touches only timestamps and values.
+// Compressed mode keeps a small raw tail and seals older samples into Gorilla blocks.
+class TagSeries {
+public:
+  static constexpr size_t kBlockSamples = 256;
+
+  TagSeries(size_t capacity, bool compressed)
+      : compressed_(compressed), capacity_(capacity),
+        ts_(compressed ? kBlockSamples : capacity), values_(ts_.size()), qualities_(ts_.size()) {}
+
+  void Push(double tsMs, double value, uint16_t quality) {
+    if (compressed_) {
+      PushCompressed(tsMs, value, quality);
+      return;
+    }
+    size_t cap = ts_.size();
+    size_t slot = (head_ + size_) % cap;
+    if (size_ == cap) {
+      slot = head_;
+      head_ = (head_ + 1) % cap;
+    } else {
+      ++size_;
+    }
+    ts_[slot] = tsMs;
+    values_[slot] = value;
+    qualities_[slot] = quality;
+  }
+
+  // Samples with timestamp in [fromMs, toMs]. Source timestamps are not guaranteed to be monotonic
+  // (server clock steps, device-stamped items), so every sample is checked; sealed blocks whose timestamp
+  // range misses the window are skipped without decoding.
+  SeriesAggregate Aggregate(double fromMs, double toMs, bool goodOnly) const {
+    SeriesAggregate agg;
+    double sum = 0.0;
+    Scan(ts_.data(), values_.data(), qualities_.data(), ts_.size(), head_, size_, fromMs, toMs, goodOnly, agg, sum);
+    if (compressed_) {
+      std::vector<double> ts(kBlockSamples), values(kBlockSamples);
+      std::vector<uint16_t> qualities(kBlockSamples);
+      for (auto it = blocks_.rbegin(); it != blocks_.rend(); ++it) {
+        if (it->minTsMs > toMs || it->maxTsMs < fromMs) continue;
+        if (!gorilla::DecodeSeriesBlock(*it, ts.data(), values.data(), qualities.data())) continue;
+        Scan(ts.data(), values.data(), qualities.data(), it->count, 0, it->count, fromMs, toMs, goodOnly, agg, sum);
+      }
+    }
+    if (agg.count) agg.avg = sum / agg.count;
+    return agg;
+  }
+
+  size_t Size() const { return size_ + blockSamples_; }
+
+  size_t Bytes() const {
+    size_t bytes = ts_.size() * (sizeof(double) * 2 + sizeof(uint16_t));
+    for (const gorilla::SeriesBlock& b : blocks_) bytes += b.Bytes();
+    return bytes;
+  }
+
+private:
+  // Walks samples newest -> oldest. last is the sample with the latest timestamp; on a tie the newer one.
+  static void Scan(const double* ts, const double* values, const uint16_t* qualities, size_t cap,
+                   size_t head, size_t size, double fromMs, double toMs, bool goodOnly,
+                   SeriesAggregate& agg, double& sum) {
+    for (size_t i = size; i-- > 0;) {
+      size_t slot = (head + i) % cap;
+      double t = ts[slot];
+      if (t > toMs || t < fromMs) continue;
+      if (goodOnly && (qualities[slot] & 0xC0) != 0xC0) continue;
+      double v = values[slot];
+      if (agg.count == 0) {
+        agg.min = agg.max = agg.last = v;
+        agg.lastTimestamp = t;
+      } else {
+        if (v < agg.min) agg.min = v;
+        if (v > agg.max) agg.max = v;
+        if (t > agg.lastTimestamp) {
+          agg.last = v;
+          agg.lastTimestamp = t;
+        }
+      }
+      sum += v;
+      ++agg.count;
+    }
+  }
+
+  // Raw tail fills linearly (head_ stays 0), then is sealed; oldest blocks go once capacity is exceeded
+  void PushCompressed(double tsMs, double value, uint16_t quality) {
+    ts_[size_] = tsMs;
+    values_[size_] = value;
+    qualities_[size_] = quality;
+    if (++size_ < kBlockSamples) return;
+    blocks_.emplace_back();
+    gorilla::EncodeSeriesBlock(ts_.data(), values_.data(), qualities_.data(), size_, blocks_.back());
+    blockSamples_ += size_;
+    size_ = 0;
+    while (!blocks_.empty() && blockSamples_ > capacity_) {
+      blockSamples_ -= blocks_.front().count;
+      blocks_.pop_front();
+    }
+  }
+
+  bool compressed_;
+  size_t capacity_;
+  std::deque<gorilla::SeriesBlock> blocks_;
+  size_t blockSamples_ = 0;
+  std::vector<double> ts_;
+  std::vector<double> values_;
+  std::vector<uint16_t> qualities_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
+// Series of one group, indexed by the pipeline's item handle
+class SeriesStore {
+public:
+  SeriesStore(size_t capacity, bool compressed) : capacity_(capacity ? capacity : 1), compressed_(compressed) {}
+
+  void Feed(uint32_t handle, double tsMs, double value, uint16_t quality) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (handle >= series_.size()) series_.resize(handle + 1);
+    if (!series_[handle]) series_[handle] = std::make_unique<TagSeries>(capacity_, compressed_);
+    series_[handle]->Push(tsMs, value, quality);
+  }
+
+  // out[w * handles.size() + i] is the aggregate of handles[i] over windowsMs[w] ending at nowMs.
+  // Negative handles (unknown items) yield empty aggregates.
+  void AggregateMany(const std::vector<int64_t>& handles, const std::vector<double>& windowsMs,
+                     double nowMs, bool goodOnly, std::vector<SeriesAggregate>& out) const {
+    out.assign(handles.size() * windowsMs.size(), SeriesAggregate());
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (size_t w = 0; w < windowsMs.size(); ++w) {
+      double fromMs = nowMs - windowsMs[w];
+      for (size_t i = 0; i < handles.size(); ++i) {
+        int64_t h = handles[i];
+        if (h < 0 || static_cast<size_t>(h) >= series_.size() || !series_[h]) continue;
+        out[w * handles.size() + i] = series_[h]->Aggregate(fromMs, nowMs, goodOnly);
+      }
+    }
+  }
+
+  size_t Capacity() const { return capacity_; }
+  bool Compressed() const { return compressed_; }
+
+  // items, samples, bytes
+  void Usage(size_t& items, size_t& samples, size_t& bytes) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    items = samples = bytes = 0;
+    for (const auto& s : series_) {
+      if (!s) continue;
+      ++items;
+      samples += s->Size();
+      bytes += s->Bytes();
+    }
+  }
+
+private:
+  mutable std::mutex mtx_;
+  size_t capacity_;
+  bool compressed_;
+  std::vector<std::unique_ptr<TagSeries>> series_;
+};
@@ -0,0 +1,90 @@
+#pragma once
+// One long-lived thread that runs submitted tasks in order, for objects that must be created (and live) in an
+// environment the callers' threads do not keep up, e.g. a COM apartment: init runs on the thread before the
+// first task and exit after the last, whatever the callers' own thread lifetimes. The thread starts with the
+// first Run() and stays until Stop().
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+class TaskThread {
+public:
+  explicit TaskThread(std::function<void()> init = nullptr, std::function<void()> exit = nullptr)
+      : init_(std::move(init)), exit_(std::move(exit)) {}
+  TaskThread(const TaskThread&) = delete;
+  TaskThread& operator=(const TaskThread&) = delete;
+  ~TaskThread() { Stop(); }
+
+  // Runs fn on the thread and waits for it; its result (or exception) is returned here. Must not be called from
+  // a task (it would wait for itself). Throws std::runtime_error while Stop() is in progress.
+  template <typename F>
+  std::invoke_result_t<F> Run(F&& fn) {
+    using R = std::invoke_result_t<F>;
+    auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+    std::future<R> result = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (stopping_) throw std::runtime_error("task thread is stopping");
+      if (!thread_.joinable()) {
+        running_ = true;
+        thread_ = std::thread([this] { Loop(); });
+      }
+      tasks_.emplace_back([task] { (*task)(); });
+    }
+    cv_.notify_one();
+    return result.get();
+  }
+
+  // Finishes the queued tasks, runs exit and joins; a later Run() starts the thread again
+  void Stop() {
+    std::thread thread;
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      if (!thread_.joinable()) return;
+      running_ = false;
+      stopping_ = true;
+      thread = std::move(thread_);
+    }
+    cv_.notify_one();
+    thread.join();
+    std::lock_guard<std::mutex> lock(mtx_);
+    stopping_ = false;
+  }
+
+  bool Running() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return running_;
+  }
+
+private:
+  void Loop() {
+    if (init_) init_();
+    std::unique_lock<std::mutex> lock(mtx_);
+    for (;;) {
+      cv_.wait(lock, [this] { return !tasks_.empty() || !running_; });
+      if (tasks_.empty()) break;
+      std::function<void()> task = std::move(tasks_.front());
+      tasks_.pop_front();
+      lock.unlock();
+      task();
+      lock.lock();
+    }
+    lock.unlock();
+    if (exit_) exit_();
+  }
+
+  std::function<void()> init_, exit_;
+  mutable std::mutex mtx_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  std::thread thread_;
+  bool running_ = false;
+  bool stopping_ = false;
+};
@@ -0,0 +1,86 @@
+#pragma once
+// Live value table in memory shared with JS (a SharedArrayBuffer), written in place by the change path.
+// Each slot is guarded by a seqlock so workers read consistent snapshots without messages or locks.
+//
+// Layout (little endian, 8-byte aligned base):
+//   header, 64 bytes:  u32 magic 'OPCV', u32 layout version, u32 slot count, u32 slot bytes,
+//                      u32 header bytes, u32 generation (bumped after every written batch)
+//   slot i at 64 + 32 * i:
+//     +0  u32 version  odd while being written (Atomics.load on Int32Array index (64 + 32 i) / 4)
+//     +4  u16 quality, u8 kind (ChangeValue::Kind), u8 reserved
+//     +8  f64 value    NaN unless kind is Number/Boolean
+//     +16 f64 timestamp (JS ms)
+//     +24 f64 seq
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "change_history.h"
+
+class ValueTable {
+public:
+  static constexpr uint32_t kMagic = 0x5643504F;  // "OPCV"
+  static constexpr uint32_t kLayoutVersion = 1;
+  static constexpr size_t kHeaderBytes = 64;
+  static constexpr size_t kSlotBytes = 32;
+
+  static size_t BytesFor(size_t slots) { return kHeaderBytes + slots * kSlotBytes; }
+
+  // base must stay valid (the owner keeps the buffer referenced) until the table is dropped
+  ValueTable(uint8_t* base, const std::vector<std::string>& items) : base_(base) {
+    for (size_t i = 0; i < items.size(); ++i) slots_.emplace(items[i], static_cast<uint32_t>(i));
+    std::memset(base_, 0, BytesFor(items.size()));
+    uint32_t header[5] = {kMagic, kLayoutVersion, static_cast<uint32_t>(items.size()),
+                          static_cast<uint32_t>(kSlotBytes), static_cast<uint32_t>(kHeaderBytes)};
+    std::memcpy(base_, header, sizeof(header));
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    for (size_t i = 0; i < items.size(); ++i) std::memcpy(Slot(static_cast<uint32_t>(i)) + 8, &nan, 8);
+  }
+
+  // -1 if the item has no slot
+  int64_t SlotOf(const std::string& item) const {
+    auto it = slots_.find(item);
+    return it == slots_.end() ? -1 : static_cast<int64_t>(it->second);
+  }
+
+  // Single writer (callers serialize per table)
+  void Write(uint32_t slot, const ChangeRecord& rec) {
+    uint8_t* p = Slot(slot);
+    std::atomic<uint32_t>* version = Version(p);
+    uint32_t v = version->load(std::memory_order_relaxed);
+    version->store(v + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint16_t quality = rec.quality;
+    uint8_t kind = static_cast<uint8_t>(rec.value.kind);
+    double value = rec.value.IsNumeric() ? rec.value.number : std::numeric_limits<double>::quiet_NaN();
+    double ts = FileTimeTicksToJsMs(rec.timestamp);
+    double seq = static_cast<double>(rec.seq);
+    std::memcpy(p + 4, &quality, 2);
+    p[6] = kind;
+    std::memcpy(p + 8, &value, 8);
+    std::memcpy(p + 16, &ts, 8);
+    std::memcpy(p + 24, &seq, 8);
+
+    version->store(v + 2, std::memory_order_release);
+  }
+
+  // After a batch, so pollers can skip unchanged tables
+  void BumpGeneration() {
+    Version(base_ + 20)->fetch_add(1, std::memory_order_release);
+  }
+
+  size_t Slots() const { return slots_.size(); }
+
+private:
+  uint8_t* Slot(uint32_t slot) const { return base_ + kHeaderBytes + static_cast<size_t>(slot) * kSlotBytes; }
+
+  // Lock-free 32-bit atomics are address-free, so they work on memory JS also sees through Atomics
+  static std::atomic<uint32_t>* Version(uint8_t* p) { return reinterpret_cast<std::atomic<uint32_t>*>(p); }
+
+  uint8_t* base_;
+  std::unordered_map<std::string, uint32_t> slots_;
+};
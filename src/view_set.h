@@ -0,0 +1,105 @@
+#pragma once
+// Named item sets ("views", e.g. one per plant area) over server groups. Showing a set of views yields,
+// per group, only the items whose visibility changed, so a switch costs one activate and one deactivate
+// call per group no matter how many items stay visible.
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+class ViewSet {
+public:
+  using Items = std::map<std::string, std::set<std::string>>;  // group -> items
+
+  struct Delta {
+    std::vector<std::string> on;
+    std::vector<std::string> off;
+  };
+
+  // Replaces the view; returns the visibility changes if it is shown
+  std::map<std::string, Delta> Define(const std::string& name, Items items) {
+    Items before = Visible();
+    views_[name] = std::move(items);
+    return Diff(before, Visible());
+  }
+
+  std::map<std::string, Delta> Remove(const std::string& name) {
+    Items before = Visible();
+    views_.erase(name);
+    shown_.erase(name);
+    return Diff(before, Visible());
+  }
+
+  // Exactly these views become visible (unknown names are ignored)
+  std::map<std::string, Delta> Show(const std::vector<std::string>& names) {
+    Items before = Visible();
+    shown_.clear();
+    for (const std::string& name : names) {
+      if (views_.count(name)) shown_.insert(name);
+    }
+    return Diff(before, Visible());
+  }
+
+  Items Visible() const {
+    Items out;
+    for (const std::string& name : shown_) {
+      for (const auto& pair : views_.at(name)) out[pair.first].insert(pair.second.begin(), pair.second.end());
+    }
+    return out;
+  }
+
+  // Number of defined views containing the item
+  size_t Holders(const std::string& group, const std::string& item) const {
+    size_t n = 0;
+    for (const auto& view : views_) {
+      auto it = view.second.find(group);
+      if (it != view.second.end() && it->second.count(item)) ++n;
+    }
+    return n;
+  }
+
+  // Whether an item with refs holders still has to be scanned: a shown view contains it, or something besides
+  // the views holds it
+  bool NeedsScan(const std::string& group, const std::string& item, size_t refs) const {
+    if (refs > Holders(group, item)) return true;
+    for (const std::string& name : shown_) {
+      const Items& view = views_.at(name);
+      auto it = view.find(group);
+      if (it != view.end() && it->second.count(item)) return true;
+    }
+    return false;
+  }
+
+  const Items* Find(const std::string& name) const {
+    auto it = views_.find(name);
+    return it == views_.end() ? nullptr : &it->second;
+  }
+
+  const std::map<std::string, Items>& Views() const { return views_; }
+  bool Shown(const std::string& name) const { return shown_.count(name) > 0; }
+
+private:
+  static std::map<std::string, Delta> Diff(const Items& before, const Items& after) {
+    static const std::set<std::string> kNone;
+    std::set<std::string> groups;
+    for (const auto& pair : before) groups.insert(pair.first);
+    for (const auto& pair : after) groups.insert(pair.first);
+    std::map<std::string, Delta> out;
+    for (const std::string& group : groups) {
+      auto b = before.find(group);
+      auto a = after.find(group);
+      const std::set<std::string>& was = b == before.end() ? kNone : b->second;
+      const std::set<std::string>& now = a == after.end() ? kNone : a->second;
+      Delta d;
+      std::set_difference(now.begin(), now.end(), was.begin(), was.end(), std::back_inserter(d.on));
+      std::set_difference(was.begin(), was.end(), now.begin(), now.end(), std::back_inserter(d.off));
+      if (!d.on.empty() || !d.off.empty()) out[group] = std::move(d);
+    }
+    return out;
+  }
+
+  std::map<std::string, Items> views_;
+  std::set<std::string> shown_;
+};
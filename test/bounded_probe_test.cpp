@@ -0,0 +1,108 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "bounded_probe.h"
+
+namespace {
+
+using Ms = std::chrono::milliseconds;
+
+// Probes stuck until Release(); stand-ins for DCOM activations against dead hosts
+struct Gate {
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool open = false;
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [this] { return open; });
+  }
+  void Release() {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      open = true;
+    }
+    cv.notify_all();
+  }
+};
+
+void WaitForAbandoned(size_t n) {
+  for (int i = 0; i < 500 && AbandonedProbes().load() != n; ++i) std::this_thread::sleep_for(Ms(2));
+}
+
+void ConcurrencyBounded() {
+  std::atomic<int> running{0}, peak{0}, inits{0}, exits{0};
+  auto results = BoundedProbe<int>::Run(20, 3, Ms(5000), [&](size_t i) {
+    int now = ++running;
+    int seen = peak.load();
+    while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+    std::this_thread::sleep_for(Ms(2));
+    --running;
+    return static_cast<int>(i) * 2;
+  }, [&] { ++inits; }, [&] { ++exits; });
+  CHECK_EQ(results.size(), 20u);
+  bool ordered = true;
+  for (size_t i = 0; i < results.size(); ++i) ordered = ordered && results[i].done && results[i].value == static_cast<int>(i) * 2;
+  CHECK(ordered);
+  CHECK(peak.load() <= 3);
+  CHECK_EQ(inits.load(), 3);
+  for (int i = 0; i < 500 && exits.load() != 3; ++i) std::this_thread::sleep_for(Ms(2));
+  CHECK_EQ(exits.load(), 3);
+}
+
+// A stuck probe times out and a replacement worker finishes the rest
+void StuckProbeReplaced() {
+  Gate gate;
+  auto results = BoundedProbe<int>::Run(4, 1, Ms(50), [&](size_t i) {
+    if (i == 0) gate.Wait();
+    return 1;
+  });
+  CHECK(results[0].timedOut);
+  CHECK(!results[0].done);
+  CHECK_EQ(results[0].ms, 50.0);
+  CHECK(results[1].done && results[2].done && results[3].done);
+  CHECK_EQ(AbandonedProbes().load(), 1u);
+  gate.Release();
+  WaitForAbandoned(0);
+  CHECK_EQ(AbandonedProbes().load(), 0u);
+}
+
+// Past the cap no replacement starts: targets left without a worker time out unstarted
+void AbandonedThreadsCapped() {
+  Gate gate;
+  std::atomic<int> probed{0};
+  auto results = BoundedProbe<int>::Run(6, 2, Ms(30), [&](size_t) {
+    ++probed;
+    gate.Wait();
+    return 1;
+  }, nullptr, nullptr, 3);
+  // Both workers stuck and replaced once each; their replacements are abandoned at the cap, leaving no worker
+  CHECK_EQ(probed.load(), 4);
+  size_t timedOut = 0, unstarted = 0;
+  for (const auto& r : results) {
+    timedOut += r.timedOut ? 1 : 0;
+    unstarted += r.started ? 0 : 1;
+  }
+  CHECK_EQ(timedOut, 6u);
+  CHECK_EQ(unstarted, 2u);
+  CHECK_EQ(AbandonedProbes().load(), 4u);
+
+  auto next = BoundedProbe<int>::Run(2, 1, Ms(30), [](size_t) { return 5; }, nullptr, nullptr, 3);
+  CHECK(next[0].done && next[1].done);  // Healthy probes still run at the cap
+  gate.Release();
+  WaitForAbandoned(0);
+  CHECK_EQ(AbandonedProbes().load(), 0u);
+}
+
+}  // namespace
+
+int main() {
+  ConcurrencyBounded();
+  StuckProbeReplaced();
+  AbandonedThreadsCapped();
+  return check::Finish("bounded_probe");
+}
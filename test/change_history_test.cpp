@@ -0,0 +1,122 @@
+#include <vector>
+#include "change_history.h"
+#include "check.h"
+
+namespace {
+
+ChangeRecord Rec(uint64_t seq) {
+  ChangeRecord rec;
+  rec.seq = seq;
+  rec.handle = static_cast<uint32_t>(seq % 3);
+  rec.value.kind = ChangeValue::Kind::Number;
+  rec.value.number = static_cast<double>(seq);
+  return rec;
+}
+
+void HistoryKeepsNewest() {
+  ChangeHistory history(4);
+  std::vector<ChangeRecord> out;
+  CHECK(!history.Since(0, 100, out));
+  CHECK(out.empty());
+  for (uint64_t seq = 1; seq <= 6; ++seq) history.Push(Rec(seq));
+  CHECK_EQ(history.OldestSeq(), 3u);
+  CHECK_EQ(history.NewestSeq(), 6u);
+
+  // 1 and 2 were evicted: the gap is reported and everything kept comes back, oldest first
+  CHECK(history.Since(0, 100, out));
+  CHECK_EQ(out.size(), 4u);
+  CHECK_EQ(out.front().seq, 3u);
+  CHECK_EQ(out.back().seq, 6u);
+
+  out.clear();
+  CHECK(!history.Since(2, 100, out));
+  CHECK_EQ(out.size(), 4u);
+
+  out.clear();
+  CHECK(!history.Since(4, 100, out));
+  CHECK_EQ(out.size(), 2u);
+  CHECK_EQ(out[0].seq, 5u);
+
+  out.clear();
+  CHECK(!history.Since(6, 100, out));
+  CHECK(out.empty());
+
+  out.clear();
+  CHECK(!history.Since(3, 2, out));
+  CHECK_EQ(out.size(), 2u);
+  CHECK_EQ(out[1].seq, 5u);
+}
+
+void HistoryReset() {
+  ChangeHistory history(2);
+  history.Push(Rec(1));
+  history.Reset(8);
+  CHECK_EQ(history.Capacity(), 8u);
+  CHECK_EQ(history.NewestSeq(), 0u);
+  history.Reset(0);
+  CHECK_EQ(history.Capacity(), 1u);
+}
+
+void LedgerMergesContiguousLosses() {
+  SequenceLedger ledger(2);
+  ledger.Note(LossKind::Drop, 1, 1, 1);
+  ledger.Note(LossKind::Drop, 2, 2, 1);       // Contiguous, same kind: one event
+  ledger.Note(LossKind::Conflation, 3, 3, 1);
+  std::vector<SequenceLedger::Event> detail;
+  LossCounts counts = ledger.Summarize(0, 100, &detail);
+  CHECK_EQ(detail.size(), 2u);
+  CHECK_EQ(detail[0].firstSeq, 1u);
+  CHECK_EQ(detail[0].lastSeq, 2u);
+  CHECK_EQ(counts.dropped, 2u);
+  CHECK_EQ(counts.conflated, 1u);
+
+  // Capacity 2: the oldest event falls off, the totals keep it
+  ledger.Note(LossKind::Overflow, 10, 12, 3);
+  counts = ledger.Summarize(0, 100);
+  CHECK_EQ(counts.dropped, 0u);
+  CHECK_EQ(counts.overflowed, 3u);
+  LossCounts totals = ledger.Totals();
+  CHECK_EQ(totals.dropped, 2u);
+  CHECK_EQ(totals.conflated, 1u);
+  CHECK_EQ(totals.overflowed, 3u);
+
+  // Events overlapping the range are counted whole
+  counts = ledger.Summarize(11, 11);
+  CHECK_EQ(counts.overflowed, 3u);
+  CHECK_EQ(counts.conflated, 0u);
+  ledger.Note(LossKind::Drop, 20, 20, 0);
+  CHECK_EQ(ledger.Totals().dropped, 2u);
+}
+
+// Conflation notes older seqs in any order; a loss before the newest event is not folded into it
+void LedgerKeepsOutOfOrderLosses() {
+  SequenceLedger ledger;
+  ledger.Note(LossKind::Conflation, 10, 10, 1);
+  ledger.Note(LossKind::Conflation, 5, 5, 1);
+  ledger.Note(LossKind::Conflation, 6, 6, 1);   // Continues the event at 5
+  ledger.Note(LossKind::Conflation, 6, 6, 1);   // Inside it
+  std::vector<SequenceLedger::Event> detail;
+  CHECK_EQ(ledger.Summarize(5, 5, &detail).conflated, 3u);
+  CHECK_EQ(detail.size(), 1u);
+  if (detail.size() == 1) CHECK_EQ(detail[0].lastSeq, 6u);
+  CHECK_EQ(ledger.Summarize(10, 10).conflated, 1u);
+  CHECK_EQ(ledger.Summarize(7, 9).conflated, 0u);
+  CHECK_EQ(ledger.Totals().conflated, 4u);
+}
+
+void FileTimeRoundTrip() {
+  double ms = 1700000000123.0;
+  CHECK_NEAR(FileTimeTicksToJsMs(JsMsToFileTimeTicks(ms)), ms, 0.001);
+  CHECK_EQ(FileTimeTicksToJsMs(0), 0.0);
+}
+
+}  // namespace
+
+int main() {
+  HistoryKeepsNewest();
+  HistoryReset();
+  LedgerMergesContiguousLosses();
+  LedgerKeepsOutOfOrderLosses();
+  FileTimeRoundTrip();
+  return check::Finish("change_history");
+}
@@ -0,0 +1,168 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "change_log.h"
+#include "check.h"
+
+namespace {
+
+std::vector<ChangeRecord> Records(size_t n) {
+  std::vector<ChangeRecord> records(n);
+  for (size_t i = 0; i < n; ++i) {
+    ChangeRecord& rec = records[i];
+    rec.seq = 100 + i;
+    rec.handle = static_cast<uint32_t>(i % 5);
+    rec.timestamp = JsMsToFileTimeTicks(1.7e12 + 1000.0 * i);
+    rec.quality = i % 7 == 0 ? 0x00 : 0xC0;
+    rec.error = i % 11 == 0 ? -1 : 0;
+    if (i % 4 == 3) {
+      rec.value.kind = ChangeValue::Kind::String;
+      rec.value.text = "text " + std::to_string(i);
+    } else {
+      rec.value.kind = ChangeValue::Kind::Number;
+      rec.value.number = 0.5 * static_cast<double>(i);
+    }
+  }
+  return records;
+}
+
+std::vector<uint32_t> NameIds(const std::vector<ChangeRecord>& records) {
+  std::vector<uint32_t> ids;
+  for (const ChangeRecord& rec : records) ids.push_back(rec.handle + 10);
+  return ids;
+}
+
+std::vector<uint8_t> RawBlock(const std::vector<ChangeRecord>& records) {
+  std::vector<uint8_t> block(changelog::RawBlockSize(records));
+  changelog::EncodeRawBlock(block.data(), records, NameIds(records), 42);
+  return block;
+}
+
+std::vector<uint8_t> GorillaBlock(const std::vector<ChangeRecord>& records) {
+  std::vector<uint8_t> block;
+  changelog::EncodeGorillaBlock(block, records, NameIds(records), 42);
+  return block;
+}
+
+void CheckSame(const std::vector<ChangeRecord>& in, const changelog::DecodedBlock& out) {
+  CHECK_EQ(out.receivedTicks, 42u);
+  CHECK_EQ(out.records.size(), in.size());
+  for (size_t i = 0; i < in.size() && i < out.records.size(); ++i) {
+    const ChangeRecord& a = in[i];
+    const ChangeRecord& b = out.records[i];
+    CHECK_EQ(a.seq, b.seq);
+    CHECK_EQ(a.timestamp, b.timestamp);
+    CHECK_EQ(a.handle + 10, b.handle);
+    CHECK_EQ(a.quality, b.quality);
+    CHECK_EQ(a.error, b.error);
+    CHECK(a.value.kind == b.value.kind);
+    CHECK_EQ(a.value.text, b.value.text);
+    if (a.value.kind == ChangeValue::Kind::Number) CHECK_EQ(a.value.number, b.value.number);
+  }
+}
+
+void RoundTrip() {
+  std::vector<ChangeRecord> records = Records(300);
+  for (bool compressed : {false, true}) {
+    std::vector<uint8_t> block = compressed ? GorillaBlock(records) : RawBlock(records);
+    CHECK_EQ(block.size() % 8, 0u);
+    changelog::DecodedBlock out;
+    CHECK(changelog::DecodeBlock(block.data(), block.size(), out));
+    CheckSame(records, out);
+  }
+  changelog::DecodedBlock empty;
+  std::vector<uint8_t> block = RawBlock({});
+  CHECK(changelog::DecodeBlock(block.data(), block.size(), empty));
+  CHECK(empty.records.empty());
+}
+
+void SetCount(std::vector<uint8_t>& block, uint32_t count) { std::memcpy(block.data() + 4, &count, 4); }
+
+// A corrupt count must be rejected before any column offset or allocation is derived from it
+void CorruptCountRejected() {
+  std::vector<ChangeRecord> records = Records(16);
+  for (bool compressed : {false, true}) {
+    std::vector<uint8_t> block = compressed ? GorillaBlock(records) : RawBlock(records);
+    changelog::BlockHeader hdr;
+    CHECK(changelog::ReadBlockHeader(block.data(), block.size(), hdr));
+    SetCount(block, 0xFFFFFFF0u);
+    CHECK(!changelog::ReadBlockHeader(block.data(), block.size(), hdr));
+    changelog::DecodedBlock out;
+    CHECK(!changelog::DecodeBlock(block.data(), block.size(), out));
+    double values[16];
+    changelog::ColumnSink sink;
+    sink.values = values;
+    CHECK(!changelog::DecodeBlockColumns(block.data(), block.size(), sink, 0));
+  }
+}
+
+void TruncatedAndDamagedRejected() {
+  std::vector<ChangeRecord> records = Records(40);
+  for (bool compressed : {false, true}) {
+    std::vector<uint8_t> block = compressed ? GorillaBlock(records) : RawBlock(records);
+    changelog::DecodedBlock out;
+    CHECK(!changelog::DecodeBlock(block.data(), block.size() - 8, out));   // byteLength > avail
+    CHECK(!changelog::DecodeBlock(block.data(), 16, out));
+    std::vector<uint8_t> shortLength = block;
+    uint32_t len = 8;                                                       // Smaller than the header
+    std::memcpy(shortLength.data() + 8, &len, 4);
+    CHECK(!changelog::DecodeBlock(shortLength.data(), shortLength.size(), out));
+    std::vector<uint8_t> badFlags = block;
+    badFlags[12] = 7;
+    CHECK(!changelog::DecodeBlock(badFlags.data(), badFlags.size(), out));
+  }
+  // Compressed: a section length running past the block
+  std::vector<uint8_t> block = GorillaBlock(records);
+  uint32_t huge = 0xFFFFFF00u;
+  std::memcpy(block.data() + sizeof(changelog::BlockHeader), &huge, 4);
+  changelog::DecodedBlock out;
+  CHECK(!changelog::DecodeBlock(block.data(), block.size(), out));
+}
+
+void SegmentFile() {
+  std::string path = "change_log_test.opcseg";
+  std::vector<ChangeRecord> a = Records(10), b = Records(20);
+  std::vector<uint8_t> blocks = RawBlock(a);
+  std::vector<uint8_t> second = GorillaBlock(b);
+  blocks.insert(blocks.end(), second.begin(), second.end());
+  changelog::SegmentHeader hdr = {};
+  std::memcpy(hdr.magic, changelog::kSegmentMagic, sizeof(hdr.magic));
+  hdr.version = changelog::kFormatVersion;
+  hdr.headerBytes = sizeof(hdr);
+  hdr.dataEnd = sizeof(hdr) + blocks.size();
+  hdr.blockCount = 2;
+  hdr.recordCount = 30;
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    out.write(reinterpret_cast<const char*>(blocks.data()), static_cast<std::streamsize>(blocks.size()));
+    out.write("garbage beyond dataEnd", 22);
+  }
+  std::vector<changelog::DecodedBlock> decoded;
+  CHECK(changelog::ReadSegment(path, decoded));
+  CHECK_EQ(decoded.size(), 2u);
+  if (decoded.size() == 2) {
+    CheckSame(a, decoded[0]);
+    CheckSame(b, decoded[1]);
+  }
+
+  hdr.headerBytes = 0xFFFFFFu;
+  {
+    std::fstream out(path, std::ios::binary | std::ios::in | std::ios::out);
+    out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+  }
+  decoded.clear();
+  CHECK(!changelog::ReadSegment(path, decoded));
+  std::remove(path.c_str());
+}
+
+}  // namespace
+
+int main() {
+  RoundTrip();
+  CorruptCountRejected();
+  TruncatedAndDamagedRejected();
+  SegmentFile();
+  return check::Finish("change_log");
+}
@@ -0,0 +1,110 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "change_replay.h"
+#include "check.h"
+
+namespace {
+
+// Segment with one batch per entry of arrivalsMs; every batch holds two records of group "g"
+void WriteLog(const std::string& dir, const std::vector<double>& arrivalsMs) {
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  {
+    std::ofstream dict(dir + "/" + changelog::kDictionaryFile);
+    dict << "0\tg\tA\n1\tg\tB\n";
+  }
+  std::vector<uint8_t> blocks;
+  uint64_t seq = 1;
+  for (double ms : arrivalsMs) {
+    std::vector<ChangeRecord> records(2);
+    for (uint32_t i = 0; i < 2; ++i) {
+      records[i].seq = seq++;
+      records[i].handle = i;
+      records[i].value.kind = ChangeValue::Kind::Number;
+      records[i].value.number = static_cast<double>(records[i].seq);
+    }
+    changelog::EncodeGorillaBlock(blocks, records, {0, 7}, JsMsToFileTimeTicks(ms));  // 7 is not in names.dict
+  }
+  changelog::SegmentHeader hdr = {};
+  std::memcpy(hdr.magic, changelog::kSegmentMagic, sizeof(hdr.magic));
+  hdr.version = changelog::kFormatVersion;
+  hdr.headerBytes = sizeof(hdr);
+  hdr.dataEnd = sizeof(hdr) + blocks.size();
+  std::ofstream out(dir + "/0001" + changelog::kSegmentExt, std::ios::binary);
+  out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+  out.write(reinterpret_cast<const char*>(blocks.data()), static_cast<std::streamsize>(blocks.size()));
+}
+
+void ReplaysEverything() {
+  std::string dir = "replay_test_all";
+  WriteLog(dir, {1000.0, 1001.0, 1002.0});
+  ChangeReplayer replayer(dir, 0.0);
+  CHECK_EQ(replayer.Groups().size(), 1u);
+  ReplayControl control;
+  ReplayStats stats;
+  std::vector<std::string> items;
+  auto sink = [&](const std::string& group, std::vector<IncomingChange>& batch, uint64_t) {
+    CHECK_EQ(group, "g");
+    for (const IncomingChange& in : batch) items.push_back(*in.item);
+  };
+  CHECK(replayer.Run(sink, control, stats));
+  CHECK(!stats.stopped);
+  CHECK_EQ(stats.segments, 1u);
+  CHECK_EQ(stats.batches, 3u);
+  CHECK_EQ(stats.records, 3u);
+  CHECK_EQ(stats.unknownNames, 3u);
+  CHECK_EQ(items.size(), 3u);
+  std::filesystem::remove_all(dir);
+}
+
+// A paced replay waiting for a batch an hour away ends as soon as it is stopped
+void StopCutsPacingShort() {
+  std::string dir = "replay_test_stop";
+  WriteLog(dir, {0.0 + 1.7e12, 3600000.0 + 1.7e12});
+  ChangeReplayer replayer(dir, 1.0);
+  ReplayControl control;
+  ReplayStats stats;
+  size_t batches = 0;
+  auto sink = [&](const std::string&, std::vector<IncomingChange>&, uint64_t) { ++batches; };
+  auto t0 = std::chrono::steady_clock::now();
+  std::thread runner([&] {
+    replayer.Run(sink, control, stats);
+    control.Finish();
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  control.Stop();
+  control.WaitFinished();
+  runner.join();
+  double waitedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  CHECK(stats.stopped);
+  CHECK_EQ(batches, 1u);
+  CHECK(waitedMs < 5000.0);
+  std::filesystem::remove_all(dir);
+}
+
+void StoppedBeforeStart() {
+  std::string dir = "replay_test_early";
+  WriteLog(dir, {1000.0});
+  ChangeReplayer replayer(dir, 0.0);
+  ReplayControl control;
+  control.Stop();
+  ReplayStats stats;
+  size_t batches = 0;
+  CHECK(replayer.Run([&](const std::string&, std::vector<IncomingChange>&, uint64_t) { ++batches; }, control, stats));
+  CHECK(stats.stopped);
+  CHECK_EQ(batches, 0u);
+  std::filesystem::remove_all(dir);
+}
+
+}  // namespace
+
+int main() {
+  ReplaysEverything();
+  StopCutsPacingShort();
+  StoppedBeforeStart();
+  return check::Finish("change_replay");
+}
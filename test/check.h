@@ -0,0 +1,42 @@
+#pragma once
+// Minimal assertions for the native tests of the portable headers in src/ (no OPC/N-API, no framework).
+// Each *_test.cpp calls its test functions from main and returns Finish(); test/run.js builds and runs them.
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace check {
+
+inline int& Failures() {
+  static int failures = 0;
+  return failures;
+}
+
+inline void Fail(const char* file, int line, const std::string& what) {
+  std::fprintf(stderr, "%s:%d: %s\n", file, line, what.c_str());
+  ++Failures();
+}
+
+inline int Finish(const char* suite) {
+  if (Failures()) std::fprintf(stderr, "%s: %d check(s) failed\n", suite, Failures());
+  else std::printf("%s: ok\n", suite);
+  return Failures() ? 1 : 0;
+}
+
+}  // namespace check
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) check::Fail(__FILE__, __LINE__, "CHECK(" #cond ")"); \
+  } while (0)
+
+#define CHECK_EQ(a, b) \
+  do { \
+    if (!((a) == (b))) check::Fail(__FILE__, __LINE__, "CHECK_EQ(" #a ", " #b ")"); \
+  } while (0)
+
+#define CHECK_NEAR(a, b, eps) \
+  do { \
+    if (!(std::fabs(static_cast<double>(a) - static_cast<double>(b)) <= (eps))) \
+      check::Fail(__FILE__, __LINE__, "CHECK_NEAR(" #a ", " #b ")"); \
+  } while (0)
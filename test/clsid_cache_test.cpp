@@ -0,0 +1,78 @@
+#include <fstream>
+#include <string>
+#include "check.h"
+#include "clsid_cache.h"
+
+namespace {
+
+const char* kClsid = "{B3AF0BF6-4C0C-4804-A122-6F3B160F4397}";
+const char* kOther = "{13486D44-4821-11D2-A494-3CB306C10000}";
+
+void WriteFile(const std::string& path, const std::string& data) {
+  std::ofstream out(path, std::ios::trunc);
+  out << data;
+}
+
+// Local host spellings share one key; remote hosts are case-insensitive
+void NormalizesHosts() {
+  ClsidCache cache;
+  cache.Put("LocalHost", "Matrikon.OPC.Simulation", kClsid);
+  CHECK(cache.Find("", "Matrikon.OPC.Simulation") != nullptr);
+  CHECK(cache.Find("127.0.0.1", "Matrikon.OPC.Simulation") != nullptr);
+  cache.Put("PLANT-01", "Kepware.KEPServerEX.V6", kOther);
+  const std::string* found = cache.Find("plant-01", "Kepware.KEPServerEX.V6");
+  CHECK(found && *found == kOther);
+  CHECK(cache.Find("plant-01", "kepware.kepserverex.v6") == nullptr);  // progIDs are compared as given
+  cache.Put("plant-01", "Other.Server", kClsid);
+  cache.EraseHost("Plant-01");
+  CHECK_EQ(cache.Size(), 1u);
+}
+
+void SaveLoadRoundTrip() {
+  ClsidCache saved;
+  saved.Put("", "Matrikon.OPC.Simulation", kClsid);
+  saved.Put("plant-01", "Kepware.KEPServerEX.V6", kOther);
+  CHECK(saved.Save("clsids.txt"));
+  std::ifstream tmp("clsids.txt.tmp");
+  CHECK(!tmp);
+
+  ClsidCache loaded;
+  loaded.Put("plant-02", "A.B", kClsid);
+  CHECK(loaded.Load("clsids.txt"));
+  CHECK_EQ(loaded.Size(), 3u);
+  const std::string* found = loaded.Find("plant-01", "Kepware.KEPServerEX.V6");
+  CHECK(found && *found == kOther);
+  CHECK(loaded.Find("localhost", "Matrikon.OPC.Simulation") != nullptr);  // Local entries are saved with an empty host
+  CHECK(!loaded.Load("missing.txt"));
+}
+
+// A malformed file is rejected and nothing from it is merged
+void CorruptLoadFails() {
+  ClsidCache cache;
+  std::string good = std::string("plant-01\tA.B\t") + kClsid + "\r\n\n";
+  WriteFile("good.txt", good);
+  CHECK(cache.Load("good.txt"));  // CRLF and blank lines are fine
+  CHECK_EQ(cache.Size(), 1u);
+
+  const std::string bad[] = {
+    good + "plant-01\tC.D\n",                          // No CLSID column
+    good + "plant-01\tC.D\tnot-a-guid\n",              // Not a CLSID
+    good + "plant-01\t\t" + kOther + "\n",             // Empty progID
+    good + "plant-01\tC.D\t" + kOther + "\textra\n",   // Extra column
+  };
+  for (const std::string& data : bad) {
+    ClsidCache fresh;
+    WriteFile("bad.txt", data);
+    CHECK(!fresh.Load("bad.txt"));
+    CHECK_EQ(fresh.Size(), 0u);
+  }
+}
+
+}  // namespace
+
+int main() {
+  NormalizesHosts();
+  SaveLoadRoundTrip();
+  CorruptLoadFails();
+  return check::Finish("clsid_cache");
+}
@@ -0,0 +1,132 @@
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+#include "check.h"
+#include "gorilla.h"
+
+namespace {
+
+bool SameBits(double a, double b) { return std::memcmp(&a, &b, sizeof(double)) == 0; }
+
+void DeltaRoundTrip() {
+  // Regular scan, jitter, steps in every dod bucket and the 64-bit extremes
+  std::vector<int64_t> in = {0, 1000, 2000, 3000, 3001, 4100, 4200, 9000, -5, 1LL << 40,
+                             std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), 7};
+  std::mt19937_64 rng(1);
+  int64_t t = 1700000000000LL;
+  for (int i = 0; i < 1000; ++i) in.push_back(t += 1000 + static_cast<int64_t>(rng() % 3));
+  std::vector<uint8_t> buf;
+  {
+    gorilla::DeltaEncoder enc(buf);
+    for (int64_t v : in) enc.Add(v);
+  }
+  gorilla::DeltaDecoder dec(buf.data(), buf.size());
+  for (int64_t v : in) CHECK_EQ(dec.Next(), v);
+  CHECK(!dec.Overrun());
+  dec.Next();
+  dec.Next();
+  CHECK(dec.Overrun());  // Reading past the end is reported, not undefined
+}
+
+void FloatRoundTrip() {
+  std::vector<double> in = {0.0, -0.0, 1.5, 1.5, 1.5, 2.25, -1e300, 1e-300,
+                            std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+                            std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::denorm_min(), 42.0};
+  std::mt19937_64 rng(2);
+  double v = 50.0;
+  for (int i = 0; i < 1000; ++i) in.push_back(v += (static_cast<double>(rng() % 200) - 100.0) / 1000.0);
+  std::vector<uint8_t> buf;
+  {
+    gorilla::FloatEncoder enc(buf);
+    for (double x : in) enc.Add(x);
+  }
+  gorilla::FloatDecoder dec(buf.data(), buf.size());
+  for (double x : in) CHECK(SameBits(dec.Next(), x));
+  CHECK(!dec.Overrun());
+}
+
+// Flat stretches and repeated values are where XOR encoding pays off
+void FloatCompresses() {
+  std::vector<uint8_t> buf;
+  {
+    gorilla::FloatEncoder enc(buf);
+    for (int i = 0; i < 1000; ++i) enc.Add(i % 100 < 90 ? 21.5 : 21.75);
+  }
+  CHECK(buf.size() * 8 < 1000 * sizeof(double));
+}
+
+void TruncatedInputOverruns() {
+  std::vector<uint8_t> buf;
+  {
+    gorilla::FloatEncoder enc(buf);
+    for (int i = 0; i < 100; ++i) enc.Add(i * 1.1);
+  }
+  gorilla::FloatDecoder dec(buf.data(), buf.size() / 2);
+  for (int i = 0; i < 100; ++i) dec.Next();
+  CHECK(dec.Overrun());
+}
+
+void VarintAndRle() {
+  std::vector<uint8_t> buf;
+  std::vector<uint64_t> in = {0, 1, 127, 128, 300, 1ull << 35, std::numeric_limits<uint64_t>::max()};
+  for (uint64_t x : in) gorilla::PutVarint(buf, x);
+  const uint8_t* p = buf.data();
+  for (uint64_t x : in) {
+    uint64_t out = 0;
+    CHECK(gorilla::GetVarint(p, buf.data() + buf.size(), out));
+    CHECK_EQ(out, x);
+  }
+  uint64_t extra;
+  CHECK(!gorilla::GetVarint(p, buf.data() + buf.size(), extra));
+
+  std::vector<uint16_t> q = {0xC0, 0xC0, 0xC0, 0x00, 0xC0, 0x18, 0x18};
+  std::vector<uint8_t> rle;
+  gorilla::PutRle(rle, q.data(), q.size());
+  std::vector<uint16_t> back(q.size());
+  CHECK(gorilla::GetRle(rle.data(), rle.data() + rle.size(), back.data(), back.size()));
+  CHECK(back == q);
+  // Runs must add up to exactly n
+  std::vector<uint16_t> more(q.size() + 1);
+  CHECK(!gorilla::GetRle(rle.data(), rle.data() + rle.size(), more.data(), more.size()));
+  CHECK(!gorilla::GetRle(rle.data(), rle.data() + rle.size() - 1, back.data(), back.size()));
+}
+
+void SeriesBlockRoundTrip() {
+  const size_t n = 256;
+  std::vector<double> ts(n), values(n);
+  std::vector<uint16_t> qualities(n);
+  for (size_t i = 0; i < n; ++i) {
+    ts[i] = 1.7e12 + 1000.0 * i + (i % 10 == 0 ? 0.5 : 0.0);  // 100 ns resolution is kept
+    values[i] = i % 3 ? 20.0 + 0.1 * i : 20.0;
+    qualities[i] = i % 50 ? 0xC0 : 0x00;
+  }
+  ts[100] = 1.6e12;  // Clock step: the range follows the minimum, not the first sample
+  gorilla::SeriesBlock block;
+  gorilla::EncodeSeriesBlock(ts.data(), values.data(), qualities.data(), n, block);
+  CHECK_EQ(block.count, n);
+  CHECK_EQ(block.minTsMs, 1.6e12);
+  CHECK_EQ(block.maxTsMs, ts[n - 1]);
+  std::vector<double> ts2(n), values2(n);
+  std::vector<uint16_t> qualities2(n);
+  CHECK(gorilla::DecodeSeriesBlock(block, ts2.data(), values2.data(), qualities2.data()));
+  for (size_t i = 0; i < n; ++i) {
+    CHECK_NEAR(ts2[i], ts[i], 1e-4);
+    CHECK(SameBits(values2[i], values[i]));
+    CHECK_EQ(qualities2[i], qualities[i]);
+  }
+  block.values.resize(block.values.size() / 2);
+  CHECK(!gorilla::DecodeSeriesBlock(block, ts2.data(), values2.data(), qualities2.data()));
+}
+
+}  // namespace
+
+int main() {
+  DeltaRoundTrip();
+  FloatRoundTrip();
+  FloatCompresses();
+  TruncatedInputOverruns();
+  VarintAndRle();
+  SeriesBlockRoundTrip();
+  return check::Finish("gorilla");
+}
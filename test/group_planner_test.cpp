@@ -0,0 +1,91 @@
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "check.h"
+#include "group_planner.h"
+
+namespace {
+
+std::vector<std::pair<std::string, uint32_t>> Tags(size_t n, uint32_t rate, const std::string& prefix = "T") {
+  std::vector<std::pair<std::string, uint32_t>> tags;
+  for (size_t i = 0; i < n; ++i) tags.emplace_back(prefix + std::to_string(1000 + i), rate);
+  return tags;
+}
+
+void BucketsRates() {
+  std::vector<uint32_t> buckets = {100, 500, 1000};
+  CHECK_EQ(BucketRate(50, buckets), 100u);     // Faster than every bucket: fastest
+  CHECK_EQ(BucketRate(100, buckets), 100u);
+  CHECK_EQ(BucketRate(700, buckets), 500u);    // Never slower than asked for
+  CHECK_EQ(BucketRate(60000, buckets), 1000u);
+  CHECK_EQ(BucketRate(700, {}), 700u);
+}
+
+void EvenGroupsPerRate() {
+  PlannerOptions opts;
+  opts.maxItemsPerGroup = 100;
+  opts.prefix = "p";
+  auto tags = Tags(250, 1000);
+  auto fast = Tags(10, 90, "F");
+  tags.insert(tags.end(), fast.begin(), fast.end());
+  tags.push_back(tags.front());  // Duplicates are planned once
+  uint32_t next = 0;
+  std::vector<PlannedGroup> plan = PlanGroups(tags, opts, next);
+  CHECK_EQ(plan.size(), 4u);
+  CHECK_EQ(next, 4u);
+  std::set<std::string> names, items;
+  size_t total = 0;
+  for (const PlannedGroup& g : plan) {
+    names.insert(g.name);
+    items.insert(g.items.begin(), g.items.end());
+    total += g.items.size();
+    CHECK(g.items.size() <= 100);
+  }
+  CHECK_EQ(names.size(), 4u);
+  CHECK_EQ(total, 260u);
+  CHECK_EQ(items.size(), 260u);
+  CHECK_EQ(plan[0].rateMs, 100u);
+  CHECK_EQ(plan[0].name, "p_100ms_0");
+  CHECK_EQ(plan[0].items.size(), 10u);
+  CHECK_EQ(plan[1].items.size(), 84u);  // 250 over three groups: 84, 83, 83
+  CHECK_EQ(plan[3].items.size(), 83u);
+}
+
+void SplitsOnCallbackSize() {
+  PlannerOptions opts;
+  opts.maxItemsPerGroup = 1000;
+  opts.maxCallbackItems = 100;
+  PlannedGroup group;
+  group.name = "g";
+  group.rateMs = 500;
+  for (int i = 0; i < 300; ++i) group.items.push_back("I" + std::to_string(i));
+  uint32_t next = 7;
+
+  CallbackSizeStats calm;
+  calm.callbacks = 10;
+  calm.items = 500;  // Average 50
+  CHECK(SplitGroup(group, calm, opts, next).empty());
+
+  CallbackSizeStats busy;
+  busy.callbacks = 10;
+  busy.items = 2500;  // Average 250: three parts
+  std::vector<PlannedGroup> moved = SplitGroup(group, busy, opts, next);
+  CHECK_EQ(moved.size(), 2u);
+  CHECK_EQ(next, 9u);
+  if (moved.size() == 2) {
+    CHECK_EQ(moved[0].items.size(), 100u);
+    CHECK_EQ(moved[0].items.front(), "I100");  // The group keeps its head
+    CHECK_EQ(moved[1].items.back(), "I299");
+    CHECK_EQ(moved[1].rateMs, 500u);
+  }
+}
+
+}  // namespace
+
+int main() {
+  BucketsRates();
+  EvenGroupsPerRate();
+  SplitsOnCallbackSize();
+  return check::Finish("group_planner");
+}
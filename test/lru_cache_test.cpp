@@ -0,0 +1,78 @@
+#include <chrono>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "lru_cache.h"
+
+namespace {
+
+using Cache = LruCache<std::string, int>;
+
+// The least recently used entry goes first; a Get makes an entry recent again
+void EvictsLeastRecent() {
+  Cache cache(3);
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+  cache.Put("c", 3);
+  CHECK(cache.Get("a") != nullptr);
+  cache.Put("d", 4);
+  CHECK_EQ(cache.Size(), 3u);
+  CHECK(cache.Get("b") == nullptr);
+  CHECK_EQ(*cache.Get("a"), 1);
+  CHECK_EQ(cache.Evictions(), 1u);
+
+  cache.Put("c", 30);  // Update in place, no eviction
+  CHECK_EQ(*cache.Get("c"), 30);
+  CHECK_EQ(cache.Evictions(), 1u);
+
+  std::vector<std::string> order;
+  cache.ForEach([&order](const std::string& key, int, Cache::Clock::time_point) { order.push_back(key); });
+  CHECK_EQ(order, std::vector<std::string>({"c", "a", "d"}));
+
+  cache.SetCapacity(1);
+  CHECK_EQ(cache.Size(), 1u);
+  CHECK(cache.Get("c") != nullptr);
+  CHECK_EQ(cache.Evictions(), 3u);
+}
+
+// An expired entry reads as absent and is dropped; others keep their own expiry
+void ExpiresEntries() {
+  Cache cache(8);
+  Cache::Clock::time_point now = Cache::Clock::now();
+  cache.Put("short", 1, now + std::chrono::seconds(1));
+  cache.Put("long", 2, now + std::chrono::seconds(60));
+  cache.Put("forever", 3);
+  CHECK(cache.Get("short", now) != nullptr);
+  CHECK(cache.Get("short", now + std::chrono::seconds(1)) == nullptr);  // Expiry is exclusive
+  CHECK_EQ(cache.Size(), 2u);
+  CHECK(cache.Get("long", now + std::chrono::seconds(30)) != nullptr);
+  CHECK(cache.Get("forever", now + std::chrono::hours(24 * 365)) != nullptr);
+
+  cache.Put("long", 20, now + std::chrono::seconds(1));  // Put replaces the expiry
+  CHECK(cache.Get("long", now + std::chrono::seconds(2)) == nullptr);
+}
+
+void CountsAndClear() {
+  Cache cache(0);  // Capacity 0 is taken as 1
+  CHECK_EQ(cache.Capacity(), 1u);
+  CHECK(cache.Get("x") == nullptr);
+  cache.Put("x", 1);
+  CHECK(cache.Get("x") != nullptr);
+  CHECK_EQ(cache.Hits(), 1u);
+  CHECK_EQ(cache.Misses(), 1u);
+  CHECK(cache.Erase("x"));
+  CHECK(!cache.Erase("x"));
+  cache.Put("y", 2);
+  cache.Clear();
+  CHECK_EQ(cache.Size(), 0u);
+  CHECK(cache.Get("y") == nullptr);
+}
+
+}  // namespace
+
+int main() {
+  EvictsLeastRecent();
+  ExpiresEntries();
+  CountsAndClear();
+  return check::Finish("lru_cache");
+}
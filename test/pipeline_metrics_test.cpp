@@ -0,0 +1,82 @@
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "pipeline_metrics.h"
+
+namespace {
+
+void BucketsCoverValues() {
+  bool monotonic = true;
+  bool covered = true;
+  for (int i = 1; i < LatencyHistogram::kBuckets; ++i) {
+    monotonic = monotonic && LatencyHistogram::UpperBound(i) > LatencyHistogram::UpperBound(i - 1);
+  }
+  for (uint64_t v : {0ull, 1ull, 31ull, 32ull, 33ull, 1000ull, 123456789ull, (1ull << 39) + 5}) {
+    int idx = LatencyHistogram::Index(v);
+    covered = covered && v <= LatencyHistogram::UpperBound(idx) && (idx == 0 || v > LatencyHistogram::UpperBound(idx - 1));
+  }
+  CHECK(monotonic);
+  CHECK(covered);
+  CHECK_EQ(LatencyHistogram::Index(~0ull), LatencyHistogram::kBuckets - 1);
+}
+
+void QuantilesWithinBucketError() {
+  auto h = std::make_unique<LatencyHistogram>();
+  for (uint64_t v = 1; v <= 10000; ++v) h->Record(v * 1000);
+  LatencyHistogram::Snapshot s = h->Take();
+  CHECK_EQ(s.count, 10000u);
+  CHECK_EQ(s.max, 10000000u);
+  CHECK_NEAR(s.Mean(), 5000500.0, 1e-6);
+  CHECK_NEAR(static_cast<double>(s.Quantile(0.5)), 5000000.0, 5000000.0 * 0.04);
+  CHECK_NEAR(static_cast<double>(s.Quantile(0.99)), 9900000.0, 9900000.0 * 0.04);
+  CHECK_EQ(s.Quantile(1.0), 10000000u);  // Capped by the real maximum
+  h->Reset();
+  CHECK_EQ(h->Take().count, 0u);
+  CHECK_EQ(h->Take().Quantile(0.5), 0u);
+}
+
+// Records from many threads land in different shards; the snapshot adds them all up
+void MergesAcrossThreads() {
+  auto m = std::make_unique<PipelineMetrics>();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&m, t] {
+      for (int i = 0; i < 10000; ++i) {
+        m->Observe(Stage::Callback, static_cast<uint64_t>(t * 100 + 1));
+        m->Add(Counter::Items, 2);
+      }
+    });
+  }
+  for (std::thread& t : threads) t.join();
+  LatencyHistogram::Snapshot s = m->Take(Stage::Callback);
+  CHECK_EQ(s.count, 80000u);
+  CHECK_EQ(s.max, 701u);
+  CHECK_EQ(s.sum, 10000u * (1 + 101 + 201 + 301 + 401 + 501 + 601 + 701));
+  CHECK_EQ(m->Total(Counter::Items), 160000u);
+  CHECK_EQ(m->Take(Stage::Handler).count, 0u);
+}
+
+void PrometheusText() {
+  auto m = std::make_unique<PipelineMetrics>();
+  m->Add(Counter::HandlerErrors, 3);
+  m->Observe(Stage::TsfnDispatch, 2000000000);
+  std::string text = m->Prometheus("x");
+  CHECK(text.find("# TYPE x_handler_errors_total counter\nx_handler_errors_total 3\n") != std::string::npos);
+  CHECK(text.find("x_stage_latency_seconds_count{stage=\"tsfnDispatch\"} 1\n") != std::string::npos);
+  CHECK(text.find("x_stage_latency_seconds_sum{stage=\"tsfnDispatch\"} 2\n") != std::string::npos);
+  m->Reset();
+  CHECK_EQ(m->Total(Counter::HandlerErrors), 0u);
+  CHECK_EQ(m->Take(Stage::TsfnDispatch).count, 0u);
+}
+
+}  // namespace
+
+int main() {
+  BucketsCoverValues();
+  QuantilesWithinBucketError();
+  MergesAcrossThreads();
+  PrometheusText();
+  return check::Finish("pipeline_metrics");
+}
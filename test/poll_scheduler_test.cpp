@@ -0,0 +1,130 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "poll_scheduler.h"
+
+namespace {
+
+using Key = PollScheduler::Key;
+using Ms = std::chrono::milliseconds;
+
+template <typename F>
+void WaitFor(F done) {
+  for (int i = 0; i < 1000 && !done(); ++i) std::this_thread::sleep_for(Ms(2));
+}
+
+// Of the tasks due together, the shortest period goes first
+void RateMonotonicOrder() {
+  PollScheduler s;
+  std::mutex mtx;
+  std::vector<std::string> order;
+  CHECK(s.Add(Key("slow", 1000)));
+  CHECK(s.Add(Key("fast", 200)));
+  CHECK(s.Add(Key("mid", 500)));
+  CHECK(!s.Add(Key("fast", 200)));  // Exists
+  CHECK(!s.Add(Key("zero", 0)));
+  s.Start([&](const Key& key) {
+    std::lock_guard<std::mutex> lock(mtx);
+    order.push_back(key.first);
+  });
+  WaitFor([&] {
+    std::lock_guard<std::mutex> lock(mtx);
+    return order.size() >= 3;
+  });
+  s.Stop();
+  CHECK_EQ(order.size(), 3u);  // Next releases are far off
+  if (order.size() == 3) CHECK_EQ(order, std::vector<std::string>({"fast", "mid", "slow"}));
+  CHECK_EQ(s.Stats()[Key("slow", 1000)].runs, 1u);
+}
+
+// A release overrun skips the releases it overlapped instead of running them late in a burst
+void CountsMissedReleases() {
+  PollScheduler s;
+  std::atomic<int> runs{0};
+  s.Start([&](const Key&) {
+    if (runs++ == 0) std::this_thread::sleep_for(Ms(75));  // Past the deadlines of the releases at 20 and 40 ms
+  });
+  CHECK(s.Running());
+  s.Add(Key("g", 20));
+  WaitFor([&] { return runs.load() >= 2; });
+  s.Stop();
+  PollTaskStats st = s.Stats()[Key("g", 20)];
+  CHECK(st.missed >= 2 && st.missed <= 4);  // The one at 60 ms starts late but within its deadline; slack for a slow machine
+  CHECK(st.runs >= 2);
+  CHECK(st.durationNsMax >= 75000000u);
+  CHECK(st.lateNsMax < 20000000u);  // Lateness is measured from the release that ran, never a skipped one
+}
+
+// Add wakes a sleeping scheduler; a task removed while it runs gets no stats and no further release
+void AddWakesRemoveStops() {
+  PollScheduler s;
+  std::atomic<int> runs{0};
+  std::atomic<bool> removing{false};
+  s.Start([&](const Key& key) {
+    ++runs;
+    if (key.first == "once") {
+      removing = true;
+      s.Remove(key);
+    }
+  });
+  std::this_thread::sleep_for(Ms(20));  // Nothing to do: waits without a deadline
+  s.Add(Key("once", 10));
+  WaitFor([&] { return removing.load(); });
+  std::this_thread::sleep_for(Ms(40));
+  s.Stop();
+  CHECK_EQ(runs.load(), 1);
+  CHECK(!s.Has(Key("once", 10)));
+  CHECK(s.Stats().empty());
+  CHECK(!s.Running());
+}
+
+IncomingChange Change(double number, uint16_t quality = 192) {
+  IncomingChange in;
+  in.quality = quality;
+  in.value.kind = ChangeValue::Kind::Number;
+  in.value.number = number;
+  return in;
+}
+
+// Value, quality or error make a change; the source timestamp alone does not, and neither does NaN read twice
+void FiltersChanges() {
+  PollFilter f;
+  CHECK(f.Changed("A", Change(1.0)));
+  IncomingChange later = Change(1.0);
+  later.timestamp = 42;
+  CHECK(!f.Changed("A", later));
+  CHECK(f.Changed("A", Change(1.0, 0)));
+  CHECK(f.Changed("A", Change(2.0, 0)));
+
+  double nan = std::numeric_limits<double>::quiet_NaN();
+  CHECK(f.Changed("B", Change(nan)));
+  CHECK(!f.Changed("B", Change(nan)));
+  CHECK(!f.Changed("B", Change(-nan)));
+  CHECK(f.Changed("B", Change(0.0)));
+  CHECK(f.Changed("B", Change(nan)));
+
+  IncomingChange text;
+  text.value.kind = ChangeValue::Kind::String;
+  text.value.text = "on";
+  CHECK(f.Changed("C", text));
+  CHECK(!f.Changed("C", text));
+  CHECK_EQ(f.Size(), 3u);
+  f.Forget("C");
+  CHECK(f.Changed("C", text));
+}
+
+}  // namespace
+
+int main() {
+  RateMonotonicOrder();
+  CountsMissedReleases();
+  AddWakesRemoveStops();
+  FiltersChanges();
+  return check::Finish("poll_scheduler");
+}
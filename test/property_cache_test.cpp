@@ -0,0 +1,119 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+#include "check.h"
+#include "property_cache.h"
+
+namespace {
+
+ChangeValue Num(double v) {
+  ChangeValue c;
+  c.kind = ChangeValue::Kind::Number;
+  c.number = v;
+  return c;
+}
+
+ChangeValue Text(const std::string& s) {
+  ChangeValue c;
+  c.kind = ChangeValue::Kind::String;
+  c.text = s;
+  return c;
+}
+
+PropertyCache Sample() {
+  PropertyCache cache;
+  cache.SetInfo(100, 8, "EU units");
+  cache.SetInfo(102, 5, "High EU");
+  cache.Set("Tag1", {{100, Text("degC")}, {102, Num(150.0)}}, {0, 0});
+  cache.Set("Tag2", {{100, Text("degC")}, {102, ChangeValue()}}, {0, static_cast<int32_t>(0xC0040203)});
+  return cache;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& path, const std::string& data) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(data.data(), data.size());
+}
+
+// Units shared by many tags are stored once
+void InternsStrings() {
+  PropertyCache cache = Sample();
+  CHECK_EQ(cache.Items(), 2u);
+  CHECK_EQ(cache.Properties(), 4u);
+  CHECK_EQ(cache.PoolStrings(), 3u);  // "EU units", "High EU", "degC"
+  const std::vector<PropertyCache::Property>* props = cache.Find("Tag2");
+  CHECK(props != nullptr);
+  if (props) {
+    CHECK_EQ(cache.Value((*props)[0]).text, "degC");
+    CHECK_EQ((*props)[1].error, static_cast<int32_t>(0xC0040203));
+  }
+  CHECK_EQ(cache.Text(cache.FindInfo(102)->description), "High EU");
+}
+
+void SaveLoadRoundTrip() {
+  PropertyCache saved = Sample();
+  CHECK(saved.Save("props.bin"));
+  std::ifstream tmp("props.bin.tmp");
+  CHECK(!tmp);  // Renamed into place
+
+  PropertyCache loaded;
+  loaded.Set("Other", {{101, Text("Pump")}}, {0});
+  CHECK(loaded.Load("props.bin"));
+  CHECK_EQ(loaded.Items(), 3u);
+  const std::vector<PropertyCache::Property>* props = loaded.Find("Tag1");
+  CHECK(props != nullptr);
+  if (props && props->size() == 2) {
+    CHECK_EQ(loaded.Value((*props)[0]).text, "degC");
+    CHECK_EQ(loaded.Value((*props)[1]).number, 150.0);
+  }
+  CHECK_EQ(loaded.Value((*loaded.Find("Other"))[0]).text, "Pump");
+  CHECK_EQ(loaded.FindInfo(100)->vt, 8u);
+  CHECK(!loaded.Load("missing.bin"));
+}
+
+// A malformed file is rejected whole: nothing of it is merged
+void CorruptFilesRejected() {
+  CHECK(Sample().Save("props.bin"));
+  std::string good = ReadFile("props.bin");
+  PropertyCache base;
+  base.Set("Keep", {{100, Num(1.0)}}, {0});
+
+  std::vector<std::pair<const char*, std::string>> bad;
+  bad.emplace_back("truncated", good.substr(0, good.size() - 3));
+  bad.emplace_back("trailing", good + "x");
+  std::string magic = good;
+  magic[0] = 'X';
+  bad.emplace_back("magic", magic);
+  std::string huge = good;
+  huge[8] = huge[9] = huge[10] = '\xFF';  // Pool count far beyond the file size
+  bad.emplace_back("count", huge);
+  std::string kind = good;
+  size_t at = kind.find("Tag1") + 4 + 4 + 4 + 4;  // Name, property count, id, error
+  kind[at] = 9;
+  bad.emplace_back("kind", kind);
+  for (const auto& pair : bad) {
+    WriteFile("corrupt.bin", pair.second);
+    bool loaded = base.Load("corrupt.bin");
+    if (loaded) std::fprintf(stderr, "loaded corrupt file: %s\n", pair.first);
+    CHECK(!loaded);
+  }
+  CHECK_EQ(base.Items(), 1u);
+  CHECK_EQ(base.PoolStrings(), 0u);
+  CHECK(base.FindInfo(100) == nullptr);
+}
+
+}  // namespace
+
+int main() {
+  InternsStrings();
+  SaveLoadRoundTrip();
+  CorruptFilesRejected();
+  return check::Finish("property_cache");
+}
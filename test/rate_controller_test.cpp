@@ -0,0 +1,101 @@
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <thread>
+#include "check.h"
+#include "rate_controller.h"
+
+namespace {
+
+ElasticGroup Elastic(uint32_t minRate, uint32_t maxRate, int priority) {
+  ElasticGroup g;
+  g.minRate = minRate;
+  g.maxRate = maxRate;
+  g.currentRate = minRate;
+  g.priority = priority;
+  return g;
+}
+
+std::map<std::string, GroupLoad> Depth(uint64_t depth) {
+  std::map<std::string, GroupLoad> loads;
+  loads["a"].depth = depth;
+  return loads;
+}
+
+// Overload slows the least important tier first, one factor per step, up to maxRate
+void SlowsLowestPriorityFirst() {
+  RateController rc;
+  RateControlOptions opts;
+  opts.highDepth = 100;
+  opts.lowDepth = 10;
+  rc.Start(opts, [] {});  // Only for the options; ticks are driven by hand below
+  rc.Stop();
+  std::map<std::string, ElasticGroup> groups;
+  groups["trend"] = Elastic(1000, 3000, 0);
+  groups["alarm"] = Elastic(100, 800, 5);
+
+  std::map<std::string, uint32_t> changes = rc.Decide(Depth(500), groups);
+  CHECK_EQ(changes.size(), 1u);
+  CHECK_EQ(changes["trend"], 2000u);
+  double busy, latencyMs;
+  uint64_t depth;
+  CHECK(rc.Level(busy, latencyMs, depth) == LoadLevel::Overloaded);
+  CHECK_EQ(depth, 500u);
+
+  changes = rc.Decide(Depth(500), groups);
+  CHECK_EQ(changes["trend"], 3000u);  // Capped at maxRate
+  changes = rc.Decide(Depth(500), groups);
+  CHECK_EQ(changes.size(), 1u);
+  CHECK_EQ(changes["alarm"], 200u);   // Next tier once the first is exhausted
+}
+
+// Restores only after restoreAfter eased samples in a row, most important tier first
+void RestoresAfterEasedSamples() {
+  RateController rc;
+  RateControlOptions opts;
+  opts.highDepth = 100;
+  opts.lowDepth = 10;
+  opts.restoreAfter = 3;
+  rc.Start(opts, [] {});
+  rc.Stop();
+  std::map<std::string, ElasticGroup> groups;
+  groups["trend"] = Elastic(1000, 8000, 0);
+  groups["alarm"] = Elastic(100, 800, 5);
+  groups["trend"].currentRate = 4000;
+  groups["alarm"].currentRate = 400;
+
+  CHECK(rc.Decide(Depth(0), groups).empty());
+  CHECK(rc.Decide(Depth(50), groups).empty());  // Steady resets the count
+  CHECK(rc.Decide(Depth(0), groups).empty());
+  CHECK(rc.Decide(Depth(0), groups).empty());
+  std::map<std::string, uint32_t> changes = rc.Decide(Depth(0), groups);
+  CHECK_EQ(changes.size(), 1u);
+  CHECK_EQ(changes["alarm"], 200u);
+  CHECK_EQ(groups["alarm"].currentRate, 200u);
+}
+
+void TickThreadStops() {
+  RateController rc;
+  RateControlOptions opts;
+  opts.intervalMs = 5;
+  std::atomic<int> ticks{0};
+  rc.Start(opts, [&] { ++ticks; });
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  CHECK(rc.Running());
+  rc.Stop();
+  int after = ticks.load();
+  CHECK(after > 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  CHECK_EQ(ticks.load(), after);
+  CHECK(!rc.Running());
+}
+
+}  // namespace
+
+int main() {
+  SlowsLowestPriorityFirst();
+  RestoresAfterEasedSamples();
+  TickThreadStops();
+  return check::Finish("rate_controller");
+}
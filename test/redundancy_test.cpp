@@ -0,0 +1,157 @@
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include "check.h"
+#include "redundancy.h"
+
+namespace {
+
+SideHealth Good() {
+  SideHealth h;
+  h.ok = true;
+  return h;
+}
+
+SideHealth Bad() {
+  SideHealth h;
+  h.error = static_cast<int32_t>(0x80004005);
+  return h;
+}
+
+RedundancyOptions Options(uint32_t failAfter, bool failback = false, uint32_t recoverAfter = 5) {
+  RedundancyOptions opts;
+  opts.failAfter = failAfter;
+  opts.failback = failback;
+  opts.recoverAfter = recoverAfter;
+  return opts;
+}
+
+// The active side fails over after failAfter bad samples in a row; a health change and the switch are queued
+void FailsOverAfterBadSamples() {
+  RedundancyMonitor m;
+  m.Start(Options(2), [] {}, [] {});
+  CHECK(!m.Decide(Good(), Good(), 1.0));
+  CHECK(!m.Decide(Bad(), Good(), 2.0));
+  CHECK(!m.Decide(Good(), Good(), 3.0));  // Not in a row
+  CHECK(!m.Decide(Bad(), Good(), 4.0));
+  CHECK(m.Decide(Bad(), Good(), 5.0));
+  CHECK(!m.OnPreferred());
+  CHECK_EQ(m.Switches(), 1u);
+  CHECK(!m.Health(true).ok);
+
+  std::deque<RedundancyEvent> events;
+  m.Drain(events);
+  CHECK_EQ(events.size(), 4u);  // Bad, good, bad again, failover
+  if (events.size() == 4) {
+    CHECK(events[0].type == RedundancyEvent::Type::Health && events[0].preferred && !events[0].health.ok);
+    CHECK(events[3].type == RedundancyEvent::Type::Failover);
+    CHECK(!events[3].preferred);  // Backup is active now
+    CHECK(!events[3].health.ok);  // State of the side given up
+    CHECK_EQ(events[3].timestampMs, 5.0);
+  }
+  m.Drain(events);
+  CHECK(events.empty());
+  m.Stop();
+}
+
+// No switch while the standby is down too; it follows as soon as the standby answers
+void StaysOnUnhealthyPair() {
+  RedundancyMonitor m;
+  m.Start(Options(2), [] {}, [] {});
+  for (int i = 0; i < 5; ++i) CHECK(!m.Decide(Bad(), Bad(), i));
+  CHECK(m.OnPreferred());
+  CHECK(m.Decide(Bad(), Good(), 6.0));
+  CHECK(!m.OnPreferred());
+  m.Stop();
+}
+
+// With failback the preferred server takes over again after recoverAfter good samples; without, it stays standby
+void FailsBack() {
+  RedundancyMonitor m;
+  m.Start(Options(1, true, 3), [] {}, [] {});
+  CHECK(m.Decide(Bad(), Good(), 1.0));
+  // Active is the backup now; the preferred server is the standby argument
+  CHECK(!m.Decide(Good(), Good(), 2.0));
+  CHECK(!m.Decide(Good(), Bad(), 3.0));  // Resets the count
+  CHECK(!m.Decide(Good(), Good(), 4.0));
+  CHECK(!m.Decide(Good(), Good(), 5.0));
+  CHECK(m.Decide(Good(), Good(), 6.0));
+  CHECK(m.OnPreferred());
+  CHECK_EQ(m.Switches(), 2u);
+
+  RedundancyMonitor stay;
+  stay.Start(Options(1, false, 1), [] {}, [] {});
+  CHECK(stay.Decide(Bad(), Good(), 1.0));
+  for (int i = 0; i < 5; ++i) CHECK(!stay.Decide(Good(), Good(), 2.0 + i));
+  CHECK(!stay.OnPreferred());
+  stay.Stop();
+  m.Stop();
+}
+
+// failover() from JS: the switch is counted and reported with the last health of the side given up
+void ForcedSwitch() {
+  RedundancyMonitor m;
+  m.Start(Options(3), [] {}, [] {});
+  CHECK(!m.Decide(Good(), Bad(), 1.0));
+  m.Switched(2.0);
+  CHECK(!m.OnPreferred());
+  m.Switched(3.0);
+  CHECK(m.OnPreferred());
+  std::deque<RedundancyEvent> events;
+  m.Drain(events);
+  CHECK_EQ(events.size(), 3u);  // Backup went bad, two switches
+  if (events.size() == 3) {
+    CHECK(!events[1].preferred && events[1].health.ok);   // Gave up the healthy primary
+    CHECK(events[2].preferred && !events[2].health.ok);   // Gave up the bad backup
+  }
+  m.Stop();
+}
+
+// Past maxEvents the oldest go and are counted; notify fires per queued event
+void BoundsEvents() {
+  RedundancyOptions opts = Options(100);
+  opts.maxEvents = 2;
+  int notified = 0;
+  RedundancyMonitor m;
+  m.Start(opts, [] {}, [&notified] { ++notified; });
+  for (int i = 0; i < 5; ++i) m.Decide(i % 2 ? Good() : Bad(), Good(), i);
+  CHECK_EQ(notified, 5);
+  CHECK_EQ(m.DroppedEvents(), 3u);
+  std::deque<RedundancyEvent> events;
+  m.Drain(events);
+  CHECK_EQ(events.size(), 2u);
+  if (events.size() == 2) CHECK_EQ(events[1].timestampMs, 4.0);
+  m.Stop();
+}
+
+// The tick runs on the monitor thread every checkMs between the thread hooks; Stop joins it
+void TicksUntilStopped() {
+  std::atomic<int> ticks{0}, inits{0}, exits{0};
+  RedundancyOptions opts;
+  opts.checkMs = 5;
+  RedundancyMonitor m;
+  m.Start(opts, [&ticks] { ++ticks; }, [] {}, [&inits] { ++inits; }, [&exits] { ++exits; });
+  CHECK(m.Running());
+  for (int i = 0; i < 500 && ticks.load() < 3; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  m.Stop();
+  CHECK(ticks.load() >= 3);
+  CHECK(!m.Running());
+  int after = ticks.load();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  CHECK_EQ(ticks.load(), after);
+  CHECK_EQ(inits.load(), 1);
+  CHECK_EQ(exits.load(), 1);
+}
+
+}  // namespace
+
+int main() {
+  FailsOverAfterBadSamples();
+  StaysOnUnhealthyPair();
+  FailsBack();
+  ForcedSwitch();
+  BoundsEvents();
+  TicksUntilStopped();
+  return check::Finish("redundancy");
+}
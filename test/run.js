@@ -0,0 +1,42 @@
+// Builds and runs the native tests of the portable headers in src/ (no OPC server or addon build needed).
+//   npm run test:native            all of test/*_test.cpp
+//   npm run test:native -- lru     only suites whose name contains "lru"
+// The compiler is $CXX, else g++; it must understand -std=c++17 (g++, clang++, MinGW).
+const { spawnSync } = require('child_process');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const root = path.join(__dirname, '..');
+const cxx = process.env.CXX || 'g++';
+const filter = process.argv[2] || '';
+const outDir = fs.mkdtempSync(path.join(os.tmpdir(), 'opcda-test-'));
+const suites = fs.readdirSync(__dirname)
+  .filter((f) => f.endsWith('_test.cpp') && f.includes(filter))
+  .sort();
+
+let failed = 0;
+for (const file of suites) {
+  const name = path.basename(file, '.cpp');
+  const exe = path.join(outDir, name + (process.platform === 'win32' ? '.exe' : ''));
+  const build = spawnSync(cxx, [
+    '-std=c++17', '-O1', '-Wall', '-pthread',
+    '-I', path.join(root, 'src'), '-I', __dirname,
+    path.join(__dirname, file), '-o', exe,
+  ], { stdio: 'inherit' });
+  if (build.status !== 0) {
+    console.error(`${name}: build failed`);
+    ++failed;
+    continue;
+  }
+  const run = spawnSync(exe, [], { stdio: 'inherit', cwd: outDir });
+  if (run.status !== 0) ++failed;
+}
+fs.rmSync(outDir, { recursive: true, force: true });
+
+if (suites.length === 0) {
+  console.error('No test suites matched');
+  process.exit(1);
+}
+console.log(`${suites.length - failed}/${suites.length} suites passed`);
+process.exit(failed ? 1 : 0);
@@ -0,0 +1,136 @@
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "spill_queue.h"
+
+namespace {
+
+ChangeRecord Rec(uint64_t seq) {
+  ChangeRecord rec;
+  rec.seq = seq;
+  rec.handle = static_cast<uint32_t>(seq % 13);
+  rec.value.kind = ChangeValue::Kind::Number;
+  rec.value.number = static_cast<double>(seq) * 0.5;
+  return rec;
+}
+
+// Pops until want records arrived or two seconds passed; records on disk show up once read back
+std::vector<ChangeRecord> Drain(SpillQueue& q, size_t want) {
+  std::vector<ChangeRecord> out;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (out.size() < want && std::chrono::steady_clock::now() < deadline) {
+    std::vector<ChangeRecord> more;
+    q.Pop(want - out.size(), more);
+    out.insert(out.end(), more.begin(), more.end());
+    if (more.empty()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return out;
+}
+
+SpillOptions Options(const std::string& dir) {
+  SpillOptions opts;
+  opts.dir = dir;
+  opts.memoryRecords = 100;
+  opts.blockRecords = 50;
+  opts.maxFileBytes = 4096;  // Several files
+  return opts;
+}
+
+void KeepsOrderThroughDisk() {
+  std::string dir = "spill_test_order";
+  SpillQueue q(Options(dir));
+  std::atomic<int> ready{0};
+  q.SetOnReady([&] { ++ready; });
+  CHECK(q.Open());
+  for (uint64_t seq = 1; seq <= 2000; ++seq) q.Push(Rec(seq));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));  // Let the writer put blocks on disk
+  std::vector<ChangeRecord> out = Drain(q, 2000);
+  CHECK_EQ(out.size(), 2000u);
+  bool ordered = true;
+  for (size_t i = 0; i < out.size(); ++i) ordered = ordered && out[i].seq == i + 1 && out[i].value.number == (i + 1) * 0.5;
+  CHECK(ordered);
+  CHECK(ready.load() > 0);
+  CHECK(q.Empty());
+  SpillStats st = q.Stats();
+  CHECK_EQ(st.spilledTotal, 1900u);
+  CHECK_EQ(st.diskRecords, 0u);
+  CHECK_EQ(st.writeErrors, 0u);
+  CHECK_EQ(st.readErrors, 0u);
+
+  // Interleaved pushes and pops after draining
+  for (uint64_t seq = 2001; seq <= 2500; ++seq) {
+    q.Push(Rec(seq));
+    if (seq % 7 == 0) {
+      std::vector<ChangeRecord> some;
+      q.Pop(3, some);
+      for (const ChangeRecord& rec : some) out.push_back(rec);
+    }
+  }
+  std::vector<ChangeRecord> rest = Drain(q, 2500 - out.size());
+  out.insert(out.end(), rest.begin(), rest.end());
+  CHECK_EQ(out.size(), 2500u);
+  ordered = true;
+  for (size_t i = 0; i < out.size(); ++i) ordered = ordered && out[i].seq == i + 1;
+  CHECK(ordered);
+  q.Close();
+  CHECK(std::filesystem::is_empty(dir));
+  std::filesystem::remove_all(dir);
+}
+
+void DiscardCountsEverything() {
+  std::string dir = "spill_test_discard";
+  SpillQueue q(Options(dir));
+  CHECK(q.Open());
+  for (uint64_t seq = 1; seq <= 1000; ++seq) q.Push(Rec(seq));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  std::vector<ChangeRecord> some;
+  q.Pop(10, some);
+  CHECK_EQ(q.Discard(), 1000u - some.size());
+  CHECK(q.Empty());
+  CHECK_EQ(q.Stats().diskRecords, 0u);
+  q.Push(Rec(1001));
+  std::vector<ChangeRecord> after = Drain(q, 1);
+  CHECK_EQ(after.size(), 1u);
+  q.Close();
+  std::filesystem::remove_all(dir);
+}
+
+// The spill directory becomes unusable: blocks stay poppable from memory, bounded, with drops counted
+void FailingWritesAreBounded() {
+  std::string dir = "spill_test_fail";
+  SpillOptions opts = Options(dir);
+  opts.maxQueuedBlocks = 4;
+  SpillQueue q(opts);
+  CHECK(q.Open());
+  std::filesystem::remove_all(dir);
+  { std::ofstream blocker(dir); }  // A file where the directory was
+  for (uint64_t seq = 1; seq <= 1100; ++seq) q.Push(Rec(seq));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  SpillStats st = q.Stats();
+  CHECK(st.writeErrors > 0);
+  CHECK_EQ(st.dropped, 1000u - 4 * 50);
+  CHECK_EQ(st.diskRecords, 4u * 50);
+  std::vector<ChangeRecord> out = Drain(q, 300);
+  CHECK_EQ(out.size(), 300u);
+  if (out.size() == 300) {
+    CHECK_EQ(out[99].seq, 100u);   // In memory before spilling
+    CHECK_EQ(out[100].seq, 901u);  // Oldest block kept
+    CHECK_EQ(out[299].seq, 1100u);
+  }
+  q.Close();
+  std::filesystem::remove(dir);
+}
+
+}  // namespace
+
+int main() {
+  KeepsOrderThroughDisk();
+  DiscardCountsEverything();
+  FailingWritesAreBounded();
+  return check::Finish("spill_queue");
+}
@@ -0,0 +1,95 @@
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <thread>
+#include "check.h"
+#include "stall_watchdog.h"
+
+namespace {
+
+WatchdogOptions FastOptions() {
+  WatchdogOptions opts;
+  opts.thresholdNs[static_cast<int>(StallKind::Handler)] = 20000000ull;  // 20 ms
+  opts.thresholdNs[static_cast<int>(StallKind::Callback)] = 20000000ull;
+  opts.thresholdNs[static_cast<int>(StallKind::Dispatch)] = 20000000ull;
+  opts.intervalNs = 5000000ull;
+  return opts;
+}
+
+void FastOperationsAreQuiet() {
+  StallWatchdog wd;
+  std::atomic<int> notified{0};
+  wd.Start(FastOptions(), [&] { ++notified; });
+  std::string group = "g";
+  for (int i = 0; i < 100; ++i) {
+    StallWatchdog::Op op;
+    wd.Begin(op, StallKind::Handler, group, i);
+    wd.End(op);
+  }
+  wd.Observe(StallKind::Dispatch, group, 1000, 5);
+  std::deque<StallEvent> events;
+  wd.Drain(events);
+  CHECK(events.empty());
+  CHECK_EQ(notified.load(), 0);
+  wd.Stop();
+}
+
+// A long handler is reported while it runs and once more when it ends; only the final one is counted
+void SlowOperationReportedTwice() {
+  StallWatchdog wd;
+  std::atomic<int> notified{0};
+  wd.Start(FastOptions(), [&] { ++notified; });
+  std::string group = "slow";
+  {
+    StallWatchdog::Op op;
+    wd.Begin(op, StallKind::Handler, group, 42);
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    wd.End(op);
+  }
+  std::deque<StallEvent> events;
+  wd.Drain(events);
+  CHECK_EQ(events.size(), 2u);
+  if (events.size() == 2) {
+    CHECK(events[0].inProgress);
+    CHECK(!events[1].inProgress);
+    CHECK_EQ(events[1].group, "slow");
+    CHECK_EQ(events[1].seq, 42u);
+    CHECK(events[1].durationNs >= 80000000ull);
+    CHECK_EQ(events[1].thresholdNs, 20000000ull);
+  }
+  CHECK_EQ(notified.load(), 2);
+  uint64_t dropped = 0;
+  std::map<std::string, StallCounts> counts = wd.Counts(dropped);
+  CHECK_EQ(counts["slow"].count[static_cast<int>(StallKind::Handler)], 1u);
+  CHECK_EQ(dropped, 0u);
+  wd.Stop();
+  CHECK(!wd.Enabled());
+}
+
+void OldEventsDropped() {
+  StallWatchdog wd;
+  WatchdogOptions opts = FastOptions();
+  opts.maxEvents = 3;
+  wd.Start(opts, [] {});
+  std::string group = "g";
+  for (uint64_t seq = 1; seq <= 5; ++seq) wd.Observe(StallKind::Dispatch, group, 30000000ull, seq);
+  std::deque<StallEvent> events;
+  wd.Drain(events);
+  CHECK_EQ(events.size(), 3u);
+  if (!events.empty()) CHECK_EQ(events.front().seq, 3u);
+  uint64_t dropped = 0;
+  std::map<std::string, StallCounts> counts = wd.Counts(dropped);
+  CHECK_EQ(dropped, 2u);
+  CHECK_EQ(counts["g"].count[static_cast<int>(StallKind::Dispatch)], 5u);
+  CHECK_EQ(counts["g"].maxNs[static_cast<int>(StallKind::Dispatch)], 30000000ull);
+}
+
+}  // namespace
+
+int main() {
+  FastOperationsAreQuiet();
+  SlowOperationReportedTwice();
+  OldEventsDropped();
+  return check::Finish("stall_watchdog");
+}
@@ -0,0 +1,148 @@
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <thread>
+#include "check.h"
+#include "status_monitor.h"
+
+namespace {
+
+StatusSample Sample(double localMs, double serverMs, uint32_t state = 1, uint32_t bandwidth = 0xFFFFFFFFu, double rttMs = 2.0) {
+  StatusSample s;
+  s.localMs = localMs;
+  s.serverMs = serverMs;
+  s.state = state;
+  s.bandwidth = bandwidth;
+  s.rttMs = rttMs;
+  return s;
+}
+
+StatusSample Failed(double localMs) {
+  StatusSample s;
+  s.localMs = localMs;
+  s.error = static_cast<int32_t>(0x800706BA);  // RPC server unavailable
+  return s;
+}
+
+StatusOptions Options(size_t history = 120, size_t maxEvents = 100) {
+  StatusOptions opts;
+  opts.intervalMs = 60000;
+  opts.skewThresholdMs = 100.0;
+  opts.history = history;
+  opts.maxEvents = maxEvents;
+  return opts;
+}
+
+// State changes, threshold crossings and a failing run (reported once) become events
+void QueuesEvents() {
+  StatusMonitor m;
+  m.Start(Options(), [] {}, [] {});
+  StatusSample last;
+  m.Record(Sample(1000.0, 1010.0));
+  CHECK(m.Last(last));
+  m.Record(Sample(2000.0, 2010.0, 2));         // Suspended
+  m.Record(Sample(3000.0, 3500.0, 2));         // Skew above the threshold
+  m.Record(Sample(4000.0, 4600.0, 2));         // Still above: no event
+  m.Record(Sample(5000.0, 4950.0, 2));         // Back within (|-50| <= 100)
+  m.Record(Failed(6000.0));
+  m.Record(Failed(7000.0));
+  m.Record(Sample(8000.0, 8000.0, 1));         // Recovered, and running again
+
+  std::deque<StatusEvent> events;
+  m.Drain(events);
+  CHECK_EQ(events.size(), 6u);
+  if (events.size() == 6) {
+    CHECK(events[0].type == StatusEvent::Type::State);
+    CHECK_EQ(events[0].previousState, 1u);
+    CHECK(events[1].type == StatusEvent::Type::Skew && events[1].exceeded);
+    CHECK_EQ(events[1].sample.SkewMs(), 500.0);
+    CHECK(events[2].type == StatusEvent::Type::Skew && !events[2].exceeded);
+    CHECK(events[3].type == StatusEvent::Type::Error);
+    CHECK_EQ(events[3].sample.localMs, 6000.0);
+    CHECK(events[4].type == StatusEvent::Type::Recovered);
+    CHECK(events[5].type == StatusEvent::Type::State);
+    CHECK_EQ(events[5].previousState, 2u);
+  }
+  CHECK(m.Last(last));
+  CHECK_EQ(last.localMs, 8000.0);  // A failed call leaves the last good sample
+
+  StatusStats st = m.Stats();
+  CHECK_EQ(st.samples, 8u);
+  CHECK_EQ(st.errors, 2u);
+  CHECK_EQ(st.stateChanges, 2u);
+  m.Stop();
+}
+
+// Window statistics cover the kept history of successful samples; unknown bandwidth is left out
+void WindowStatistics() {
+  StatusMonitor m;
+  m.Start(Options(3), [] {}, [] {});
+  StatusSample last;
+  CHECK(!m.Last(last));
+  CHECK_EQ(m.Stats().window, 0u);
+  m.Record(Sample(0.0, 1000.0, 1, 90, 50.0));  // Falls out of the window
+  m.Record(Sample(1000.0, 1010.0, 1, 20, 4.0));
+  m.Record(Failed(1500.0));
+  m.Record(Sample(2000.0, 1990.0, 1, 0xFFFFFFFFu, 6.0));
+  m.Record(Sample(3000.0, 3030.0, 1, 40, 2.0));
+  StatusStats st = m.Stats();
+  CHECK_EQ(st.window, 3u);
+  CHECK_EQ(m.History().size(), 3u);
+  CHECK_NEAR(st.skewMinMs, -10.0, 1e-9);
+  CHECK_NEAR(st.skewMaxMs, 30.0, 1e-9);
+  CHECK_NEAR(st.skewMeanMs, 10.0, 1e-9);
+  CHECK_NEAR(st.rttMeanMs, 4.0, 1e-9);
+  CHECK_NEAR(st.rttMaxMs, 6.0, 1e-9);
+  CHECK_NEAR(st.bandwidthMean, 30.0, 1e-9);
+  CHECK_EQ(st.bandwidthMax, 40u);
+  m.Stop();
+}
+
+// Past maxEvents the oldest go and are counted; notify fires per queued event
+void BoundsEvents() {
+  int notified = 0;
+  StatusMonitor m;
+  m.Start(Options(120, 2), [] {}, [&notified] { ++notified; });
+  m.Record(Sample(0.0, 0.0, 1));
+  for (int i = 1; i <= 4; ++i) m.Record(Sample(i * 1000.0, i * 1000.0, 1 + i % 2));
+  CHECK_EQ(notified, 4);
+  CHECK_EQ(m.DroppedEvents(), 2u);
+  std::deque<StatusEvent> events;
+  m.Drain(events);
+  CHECK_EQ(events.size(), 2u);
+  if (events.size() == 2) CHECK_EQ(events[1].sample.localMs, 4000.0);
+  m.Stop();
+}
+
+// The first poll runs right away on the monitor thread, between the thread hooks; Stop joins it
+void PollsUntilStopped() {
+  std::atomic<int> polls{0}, inits{0}, exits{0};
+  StatusOptions opts = Options();
+  opts.intervalMs = 5;
+  StatusMonitor m;
+  m.Start(opts, [&polls] { ++polls; }, [] {}, [&inits] { ++inits; }, [&exits] { ++exits; });
+  CHECK(m.Running());
+  for (int i = 0; i < 500 && polls.load() < 3; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  m.Stop();
+  CHECK(polls.load() >= 3);
+  CHECK(!m.Running());
+  CHECK_EQ(inits.load(), 1);
+  CHECK_EQ(exits.load(), 1);
+
+  std::atomic<int> first{0};
+  opts.intervalMs = 60000;
+  m.Start(opts, [&first] { ++first; }, [] {});
+  for (int i = 0; i < 500 && first.load() == 0; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  CHECK_EQ(first.load(), 1);  // Did not wait an interval first
+  m.Stop();  // Wakes the wait instead of sleeping it out
+}
+
+}  // namespace
+
+int main() {
+  QueuesEvents();
+  WindowStatistics();
+  BoundsEvents();
+  PollsUntilStopped();
+  return check::Finish("status_monitor");
+}
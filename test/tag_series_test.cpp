@@ -0,0 +1,104 @@
+#include <vector>
+#include "check.h"
+#include "tag_series.h"
+
+namespace {
+
+void RawWindow() {
+  TagSeries series(8, false);
+  for (int i = 0; i < 10; ++i) series.Push(1000.0 * i, i, 0xC0);  // 0 and 1 evicted
+  SeriesAggregate agg = series.Aggregate(4000.0, 7000.0, false);
+  CHECK_EQ(agg.count, 4u);
+  CHECK_EQ(agg.min, 4.0);
+  CHECK_EQ(agg.max, 7.0);
+  CHECK_EQ(agg.avg, 5.5);
+  CHECK_EQ(agg.last, 7.0);
+  CHECK_EQ(agg.lastTimestamp, 7000.0);
+
+  agg = series.Aggregate(20000.0, 30000.0, false);
+  CHECK_EQ(agg.count, 0u);
+  CHECK(std::isnan(agg.avg));
+}
+
+void GoodOnlySkipsBadQuality() {
+  TagSeries series(8, false);
+  series.Push(1.0, 10.0, 0xC0);
+  series.Push(2.0, 99.0, 0x00);
+  SeriesAggregate agg = series.Aggregate(0.0, 10.0, true);
+  CHECK_EQ(agg.count, 1u);
+  CHECK_EQ(agg.max, 10.0);
+  CHECK_EQ(series.Aggregate(0.0, 10.0, false).max, 99.0);
+}
+
+// A server clock step puts older timestamps after newer ones; samples behind the step still count
+void OutOfOrderTimestamps() {
+  for (bool compressed : {false, true}) {
+    TagSeries series(4096, compressed);
+    for (int i = 0; i < 600; ++i) series.Push(10000.0 + i, 1.0, 0xC0);
+    series.Push(500.0, 2.0, 0xC0);       // Clock stepped back
+    series.Push(20000.0, 3.0, 0xC0);
+    series.Push(501.0, 4.0, 0xC0);
+    SeriesAggregate agg = series.Aggregate(10000.0, 10599.0, false);
+    CHECK_EQ(agg.count, 600u);
+    CHECK_EQ(agg.lastTimestamp, 10599.0);
+
+    agg = series.Aggregate(0.0, 30000.0, false);
+    CHECK_EQ(agg.count, 603u);
+    CHECK_EQ(agg.last, 3.0);             // Latest timestamp, not latest pushed
+    CHECK_EQ(agg.max, 4.0);
+
+    agg = series.Aggregate(400.0, 600.0, false);
+    CHECK_EQ(agg.count, 2u);
+    CHECK_EQ(agg.last, 4.0);
+  }
+}
+
+void CompressedMatchesRaw() {
+  TagSeries raw(2048, false), packed(2048, true);
+  for (int i = 0; i < 1500; ++i) {
+    double v = (i % 17) * 0.25 - 1.0;
+    uint16_t q = i % 100 == 0 ? 0x00 : 0xC0;
+    raw.Push(1.7e12 + i * 100.0, v, q);
+    packed.Push(1.7e12 + i * 100.0, v, q);
+  }
+  CHECK_EQ(packed.Size(), 1500u);
+  CHECK(packed.Bytes() < raw.Bytes());
+  for (bool goodOnly : {false, true}) {
+    SeriesAggregate a = raw.Aggregate(1.7e12 + 3000.0, 1.7e12 + 120000.0, goodOnly);
+    SeriesAggregate b = packed.Aggregate(1.7e12 + 3000.0, 1.7e12 + 120000.0, goodOnly);
+    CHECK_EQ(a.count, b.count);
+    CHECK_EQ(a.min, b.min);
+    CHECK_EQ(a.max, b.max);
+    CHECK_NEAR(a.avg, b.avg, 1e-12);
+    CHECK_EQ(a.last, b.last);
+  }
+}
+
+void StoreAggregatesMany() {
+  SeriesStore store(16, false);
+  store.Feed(0, 100.0, 1.0, 0xC0);
+  store.Feed(2, 150.0, 5.0, 0xC0);
+  std::vector<SeriesAggregate> out;
+  store.AggregateMany({0, 1, 2, -1}, {100.0, 1000.0}, 200.0, false, out);
+  CHECK_EQ(out.size(), 8u);
+  CHECK_EQ(out[0].count, 1u);   // Window bounds are inclusive: [100, 200]
+  CHECK_EQ(out[2].count, 1u);
+  CHECK_EQ(out[1].count, 0u);
+  CHECK_EQ(out[3].count, 0u);
+  CHECK_EQ(out[4].count, 1u);
+  size_t items, samples, bytes;
+  store.Usage(items, samples, bytes);
+  CHECK_EQ(items, 2u);
+  CHECK_EQ(samples, 2u);
+}
+
+}  // namespace
+
+int main() {
+  RawWindow();
+  GoodOnlySkipsBadQuality();
+  OutOfOrderTimestamps();
+  CompressedMatchesRaw();
+  StoreAggregatesMany();
+  return check::Finish("tag_series");
+}
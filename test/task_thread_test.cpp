@@ -0,0 +1,61 @@
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "task_thread.h"
+
+namespace {
+
+// Every task runs on the one thread, between init and exit, whichever thread submitted it
+void RunsOnOneThread() {
+  std::atomic<int> inits{0}, exits{0};
+  std::thread::id initThread;
+  TaskThread tt([&] { ++inits; initThread = std::this_thread::get_id(); }, [&] { ++exits; });
+  CHECK(!tt.Running());
+  std::vector<std::thread> callers;
+  std::atomic<int> elsewhere{0}, sum{0};
+  for (int t = 0; t < 4; ++t) {
+    callers.emplace_back([&, t] {
+      for (int i = 0; i < 100; ++i) {
+        std::thread::id id = tt.Run([] { return std::this_thread::get_id(); });
+        if (id != initThread) ++elsewhere;
+        sum += tt.Run([t, i] { return t * 1000 + i; });
+      }
+    });
+  }
+  for (std::thread& t : callers) t.join();
+  CHECK(tt.Running());
+  CHECK_EQ(elsewhere.load(), 0);
+  CHECK_EQ(sum.load(), 100 * (0 + 1000 + 2000 + 3000) + 4 * 4950);
+  CHECK_EQ(inits.load(), 1);
+  tt.Stop();
+  CHECK_EQ(exits.load(), 1);
+  CHECK(!tt.Running());
+
+  tt.Run([] {});  // Starts again
+  CHECK_EQ(inits.load(), 2);
+  tt.Stop();
+  CHECK_EQ(exits.load(), 2);
+}
+
+void PassesExceptions() {
+  TaskThread tt;
+  bool caught = false;
+  try {
+    tt.Run([]() -> int { throw std::runtime_error("boom"); });
+  } catch (const std::runtime_error& e) {
+    caught = std::string(e.what()) == "boom";
+  }
+  CHECK(caught);
+  CHECK_EQ(tt.Run([] { return 7; }), 7);  // The thread survives
+}
+
+}  // namespace
+
+int main() {
+  RunsOnOneThread();
+  PassesExceptions();
+  return check::Finish("task_thread");
+}
@@ -0,0 +1,95 @@
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "check.h"
+#include "value_table.h"
+
+namespace {
+
+template <typename T>
+T At(const uint8_t* base, size_t offset) {
+  T v;
+  std::memcpy(&v, base + offset, sizeof(T));
+  return v;
+}
+
+ChangeRecord Rec(uint64_t seq, double value) {
+  ChangeRecord rec;
+  rec.seq = seq;
+  rec.quality = 0xC0;
+  rec.timestamp = JsMsToFileTimeTicks(1.7e12 + static_cast<double>(seq));
+  rec.value.kind = ChangeValue::Kind::Number;
+  rec.value.number = value;
+  return rec;
+}
+
+void HeaderAndSlots() {
+  std::vector<std::string> items = {"A", "B", "C"};
+  alignas(8) uint8_t buf[64 + 32 * 3];
+  std::memset(buf, 0xFF, sizeof(buf));
+  ValueTable table(buf, items);
+  CHECK_EQ(ValueTable::BytesFor(3), sizeof(buf));
+  CHECK_EQ(At<uint32_t>(buf, 0), ValueTable::kMagic);
+  CHECK_EQ(At<uint32_t>(buf, 8), 3u);
+  CHECK_EQ(At<uint32_t>(buf, 12), 32u);
+  CHECK_EQ(At<uint32_t>(buf, 16), 64u);
+  CHECK_EQ(At<uint32_t>(buf, 20), 0u);
+  CHECK_EQ(table.SlotOf("B"), 1);
+  CHECK_EQ(table.SlotOf("missing"), -1);
+  CHECK(std::isnan(At<double>(buf, 64 + 32 * 2 + 8)));  // Unwritten slots read as NaN
+
+  table.Write(1, Rec(9, 12.5));
+  table.BumpGeneration();
+  const size_t slot = 64 + 32;
+  CHECK_EQ(At<uint32_t>(buf, slot), 2u);  // Even again after the write
+  CHECK_EQ(At<uint16_t>(buf, slot + 4), 0xC0u);
+  CHECK_EQ(buf[slot + 6], static_cast<uint8_t>(ChangeValue::Kind::Number));
+  CHECK_EQ(At<double>(buf, slot + 8), 12.5);
+  CHECK_NEAR(At<double>(buf, slot + 16), 1.7e12 + 9, 1e-3);
+  CHECK_EQ(At<double>(buf, slot + 24), 9.0);
+  CHECK_EQ(At<uint32_t>(buf, 20), 1u);
+
+  ChangeRecord text = Rec(10, 0.0);
+  text.value.kind = ChangeValue::Kind::String;
+  text.value.text = "hello";
+  table.Write(1, text);
+  CHECK(std::isnan(At<double>(buf, slot + 8)));  // Only numeric kinds carry a value
+}
+
+// Readers following the seqlock protocol never see a torn slot while the writer runs
+void ReadersSeeConsistentSlots() {
+  std::vector<std::string> items = {"A"};
+  alignas(8) uint8_t buf[64 + 32];
+  ValueTable table(buf, items);
+  std::atomic<bool> done{false};
+  std::atomic<uint64_t> torn{0}, reads{0};
+  std::thread reader([&] {
+    auto* version = reinterpret_cast<std::atomic<uint32_t>*>(buf + 64);
+    while (!done.load()) {
+      uint32_t v1 = version->load(std::memory_order_acquire);
+      if (v1 & 1) continue;
+      double value, seq;
+      std::memcpy(&value, buf + 64 + 8, 8);
+      std::memcpy(&seq, buf + 64 + 24, 8);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (version->load(std::memory_order_relaxed) != v1) continue;
+      if (v1 != 0 && value != seq * 2.0) ++torn;
+      ++reads;
+    }
+  });
+  for (uint64_t seq = 1; seq <= 200000 || reads.load() < 1000; ++seq) table.Write(0, Rec(seq, static_cast<double>(seq) * 2.0));
+  done = true;
+  reader.join();
+  CHECK_EQ(torn.load(), 0u);
+}
+
+}  // namespace
+
+int main() {
+  HeaderAndSlots();
+  ReadersSeeConsistentSlots();
+  return check::Finish("value_table");
+}
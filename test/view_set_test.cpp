@@ -0,0 +1,71 @@
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "check.h"
+#include "view_set.h"
+
+namespace {
+
+ViewSet::Items One(const std::string& group, std::set<std::string> items) {
+  ViewSet::Items out;
+  out[group] = std::move(items);
+  return out;
+}
+
+// Switching views yields only the items whose visibility changed
+void ShowYieldsDeltas() {
+  ViewSet vs;
+  CHECK(vs.Define("north", One("g", {"A", "B", "C"})).empty());  // Hidden: nothing to change
+  vs.Define("south", One("g", {"C", "D"}));
+
+  std::map<std::string, ViewSet::Delta> d = vs.Show({"north", "unknown"});
+  CHECK_EQ(d["g"].on.size(), 3u);
+  CHECK(d["g"].off.empty());
+  CHECK(vs.Shown("north"));
+  CHECK(!vs.Shown("unknown"));
+
+  d = vs.Show({"south"});
+  CHECK_EQ(d["g"].on, std::vector<std::string>({"D"}));
+  CHECK_EQ(d["g"].off, std::vector<std::string>({"A", "B"}));  // C stays visible
+
+  d = vs.Remove("south");
+  CHECK_EQ(d["g"].off, std::vector<std::string>({"C", "D"}));
+  CHECK(vs.Visible().empty());
+  CHECK(vs.Find("south") == nullptr);
+}
+
+void RedefineShownView() {
+  ViewSet vs;
+  vs.Define("v", One("g", {"A", "B"}));
+  vs.Show({"v"});
+  std::map<std::string, ViewSet::Delta> d = vs.Define("v", One("g", {"B", "C"}));
+  CHECK_EQ(d["g"].on, std::vector<std::string>({"C"}));
+  CHECK_EQ(d["g"].off, std::vector<std::string>({"A"}));
+}
+
+// An item held only by hidden views needs no scanning once every other holder has gone
+void HiddenHoldersDoNotScan() {
+  ViewSet vs;
+  vs.Define("a", One("g", {"X"}));
+  vs.Define("b", One("g", {"X", "Y"}));
+  CHECK_EQ(vs.Holders("g", "X"), 2u);
+  CHECK_EQ(vs.Holders("other", "X"), 0u);
+  CHECK(vs.NeedsScan("g", "X", 3));   // A subscriber holds it as well
+  CHECK(!vs.NeedsScan("g", "X", 2));  // Subscriber gone, both views hidden
+  vs.Show({"b"});
+  CHECK(vs.NeedsScan("g", "X", 2));
+  CHECK(vs.NeedsScan("g", "Y", 1));
+  vs.Show({"a"});
+  CHECK(!vs.NeedsScan("g", "Y", 1));
+  CHECK(!vs.NeedsScan("g", "Z", 0));
+}
+
+}  // namespace
+
+int main() {
+  ShowYieldsDeltas();
+  RedefineShownView();
+  HiddenHoldersDoNotScan();
+  return check::Finish("view_set");
+}